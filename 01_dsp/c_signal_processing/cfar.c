@@ -0,0 +1,299 @@
+/*
+ * File:   cfar.c
+ * Author: ericdvet
+ *
+ * Constant false alarm rate (CFAR) peak detection over the tag FT
+ */
+
+#include "cfar.h"
+#include <math.h>
+#include <string.h>
+
+/**
+ * @function cfarOSFalseAlarmRate(int numCells, int order, double scale)
+ * @param numCells - Number of training cells
+ * @param order - Rank (1-based) of the training cell used as the noise estimate
+ * @param scale - Threshold factor applied to that cell
+ * @return double
+ * @brief False alarm rate of OS-CFAR on exponential noise power (Rohling)
+ * @author ericdvet */
+static double cfarOSFalseAlarmRate(int numCells, int order, double scale)
+{
+    double rate = 1;
+    for (int i = 0; i < order; i++)
+    {
+        rate *= (double)(numCells - i) / (numCells - i + scale);
+    }
+    return rate;
+}
+
+/**
+ * @function cfarSelect(double *values, int count, int k)
+ * @param values - Values to partially reorder
+ * @param count - Number of values
+ * @param k - Rank (0-based) to find
+ * @return double
+ * @brief Quickselect of the k-th smallest value
+ * @author ericdvet */
+static double cfarSelect(double *values, int count, int k)
+{
+    int low = 0;
+    int high = count - 1;
+    while (low < high)
+    {
+        double pivot = values[(low + high) / 2];
+        int i = low;
+        int j = high;
+        while (i <= j)
+        {
+            while (values[i] < pivot)
+            {
+                i++;
+            }
+            while (values[j] > pivot)
+            {
+                j--;
+            }
+            if (i <= j)
+            {
+                double swap = values[i];
+                values[i++] = values[j];
+                values[j--] = swap;
+            }
+        }
+        if (k <= j)
+        {
+            high = j;
+        }
+        else if (k >= i)
+        {
+            low = i;
+        }
+        else
+        {
+            break;
+        }
+    }
+    return values[k];
+}
+
+/**
+ * @function cfarCreate(int type, int guardCells, int trainingCells, double falseAlarmRate, int numOfSamplers)
+ * @param type - CFAR_CA or CFAR_OS
+ * @param guardCells - Cells skipped on each side of the cell under test, 0 for the default
+ * @param trainingCells - Cells averaged (CA) or ranked (OS) on each side beyond the guard cells, 0 for the default
+ * @param falseAlarmRate - Probability of a noise cell crossing the threshold, 0 for the default
+ * @param numOfSamplers - Number of range bins in the tag FT
+ * @return CFARDetector *
+ * @brief Precomputes the threshold factors for the false alarm rate, assuming exponentially distributed
+ *      noise power. Cells near the edges use the training cells that exist, with their own factor
+ * @author ericdvet */
+CFARDetector *cfarCreate(int type, int guardCells, int trainingCells, double falseAlarmRate, int numOfSamplers)
+{
+    guardCells = guardCells > 0 ? guardCells : CFAR_DEFAULT_GUARD_CELLS;
+    trainingCells = trainingCells > 0 ? trainingCells : CFAR_DEFAULT_TRAINING_CELLS;
+    falseAlarmRate = falseAlarmRate > 0 ? falseAlarmRate : CFAR_DEFAULT_FALSE_ALARM_RATE;
+    if ((type != CFAR_CA && type != CFAR_OS) || falseAlarmRate >= 1 || numOfSamplers < 3)
+    {
+        fprintf(stderr, "ERROR: Invalid CFAR parameters\n");
+        return NULL;
+    }
+
+    CFARDetector *cfar = (CFARDetector *)calloc(1, sizeof(CFARDetector));
+    if (!cfar)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        return NULL;
+    }
+    cfar->type = type;
+    cfar->guardCells = guardCells;
+    cfar->trainingCells = trainingCells;
+    cfar->numOfSamplers = numOfSamplers;
+
+    int maxCells = 2 * trainingCells;
+    cfar->scale = (double *)calloc(maxCells + 1, sizeof(double));
+    cfar->order = (int *)calloc(maxCells + 1, sizeof(int));
+    cfar->power = (double *)malloc(numOfSamplers * sizeof(double));
+    cfar->prefix = (double *)malloc((numOfSamplers + 1) * sizeof(double));
+    cfar->training = (double *)malloc(maxCells * sizeof(double));
+    cfar->threshold = (double *)malloc(numOfSamplers * sizeof(double));
+    if (!cfar->scale || !cfar->order || !cfar->power || !cfar->prefix || !cfar->training || !cfar->threshold)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        cfarFree(cfar);
+        return NULL;
+    }
+
+    for (int numCells = 1; numCells <= maxCells; numCells++)
+    {
+        if (type == CFAR_CA)
+        {
+            // Pfa = (1 + scale / N)^-N with the threshold at scale times the mean
+            cfar->scale[numCells] = numCells * (pow(falseAlarmRate, -1.0 / numCells) - 1);
+        }
+        else
+        {
+            // Third quartile of the training cells, factor found by bisection since Pfa falls with it
+            int order = (3 * numCells + 3) / 4;
+            double low = 0;
+            double high = 1;
+            while (cfarOSFalseAlarmRate(numCells, order, high) > falseAlarmRate)
+            {
+                high *= 2;
+            }
+            for (int i = 0; i < 100; i++)
+            {
+                double mid = 0.5 * (low + high);
+                if (cfarOSFalseAlarmRate(numCells, order, mid) > falseAlarmRate)
+                {
+                    low = mid;
+                }
+                else
+                {
+                    high = mid;
+                }
+            }
+            cfar->order[numCells] = order;
+            cfar->scale[numCells] = high;
+        }
+    }
+
+    return cfar;
+}
+
+/**
+ * @function cfarDetect(CFARDetector *cfar, const double *tagFT)
+ * @param cfar - Detector created by cfarCreate()
+ * @param tagFT - FT of the tag's frequency isolated (numOfSamplers)
+ * @return int
+ * @brief Thresholds the power of every range bin against its training cells and returns the strongest
+ *      local maximum above its threshold, or the strongest bin if nothing is detected. The power
+ *      threshold of every bin is left in cfar->threshold
+ * @author ericdvet */
+int cfarDetect(CFARDetector *cfar, const double *tagFT)
+{
+    int numOfSamplers = cfar->numOfSamplers;
+    int guardCells = cfar->guardCells;
+    int trainingCells = cfar->trainingCells;
+    double *power = cfar->power;
+    double *prefix = cfar->prefix;
+    double *threshold = cfar->threshold;
+
+    prefix[0] = 0;
+    for (int i = 0; i < numOfSamplers; i++)
+    {
+        power[i] = tagFT[i] * tagFT[i];
+        prefix[i + 1] = prefix[i] + power[i];
+    }
+
+    // Training windows [i - g - t, i - g - 1] and [i + g + 1, i + g + t], clipped to the capture
+    for (int i = 0; i < numOfSamplers; i++)
+    {
+        int leftLow = i - guardCells - trainingCells;
+        int leftHigh = i - guardCells;
+        int rightLow = i + guardCells + 1;
+        int rightHigh = i + guardCells + trainingCells + 1;
+        leftLow = leftLow < 0 ? 0 : leftLow;
+        leftHigh = leftHigh < 0 ? 0 : leftHigh;
+        rightLow = rightLow > numOfSamplers ? numOfSamplers : rightLow;
+        rightHigh = rightHigh > numOfSamplers ? numOfSamplers : rightHigh;
+        int numCells = (leftHigh - leftLow) + (rightHigh - rightLow);
+
+        if (numCells == 0)
+        {
+            threshold[i] = INFINITY;
+        }
+        else if (cfar->type == CFAR_CA)
+        {
+            double sum = (prefix[leftHigh] - prefix[leftLow]) + (prefix[rightHigh] - prefix[rightLow]);
+            threshold[i] = cfar->scale[numCells] * sum / numCells;
+        }
+        else
+        {
+            memcpy(cfar->training, &power[leftLow], (leftHigh - leftLow) * sizeof(double));
+            memcpy(&cfar->training[leftHigh - leftLow], &power[rightLow], (rightHigh - rightLow) * sizeof(double));
+            threshold[i] = cfar->scale[numCells] * cfarSelect(cfar->training, numCells, cfar->order[numCells] - 1);
+        }
+    }
+
+    int peakBin = -1;
+    int strongestBin = 0;
+    for (int i = 0; i < numOfSamplers; i++)
+    {
+        if (power[i] > power[strongestBin])
+        {
+            strongestBin = i;
+        }
+        if (i > 0 && i < numOfSamplers - 1 && power[i] > threshold[i] && power[i] > power[i - 1] && power[i] >= power[i + 1] &&
+            (peakBin < 0 || power[i] > power[peakBin]))
+        {
+            peakBin = i;
+        }
+    }
+
+    return peakBin >= 0 ? peakBin : strongestBin;
+}
+
+/**
+ * @function cfarFree(CFARDetector *cfar)
+ * @param cfar - CFARDetector to free
+ * @return None
+ * @brief Free a CFARDetector constructed by cfarCreate()
+ * @author ericdvet */
+void cfarFree(CFARDetector *cfar)
+{
+    if (cfar)
+    {
+        free(cfar->scale);
+        free(cfar->order);
+        free(cfar->power);
+        free(cfar->prefix);
+        free(cfar->training);
+        free(cfar->threshold);
+        free(cfar);
+    }
+}
+
+// #define CFAR_TEST
+
+#ifdef CFAR_TEST
+#include <time.h>
+
+int main()
+{
+    int numOfSamplers = 512;
+    int numRuns = 10000;
+    double *tagFT = (double *)malloc(numOfSamplers * sizeof(double));
+
+    // Tag at 300 on a noise floor that rises with range, plus a weaker reflection at 120
+    for (int i = 0; i < numOfSamplers; i++)
+    {
+        double noise = (0.05 + 0.1 * i / numOfSamplers) * sqrt(-log((rand() + 1.0) / (RAND_MAX + 2.0)));
+        tagFT[i] = exp(-pow(i - 300, 2) / 50.0) + 0.4 * exp(-pow(i - 120, 2) / 20.0) + noise;
+    }
+
+    for (int type = CFAR_CA; type <= CFAR_OS; type++)
+    {
+        CFARDetector *cfar = cfarCreate(type, 0, 0, 0, numOfSamplers);
+        int peakBin = cfarDetect(cfar, tagFT);
+        int numDetections = 0;
+        for (int i = 0; i < numOfSamplers; i++)
+        {
+            numDetections += tagFT[i] * tagFT[i] > cfar->threshold[i];
+        }
+
+        clock_t start = clock();
+        for (int run = 0; run < numRuns; run++)
+        {
+            cfarDetect(cfar, tagFT);
+        }
+        double runTime = (double)(clock() - start) / CLOCKS_PER_SEC / numRuns;
+        printf("%s-CFAR: peak bin %d, %d bins above threshold, %g us per capture\n", type == CFAR_CA ? "CA" : "OS", peakBin, numDetections,
+               runTime * 1E6);
+        cfarFree(cfar);
+    }
+
+    free(tagFT);
+    return 0;
+}
+#endif
@@ -0,0 +1,73 @@
+/*
+ * File:   cfar.h
+ * Author: ericdvet
+ *
+ * Constant false alarm rate (CFAR) peak detection over the tag FT
+ */
+
+#ifndef CFAR_H
+#define CFAR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// CFAR variants
+#define CFAR_CA 0 // cell averaging
+#define CFAR_OS 1 // order statistic, robust to other targets in the training cells
+
+// Defaults used when a parameter is 0
+#define CFAR_DEFAULT_GUARD_CELLS 8
+#define CFAR_DEFAULT_TRAINING_CELLS 16
+#define CFAR_DEFAULT_FALSE_ALARM_RATE 1E-3
+
+/**
+ * @struct CFARDetector
+ * @brief Threshold factors for every number of training cells that fits around a cell, and scratch space
+ * @author ericdvet */
+typedef struct
+{
+    int type;
+    int guardCells;
+    int trainingCells;
+    int numOfSamplers;
+    double *scale;
+    int *order;
+    double *power;
+    double *prefix;
+    double *training;
+    double *threshold;
+} CFARDetector;
+
+/**
+ * @function cfarCreate(int type, int guardCells, int trainingCells, double falseAlarmRate, int numOfSamplers)
+ * @param type - CFAR_CA or CFAR_OS
+ * @param guardCells - Cells skipped on each side of the cell under test, 0 for the default
+ * @param trainingCells - Cells averaged (CA) or ranked (OS) on each side beyond the guard cells, 0 for the default
+ * @param falseAlarmRate - Probability of a noise cell crossing the threshold, 0 for the default
+ * @param numOfSamplers - Number of range bins in the tag FT
+ * @return CFARDetector *
+ * @brief Precomputes the threshold factors for the false alarm rate, assuming exponentially distributed
+ *      noise power. Cells near the edges use the training cells that exist, with their own factor
+ * @author ericdvet */
+CFARDetector *cfarCreate(int type, int guardCells, int trainingCells, double falseAlarmRate, int numOfSamplers);
+
+/**
+ * @function cfarDetect(CFARDetector *cfar, const double *tagFT)
+ * @param cfar - Detector created by cfarCreate()
+ * @param tagFT - FT of the tag's frequency isolated (numOfSamplers)
+ * @return int
+ * @brief Thresholds the power of every range bin against its training cells and returns the strongest
+ *      local maximum above its threshold, or the strongest bin if nothing is detected. The power
+ *      threshold of every bin is left in cfar->threshold
+ * @author ericdvet */
+int cfarDetect(CFARDetector *cfar, const double *tagFT);
+
+/**
+ * @function cfarFree(CFARDetector *cfar)
+ * @param cfar - CFARDetector to free
+ * @return None
+ * @brief Free a CFARDetector constructed by cfarCreate()
+ * @author ericdvet */
+void cfarFree(CFARDetector *cfar);
+
+#endif // CFAR_H
@@ -0,0 +1,501 @@
+/*
+ * File:   clutter.c
+ * Author: ericdvet
+ *
+ * Clutter removal from blocks of baseband frames before the slow-time transform, the static, adaptive and
+ * MTI clutter maps of the FlatEarth cluttermap library (static.h, adaptive.h, MTI.h) on the host
+ */
+
+#include "clutter.h"
+#include <string.h>
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__)
+/**
+ * @function clutterBlendAVX(double *map, const double *frame, double gain, int length)
+ * @param map - Clutter map, moved towards the frame in place
+ * @param frame - Interleaved I/Q samples of one frame
+ * @param gain - Fraction of the way the map moves, 1 replaces it by the frame
+ * @param length - Number of doubles in the frame
+ * @return int
+ * @brief AVX loop of clutterBlend(), compiled for AVX whatever the build flags and only run on CPUs that have
+ *      it. Returns the first element left for the scalar tail
+ * @author ericdvet */
+static __attribute__((target("avx"))) int clutterBlendAVX(double *map, const double *frame, double gain, int length)
+{
+    int i = 0;
+    __m256d gainVec = _mm256_set1_pd(gain);
+    for (; i + 4 <= length; i += 4)
+    {
+        __m256d m = _mm256_loadu_pd(&map[i]);
+        __m256d step = _mm256_mul_pd(gainVec, _mm256_sub_pd(_mm256_loadu_pd(&frame[i]), m));
+        _mm256_storeu_pd(&map[i], _mm256_add_pd(m, step));
+    }
+    return i;
+}
+#endif
+
+/**
+ * @function clutterBlend(double *map, const double *frame, double gain, int length, bool useAVX)
+ * @param map - Clutter map, moved towards the frame in place
+ * @param frame - Interleaved I/Q samples of one frame
+ * @param gain - Fraction of the way the map moves, 1 replaces it by the frame
+ * @param length - Number of doubles in the frame
+ * @param useAVX - Run the AVX loop, ClutterFilter.useAVX
+ * @return None
+ * @brief map += gain * (frame - map) over every range bin
+ * @author ericdvet */
+static void clutterBlend(double *map, const double *frame, double gain, int length, bool useAVX)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    if (useAVX)
+    {
+        i = clutterBlendAVX(map, frame, gain, length);
+    }
+    __m128d gainVec = _mm_set1_pd(gain);
+    for (; i + 2 <= length; i += 2)
+    {
+        __m128d m = _mm_loadu_pd(&map[i]);
+        __m128d step = _mm_mul_pd(gainVec, _mm_sub_pd(_mm_loadu_pd(&frame[i]), m));
+        _mm_storeu_pd(&map[i], _mm_add_pd(m, step));
+    }
+#endif
+    for (; i < length; i++)
+    {
+        map[i] += gain * (frame[i] - map[i]);
+    }
+}
+
+#if defined(__SSE2__)
+/**
+ * @function clutterAxpyAVX(double *y, const double *x, double a, int length)
+ * @param y - Interleaved I/Q samples added to in place
+ * @param x - Interleaved I/Q samples to add
+ * @param a - Weight of x
+ * @param length - Number of doubles in the frame
+ * @return int
+ * @brief AVX loop of clutterAxpy(), compiled for AVX whatever the build flags and only run on CPUs that have
+ *      it. Returns the first element left for the scalar tail
+ * @author ericdvet */
+static __attribute__((target("avx"))) int clutterAxpyAVX(double *y, const double *x, double a, int length)
+{
+    int i = 0;
+    __m256d aVec = _mm256_set1_pd(a);
+    for (; i + 4 <= length; i += 4)
+    {
+        _mm256_storeu_pd(&y[i], _mm256_add_pd(_mm256_loadu_pd(&y[i]), _mm256_mul_pd(aVec, _mm256_loadu_pd(&x[i]))));
+    }
+    return i;
+}
+#endif
+
+/**
+ * @function clutterAxpy(double *y, const double *x, double a, int length, bool useAVX)
+ * @param y - Interleaved I/Q samples added to in place
+ * @param x - Interleaved I/Q samples to add
+ * @param a - Weight of x
+ * @param length - Number of doubles in the frame
+ * @param useAVX - Run the AVX loop, ClutterFilter.useAVX
+ * @return None
+ * @brief y += a * x over every range bin
+ * @author ericdvet */
+static void clutterAxpy(double *y, const double *x, double a, int length, bool useAVX)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    if (useAVX)
+    {
+        i = clutterAxpyAVX(y, x, a, length);
+    }
+    __m128d aVec = _mm_set1_pd(a);
+    for (; i + 2 <= length; i += 2)
+    {
+        _mm_storeu_pd(&y[i], _mm_add_pd(_mm_loadu_pd(&y[i]), _mm_mul_pd(aVec, _mm_loadu_pd(&x[i]))));
+    }
+#endif
+    for (; i < length; i++)
+    {
+        y[i] += a * x[i];
+    }
+}
+
+#if defined(__SSE2__)
+/**
+ * @function clutterBlendAVXf(float *map, const float *frame, float gain, int length)
+ * @param map - Clutter map, moved towards the frame in place
+ * @param frame - Interleaved I/Q samples of one frame
+ * @param gain - Fraction of the way the map moves, 1 replaces it by the frame
+ * @param length - Number of floats in the frame
+ * @return int
+ * @brief Single precision clutterBlendAVX()
+ * @author ericdvet */
+static __attribute__((target("avx"))) int clutterBlendAVXf(float *map, const float *frame, float gain, int length)
+{
+    int i = 0;
+    __m256 gainVec = _mm256_set1_ps(gain);
+    for (; i + 8 <= length; i += 8)
+    {
+        __m256 m = _mm256_loadu_ps(&map[i]);
+        __m256 step = _mm256_mul_ps(gainVec, _mm256_sub_ps(_mm256_loadu_ps(&frame[i]), m));
+        _mm256_storeu_ps(&map[i], _mm256_add_ps(m, step));
+    }
+    return i;
+}
+#endif
+
+/**
+ * @function clutterBlendf(float *map, const float *frame, float gain, int length, bool useAVX)
+ * @param map - Clutter map, moved towards the frame in place
+ * @param frame - Interleaved I/Q samples of one frame
+ * @param gain - Fraction of the way the map moves, 1 replaces it by the frame
+ * @param length - Number of floats in the frame
+ * @param useAVX - Run the AVX loop, ClutterFilter.useAVX
+ * @return None
+ * @brief Single precision clutterBlend()
+ * @author ericdvet */
+static void clutterBlendf(float *map, const float *frame, float gain, int length, bool useAVX)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    if (useAVX)
+    {
+        i = clutterBlendAVXf(map, frame, gain, length);
+    }
+    __m128 gainVec = _mm_set1_ps(gain);
+    for (; i + 4 <= length; i += 4)
+    {
+        __m128 m = _mm_loadu_ps(&map[i]);
+        __m128 step = _mm_mul_ps(gainVec, _mm_sub_ps(_mm_loadu_ps(&frame[i]), m));
+        _mm_storeu_ps(&map[i], _mm_add_ps(m, step));
+    }
+#endif
+    for (; i < length; i++)
+    {
+        map[i] += gain * (frame[i] - map[i]);
+    }
+}
+
+#if defined(__SSE2__)
+/**
+ * @function clutterAxpyAVXf(float *y, const float *x, float a, int length)
+ * @param y - Interleaved I/Q samples added to in place
+ * @param x - Interleaved I/Q samples to add
+ * @param a - Weight of x
+ * @param length - Number of floats in the frame
+ * @return int
+ * @brief Single precision clutterAxpyAVX()
+ * @author ericdvet */
+static __attribute__((target("avx"))) int clutterAxpyAVXf(float *y, const float *x, float a, int length)
+{
+    int i = 0;
+    __m256 aVec = _mm256_set1_ps(a);
+    for (; i + 8 <= length; i += 8)
+    {
+        _mm256_storeu_ps(&y[i], _mm256_add_ps(_mm256_loadu_ps(&y[i]), _mm256_mul_ps(aVec, _mm256_loadu_ps(&x[i]))));
+    }
+    return i;
+}
+#endif
+
+/**
+ * @function clutterAxpyf(float *y, const float *x, float a, int length, bool useAVX)
+ * @param y - Interleaved I/Q samples added to in place
+ * @param x - Interleaved I/Q samples to add
+ * @param a - Weight of x
+ * @param length - Number of floats in the frame
+ * @param useAVX - Run the AVX loop, ClutterFilter.useAVX
+ * @return None
+ * @brief Single precision clutterAxpy()
+ * @author ericdvet */
+static void clutterAxpyf(float *y, const float *x, float a, int length, bool useAVX)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    if (useAVX)
+    {
+        i = clutterAxpyAVXf(y, x, a, length);
+    }
+    __m128 aVec = _mm_set1_ps(a);
+    for (; i + 4 <= length; i += 4)
+    {
+        _mm_storeu_ps(&y[i], _mm_add_ps(_mm_loadu_ps(&y[i]), _mm_mul_ps(aVec, _mm_loadu_ps(&x[i]))));
+    }
+#endif
+    for (; i < length; i++)
+    {
+        y[i] += a * x[i];
+    }
+}
+
+/**
+ * @function clutterCreate(int mode, int numOfSamplers, double beta)
+ * @param mode - CLUTTER_STATIC, CLUTTER_ADAPTIVE or CLUTTER_MTI
+ * @param numOfSamplers - Number of range bins per frame
+ * @param beta - Adaptation rate of CLUTTER_ADAPTIVE in (0, 1), 0 for CLUTTER_ADAPTIVE_BETA. Ignored by the other maps
+ * @return ClutterFilter *
+ * @brief Creates an empty clutter map, so it is built from the first frames of the capture
+ * @author ericdvet */
+ClutterFilter *clutterCreate(int mode, int numOfSamplers, double beta)
+{
+    beta = beta > 0 ? beta : CLUTTER_ADAPTIVE_BETA;
+    if ((mode != CLUTTER_STATIC && mode != CLUTTER_ADAPTIVE && mode != CLUTTER_MTI) || numOfSamplers < 1 || beta >= 1)
+    {
+        fprintf(stderr, "ERROR: Invalid clutter map\n");
+        return NULL;
+    }
+
+    ClutterFilter *clutter = (ClutterFilter *)calloc(1, sizeof(ClutterFilter));
+    if (!clutter)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        return NULL;
+    }
+    clutter->mode = mode;
+#if defined(__SSE2__)
+    clutter->useAVX = __builtin_cpu_supports("avx");
+#endif
+    clutter->numOfSamplers = numOfSamplers;
+    clutter->beta = beta;
+
+    size_t length = 2 * (size_t)numOfSamplers;
+    clutter->map = (double *)calloc(length, sizeof(double));
+    clutter->mapf = (float *)calloc(length, sizeof(float));
+    if (mode == CLUTTER_MTI)
+    {
+        clutter->history = (double *)calloc((CLUTTER_MTI_PULSES - 1) * length, sizeof(double));
+        clutter->historyf = (float *)calloc((CLUTTER_MTI_PULSES - 1) * length, sizeof(float));
+        clutter->output = (double *)malloc(length * sizeof(double));
+        clutter->outputf = (float *)malloc(length * sizeof(float));
+    }
+    if (!clutter->map || !clutter->mapf ||
+        (mode == CLUTTER_MTI && (!clutter->history || !clutter->historyf || !clutter->output || !clutter->outputf)))
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        clutterFree(clutter);
+        return NULL;
+    }
+
+    // Binomial weights with alternating signs, a zero of order CLUTTER_MTI_PULSES - 1 at DC
+    double weight = 1.0;
+    for (int k = 0; k < CLUTTER_MTI_PULSES; k++)
+    {
+        clutter->weights[k] = weight;
+        weight *= -(double)(CLUTTER_MTI_PULSES - 1 - k) / (k + 1);
+    }
+
+    return clutter;
+}
+
+/**
+ * @function clutterReset(ClutterFilter *clutter)
+ * @param clutter - Filter created by clutterCreate()
+ * @return None
+ * @brief Clears the clutter map and frame history for a new capture
+ * @author ericdvet */
+void clutterReset(ClutterFilter *clutter)
+{
+    clutter->numSeen = 0;
+}
+
+/**
+ * @function clutterApply(ClutterFilter *clutter, double complex *framesBB, int numFrames)
+ * @param clutter - Filter created by clutterCreate()
+ * @param framesBB - Next baseband frames of the capture (numFrames x numOfSamplers), decluttered in place
+ * @param numFrames - Number of frames in the block
+ * @return None
+ * @brief Updates the clutter map with every frame and removes it, in frame order, so a capture can be fed
+ *      block by block. Every frame is processed across all range bins at once. The static map is the
+ *      running mean until CLUTTER_STATIC_FRAMES frames are in, and the first CLUTTER_MTI_PULSES - 1
+ *      frames out of the MTI canceller are zero
+ * @author ericdvet */
+void clutterApply(ClutterFilter *clutter, double complex *framesBB, int numFrames)
+{
+    int length = 2 * clutter->numOfSamplers;
+    int ringRows = CLUTTER_MTI_PULSES - 1;
+
+    for (int n = 0; n < numFrames; n++)
+    {
+        double *frame = (double *)&framesBB[(size_t)n * clutter->numOfSamplers];
+        int seen = clutter->numSeen;
+
+        if (clutter->mode == CLUTTER_MTI)
+        {
+            memset(clutter->output, 0, length * sizeof(double));
+            clutterAxpy(clutter->output, frame, clutter->weights[0], length, clutter->useAVX);
+            for (int k = 1; k < CLUTTER_MTI_PULSES; k++)
+            {
+                clutterAxpy(clutter->output, &clutter->history[(size_t)((seen - k + ringRows) % ringRows) * length], clutter->weights[k], length,
+                            clutter->useAVX);
+            }
+            memcpy(&clutter->history[(size_t)(seen % ringRows) * length], frame, length * sizeof(double));
+            if (seen >= ringRows)
+            {
+                memcpy(frame, clutter->output, length * sizeof(double));
+            }
+            else
+            {
+                memset(frame, 0, length * sizeof(double));
+            }
+        }
+        else
+        {
+            // Update then remove, as rangingDemo.c does with the FlatEarth maps. The first frame sets the map
+            if (clutter->mode == CLUTTER_ADAPTIVE)
+            {
+                clutterBlend(clutter->map, frame, seen == 0 ? 1.0 : 1.0 - clutter->beta, length, clutter->useAVX);
+            }
+            else if (seen < CLUTTER_STATIC_FRAMES)
+            {
+                clutterBlend(clutter->map, frame, 1.0 / (seen + 1), length, clutter->useAVX);
+            }
+            clutterAxpy(frame, clutter->map, -1.0, length, clutter->useAVX);
+        }
+        clutter->numSeen++;
+    }
+}
+
+/**
+ * @function clutterApplyf(ClutterFilter *clutter, float complex *framesBB, int numFrames)
+ * @param clutter - Filter created by clutterCreate()
+ * @param framesBB - Next baseband frames of the capture (numFrames x numOfSamplers), decluttered in place
+ * @param numFrames - Number of frames in the block
+ * @return None
+ * @brief Single precision clutterApply()
+ * @author ericdvet */
+void clutterApplyf(ClutterFilter *clutter, float complex *framesBB, int numFrames)
+{
+    int length = 2 * clutter->numOfSamplers;
+    int ringRows = CLUTTER_MTI_PULSES - 1;
+
+    for (int n = 0; n < numFrames; n++)
+    {
+        float *frame = (float *)&framesBB[(size_t)n * clutter->numOfSamplers];
+        int seen = clutter->numSeen;
+
+        if (clutter->mode == CLUTTER_MTI)
+        {
+            memset(clutter->outputf, 0, length * sizeof(float));
+            clutterAxpyf(clutter->outputf, frame, (float)clutter->weights[0], length, clutter->useAVX);
+            for (int k = 1; k < CLUTTER_MTI_PULSES; k++)
+            {
+                clutterAxpyf(clutter->outputf, &clutter->historyf[(size_t)((seen - k + ringRows) % ringRows) * length], (float)clutter->weights[k],
+                             length, clutter->useAVX);
+            }
+            memcpy(&clutter->historyf[(size_t)(seen % ringRows) * length], frame, length * sizeof(float));
+            if (seen >= ringRows)
+            {
+                memcpy(frame, clutter->outputf, length * sizeof(float));
+            }
+            else
+            {
+                memset(frame, 0, length * sizeof(float));
+            }
+        }
+        else
+        {
+            if (clutter->mode == CLUTTER_ADAPTIVE)
+            {
+                clutterBlendf(clutter->mapf, frame, seen == 0 ? 1.0f : (float)(1.0 - clutter->beta), length, clutter->useAVX);
+            }
+            else if (seen < CLUTTER_STATIC_FRAMES)
+            {
+                clutterBlendf(clutter->mapf, frame, 1.0f / (seen + 1), length, clutter->useAVX);
+            }
+            clutterAxpyf(frame, clutter->mapf, -1.0f, length, clutter->useAVX);
+        }
+        clutter->numSeen++;
+    }
+}
+
+/**
+ * @function clutterFree(ClutterFilter *clutter)
+ * @param clutter - ClutterFilter to free
+ * @return None
+ * @brief Free a ClutterFilter constructed by clutterCreate()
+ * @author ericdvet */
+void clutterFree(ClutterFilter *clutter)
+{
+    if (clutter)
+    {
+        free(clutter->map);
+        free(clutter->mapf);
+        free(clutter->history);
+        free(clutter->historyf);
+        free(clutter->output);
+        free(clutter->outputf);
+        free(clutter);
+    }
+}
+
+// #define CLUTTER_TEST
+
+#ifdef CLUTTER_TEST
+#include <time.h>
+
+#define PI 3.14159265358979323846
+
+int main()
+{
+    int numFrames = 2000;
+    int numOfSamplers = 512;
+    int blockFrames = 64;
+    double tagFreq = 80.0 / 200;
+
+    // A strong drifting surface return at bin 100 over a weak tag at bin 300
+    double complex *framesBB = (double complex *)malloc((size_t)numFrames * numOfSamplers * sizeof(double complex));
+    float complex *framesBBf = (float complex *)malloc((size_t)numFrames * numOfSamplers * sizeof(float complex));
+    const char *names[3] = {"static", "adaptive", "MTI"};
+
+    for (int mode = CLUTTER_STATIC; mode <= CLUTTER_MTI; mode++)
+    {
+        for (int n = 0; n < numFrames; n++)
+        {
+            for (int i = 0; i < numOfSamplers; i++)
+            {
+                double complex surface = (i == 100 ? 1000.0 * (1 + 0.001 * n / numFrames) : 0);
+                double complex tag = (i == 300 ? cexp(I * 2 * PI * tagFreq * n) : 0);
+                framesBB[(size_t)n * numOfSamplers + i] = surface + tag + 0.01 * (rand() % 100);
+                framesBBf[(size_t)n * numOfSamplers + i] = (float complex)framesBB[(size_t)n * numOfSamplers + i];
+            }
+        }
+
+        ClutterFilter *clutter = clutterCreate(mode, numOfSamplers, 0);
+        clock_t start = clock();
+        for (int n = 0; n < numFrames; n += blockFrames)
+        {
+            clutterApply(clutter, &framesBB[(size_t)n * numOfSamplers], numFrames - n < blockFrames ? numFrames - n : blockFrames);
+        }
+        double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+        clutterReset(clutter);
+        for (int n = 0; n < numFrames; n += blockFrames)
+        {
+            clutterApplyf(clutter, &framesBBf[(size_t)n * numOfSamplers], numFrames - n < blockFrames ? numFrames - n : blockFrames);
+        }
+
+        // Residual surface power and tag amplitude after the map has settled
+        double surface = 0, tagAmplitude = 0, maxErrorf = 0;
+        for (int n = CLUTTER_STATIC_FRAMES; n < numFrames; n++)
+        {
+            surface += pow(cabs(framesBB[(size_t)n * numOfSamplers + 100]), 2);
+            tagAmplitude += cabs(framesBB[(size_t)n * numOfSamplers + 300]);
+            for (int i = 0; i < numOfSamplers; i++)
+            {
+                maxErrorf = fmax(maxErrorf, cabs(framesBB[(size_t)n * numOfSamplers + i] - framesBBf[(size_t)n * numOfSamplers + i]));
+            }
+        }
+        int settled = numFrames - CLUTTER_STATIC_FRAMES;
+        printf("%-8s clutter map over %d frames: %f ms, surface residual %.3g (was 1e6), tag amplitude %.3f, float error %g\n",
+               names[mode], numFrames, elapsed * 1000, surface / settled, tagAmplitude / settled, maxErrorf);
+        clutterFree(clutter);
+    }
+
+    free(framesBB);
+    free(framesBBf);
+    return 0;
+}
+#endif
@@ -0,0 +1,100 @@
+/*
+ * File:   clutter.h
+ * Author: ericdvet
+ *
+ * Clutter removal from blocks of baseband frames before the slow-time transform, the static, adaptive and
+ * MTI clutter maps of the FlatEarth cluttermap library (static.h, adaptive.h, MTI.h) on the host
+ */
+
+#ifndef CLUTTER_H
+#define CLUTTER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <complex.h>
+
+// Clutter maps of clutterCreate()
+#define CLUTTER_STATIC 0   // mean of the first CLUTTER_STATIC_FRAMES frames, then held
+#define CLUTTER_ADAPTIVE 1 // exponential average that keeps following the clutter
+#define CLUTTER_MTI 2      // binomial canceller over the last CLUTTER_MTI_PULSES frames
+
+// Frames averaged into the static clutter map, as clutterFrames in rangingDemo.c
+#define CLUTTER_STATIC_FRAMES 100
+
+// Default adaptation rate of the adaptive clutter map, the fraction of the map kept every frame
+#define CLUTTER_ADAPTIVE_BETA 0.9
+
+// Pulses of the MTI canceller, (1, -2, 1) like the 3 pulse MTI filter of MTI.h
+#define CLUTTER_MTI_PULSES 3
+
+/**
+ * @struct ClutterFilter
+ * @brief Clutter map and frame history carried from one block of frames to the next
+ * @author ericdvet */
+typedef struct
+{
+    int mode;
+    int numOfSamplers;
+    double beta;
+    double weights[CLUTTER_MTI_PULSES]; // MTI weights, weights[k] applied to the frame k frames back
+    double *map;                        // clutter map as interleaved I/Q, 2 x numOfSamplers
+    float *mapf;
+    double *history;                    // last CLUTTER_MTI_PULSES - 1 frames, a ring of 2 x numOfSamplers rows
+    float *historyf;
+    double *output;                     // one MTI output frame
+    float *outputf;
+    int numSeen;                        // frames filtered since the last clutterReset()
+    bool useAVX;                        // run the AVX kernels, set by clutterCreate() on CPUs that have AVX
+} ClutterFilter;
+
+/**
+ * @function clutterCreate(int mode, int numOfSamplers, double beta)
+ * @param mode - CLUTTER_STATIC, CLUTTER_ADAPTIVE or CLUTTER_MTI
+ * @param numOfSamplers - Number of range bins per frame
+ * @param beta - Adaptation rate of CLUTTER_ADAPTIVE in (0, 1), 0 for CLUTTER_ADAPTIVE_BETA. Ignored by the other maps
+ * @return ClutterFilter *
+ * @brief Creates an empty clutter map, so it is built from the first frames of the capture
+ * @author ericdvet */
+ClutterFilter *clutterCreate(int mode, int numOfSamplers, double beta);
+
+/**
+ * @function clutterReset(ClutterFilter *clutter)
+ * @param clutter - Filter created by clutterCreate()
+ * @return None
+ * @brief Clears the clutter map and frame history for a new capture
+ * @author ericdvet */
+void clutterReset(ClutterFilter *clutter);
+
+/**
+ * @function clutterApply(ClutterFilter *clutter, double complex *framesBB, int numFrames)
+ * @param clutter - Filter created by clutterCreate()
+ * @param framesBB - Next baseband frames of the capture (numFrames x numOfSamplers), decluttered in place
+ * @param numFrames - Number of frames in the block
+ * @return None
+ * @brief Updates the clutter map with every frame and removes it, in frame order, so a capture can be fed
+ *      block by block. Every frame is processed across all range bins at once. The static map is the
+ *      running mean until CLUTTER_STATIC_FRAMES frames are in, and the first CLUTTER_MTI_PULSES - 1
+ *      frames out of the MTI canceller are zero
+ * @author ericdvet */
+void clutterApply(ClutterFilter *clutter, double complex *framesBB, int numFrames);
+
+/**
+ * @function clutterApplyf(ClutterFilter *clutter, float complex *framesBB, int numFrames)
+ * @param clutter - Filter created by clutterCreate()
+ * @param framesBB - Next baseband frames of the capture (numFrames x numOfSamplers), decluttered in place
+ * @param numFrames - Number of frames in the block
+ * @return None
+ * @brief Single precision clutterApply()
+ * @author ericdvet */
+void clutterApplyf(ClutterFilter *clutter, float complex *framesBB, int numFrames);
+
+/**
+ * @function clutterFree(ClutterFilter *clutter)
+ * @param clutter - ClutterFilter to free
+ * @return None
+ * @brief Free a ClutterFilter constructed by clutterCreate()
+ * @author ericdvet */
+void clutterFree(ClutterFilter *clutter);
+
+#endif // CLUTTER_H
@@ -0,0 +1,222 @@
+/*
+ * File:   cwtfft.c
+ * Author: ericdvet
+ *
+ * Continuous wavelet transform computed in the frequency domain with precomputed wavelet spectra
+ */
+
+#include "cwtfft.h"
+#include <math.h>
+#include <string.h>
+
+/**
+ * @function cwtPlanCreate(int signalLength, int dogOrder, int numScales, double s0, double ds)
+ * @param signalLength - Number of samples of the signals to transform
+ * @param dogOrder - Derivative order of the DoG wavelet (even, 2 is the Mexican hat)
+ * @param numScales - Number of scales
+ * @param s0 - Smallest scale in samples
+ * @param ds - Linear spacing between scales in samples
+ * @return CWTPlan *
+ * @brief Precomputes the wavelet spectra of all scales and plans one forward FFT and a batched inverse
+ *      FFT over all scales. Matches wavelib's cwt_init("dog", dogOrder, signalLength, 1, numScales)
+ *      with setCWTScales(s0, ds, "linear", 1)
+ * @author ericdvet */
+CWTPlan *cwtPlanCreate(int signalLength, int dogOrder, int numScales, double s0, double ds)
+{
+    if (signalLength < 2 || numScales < 1 || dogOrder < 2 || dogOrder % 2 != 0)
+    {
+        fprintf(stderr, "ERROR: Invalid CWT parameters\n");
+        return NULL;
+    }
+
+    CWTPlan *plan = (CWTPlan *)calloc(1, sizeof(CWTPlan));
+    if (!plan)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        return NULL;
+    }
+    plan->signalLength = signalLength;
+    plan->numScales = numScales;
+
+    // Zero padding to the power of two chosen by wavelib
+    plan->npad = (int)pow(2.0, 1 + (int)(0.499999 + log((double)signalLength) / log(2.0)));
+    int npad = plan->npad;
+    int numFreqs = npad / 2 + 1;
+
+    plan->scales = (double *)malloc(numScales * sizeof(double));
+    plan->daughters = (double *)malloc((size_t)numScales * numFreqs * sizeof(double));
+    plan->signal = (double *)fftw_malloc(npad * sizeof(double));
+    plan->signalFT = (fftw_complex *)fftw_malloc(numFreqs * sizeof(fftw_complex));
+    plan->products = (fftw_complex *)fftw_malloc((size_t)numScales * numFreqs * sizeof(fftw_complex));
+    plan->output = (double *)fftw_malloc((size_t)numScales * npad * sizeof(double));
+    if (!plan->scales || !plan->daughters || !plan->signal || !plan->signalFT || !plan->products || !plan->output)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        cwtPlanFree(plan);
+        return NULL;
+    }
+
+    // DoG spectrum -(i^m) / sqrt(gamma(m + 1/2)) * (s k)^m * exp(-(s k)^2 / 2), normalized to unit energy at
+    // each scale (Torrence and Compo). Real because m is even, so only k >= 0 is stored. The 1 / npad of the
+    // inverse FFT is folded in
+    double sign = (dogOrder / 2) % 2 == 0 ? -1.0 : 1.0;
+    double dk = 2.0 * M_PI / npad;
+    for (int j = 0; j < numScales; j++)
+    {
+        double scale = s0 + j * ds;
+        double norm = sign * sqrt(2.0 * M_PI * scale) / sqrt(tgamma(dogOrder + 0.5)) / npad;
+        plan->scales[j] = scale;
+        for (int k = 0; k < numFreqs; k++)
+        {
+            double sk = scale * k * dk;
+            plan->daughters[(size_t)j * numFreqs + k] = norm * pow(sk, dogOrder) * exp(-0.5 * sk * sk);
+        }
+    }
+
+    int n[] = {npad};
+    plan->forward = fftw_plan_dft_r2c_1d(npad, plan->signal, plan->signalFT, FFTW_MEASURE);
+    plan->inverse = fftw_plan_many_dft_c2r(1, n, numScales, plan->products, NULL, 1, numFreqs, plan->output, NULL, 1, npad, FFTW_MEASURE);
+    if (!plan->forward || !plan->inverse)
+    {
+        fprintf(stderr, "ERROR: Unable to plan CWT FFTs\n");
+        cwtPlanFree(plan);
+        return NULL;
+    }
+
+    return plan;
+}
+
+/**
+ * @function cwtPlanExecute(CWTPlan *plan, const double *signal)
+ * @param plan - Plan created by cwtPlanCreate()
+ * @param signal - Real signal (signalLength)
+ * @return const double *
+ * @brief Continuous wavelet transform of the signal. Scale j of the result starts at j * npad and its
+ *      first signalLength samples are the coefficients. The result is overwritten by the next call
+ * @author ericdvet */
+const double *cwtPlanExecute(CWTPlan *plan, const double *signal)
+{
+    int signalLength = plan->signalLength;
+    int npad = plan->npad;
+    int numFreqs = npad / 2 + 1;
+
+    // Remove the mean and zero pad
+    double mean = 0;
+    for (int i = 0; i < signalLength; i++)
+    {
+        mean += signal[i];
+    }
+    mean /= signalLength;
+    for (int i = 0; i < signalLength; i++)
+    {
+        plan->signal[i] = signal[i] - mean;
+    }
+    memset(&plan->signal[signalLength], 0, (npad - signalLength) * sizeof(double));
+
+    fftw_execute(plan->forward);
+
+    // One spectrum per scale, then every scale is inverted by a single batched plan
+    const double *signalFT = (const double *)plan->signalFT;
+    for (int j = 0; j < plan->numScales; j++)
+    {
+        const double *daughter = &plan->daughters[(size_t)j * numFreqs];
+        double *product = (double *)&plan->products[(size_t)j * numFreqs];
+        for (int k = 0; k < numFreqs; k++)
+        {
+            product[2 * k] = daughter[k] * signalFT[2 * k];
+            product[2 * k + 1] = daughter[k] * signalFT[2 * k + 1];
+        }
+    }
+
+    fftw_execute(plan->inverse);
+    return plan->output;
+}
+
+/**
+ * @function cwtPlanFree(CWTPlan *plan)
+ * @param plan - CWTPlan to free
+ * @return None
+ * @brief Free a CWTPlan constructed by cwtPlanCreate()
+ * @author ericdvet */
+void cwtPlanFree(CWTPlan *plan)
+{
+    if (plan)
+    {
+        if (plan->forward)
+        {
+            fftw_destroy_plan(plan->forward);
+        }
+        if (plan->inverse)
+        {
+            fftw_destroy_plan(plan->inverse);
+        }
+        free(plan->scales);
+        free(plan->daughters);
+        fftw_free(plan->signal);
+        fftw_free(plan->signalFT);
+        fftw_free(plan->products);
+        fftw_free(plan->output);
+        free(plan);
+    }
+}
+
+// #define CWTFFT_TEST
+
+#ifdef CWTFFT_TEST
+#include <time.h>
+#include "wavelib/header/wavelib.h"
+
+int main()
+{
+    int signalLength = 512;
+    int numScales = 32;
+    int numRuns = 1000;
+    double *signal = (double *)malloc(signalLength * sizeof(double));
+    for (int i = 0; i < signalLength; i++)
+    {
+        signal[i] = exp(-pow(i - 300, 2) / 200.0) + 0.3 * exp(-pow(i - 120, 2) / 50.0) + 0.001 * (rand() % 100);
+    }
+
+    CWTPlan *plan = cwtPlanCreate(signalLength, 2, numScales, 1, 2);
+
+    // Compare against wavelib
+    cwt_object cwtInfo = cwt_init("dog", 2, signalLength, 1, numScales);
+    setCWTScales(cwtInfo, 1, 2, "linear", 1);
+    cwt(cwtInfo, signal);
+    const double *output = cwtPlanExecute(plan, signal);
+    double maxCoeff = 0;
+    double maxError = 0;
+    for (int j = 0; j < numScales; j++)
+    {
+        for (int i = 0; i < signalLength; i++)
+        {
+            maxCoeff = fmax(maxCoeff, fabs(cwtInfo->output[j * signalLength + i].re));
+            maxError = fmax(maxError, fabs(cwtInfo->output[j * signalLength + i].re - output[j * plan->npad + i]));
+        }
+    }
+    printf("Max error against wavelib: %g (%g of peak)\n", maxError, maxError / maxCoeff);
+    cwt_free(cwtInfo);
+
+    clock_t start = clock();
+    for (int run = 0; run < numRuns; run++)
+    {
+        cwtInfo = cwt_init("dog", 2, signalLength, 1, numScales);
+        setCWTScales(cwtInfo, 1, 2, "linear", 1);
+        cwt(cwtInfo, signal);
+        cwt_free(cwtInfo);
+    }
+    double wavelibTime = (double)(clock() - start) / CLOCKS_PER_SEC / numRuns;
+
+    start = clock();
+    for (int run = 0; run < numRuns; run++)
+    {
+        cwtPlanExecute(plan, signal);
+    }
+    double planTime = (double)(clock() - start) / CLOCKS_PER_SEC / numRuns;
+    printf("wavelib: %g s per transform, CWTPlan: %g s per transform\n", wavelibTime, planTime);
+
+    cwtPlanFree(plan);
+    free(signal);
+    return 0;
+}
+#endif
@@ -0,0 +1,68 @@
+/*
+ * File:   cwtfft.h
+ * Author: ericdvet
+ *
+ * Continuous wavelet transform computed in the frequency domain with precomputed wavelet spectra
+ */
+
+#ifndef CWTFFT_H
+#define CWTFFT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <complex.h>
+#include <fftw3.h>
+
+/**
+ * @struct CWTPlan
+ * @brief Derivative of Gaussian wavelet spectra for every scale and the FFT plans that apply them,
+ *      created once and reused for every signal of the same length
+ * @author ericdvet */
+typedef struct
+{
+    int signalLength;
+    int numScales;
+    int npad;
+    double *scales;
+    double *daughters;
+    double *signal;
+    fftw_complex *signalFT;
+    fftw_complex *products;
+    double *output;
+    fftw_plan forward;
+    fftw_plan inverse;
+} CWTPlan;
+
+/**
+ * @function cwtPlanCreate(int signalLength, int dogOrder, int numScales, double s0, double ds)
+ * @param signalLength - Number of samples of the signals to transform
+ * @param dogOrder - Derivative order of the DoG wavelet (even, 2 is the Mexican hat)
+ * @param numScales - Number of scales
+ * @param s0 - Smallest scale in samples
+ * @param ds - Linear spacing between scales in samples
+ * @return CWTPlan *
+ * @brief Precomputes the wavelet spectra of all scales and plans one forward FFT and a batched inverse
+ *      FFT over all scales. Matches wavelib's cwt_init("dog", dogOrder, signalLength, 1, numScales)
+ *      with setCWTScales(s0, ds, "linear", 1)
+ * @author ericdvet */
+CWTPlan *cwtPlanCreate(int signalLength, int dogOrder, int numScales, double s0, double ds);
+
+/**
+ * @function cwtPlanExecute(CWTPlan *plan, const double *signal)
+ * @param plan - Plan created by cwtPlanCreate()
+ * @param signal - Real signal (signalLength)
+ * @return const double *
+ * @brief Continuous wavelet transform of the signal. Scale j of the result starts at j * npad and its
+ *      first signalLength samples are the coefficients. The result is overwritten by the next call
+ * @author ericdvet */
+const double *cwtPlanExecute(CWTPlan *plan, const double *signal);
+
+/**
+ * @function cwtPlanFree(CWTPlan *plan)
+ * @param plan - CWTPlan to free
+ * @return None
+ * @brief Free a CWTPlan constructed by cwtPlanCreate()
+ * @author ericdvet */
+void cwtPlanFree(CWTPlan *plan);
+
+#endif // CWTFFT_H
@@ -0,0 +1,273 @@
+/*
+ * File:   czt.c
+ * Author: ericdvet
+ *
+ * Chirp-Z zoom of the slow-time spectrum, a dense frequency grid over a narrow band for every range bin
+ */
+
+#include "czt.h"
+#include "utils.h"
+#include <math.h>
+#include <string.h>
+
+#define PI 3.14159265358979323846
+
+/**
+ * @function cztChirp(double stepFreq, double n)
+ * @param stepFreq - Grid spacing in cycles per frame
+ * @param n - Index, squared in the phase
+ * @return double complex
+ * @brief exp(-j pi stepFreq n^2), with the phase reduced before the exponential so large n stay accurate
+ * @author ericdvet */
+static double complex cztChirp(double stepFreq, double n)
+{
+    double phase = fmod(stepFreq * n * n, 2.0);
+    return cos(PI * phase) - I * sin(PI * phase);
+}
+
+/**
+ * @function cztPlanCreate(int numFrames, int numOfSamplers, double startFreq, double stepFreq, int numPoints)
+ * @param numFrames - Frames in the capture
+ * @param numOfSamplers - Number of range bins per frame
+ * @param startFreq - First frequency of the grid in cycles per frame (tagHz / frameRate)
+ * @param stepFreq - Grid spacing in cycles per frame, usually a fraction of 1 / numFrames
+ * @param numPoints - Number of grid frequencies
+ * @return CZTPlan *
+ * @brief Precomputes the chirps and the kernel spectrum once, so each capture costs one batched forward
+ *      and inverse FFT of fftLength >= numFrames + numPoints - 1 over all range bins
+ * @author ericdvet */
+CZTPlan *cztPlanCreate(int numFrames, int numOfSamplers, double startFreq, double stepFreq, int numPoints)
+{
+    if (numFrames < 1 || numOfSamplers < 1 || numPoints < 1 || stepFreq <= 0)
+    {
+        fprintf(stderr, "ERROR: Invalid chirp-Z transform\n");
+        return NULL;
+    }
+
+    CZTPlan *plan = (CZTPlan *)calloc(1, sizeof(CZTPlan));
+    if (!plan)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        return NULL;
+    }
+    plan->numFrames = numFrames;
+    plan->numOfSamplers = numOfSamplers;
+    plan->numPoints = numPoints;
+    plan->startFreq = startFreq;
+    plan->stepFreq = stepFreq;
+    plan->fftLength = fftFastLength(numFrames + numPoints - 1);
+    int fftLength = plan->fftLength;
+
+    plan->preChirp = (double complex *)malloc(numFrames * sizeof(double complex));
+    plan->postChirp = (double complex *)malloc(numPoints * sizeof(double complex));
+    plan->kernelFT = (double complex *)fftw_malloc(fftLength * sizeof(double complex));
+    plan->work = (double complex *)fftw_malloc((size_t)fftLength * numOfSamplers * sizeof(double complex));
+    if (!plan->preChirp || !plan->postChirp || !plan->kernelFT || !plan->work)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        cztPlanFree(plan);
+        return NULL;
+    }
+
+    // Frame-major like the capture, so every range bin is one strided transform of the same plan
+    fftw_complex *work = (fftw_complex *)plan->work;
+    plan->forward = fftw_plan_many_dft(1, &fftLength, numOfSamplers, work, NULL, numOfSamplers, 1, work, NULL, numOfSamplers, 1,
+                                       FFTW_FORWARD, FFTW_MEASURE);
+    plan->inverse = fftw_plan_many_dft(1, &fftLength, numOfSamplers, work, NULL, numOfSamplers, 1, work, NULL, numOfSamplers, 1,
+                                       FFTW_BACKWARD, FFTW_MEASURE);
+    fftw_plan kernelPlan = fftw_plan_dft_1d(fftLength, (fftw_complex *)plan->kernelFT, (fftw_complex *)plan->kernelFT, FFTW_FORWARD,
+                                            FFTW_ESTIMATE);
+    if (!plan->forward || !plan->inverse || !kernelPlan)
+    {
+        fprintf(stderr, "ERROR: Unable to plan chirp-Z FFTs\n");
+        if (kernelPlan)
+        {
+            fftw_destroy_plan(kernelPlan);
+        }
+        cztPlanFree(plan);
+        return NULL;
+    }
+
+    // X(k) = W^(k^2/2) sum_n [x(n) A^-n W^(n^2/2)] W^(-(k-n)^2/2) with A = exp(j 2 pi startFreq) and
+    // W = exp(-j 2 pi stepFreq), a convolution done with FFTs
+    for (int n = 0; n < numFrames; n++)
+    {
+        double startPhase = fmod(startFreq * n, 1.0);
+        plan->preChirp[n] = (cos(2 * PI * startPhase) - I * sin(2 * PI * startPhase)) * cztChirp(stepFreq, n);
+    }
+    for (int k = 0; k < numPoints; k++)
+    {
+        plan->postChirp[k] = cztChirp(stepFreq, k) / fftLength;
+    }
+    memset(plan->kernelFT, 0, fftLength * sizeof(double complex));
+    for (int l = 0; l < numPoints; l++)
+    {
+        plan->kernelFT[l] = conj(cztChirp(stepFreq, l));
+    }
+    for (int l = 1; l < numFrames; l++)
+    {
+        plan->kernelFT[fftLength - l] = conj(cztChirp(stepFreq, l));
+    }
+    fftw_execute(kernelPlan);
+    fftw_destroy_plan(kernelPlan);
+
+    return plan;
+}
+
+/**
+ * @function cztPlanLoad(CZTPlan *plan, const double complex *framesBB, int numFrames, int frameOffset)
+ * @param plan - Plan created by cztPlanCreate()
+ * @param framesBB - Baseband frames (numFrames x numOfSamplers)
+ * @param numFrames - Number of frames in the block
+ * @param frameOffset - Index of the block's first frame in the capture
+ * @return None
+ * @brief Multiplies a block of frames by the pre-chirp into the plan's work buffer, so the capture can be
+ *      loaded block by block as it is downconverted
+ * @author ericdvet */
+void cztPlanLoad(CZTPlan *plan, const double complex *framesBB, int numFrames, int frameOffset)
+{
+    int numOfSamplers = plan->numOfSamplers;
+    for (int n = 0; n < numFrames && frameOffset + n < plan->numFrames; n++)
+    {
+        double complex chirp = plan->preChirp[frameOffset + n];
+        const double complex *frame = &framesBB[(size_t)n * numOfSamplers];
+        double complex *row = &plan->work[(size_t)(frameOffset + n) * numOfSamplers];
+        for (int i = 0; i < numOfSamplers; i++)
+        {
+            row[i] = frame[i] * chirp;
+        }
+    }
+}
+
+/**
+ * @function cztPlanExecute(CZTPlan *plan)
+ * @param plan - Plan holding a whole capture loaded by cztPlanLoad()
+ * @return const double complex *
+ * @brief Returns the spectrum at startFreq + k * stepFreq, numPoints x numOfSamplers laid out like
+ *      computeFFT()'s output and scaled like it. Valid until the plan is loaded again
+ * @author ericdvet */
+const double complex *cztPlanExecute(CZTPlan *plan)
+{
+    int numOfSamplers = plan->numOfSamplers;
+    memset(&plan->work[(size_t)plan->numFrames * numOfSamplers], 0,
+           (size_t)(plan->fftLength - plan->numFrames) * numOfSamplers * sizeof(double complex));
+
+    fftw_execute(plan->forward);
+    for (int l = 0; l < plan->fftLength; l++)
+    {
+        double complex kernel = plan->kernelFT[l];
+        double complex *row = &plan->work[(size_t)l * numOfSamplers];
+        for (int i = 0; i < numOfSamplers; i++)
+        {
+            row[i] *= kernel;
+        }
+    }
+    fftw_execute(plan->inverse);
+
+    // The first numPoints rows of the circular convolution are the linear one
+    for (int k = 0; k < plan->numPoints; k++)
+    {
+        double complex chirp = plan->postChirp[k];
+        double complex *row = &plan->work[(size_t)k * numOfSamplers];
+        for (int i = 0; i < numOfSamplers; i++)
+        {
+            row[i] *= chirp;
+        }
+    }
+    return plan->work;
+}
+
+/**
+ * @function cztPlanFree(CZTPlan *plan)
+ * @param plan - CZTPlan to free
+ * @return None
+ * @brief Free a CZTPlan constructed by cztPlanCreate()
+ * @author ericdvet */
+void cztPlanFree(CZTPlan *plan)
+{
+    if (plan)
+    {
+        if (plan->forward)
+        {
+            fftw_destroy_plan(plan->forward);
+        }
+        if (plan->inverse)
+        {
+            fftw_destroy_plan(plan->inverse);
+        }
+        free(plan->preChirp);
+        free(plan->postChirp);
+        fftw_free(plan->kernelFT);
+        fftw_free(plan->work);
+        free(plan);
+    }
+}
+
+// #define CZT_TEST
+
+#ifdef CZT_TEST
+#include <time.h>
+
+int main()
+{
+    int numFrames = 2000;
+    int numOfSamplers = 512;
+    int numPoints = 64;
+    double tagFreq = 80.37 / 200;
+    double startFreq = tagFreq - 2.5 / numFrames;
+    double stepFreq = 5.0 / numFrames / numPoints;
+
+    double complex *framesBB = (double complex *)malloc((size_t)numFrames * numOfSamplers * sizeof(double complex));
+    for (int n = 0; n < numFrames; n++)
+    {
+        for (int i = 0; i < numOfSamplers; i++)
+        {
+            framesBB[(size_t)n * numOfSamplers + i] = cexp(I * 2 * PI * tagFreq * n) * exp(-pow(i - 200, 2) / 50.0) +
+                                                      0.01 * (rand() % 100) + 0.01 * I * (rand() % 100);
+        }
+    }
+
+    CZTPlan *plan = cztPlanCreate(numFrames, numOfSamplers, startFreq, stepFreq, numPoints);
+
+    // Load in blocks as a stream would
+    clock_t start = clock();
+    for (int n = 0; n < numFrames; n += 64)
+    {
+        cztPlanLoad(plan, &framesBB[(size_t)n * numOfSamplers], numFrames - n < 64 ? numFrames - n : 64, n);
+    }
+    const double complex *zoomFT = cztPlanExecute(plan);
+    double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    // Compare every grid point against a direct DFT at a few range bins
+    double maxError = 0;
+    double maxZoom = 0;
+    int peakPoint = 0;
+    int testBins[3] = {0, 200, 511};
+    for (int k = 0; k < numPoints; k++)
+    {
+        double freq = startFreq + k * stepFreq;
+        for (int b = 0; b < 3; b++)
+        {
+            double complex direct = 0;
+            for (int n = 0; n < numFrames; n++)
+            {
+                direct += framesBB[(size_t)n * numOfSamplers + testBins[b]] * cexp(-I * 2 * PI * fmod(freq * n, 1.0));
+            }
+            maxError = fmax(maxError, cabs(direct - zoomFT[(size_t)k * numOfSamplers + testBins[b]]));
+        }
+        if (cabs(zoomFT[(size_t)k * numOfSamplers + 200]) > maxZoom)
+        {
+            maxZoom = cabs(zoomFT[(size_t)k * numOfSamplers + 200]);
+            peakPoint = k;
+        }
+    }
+
+    printf("Chirp-Z of %d points over %d range bins: %f ms, FFT length %d\n", numPoints, numOfSamplers, elapsed * 1000, plan->fftLength);
+    printf("Max error against direct DFT %g, peak %.3f Hz (tag at %.3f Hz), peak magnitude %f of %d\n", maxError,
+           (startFreq + peakPoint * stepFreq) * 200, tagFreq * 200, maxZoom, numFrames);
+
+    cztPlanFree(plan);
+    free(framesBB);
+    return 0;
+}
+#endif
@@ -0,0 +1,78 @@
+/*
+ * File:   czt.h
+ * Author: ericdvet
+ *
+ * Chirp-Z zoom of the slow-time spectrum, a dense frequency grid over a narrow band for every range bin
+ */
+
+#ifndef CZT_H
+#define CZT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <complex.h>
+#include <fftw3.h>
+
+/**
+ * @struct CZTPlan
+ * @brief Chirp tables, kernel spectrum and batched FFTs of a Bluestein chirp-Z transform over every range bin
+ * @author ericdvet */
+typedef struct
+{
+    int numFrames;
+    int numOfSamplers;
+    int numPoints;
+    double startFreq;
+    double stepFreq;
+    int fftLength;
+    double complex *preChirp;
+    double complex *postChirp;
+    double complex *kernelFT;
+    double complex *work;
+    fftw_plan forward;
+    fftw_plan inverse;
+} CZTPlan;
+
+/**
+ * @function cztPlanCreate(int numFrames, int numOfSamplers, double startFreq, double stepFreq, int numPoints)
+ * @param numFrames - Frames in the capture
+ * @param numOfSamplers - Number of range bins per frame
+ * @param startFreq - First frequency of the grid in cycles per frame (tagHz / frameRate)
+ * @param stepFreq - Grid spacing in cycles per frame, usually a fraction of 1 / numFrames
+ * @param numPoints - Number of grid frequencies
+ * @return CZTPlan *
+ * @brief Precomputes the chirps and the kernel spectrum once, so each capture costs one batched forward
+ *      and inverse FFT of fftLength >= numFrames + numPoints - 1 over all range bins
+ * @author ericdvet */
+CZTPlan *cztPlanCreate(int numFrames, int numOfSamplers, double startFreq, double stepFreq, int numPoints);
+
+/**
+ * @function cztPlanLoad(CZTPlan *plan, const double complex *framesBB, int numFrames, int frameOffset)
+ * @param plan - Plan created by cztPlanCreate()
+ * @param framesBB - Baseband frames (numFrames x numOfSamplers)
+ * @param numFrames - Number of frames in the block
+ * @param frameOffset - Index of the block's first frame in the capture
+ * @return None
+ * @brief Multiplies a block of frames by the pre-chirp into the plan's work buffer, so the capture can be
+ *      loaded block by block as it is downconverted
+ * @author ericdvet */
+void cztPlanLoad(CZTPlan *plan, const double complex *framesBB, int numFrames, int frameOffset);
+
+/**
+ * @function cztPlanExecute(CZTPlan *plan)
+ * @param plan - Plan holding a whole capture loaded by cztPlanLoad()
+ * @return const double complex *
+ * @brief Returns the spectrum at startFreq + k * stepFreq, numPoints x numOfSamplers laid out like
+ *      computeFFT()'s output and scaled like it. Valid until the plan is loaded again
+ * @author ericdvet */
+const double complex *cztPlanExecute(CZTPlan *plan);
+
+/**
+ * @function cztPlanFree(CZTPlan *plan)
+ * @param plan - CZTPlan to free
+ * @return None
+ * @brief Free a CZTPlan constructed by cztPlanCreate()
+ * @author ericdvet */
+void cztPlanFree(CZTPlan *plan);
+
+#endif // CZT_H
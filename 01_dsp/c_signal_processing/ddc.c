@@ -0,0 +1,663 @@
+/*
+ * File:   ddc.c
+ * Author: ericdvet
+ *
+ * Precomputed digital downconversion (DDC) plans for processing blocks of radar frames
+ */
+
+#include "ddc.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#define PI 3.14159265358979323846
+
+/**
+ * @function ddcPlanCreate(double CF, double Fs, int frameSize, int decimation)
+ * @param CF - Center frequency of the radar in Hz
+ * @param Fs - Sampling rate of the radar in Hz
+ * @param frameSize - Number of samplers per frame
+ * @param decimation - Keep every decimation-th baseband sample (1 keeps all of them)
+ * @return DDCPlan *
+ * @brief Precomputes the local oscillator and the normalized Hamming low-pass filter used by NoveldaDDC().
+ *      Baseband sample m of a decimating plan corresponds to sampler m * decimation
+ * @author ericdvet */
+DDCPlan *ddcPlanCreate(double CF, double Fs, int frameSize, int decimation)
+{
+    if (decimation < 1 || decimation > frameSize)
+    {
+        fprintf(stderr, "ERROR: Invalid decimation factor %d\n", decimation);
+        return NULL;
+    }
+
+    DDCPlan *plan = (DDCPlan *)calloc(1, sizeof(DDCPlan));
+    if (!plan)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure");
+        return NULL;
+    }
+
+    int M = 20;
+#if defined(__SSE2__)
+    plan->useAVX = __builtin_cpu_supports("avx");
+#endif
+    plan->frameSize = frameSize;
+    plan->decimation = decimation;
+    plan->outputSize = (frameSize + decimation - 1) / decimation;
+    plan->mixSize = frameSize;
+    plan->filterSize = M + 1;
+    plan->lo = (double *)malloc(2 * frameSize * sizeof(double));
+    plan->filterWeights = (double *)malloc(plan->filterSize * sizeof(double));
+    plan->mixed = (double *)calloc(2 * (frameSize + plan->filterSize - 1), sizeof(double));
+    plan->lof = (float *)malloc(2 * frameSize * sizeof(float));
+    plan->filterWeightsf = (float *)malloc(plan->filterSize * sizeof(float));
+    plan->mixedf = (float *)calloc(2 * (frameSize + plan->filterSize - 1), sizeof(float));
+    if (!plan->lo || !plan->filterWeights || !plan->mixed || !plan->lof || !plan->filterWeightsf || !plan->mixedf)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure");
+        ddcPlanFree(plan);
+        return NULL;
+    }
+
+    // Complex sinusoid LO (local oscillator), interleaved as (sin, cos) pairs
+    double freqIndex = CF / Fs * frameSize;
+    for (int i = 0; i < frameSize; i++)
+    {
+        double t = (double)i / (frameSize - 1);
+        plan->lo[2 * i] = sin(2 * PI * freqIndex * t);
+        plan->lo[2 * i + 1] = cos(2 * PI * freqIndex * t);
+    }
+
+    // Hamming low-pass, normalized the same way as NoveldaDDC()
+    double window[M + 1];
+    hamming(window, M);
+    double sum = 0.0;
+    for (int i = 0; i <= M / 2; i++)
+    {
+        sum += window[i];
+    }
+    for (int i = 0; i <= M; i++)
+    {
+        plan->filterWeights[i] = window[i] / sum;
+    }
+
+    // Single precision copies for ddcProcessBlockf(), rounded from the double tables
+    for (int i = 0; i < 2 * frameSize; i++)
+    {
+        plan->lof[i] = (float)plan->lo[i];
+    }
+    for (int i = 0; i <= M; i++)
+    {
+        plan->filterWeightsf[i] = (float)plan->filterWeights[i];
+    }
+
+    return plan;
+}
+
+/**
+ * @function ddcPlanWindow(DDCPlan *plan, int outputStart, int outputSize)
+ * @param plan - Plan created by ddcPlanCreate()
+ * @param outputStart - First baseband sample kept, in decimated samples
+ * @param outputSize - Number of baseband samples kept
+ * @return int
+ * @brief Restricts the plan to a window of range bins. Only the samplers the filter needs for those
+ *      outputs are mixed and only those outputs are filtered, so they match the same bins of the whole
+ *      frame exactly. Returns 0 on success, -1 for a window outside the frame
+ * @author ericdvet */
+int ddcPlanWindow(DDCPlan *plan, int outputStart, int outputSize)
+{
+    int fullSize = (plan->frameSize + plan->decimation - 1) / plan->decimation;
+    if (outputStart < 0 || outputSize < 1 || outputStart + outputSize > fullSize)
+    {
+        fprintf(stderr, "ERROR: Invalid DDC window %d + %d\n", outputStart, outputSize);
+        return -1;
+    }
+
+    int halfFilter = plan->filterSize / 2;
+    int mixStart = outputStart * plan->decimation - halfFilter;
+    int mixEnd = (outputStart + outputSize - 1) * plan->decimation + halfFilter + 1;
+    plan->outputStart = outputStart;
+    plan->outputSize = outputSize;
+    plan->mixStart = mixStart > 0 ? mixStart : 0;
+    plan->mixSize = (mixEnd < plan->frameSize ? mixEnd : plan->frameSize) - plan->mixStart;
+    return 0;
+}
+
+#if defined(__SSE2__)
+/**
+ * @function ddcMixAVX(const double *rfSignal, const double *lo, double mean, double *mixed, int i, int mixEnd)
+ * @param rfSignal - One raw radar frame
+ * @param lo - Local oscillator (sin, cos) pairs
+ * @param mean - Mean of the frame
+ * @param mixed - Resulting interleaved I/Q samples
+ * @param i - First sampler to mix
+ * @param mixEnd - One past the last sampler to mix
+ * @return int
+ * @brief AVX loop of ddcMix(), compiled for AVX whatever the build flags and only run on CPUs that have
+ *      it. Returns the first sampler left for the scalar tail
+ * @author ericdvet */
+static __attribute__((target("avx"))) int ddcMixAVX(const double *rfSignal, const double *lo, double mean, double *mixed, int i, int mixEnd)
+{
+    __m256d meanVec = _mm256_set1_pd(mean);
+    for (; i + 4 <= mixEnd; i += 4)
+    {
+        __m256d x = _mm256_sub_pd(_mm256_loadu_pd(&rfSignal[i]), meanVec);
+        // (x0, x1, x2, x3) -> (x0, x0, x1, x1) and (x2, x2, x3, x3) to line up with the (sin, cos) pairs
+        __m256d xLow = _mm256_unpacklo_pd(x, x);
+        __m256d xHigh = _mm256_unpackhi_pd(x, x);
+        __m256d x01 = _mm256_permute2f128_pd(xLow, xHigh, 0x20);
+        __m256d x23 = _mm256_permute2f128_pd(xLow, xHigh, 0x31);
+        _mm256_storeu_pd(&mixed[2 * i], _mm256_mul_pd(x01, _mm256_loadu_pd(&lo[2 * i])));
+        _mm256_storeu_pd(&mixed[2 * i + 4], _mm256_mul_pd(x23, _mm256_loadu_pd(&lo[2 * i + 4])));
+    }
+    return i;
+}
+#endif
+
+/**
+ * @function ddcMix(const DDCPlan *plan, const double *rfSignal, double *mixed)
+ * @param plan - Plan created by ddcPlanCreate()
+ * @param rfSignal - One raw radar frame
+ * @param mixed - Resulting interleaved I/Q samples
+ * @return None
+ * @brief Removes the frame mean and multiplies by the local oscillator
+ * @author ericdvet */
+static void ddcMix(const DDCPlan *plan, const double *rfSignal, double *mixed)
+{
+    int frameSize = plan->frameSize;
+    const double *lo = plan->lo;
+
+    double mean = 0.0;
+    for (int i = 0; i < frameSize; i++)
+    {
+        mean += rfSignal[i];
+    }
+    mean /= frameSize;
+
+    // Only the samples the filter reads for the outputs kept by ddcPlanWindow() are mixed
+    int i = plan->mixStart;
+    int mixEnd = plan->mixStart + plan->mixSize;
+#if defined(__SSE2__)
+    if (plan->useAVX)
+    {
+        i = ddcMixAVX(rfSignal, lo, mean, mixed, i, mixEnd);
+    }
+    for (; i < mixEnd; i++)
+    {
+        __m128d x = _mm_set1_pd(rfSignal[i] - mean);
+        _mm_storeu_pd(&mixed[2 * i], _mm_mul_pd(x, _mm_loadu_pd(&lo[2 * i])));
+    }
+#endif
+    for (; i < mixEnd; i++)
+    {
+        double x = rfSignal[i] - mean;
+        mixed[2 * i] = x * lo[2 * i];
+        mixed[2 * i + 1] = x * lo[2 * i + 1];
+    }
+}
+
+#if defined(__SSE2__)
+/**
+ * @function ddcFilterAVX(const DDCPlan *plan, const double *padded, double *baseband)
+ * @param plan - Plan created by ddcPlanCreate()
+ * @param padded - Mixed interleaved I/Q samples with filterSize / 2 zero samples on either side
+ * @param baseband - Resulting filtered interleaved I/Q samples
+ * @return int
+ * @brief AVX loop of ddcFilter(). Returns the first output left for the scalar tail
+ * @author ericdvet */
+static __attribute__((target("avx"))) int ddcFilterAVX(const DDCPlan *plan, const double *padded, double *baseband)
+{
+    int length = 2 * plan->outputSize;
+    const double *w = plan->filterWeights;
+
+    int d = 0;
+    for (; d + 4 <= length; d += 4)
+    {
+        __m256d acc = _mm256_setzero_pd();
+        for (int j = 0; j < plan->filterSize; j++)
+        {
+            acc = _mm256_add_pd(acc, _mm256_mul_pd(_mm256_loadu_pd(&padded[d + 2 * j]), _mm256_set1_pd(w[j])));
+        }
+        _mm256_storeu_pd(&baseband[d], acc);
+    }
+    return d;
+}
+#endif
+
+/**
+ * @function ddcFilter(const DDCPlan *plan, const double *padded, double *baseband)
+ * @param plan - Plan created by ddcPlanCreate()
+ * @param padded - Mixed interleaved I/Q samples with filterSize / 2 zero samples on either side
+ * @param baseband - Resulting filtered interleaved I/Q samples
+ * @return None
+ * @brief Convolves the mixed signal with the low-pass filter. The weights are real, so I and Q are
+ *      filtered together as one interleaved real sequence with a tap stride of two
+ * @author ericdvet */
+static void ddcFilter(const DDCPlan *plan, const double *padded, double *baseband)
+{
+    int length = 2 * plan->outputSize;
+    const double *w = plan->filterWeights;
+
+    int d = 0;
+#if defined(__SSE2__)
+    if (plan->useAVX)
+    {
+        d = ddcFilterAVX(plan, padded, baseband);
+    }
+    for (; d + 2 <= length; d += 2)
+    {
+        __m128d acc = _mm_setzero_pd();
+        for (int j = 0; j < plan->filterSize; j++)
+        {
+            acc = _mm_add_pd(acc, _mm_mul_pd(_mm_loadu_pd(&padded[d + 2 * j]), _mm_set1_pd(w[j])));
+        }
+        _mm_storeu_pd(&baseband[d], acc);
+    }
+#endif
+    for (; d < length; d++)
+    {
+        double acc = 0.0;
+        for (int j = 0; j < plan->filterSize; j++)
+        {
+            acc += padded[d + 2 * j] * w[j];
+        }
+        baseband[d] = acc;
+    }
+}
+
+/**
+ * @function ddcFilterDecimate(const DDCPlan *plan, const double *padded, double *baseband)
+ * @param plan - Plan created by ddcPlanCreate() with a decimation factor above one
+ * @param padded - Mixed interleaved I/Q samples with filterSize / 2 zero samples on either side
+ * @param baseband - Resulting filtered and decimated interleaved I/Q samples
+ * @return None
+ * @brief Mix-filter-decimate in polyphase form: the filter is only evaluated at every decimation-th
+ *      sample, so the discarded outputs are never computed
+ * @author ericdvet */
+static void ddcFilterDecimate(const DDCPlan *plan, const double *padded, double *baseband)
+{
+    const double *w = plan->filterWeights;
+
+    for (int m = 0; m < plan->outputSize; m++)
+    {
+        const double *x = &padded[2 * m * plan->decimation];
+#if defined(__SSE2__)
+        // One I/Q pair per register, the taps of each output are contiguous pairs
+        __m128d acc = _mm_setzero_pd();
+        for (int j = 0; j < plan->filterSize; j++)
+        {
+            acc = _mm_add_pd(acc, _mm_mul_pd(_mm_loadu_pd(&x[2 * j]), _mm_set1_pd(w[j])));
+        }
+        _mm_storeu_pd(&baseband[2 * m], acc);
+#else
+        double accRe = 0.0;
+        double accIm = 0.0;
+        for (int j = 0; j < plan->filterSize; j++)
+        {
+            accRe += x[2 * j] * w[j];
+            accIm += x[2 * j + 1] * w[j];
+        }
+        baseband[2 * m] = accRe;
+        baseband[2 * m + 1] = accIm;
+#endif
+    }
+}
+
+/**
+ * @function ddcProcessBlock(DDCPlan *plan, const double *rfFrames, double complex *basebandFrames, int numFrames)
+ * @param plan - Plan created by ddcPlanCreate()
+ * @param rfFrames - Raw radar frames (numFrames x frameSize)
+ * @param basebandFrames - Resulting digitally downconverted frames (numFrames x outputSize)
+ * @param numFrames - Number of frames in the block
+ * @return None
+ * @brief Applies NoveldaDDC() to a block of frames with vectorized mix and filter kernels. Decimating
+ *      plans only evaluate the filter at the retained outputs
+ * @author ericdvet */
+void ddcProcessBlock(DDCPlan *plan, const double *rfFrames, double complex *basebandFrames, int numFrames)
+{
+    int frameSize = plan->frameSize;
+    // The zero padding either side of the mixed samples stays zero between frames
+    double *mixed = plan->mixed + 2 * (plan->filterSize / 2);
+
+    // Output m reads padded samples from 2 * (outputStart + m) * decimation on
+    const double *padded = plan->mixed + 2 * (size_t)plan->outputStart * plan->decimation;
+
+    for (int i = 0; i < numFrames; i++)
+    {
+        ddcMix(plan, &rfFrames[(size_t)i * frameSize], mixed);
+        if (plan->decimation == 1)
+        {
+            ddcFilter(plan, padded, (double *)&basebandFrames[(size_t)i * plan->outputSize]);
+        }
+        else
+        {
+            ddcFilterDecimate(plan, padded, (double *)&basebandFrames[(size_t)i * plan->outputSize]);
+        }
+    }
+}
+
+#if defined(__SSE2__)
+/**
+ * @function ddcMixAVXf(const float *rfSignal, const float *lo, float mean, float *mixed, int i, int mixEnd)
+ * @param rfSignal - One raw radar frame
+ * @param lo - Local oscillator (sin, cos) pairs
+ * @param mean - Mean of the frame
+ * @param mixed - Resulting interleaved I/Q samples
+ * @param i - First sampler to mix
+ * @param mixEnd - One past the last sampler to mix
+ * @return int
+ * @brief Single precision ddcMixAVX()
+ * @author ericdvet */
+static __attribute__((target("avx"))) int ddcMixAVXf(const float *rfSignal, const float *lo, float mean, float *mixed, int i, int mixEnd)
+{
+    __m256 meanVec = _mm256_set1_ps(mean);
+    for (; i + 8 <= mixEnd; i += 8)
+    {
+        __m256 x = _mm256_sub_ps(_mm256_loadu_ps(&rfSignal[i]), meanVec);
+        // (x0 .. x7) -> (x0, x0, .. x3, x3) and (x4, x4, .. x7, x7) to line up with the (sin, cos) pairs
+        __m256 xLow = _mm256_unpacklo_ps(x, x);
+        __m256 xHigh = _mm256_unpackhi_ps(x, x);
+        __m256 x0123 = _mm256_permute2f128_ps(xLow, xHigh, 0x20);
+        __m256 x4567 = _mm256_permute2f128_ps(xLow, xHigh, 0x31);
+        _mm256_storeu_ps(&mixed[2 * i], _mm256_mul_ps(x0123, _mm256_loadu_ps(&lo[2 * i])));
+        _mm256_storeu_ps(&mixed[2 * i + 8], _mm256_mul_ps(x4567, _mm256_loadu_ps(&lo[2 * i + 8])));
+    }
+    return i;
+}
+#endif
+
+/**
+ * @function ddcMixf(const DDCPlan *plan, const float *rfSignal, float *mixed)
+ * @param plan - Plan created by ddcPlanCreate()
+ * @param rfSignal - One raw radar frame
+ * @param mixed - Resulting interleaved I/Q samples
+ * @return None
+ * @brief Single precision ddcMix(). The mean is still accumulated in double
+ * @author ericdvet */
+static void ddcMixf(const DDCPlan *plan, const float *rfSignal, float *mixed)
+{
+    int frameSize = plan->frameSize;
+    const float *lo = plan->lof;
+
+    double sum = 0.0;
+    for (int i = 0; i < frameSize; i++)
+    {
+        sum += rfSignal[i];
+    }
+    float mean = (float)(sum / frameSize);
+
+    int i = plan->mixStart;
+    int mixEnd = plan->mixStart + plan->mixSize;
+#if defined(__SSE2__)
+    if (plan->useAVX)
+    {
+        i = ddcMixAVXf(rfSignal, lo, mean, mixed, i, mixEnd);
+    }
+    __m128 meanVec = _mm_set1_ps(mean);
+    for (; i + 4 <= mixEnd; i += 4)
+    {
+        __m128 x = _mm_sub_ps(_mm_loadu_ps(&rfSignal[i]), meanVec);
+        _mm_storeu_ps(&mixed[2 * i], _mm_mul_ps(_mm_unpacklo_ps(x, x), _mm_loadu_ps(&lo[2 * i])));
+        _mm_storeu_ps(&mixed[2 * i + 4], _mm_mul_ps(_mm_unpackhi_ps(x, x), _mm_loadu_ps(&lo[2 * i + 4])));
+    }
+#endif
+    for (; i < mixEnd; i++)
+    {
+        float x = rfSignal[i] - mean;
+        mixed[2 * i] = x * lo[2 * i];
+        mixed[2 * i + 1] = x * lo[2 * i + 1];
+    }
+}
+
+#if defined(__SSE2__)
+/**
+ * @function ddcFilterAVXf(const DDCPlan *plan, const float *padded, float *baseband)
+ * @param plan - Plan created by ddcPlanCreate()
+ * @param padded - Mixed interleaved I/Q samples with filterSize / 2 zero samples on either side
+ * @param baseband - Resulting filtered interleaved I/Q samples
+ * @return int
+ * @brief Single precision ddcFilterAVX()
+ * @author ericdvet */
+static __attribute__((target("avx"))) int ddcFilterAVXf(const DDCPlan *plan, const float *padded, float *baseband)
+{
+    int length = 2 * plan->outputSize;
+    const float *w = plan->filterWeightsf;
+
+    int d = 0;
+    for (; d + 8 <= length; d += 8)
+    {
+        __m256 acc = _mm256_setzero_ps();
+        for (int j = 0; j < plan->filterSize; j++)
+        {
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(&padded[d + 2 * j]), _mm256_set1_ps(w[j])));
+        }
+        _mm256_storeu_ps(&baseband[d], acc);
+    }
+    return d;
+}
+#endif
+
+/**
+ * @function ddcFilterf(const DDCPlan *plan, const float *padded, float *baseband)
+ * @param plan - Plan created by ddcPlanCreate()
+ * @param padded - Mixed interleaved I/Q samples with filterSize / 2 zero samples on either side
+ * @param baseband - Resulting filtered interleaved I/Q samples
+ * @return None
+ * @brief Single precision ddcFilter(), twice as many samples per register
+ * @author ericdvet */
+static void ddcFilterf(const DDCPlan *plan, const float *padded, float *baseband)
+{
+    int length = 2 * plan->outputSize;
+    const float *w = plan->filterWeightsf;
+
+    int d = 0;
+#if defined(__SSE2__)
+    if (plan->useAVX)
+    {
+        d = ddcFilterAVXf(plan, padded, baseband);
+    }
+    for (; d + 4 <= length; d += 4)
+    {
+        __m128 acc = _mm_setzero_ps();
+        for (int j = 0; j < plan->filterSize; j++)
+        {
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(&padded[d + 2 * j]), _mm_set1_ps(w[j])));
+        }
+        _mm_storeu_ps(&baseband[d], acc);
+    }
+#endif
+    for (; d < length; d++)
+    {
+        float acc = 0.0f;
+        for (int j = 0; j < plan->filterSize; j++)
+        {
+            acc += padded[d + 2 * j] * w[j];
+        }
+        baseband[d] = acc;
+    }
+}
+
+/**
+ * @function ddcFilterDecimatef(const DDCPlan *plan, const float *padded, float *baseband)
+ * @param plan - Plan created by ddcPlanCreate() with a decimation factor above one
+ * @param padded - Mixed interleaved I/Q samples with filterSize / 2 zero samples on either side
+ * @param baseband - Resulting filtered and decimated interleaved I/Q samples
+ * @return None
+ * @brief Single precision ddcFilterDecimate()
+ * @author ericdvet */
+static void ddcFilterDecimatef(const DDCPlan *plan, const float *padded, float *baseband)
+{
+    const float *w = plan->filterWeightsf;
+
+    for (int m = 0; m < plan->outputSize; m++)
+    {
+        const float *x = &padded[2 * m * plan->decimation];
+        float accRe = 0.0f;
+        float accIm = 0.0f;
+        for (int j = 0; j < plan->filterSize; j++)
+        {
+            accRe += x[2 * j] * w[j];
+            accIm += x[2 * j + 1] * w[j];
+        }
+        baseband[2 * m] = accRe;
+        baseband[2 * m + 1] = accIm;
+    }
+}
+
+/**
+ * @function ddcProcessBlockf(DDCPlan *plan, const float *rfFrames, float complex *basebandFrames, int numFrames)
+ * @param plan - Plan created by ddcPlanCreate()
+ * @param rfFrames - Raw radar frames (numFrames x frameSize)
+ * @param basebandFrames - Resulting digitally downconverted frames (numFrames x outputSize)
+ * @param numFrames - Number of frames in the block
+ * @return None
+ * @brief Single precision ddcProcessBlock()
+ * @author ericdvet */
+void ddcProcessBlockf(DDCPlan *plan, const float *rfFrames, float complex *basebandFrames, int numFrames)
+{
+    int frameSize = plan->frameSize;
+    float *mixed = plan->mixedf + 2 * (plan->filterSize / 2);
+
+    const float *padded = plan->mixedf + 2 * (size_t)plan->outputStart * plan->decimation;
+
+    for (int i = 0; i < numFrames; i++)
+    {
+        ddcMixf(plan, &rfFrames[(size_t)i * frameSize], mixed);
+        if (plan->decimation == 1)
+        {
+            ddcFilterf(plan, padded, (float *)&basebandFrames[(size_t)i * plan->outputSize]);
+        }
+        else
+        {
+            ddcFilterDecimatef(plan, padded, (float *)&basebandFrames[(size_t)i * plan->outputSize]);
+        }
+    }
+}
+
+/**
+ * @function ddcPlanFree(DDCPlan *plan)
+ * @param plan - DDCPlan to free
+ * @return None
+ * @brief Free a DDCPlan constructed by ddcPlanCreate()
+ * @author ericdvet */
+void ddcPlanFree(DDCPlan *plan)
+{
+    if (plan)
+    {
+        free(plan->lo);
+        free(plan->filterWeights);
+        free(plan->mixed);
+        free(plan->lof);
+        free(plan->filterWeightsf);
+        free(plan->mixedf);
+        free(plan);
+    }
+}
+
+// #define DDC_TEST
+
+#ifdef DDC_TEST
+int main()
+{
+    int frameSize = 512;
+    int numFrames = 8;
+    double *rfFrames = (double *)malloc(numFrames * frameSize * sizeof(double));
+    double complex *basebandFrames = (double complex *)malloc(numFrames * frameSize * sizeof(double complex));
+    double complex *reference = (double complex *)malloc(frameSize * sizeof(double complex));
+
+    for (int i = 0; i < numFrames * frameSize; i++)
+    {
+        rfFrames[i] = 4096 + 100 * sin(0.3 * i) + (rand() % 50);
+    }
+
+    DDCPlan *plan = ddcPlanCreate(CHIPOTLE_CF, CHIPOTLE_FS, frameSize, 1);
+    ddcProcessBlock(plan, rfFrames, basebandFrames, numFrames);
+
+    double maxError = 0;
+    for (int i = 0; i < numFrames; i++)
+    {
+        NoveldaDDC(&rfFrames[i * frameSize], reference);
+        for (int j = 0; j < frameSize; j++)
+        {
+            maxError = fmax(maxError, cabs(reference[j] - basebandFrames[i * frameSize + j]));
+        }
+    }
+    printf("Max error against NoveldaDDC(): %g\n", maxError);
+    ddcPlanFree(plan);
+
+    int decimation = 4;
+    plan = ddcPlanCreate(CHIPOTLE_CF, CHIPOTLE_FS, frameSize, decimation);
+    ddcProcessBlock(plan, rfFrames, basebandFrames, numFrames);
+    maxError = 0;
+    for (int i = 0; i < numFrames; i++)
+    {
+        NoveldaDDC(&rfFrames[i * frameSize], reference);
+        for (int m = 0; m < plan->outputSize; m++)
+        {
+            maxError = fmax(maxError, cabs(reference[m * decimation] - basebandFrames[i * plan->outputSize + m]));
+        }
+    }
+    printf("Max error of decimated output: %g\n", maxError);
+
+    // A window of range bins, double and single precision, against the same bins of the whole frame
+    int windowStart = 37;
+    int windowSize = 50;
+    ddcPlanWindow(plan, windowStart, windowSize);
+    float *rfWindowf = (float *)malloc(numFrames * frameSize * sizeof(float));
+    float complex *windowf = (float complex *)malloc(numFrames * windowSize * sizeof(float complex));
+    for (int i = 0; i < numFrames * frameSize; i++)
+    {
+        rfWindowf[i] = (float)rfFrames[i];
+    }
+    ddcProcessBlock(plan, rfFrames, basebandFrames, numFrames);
+    ddcProcessBlockf(plan, rfWindowf, windowf, numFrames);
+    maxError = 0;
+    double maxErrorf = 0;
+    for (int i = 0; i < numFrames; i++)
+    {
+        NoveldaDDC(&rfFrames[i * frameSize], reference);
+        for (int m = 0; m < windowSize; m++)
+        {
+            maxError = fmax(maxError, cabs(reference[(windowStart + m) * decimation] - basebandFrames[i * windowSize + m]));
+            maxErrorf = fmax(maxErrorf, cabs(reference[(windowStart + m) * decimation] - windowf[i * windowSize + m]));
+        }
+    }
+    printf("Max error of windowed output: %g (single precision %g), %d of %d samplers mixed\n", maxError, maxErrorf, plan->mixSize,
+           frameSize);
+    free(rfWindowf);
+    free(windowf);
+    ddcPlanFree(plan);
+
+    float *rfFramesf = (float *)malloc(numFrames * frameSize * sizeof(float));
+    float complex *basebandFramesf = (float complex *)malloc(numFrames * frameSize * sizeof(float complex));
+    for (int i = 0; i < numFrames * frameSize; i++)
+    {
+        rfFramesf[i] = (float)rfFrames[i];
+    }
+    plan = ddcPlanCreate(CHIPOTLE_CF, CHIPOTLE_FS, frameSize, 1);
+    ddcProcessBlock(plan, rfFrames, basebandFrames, numFrames);
+    ddcProcessBlockf(plan, rfFramesf, basebandFramesf, numFrames);
+    maxError = 0;
+    double maxMagnitude = 0;
+    for (int i = 0; i < numFrames * frameSize; i++)
+    {
+        maxError = fmax(maxError, cabs(basebandFrames[i] - basebandFramesf[i]));
+        maxMagnitude = fmax(maxMagnitude, cabs(basebandFrames[i]));
+    }
+    printf("Max error of single precision output: %g (relative %g)\n", maxError, maxError / maxMagnitude);
+    ddcPlanFree(plan);
+    free(rfFramesf);
+    free(basebandFramesf);
+    free(rfFrames);
+    free(basebandFrames);
+    free(reference);
+    return 0;
+}
+#endif
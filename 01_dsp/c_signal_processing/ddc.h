@@ -0,0 +1,97 @@
+/*
+ * File:   ddc.h
+ * Author: ericdvet
+ *
+ * Precomputed digital downconversion (DDC) plans for processing blocks of radar frames
+ */
+
+#ifndef DDC_H
+#define DDC_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <complex.h>
+
+// Chipotle chip parameters used by NoveldaDDC()
+#define CHIPOTLE_CF 1.8E9
+#define CHIPOTLE_FS 3.9E10
+
+/**
+ * @struct DDCPlan
+ * @brief Local oscillator, filter weights and scratch space reused for every frame of a capture
+ * @author ericdvet */
+typedef struct
+{
+    int frameSize;
+    int outputSize;
+    int outputStart; // first baseband sample kept, set by ddcPlanWindow()
+    int decimation;
+    int filterSize;
+    int mixStart;    // samplers mixed, the ones the filter reads for the kept outputs
+    int mixSize;
+    double *lo;
+    double *filterWeights;
+    double *mixed;
+    float *lof;
+    float *filterWeightsf;
+    float *mixedf;
+    bool useAVX;     // run the AVX kernels, set by ddcPlanCreate() on CPUs that have AVX
+} DDCPlan;
+
+/**
+ * @function ddcPlanCreate(double CF, double Fs, int frameSize, int decimation)
+ * @param CF - Center frequency of the radar in Hz
+ * @param Fs - Sampling rate of the radar in Hz
+ * @param frameSize - Number of samplers per frame
+ * @param decimation - Keep every decimation-th baseband sample (1 keeps all of them)
+ * @return DDCPlan *
+ * @brief Precomputes the local oscillator and the normalized Hamming low-pass filter used by NoveldaDDC().
+ *      Baseband sample m of a decimating plan corresponds to sampler m * decimation
+ * @author ericdvet */
+DDCPlan *ddcPlanCreate(double CF, double Fs, int frameSize, int decimation);
+
+/**
+ * @function ddcPlanWindow(DDCPlan *plan, int outputStart, int outputSize)
+ * @param plan - Plan created by ddcPlanCreate()
+ * @param outputStart - First baseband sample kept, in decimated samples
+ * @param outputSize - Number of baseband samples kept
+ * @return int
+ * @brief Restricts the plan to a window of range bins. Only the samplers the filter needs for those
+ *      outputs are mixed and only those outputs are filtered, so they match the same bins of the whole
+ *      frame exactly. Returns 0 on success, -1 for a window outside the frame
+ * @author ericdvet */
+int ddcPlanWindow(DDCPlan *plan, int outputStart, int outputSize);
+
+/**
+ * @function ddcProcessBlock(DDCPlan *plan, const double *rfFrames, double complex *basebandFrames, int numFrames)
+ * @param plan - Plan created by ddcPlanCreate()
+ * @param rfFrames - Raw radar frames (numFrames x frameSize)
+ * @param basebandFrames - Resulting digitally downconverted frames (numFrames x outputSize)
+ * @param numFrames - Number of frames in the block
+ * @return None
+ * @brief Applies NoveldaDDC() to a block of frames with vectorized mix and filter kernels. Decimating
+ *      plans only evaluate the filter at the retained outputs
+ * @author ericdvet */
+void ddcProcessBlock(DDCPlan *plan, const double *rfFrames, double complex *basebandFrames, int numFrames);
+
+/**
+ * @function ddcProcessBlockf(DDCPlan *plan, const float *rfFrames, float complex *basebandFrames, int numFrames)
+ * @param plan - Plan created by ddcPlanCreate()
+ * @param rfFrames - Raw radar frames (numFrames x frameSize)
+ * @param basebandFrames - Resulting digitally downconverted frames (numFrames x outputSize)
+ * @param numFrames - Number of frames in the block
+ * @return None
+ * @brief Single precision ddcProcessBlock(), with twice the samples per vector register
+ * @author ericdvet */
+void ddcProcessBlockf(DDCPlan *plan, const float *rfFrames, float complex *basebandFrames, int numFrames);
+
+/**
+ * @function ddcPlanFree(DDCPlan *plan)
+ * @param plan - DDCPlan to free
+ * @return None
+ * @brief Free a DDCPlan constructed by ddcPlanCreate()
+ * @author ericdvet */
+void ddcPlanFree(DDCPlan *plan);
+
+#endif // DDC_H
@@ -0,0 +1,958 @@
+/*
+ * File:   fixed.c
+ * Author: ericdvet
+ *
+ * Fixed-point normalization, DDC, targeted slow-time DFT and peak search for running on the radar's
+ * BeagleBone. Frames are Q15 int16 from the counters to the DFT, the DFT accumulates in int64 and
+ * magnitudes are taken in Q31. The mixing, filter, DFT and magnitude kernels use NEON when built for the
+ * radar (-mfpu=neon) and give the same bits as their scalar loops
+ */
+
+#include "fixed.h"
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define PI 3.14159265358979323846
+
+/**
+ * @function fixedSaturate(int32_t value)
+ * @param value - Value to store
+ * @return int16_t
+ * @brief Clamps to the int16 range
+ * @author ericdvet */
+static int16_t fixedSaturate(int32_t value)
+{
+    return (int16_t)(value > INT16_MAX ? INT16_MAX : value < INT16_MIN ? INT16_MIN : value);
+}
+
+/**
+ * @function fixedQ15(double value)
+ * @param value - Value in [-1, 1]
+ * @return int16_t
+ * @brief Rounds to Q15, saturating 1 to 32767
+ * @author ericdvet */
+static int16_t fixedQ15(double value)
+{
+    return fixedSaturate((int32_t)lround(fmax(-1.0, fmin(1.0, value)) * 32768.0));
+}
+
+/**
+ * @function fixedNormalize(const RadarCapture *capture, int frame, int16_t *rfSignal)
+ * @param capture - Capture mapped by salsaMap()
+ * @param frame - Index of the frame to normalize
+ * @param rfSignal - Resulting numOfSamplers DAC values with FIXED_DAC_FRAC fractional bits
+ * @return bool
+ * @brief Converts one mapped frame to DAC values, rounded to nearest. Returns true if the frame holds the
+ *      counter spike, tested as counter / countsPerStep * dacStep + dacMin > FIXED_SPIKE_DAC on integers
+ * @author ericdvet */
+static bool fixedNormalize(const RadarCapture *capture, int frame, int16_t *rfSignal)
+{
+    const uint32_t *counters = capture->counters + (size_t)frame * capture->numOfSamplers;
+    int64_t countsPerStep = capture->countsPerStep;
+    int64_t spikeCounts = (int64_t)(FIXED_SPIKE_DAC - capture->dacMin) * countsPerStep;
+    int32_t offset = capture->dacMin * (1 << FIXED_DAC_FRAC);
+    bool spike = false;
+
+    for (int j = 0; j < capture->numOfSamplers; j++)
+    {
+        int64_t scaled = (int64_t)counters[j] * capture->dacStep;
+        spike = spike || scaled > spikeCounts;
+        // Counters and steps are non-negative, so adding half a step before dividing rounds to nearest
+        int32_t value = (int32_t)(((scaled << (FIXED_DAC_FRAC + 1)) + countsPerStep) / (2 * countsPerStep)) + offset;
+        rfSignal[j] = fixedSaturate(value);
+    }
+    return spike;
+}
+
+/**
+ * @function fixedFrame(const RadarCapture *capture, int frame, int16_t *rfSignal)
+ * @param capture - Capture mapped by salsaMap()
+ * @param frame - Index of the frame to normalize
+ * @param rfSignal - Resulting numOfSamplers DAC values with FIXED_DAC_FRAC fractional bits
+ * @return None
+ * @brief Integer salsaFrame(). Each value is salsaFrame()'s rounded to the nearest 2^-FIXED_DAC_FRAC,
+ *      and the spike test is done on the exact integer counters, so the same frames are replaced
+ * @author ericdvet */
+void fixedFrame(const RadarCapture *capture, int frame, int16_t *rfSignal)
+{
+    // Process out the weird spike
+    while (fixedNormalize(capture, frame, rfSignal))
+    {
+        if (frame == 0)
+        {
+            if (capture->numFrames > 1)
+            {
+                fixedNormalize(capture, 1, rfSignal);
+            }
+            return;
+        }
+        frame--;
+    }
+}
+
+/**
+ * @function fixedDDCCreate(const DDCPlan *plan)
+ * @param plan - Plan created by ddcPlanCreate(), possibly windowed by ddcPlanWindow()
+ * @return FixedDDCPlan *
+ * @brief Rounds the plan's local oscillator and filter weights to Q15. NULL on error
+ * @author ericdvet */
+FixedDDCPlan *fixedDDCCreate(const DDCPlan *plan)
+{
+    FixedDDCPlan *fixed = (FixedDDCPlan *)calloc(1, sizeof(FixedDDCPlan));
+    if (!fixed)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        return NULL;
+    }
+    fixed->frameSize = plan->frameSize;
+    fixed->outputSize = plan->outputSize;
+    fixed->outputStart = plan->outputStart;
+    fixed->decimation = plan->decimation;
+    fixed->filterSize = plan->filterSize;
+    fixed->mixStart = plan->mixStart;
+    fixed->mixSize = plan->mixSize;
+    fixed->lo = (int16_t *)malloc(2 * plan->frameSize * sizeof(int16_t));
+    fixed->filterWeights = (int16_t *)malloc(plan->filterSize * sizeof(int16_t));
+    fixed->pairWeights = (int16_t *)malloc(2 * plan->filterSize * sizeof(int16_t));
+    fixed->mixed = (int16_t *)calloc(2 * (plan->frameSize + plan->filterSize - 1), sizeof(int16_t));
+    if (!fixed->lo || !fixed->filterWeights || !fixed->pairWeights || !fixed->mixed)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        fixedDDCFree(fixed);
+        return NULL;
+    }
+
+    for (int i = 0; i < 2 * plan->frameSize; i++)
+    {
+        fixed->lo[i] = fixedQ15(plan->lo[i]);
+    }
+
+    // The filter accumulator stays in int32 as long as the weights sum to less than 2
+    int32_t weightSum = 0;
+    for (int j = 0; j < plan->filterSize; j++)
+    {
+        fixed->filterWeights[j] = fixedQ15(plan->filterWeights[j]);
+        fixed->pairWeights[2 * j] = fixed->filterWeights[j];
+        fixed->pairWeights[2 * j + 1] = fixed->filterWeights[j];
+        weightSum += abs(fixed->filterWeights[j]);
+    }
+    if (weightSum >= 1 << 16)
+    {
+        fprintf(stderr, "ERROR: DDC filter gain too large for fixed point\n");
+        fixedDDCFree(fixed);
+        return NULL;
+    }
+
+    return fixed;
+}
+
+/**
+ * @function fixedMix(const FixedDDCPlan *plan, const int16_t *rfSignal, int16_t mean, int16_t *mixed)
+ * @param plan - Plan created by fixedDDCCreate()
+ * @param rfSignal - One frame normalized by fixedFrame()
+ * @param mean - Rounded mean of the frame
+ * @param mixed - Resulting interleaved I/Q samples
+ * @return None
+ * @brief Removes the frame mean and multiplies by the Q15 local oscillator with rounding. The DAC values
+ *      of fixedFrame() and their mean are non-negative int16, so both factors stay below 2^15
+ * @author ericdvet */
+static void fixedMix(const FixedDDCPlan *plan, const int16_t *rfSignal, int16_t mean, int16_t *mixed)
+{
+    const int16_t *lo = plan->lo;
+
+    // Only the samples the filter reads for the outputs kept by ddcPlanWindow() are mixed
+    int i = plan->mixStart;
+    int mixEnd = plan->mixStart + plan->mixSize;
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    int16x8_t meanVec = vdupq_n_s16(mean);
+    for (; i + 8 <= mixEnd; i += 8)
+    {
+        // (x0 .. x7) -> (x0, x0, .. x3, x3) and (x4, x4, .. x7, x7) to line up with the (sin, cos) pairs.
+        // vqrdmulh is (2 * x * lo + 2^15) >> 16, the same rounded Q15 product
+        int16x8_t x = vsubq_s16(vld1q_s16(&rfSignal[i]), meanVec);
+        int16x8x2_t pairs = vzipq_s16(x, x);
+        vst1q_s16(&mixed[2 * i], vqrdmulhq_s16(pairs.val[0], vld1q_s16(&lo[2 * i])));
+        vst1q_s16(&mixed[2 * i + 8], vqrdmulhq_s16(pairs.val[1], vld1q_s16(&lo[2 * i + 8])));
+    }
+#endif
+    for (; i < mixEnd; i++)
+    {
+        int32_t x = rfSignal[i] - mean;
+        mixed[2 * i] = (int16_t)((x * lo[2 * i] + (1 << 14)) >> 15);
+        mixed[2 * i + 1] = (int16_t)((x * lo[2 * i + 1] + (1 << 14)) >> 15);
+    }
+}
+
+/**
+ * @function fixedFilter(const FixedDDCPlan *plan, const int16_t *padded, int16_t *baseband)
+ * @param plan - Plan created by fixedDDCCreate()
+ * @param padded - Mixed interleaved I/Q samples from the first one output 0 reads
+ * @param baseband - Resulting filtered and decimated interleaved I/Q samples (2 * outputSize)
+ * @return None
+ * @brief Low-pass filters the mixed samples at the kept outputs. The Q15 weights sum below 2, so the
+ *      int32 accumulators cannot overflow, and outputs are rounded and saturated to int16
+ * @author ericdvet */
+static void fixedFilter(const FixedDDCPlan *plan, const int16_t *padded, int16_t *baseband)
+{
+    const int16_t *w = plan->filterWeights;
+
+    int m = 0;
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    if (plan->decimation == 1)
+    {
+        // Four outputs at a time, every tap multiplies eight interleaved samples by one weight.
+        // vqrshrn is the rounded, saturated shift of the scalar loop
+        for (; m + 4 <= plan->outputSize; m += 4)
+        {
+            const int16_t *x = &padded[2 * m];
+            int32x4_t accLow = vdupq_n_s32(0);
+            int32x4_t accHigh = vdupq_n_s32(0);
+            for (int j = 0; j < plan->filterSize; j++)
+            {
+                int16x8_t v = vld1q_s16(&x[2 * j]);
+                accLow = vmlal_n_s16(accLow, vget_low_s16(v), w[j]);
+                accHigh = vmlal_n_s16(accHigh, vget_high_s16(v), w[j]);
+            }
+            vst1q_s16(&baseband[2 * m], vcombine_s16(vqrshrn_n_s32(accLow, FIXED_BB_SHIFT), vqrshrn_n_s32(accHigh, FIXED_BB_SHIFT)));
+        }
+    }
+    else
+    {
+        // Decimated outputs are too far apart to load together, so four taps are taken at a time instead,
+        // as I/Q pairs against the paired weights (w0, w0, w1, w1, ...)
+        int vectorTaps = plan->filterSize / 4 * 4;
+        for (; m < plan->outputSize; m++)
+        {
+            const int16_t *x = &padded[2 * m * plan->decimation];
+            int32x4_t acc = vdupq_n_s32(0);
+            for (int j = 0; j < vectorTaps; j += 4)
+            {
+                int16x8_t v = vld1q_s16(&x[2 * j]);
+                int16x8_t pairWeights = vld1q_s16(&plan->pairWeights[2 * j]);
+                acc = vmlal_s16(acc, vget_low_s16(v), vget_low_s16(pairWeights));
+                acc = vmlal_s16(acc, vget_high_s16(v), vget_high_s16(pairWeights));
+            }
+            int32x2_t sum = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+            int32_t accRe = vget_lane_s32(sum, 0);
+            int32_t accIm = vget_lane_s32(sum, 1);
+            for (int j = vectorTaps; j < plan->filterSize; j++)
+            {
+                accRe += x[2 * j] * w[j];
+                accIm += x[2 * j + 1] * w[j];
+            }
+            baseband[2 * m] = fixedSaturate((accRe + (1 << (FIXED_BB_SHIFT - 1))) >> FIXED_BB_SHIFT);
+            baseband[2 * m + 1] = fixedSaturate((accIm + (1 << (FIXED_BB_SHIFT - 1))) >> FIXED_BB_SHIFT);
+        }
+    }
+#endif
+    for (; m < plan->outputSize; m++)
+    {
+        const int16_t *x = &padded[2 * m * plan->decimation];
+        int32_t accRe = 0;
+        int32_t accIm = 0;
+        for (int j = 0; j < plan->filterSize; j++)
+        {
+            accRe += x[2 * j] * w[j];
+            accIm += x[2 * j + 1] * w[j];
+        }
+        baseband[2 * m] = fixedSaturate((accRe + (1 << (FIXED_BB_SHIFT - 1))) >> FIXED_BB_SHIFT);
+        baseband[2 * m + 1] = fixedSaturate((accIm + (1 << (FIXED_BB_SHIFT - 1))) >> FIXED_BB_SHIFT);
+    }
+}
+
+/**
+ * @function fixedDDCProcessBlock(FixedDDCPlan *plan, const int16_t *rfFrames, int16_t *basebandFrames, int numFrames)
+ * @param plan - Plan created by fixedDDCCreate()
+ * @param rfFrames - Frames normalized by fixedFrame() (numFrames x frameSize)
+ * @param basebandFrames - Resulting interleaved I/Q frames (numFrames x 2 * outputSize), FIXED_BB_ONE per
+ *      unit of ddcProcessBlock()
+ * @param numFrames - Number of frames in the block
+ * @return None
+ * @brief ddcProcessBlock() in integer arithmetic: 16 x 16 bit products with rounding shifts, 32 bit
+ *      filter accumulators that cannot overflow and outputs saturated to int16
+ * @author ericdvet */
+void fixedDDCProcessBlock(FixedDDCPlan *plan, const int16_t *rfFrames, int16_t *basebandFrames, int numFrames)
+{
+    int frameSize = plan->frameSize;
+
+    // The zero padding either side of the mixed samples stays zero between frames
+    int16_t *mixed = plan->mixed + 2 * (plan->filterSize / 2);
+    const int16_t *padded = plan->mixed + 2 * (size_t)plan->outputStart * plan->decimation;
+
+    for (int n = 0; n < numFrames; n++)
+    {
+        const int16_t *rfSignal = &rfFrames[(size_t)n * frameSize];
+        int16_t *baseband = &basebandFrames[(size_t)n * 2 * plan->outputSize];
+
+        int64_t sum = 0;
+        for (int i = 0; i < frameSize; i++)
+        {
+            sum += rfSignal[i];
+        }
+        int16_t mean = (int16_t)((2 * sum + (sum >= 0 ? frameSize : -frameSize)) / (2 * frameSize));
+
+        fixedMix(plan, rfSignal, mean, mixed);
+        fixedFilter(plan, padded, baseband);
+    }
+}
+
+/**
+ * @function fixedDDCFree(FixedDDCPlan *plan)
+ * @param plan - FixedDDCPlan to free
+ * @return None
+ * @brief Free a FixedDDCPlan constructed by fixedDDCCreate()
+ * @author ericdvet */
+void fixedDDCFree(FixedDDCPlan *plan)
+{
+    if (plan)
+    {
+        free(plan->lo);
+        free(plan->filterWeights);
+        free(plan->pairWeights);
+        free(plan->mixed);
+        free(plan);
+    }
+}
+
+/**
+ * @function fixedSlowTimeWrap(int bin, int numFrames)
+ * @param bin - Frequency bin, possibly negative or past the end of the FFT
+ * @param numFrames - Length of the slow-time DFT
+ * @return int
+ * @brief Wraps a frequency bin into [0, numFrames)
+ * @author ericdvet */
+static int fixedSlowTimeWrap(int bin, int numFrames)
+{
+    bin %= numFrames;
+    return bin < 0 ? bin + numFrames : bin;
+}
+
+/**
+ * @function fixedSlowTimeCreate(int numFrames, int numOfSamplers, const int *bins, int numBins)
+ * @param numFrames - Length of the slow-time DFT (frames in the capture)
+ * @param numOfSamplers - Number of range bins per frame
+ * @param bins - Frequency bins to compute, as indices of the numFrames-point FFT (e.g. slowTimeTagBins())
+ * @param numBins - Number of frequency bins
+ * @return FixedSlowTimeDFT *
+ * @brief Integer slowTimeCreate()
+ * @author ericdvet */
+FixedSlowTimeDFT *fixedSlowTimeCreate(int numFrames, int numOfSamplers, const int *bins, int numBins)
+{
+    if (numFrames < 1 || numOfSamplers < 1 || numBins < 1)
+    {
+        fprintf(stderr, "ERROR: Invalid slow-time DFT size\n");
+        return NULL;
+    }
+
+    FixedSlowTimeDFT *dft = (FixedSlowTimeDFT *)calloc(1, sizeof(FixedSlowTimeDFT));
+    if (!dft)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        return NULL;
+    }
+    dft->numFrames = numFrames;
+    dft->numOfSamplers = numOfSamplers;
+
+    int minBin = numFrames;
+    int maxBin = -1;
+    for (int i = 0; i < numBins; i++)
+    {
+        int bin = fixedSlowTimeWrap(bins[i], numFrames);
+        minBin = bin < minBin ? bin : minBin;
+        maxBin = bin > maxBin ? bin : maxBin;
+    }
+    dft->minBin = minBin;
+    dft->binSpan = maxBin - minBin + 1;
+
+    dft->bins = (int *)malloc(numBins * sizeof(int));
+    dft->binIndex = (int *)malloc(dft->binSpan * sizeof(int));
+    dft->twiddle = (int16_t *)malloc(2 * (size_t)numFrames * sizeof(int16_t));
+    if (!dft->bins || !dft->binIndex || !dft->twiddle)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        fixedSlowTimeFree(dft);
+        return NULL;
+    }
+
+    // Map each requested bin to a row of the spectrum, skipping duplicates
+    for (int i = 0; i < dft->binSpan; i++)
+    {
+        dft->binIndex[i] = -1;
+    }
+    for (int i = 0; i < numBins; i++)
+    {
+        int bin = fixedSlowTimeWrap(bins[i], numFrames);
+        if (dft->binIndex[bin - minBin] < 0)
+        {
+            dft->binIndex[bin - minBin] = dft->numBins;
+            dft->bins[dft->numBins++] = bin;
+        }
+    }
+
+    // Roots of unity indexed by (bin * frame) mod numFrames, as slowTimeCreate()
+    for (int n = 0; n < numFrames; n++)
+    {
+        dft->twiddle[2 * n] = fixedQ15(cos(2 * PI * n / numFrames));
+        dft->twiddle[2 * n + 1] = fixedQ15(-sin(2 * PI * n / numFrames));
+    }
+
+    dft->spectrum = (int64_t *)calloc(2 * (size_t)dft->numBins * numOfSamplers, sizeof(int64_t));
+    dft->power = (uint64_t *)malloc(numOfSamplers * sizeof(uint64_t));
+    if (!dft->spectrum || !dft->power)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        fixedSlowTimeFree(dft);
+        return NULL;
+    }
+
+    return dft;
+}
+
+/**
+ * @function fixedAccumulateRow(int64_t *row, const int16_t *frame, int16_t wr, int16_t wi, int numOfSamplers)
+ * @param row - Spectrum of one frequency bin, interleaved I/Q (2 * numOfSamplers)
+ * @param frame - One baseband frame, interleaved I/Q (2 * numOfSamplers)
+ * @param wr - Real part of the frame's twiddle in Q15
+ * @param wi - Imaginary part of the frame's twiddle in Q15
+ * @param numOfSamplers - Number of range bins per frame
+ * @return None
+ * @brief row += (wr + i wi) * frame. |wr|, |wi| <= 2^15 - 1 and |x| <= 2^15, so each complex product is
+ *      exact in int32 before it is widened into the 64 bit row
+ * @author ericdvet */
+static void fixedAccumulateRow(int64_t *row, const int16_t *frame, int16_t wr, int16_t wi, int numOfSamplers)
+{
+    int i = 0;
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    for (; i + 4 <= numOfSamplers; i += 4)
+    {
+        // De-interleave four range bins, form their products in int32 and re-interleave them to widen into the row
+        int16x4x2_t x = vld2_s16(&frame[2 * i]);
+        int32x4_t re = vmlsl_n_s16(vmull_n_s16(x.val[0], wr), x.val[1], wi);
+        int32x4_t im = vmlal_n_s16(vmull_n_s16(x.val[1], wr), x.val[0], wi);
+        int32x4x2_t products = vzipq_s32(re, im);
+        vst1q_s64(&row[2 * i], vaddw_s32(vld1q_s64(&row[2 * i]), vget_low_s32(products.val[0])));
+        vst1q_s64(&row[2 * i + 2], vaddw_s32(vld1q_s64(&row[2 * i + 2]), vget_high_s32(products.val[0])));
+        vst1q_s64(&row[2 * i + 4], vaddw_s32(vld1q_s64(&row[2 * i + 4]), vget_low_s32(products.val[1])));
+        vst1q_s64(&row[2 * i + 6], vaddw_s32(vld1q_s64(&row[2 * i + 6]), vget_high_s32(products.val[1])));
+    }
+#endif
+    for (; i < numOfSamplers; i++)
+    {
+        int32_t xr = frame[2 * i];
+        int32_t xi = frame[2 * i + 1];
+        row[2 * i] += wr * xr - wi * xi;
+        row[2 * i + 1] += wr * xi + wi * xr;
+    }
+}
+
+/**
+ * @function fixedSlowTimeAccumulate(FixedSlowTimeDFT *dft, const int16_t *framesBB, int numFrames)
+ * @param dft - DFT created by fixedSlowTimeCreate()
+ * @param framesBB - Next baseband frames of fixedDDCProcessBlock() (numFrames x 2 * numOfSamplers)
+ * @param numFrames - Number of frames in the block
+ * @return None
+ * @brief Integer slowTimeAccumulate(). Blocks must be passed in capture order
+ * @author ericdvet */
+void fixedSlowTimeAccumulate(FixedSlowTimeDFT *dft, const int16_t *framesBB, int numFrames)
+{
+    int numOfSamplers = dft->numOfSamplers;
+
+    for (int b = 0; b < dft->numBins; b++)
+    {
+        int64_t *row = &dft->spectrum[2 * (size_t)b * numOfSamplers];
+        int step = dft->bins[b];
+        int phase = (int)(((long long)step * dft->frame) % dft->numFrames);
+
+        for (int n = 0; n < numFrames; n++)
+        {
+            fixedAccumulateRow(row, &framesBB[2 * (size_t)n * numOfSamplers], dft->twiddle[2 * phase], dft->twiddle[2 * phase + 1],
+                               numOfSamplers);
+
+            phase += step;
+            if (phase >= dft->numFrames)
+            {
+                phase -= dft->numFrames;
+            }
+        }
+    }
+
+    dft->frame += numFrames;
+}
+
+/**
+ * @function fixedSlowTimeRow(const FixedSlowTimeDFT *dft, int bin)
+ * @param dft - DFT created by fixedSlowTimeCreate()
+ * @param bin - Frequency bin, as an index of the numFrames-point FFT
+ * @return const int64_t *
+ * @brief Integer slowTimeBin(), the interleaved I/Q row of one frequency bin. NULL if it was not requested
+ * @author ericdvet */
+static const int64_t *fixedSlowTimeRow(const FixedSlowTimeDFT *dft, int bin)
+{
+    bin = fixedSlowTimeWrap(bin, dft->numFrames) - dft->minBin;
+    if (bin < 0 || bin >= dft->binSpan || dft->binIndex[bin] < 0)
+    {
+        return NULL;
+    }
+    return &dft->spectrum[2 * (size_t)dft->binIndex[bin] * dft->numOfSamplers];
+}
+
+/**
+ * @function fixedSlowTimeExponent(const FixedSlowTimeDFT *dft)
+ * @param dft - DFT created by fixedSlowTimeCreate()
+ * @return int
+ * @brief Returns the smallest right shift that brings every I and Q of the spectrum into int32, so a
+ *      squared magnitude is below 2^63
+ * @author ericdvet */
+static int fixedSlowTimeExponent(const FixedSlowTimeDFT *dft)
+{
+    uint64_t maxAbs = 0;
+    for (size_t i = 0; i < 2 * (size_t)dft->numBins * dft->numOfSamplers; i++)
+    {
+        int64_t value = dft->spectrum[i];
+        uint64_t magnitude = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+        maxAbs = magnitude > maxAbs ? magnitude : maxAbs;
+    }
+
+    int exponent = 0;
+    while ((maxAbs >> exponent) > INT32_MAX)
+    {
+        exponent++;
+    }
+    return exponent;
+}
+
+/**
+ * @function fixedPower(const int64_t *value, int exponent)
+ * @param value - Interleaved I/Q pair of the spectrum
+ * @param exponent - Shift from fixedSlowTimeExponent()
+ * @return uint64_t
+ * @brief Squared magnitude of the pair shifted down by exponent
+ * @author ericdvet */
+static uint64_t fixedPower(const int64_t *value, int exponent)
+{
+    int64_t re = value[0] >> exponent;
+    int64_t im = value[1] >> exponent;
+    return (uint64_t)(re * re) + (uint64_t)(im * im);
+}
+
+/**
+ * @function fixedRowPower(const int64_t *row, int exponent, uint64_t *power, int numOfSamplers)
+ * @param row - Spectrum of one frequency bin, interleaved I/Q (2 * numOfSamplers)
+ * @param exponent - Shift from fixedSlowTimeExponent()
+ * @param power - Resulting squared magnitude of every range bin
+ * @param numOfSamplers - Number of range bins per frame
+ * @return None
+ * @brief fixedPower() of every range bin of a row
+ * @author ericdvet */
+static void fixedRowPower(const int64_t *row, int exponent, uint64_t *power, int numOfSamplers)
+{
+    int i = 0;
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    int64x2_t shift = vdupq_n_s64(-exponent);
+    for (; i + 2 <= numOfSamplers; i += 2)
+    {
+        // Shifted I and Q fit int32, so two range bins are squared by 32 x 32 bit multiplies into 64 bits
+        int32x2_t pair0 = vmovn_s64(vshlq_s64(vld1q_s64(&row[2 * i]), shift));
+        int32x2_t pair1 = vmovn_s64(vshlq_s64(vld1q_s64(&row[2 * i + 2]), shift));
+        int32x2x2_t parts = vtrn_s32(pair0, pair1);
+        int64x2_t squares = vmlal_s32(vmull_s32(parts.val[0], parts.val[0]), parts.val[1], parts.val[1]);
+        vst1q_u64(&power[i], vreinterpretq_u64_s64(squares));
+    }
+#endif
+    for (; i < numOfSamplers; i++)
+    {
+        power[i] = fixedPower(&row[2 * i], exponent);
+    }
+}
+
+/**
+ * @function fixedSqrt(uint64_t value)
+ * @param value - Squared magnitude
+ * @return uint32_t
+ * @brief Integer square root, rounded down, one result bit per iteration
+ * @author ericdvet */
+static uint32_t fixedSqrt(uint64_t value)
+{
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > value)
+    {
+        bit >>= 2;
+    }
+    while (bit != 0)
+    {
+        if (value >= root + bit)
+        {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+/**
+ * @function fixedSlowTimeTagFT(const FixedSlowTimeDFT *dft, int freqTag, uint32_t *tagFT, int *exponent)
+ * @param dft - DFT holding the bins returned by slowTimeTagBins()
+ * @param freqTag - Expected frequency bin of the tag
+ * @param tagFT - Resulting magnitude of every range bin at the tag frequency (numOfSamplers)
+ * @param exponent - Resulting block exponent, tagFT[i] * 2^exponent is in units of dft->spectrum
+ * @return int
+ * @brief Integer slowTimeTagFT(). The spectrum is shifted down to Q31 so squared magnitudes fit 64 bits
+ *      and compared without square roots, only the returned magnitudes take an integer square root
+ * @author ericdvet */
+int fixedSlowTimeTagFT(const FixedSlowTimeDFT *dft, int freqTag, uint32_t *tagFT, int *exponent)
+{
+    *exponent = fixedSlowTimeExponent(dft);
+    uint64_t maxFTPeak = 0;
+    int idx_maxFTPeak = freqTag;
+
+    for (int j = freqTag - 2; j <= freqTag + 2; j++)
+    {
+        const int64_t *row = fixedSlowTimeRow(dft, j - 1);
+        if (!row)
+        {
+            continue;
+        }
+        fixedRowPower(row, *exponent, dft->power, dft->numOfSamplers);
+        for (int i = 0; i < dft->numOfSamplers; i++)
+        {
+            if (dft->power[i] > maxFTPeak)
+            {
+                maxFTPeak = dft->power[i];
+                idx_maxFTPeak = j;
+            }
+        }
+    }
+
+    const int64_t *tagRow = fixedSlowTimeRow(dft, idx_maxFTPeak - 1);
+    if (tagRow)
+    {
+        fixedRowPower(tagRow, *exponent, dft->power, dft->numOfSamplers);
+    }
+    for (int i = 0; i < dft->numOfSamplers; i++)
+    {
+        tagFT[i] = tagRow ? fixedSqrt(dft->power[i]) : 0;
+    }
+    return idx_maxFTPeak;
+}
+
+/**
+ * @function fixedPeakBin(const uint32_t *tagFT, int numOfSamplers)
+ * @param tagFT - Magnitudes from fixedSlowTimeTagFT()
+ * @param numOfSamplers - Number of range bins in tagFT
+ * @return int
+ * @brief Returns the strongest range bin, the fallback peak of cfarDetect()
+ * @author ericdvet */
+int fixedPeakBin(const uint32_t *tagFT, int numOfSamplers)
+{
+    int peakBin = 0;
+    for (int i = 1; i < numOfSamplers; i++)
+    {
+        if (tagFT[i] > tagFT[peakBin])
+        {
+            peakBin = i;
+        }
+    }
+    return peakBin;
+}
+
+/**
+ * @function fixedSlowTimeSNR(const FixedSlowTimeDFT *dft, int freqTag, int peakBin)
+ * @param dft - DFT holding the bins returned by slowTimeTagBins()
+ * @param freqTag - FT isolation of backscatter tag
+ * @param peakBin - Determined peak bin location of backscatter tag
+ * @return double
+ * @brief Integer slowTimeSNR(). The magnitudes are integer, only the final ratio is taken to dB
+ * @author ericdvet */
+double fixedSlowTimeSNR(const FixedSlowTimeDFT *dft, int freqTag, int peakBin)
+{
+    const int64_t *signal = fixedSlowTimeRow(dft, freqTag - 1);
+    if (!signal)
+    {
+        fprintf(stderr, "ERROR: Tag bin %d was not computed\n", freqTag);
+        return 0;
+    }
+    int exponent = fixedSlowTimeExponent(dft);
+    uint32_t signalMag = fixedSqrt(fixedPower(&signal[2 * peakBin], exponent));
+
+    int noiseFreqLowBound = (int)(freqTag * 0.945);
+    int noiseFreqHighBound = (int)(freqTag * 0.955);
+    uint64_t noiseSum = 0;
+    for (int j = noiseFreqLowBound; j < noiseFreqHighBound; j++)
+    {
+        const int64_t *noise = fixedSlowTimeRow(dft, j - 1);
+        if (!noise)
+        {
+            fprintf(stderr, "ERROR: Noise bin %d was not computed\n", j);
+            return 0;
+        }
+        noiseSum += fixedSqrt(fixedPower(&noise[2 * peakBin], exponent));
+    }
+    if (noiseSum == 0)
+    {
+        return 0;
+    }
+
+    return 10 * log10((double)signalMag * (noiseFreqHighBound - noiseFreqLowBound) / noiseSum);
+}
+
+/**
+ * @function fixedSlowTimeFree(FixedSlowTimeDFT *dft)
+ * @param dft - FixedSlowTimeDFT to free
+ * @return None
+ * @brief Free a FixedSlowTimeDFT constructed by fixedSlowTimeCreate()
+ * @author ericdvet */
+void fixedSlowTimeFree(FixedSlowTimeDFT *dft)
+{
+    if (dft)
+    {
+        free(dft->bins);
+        free(dft->binIndex);
+        free(dft->twiddle);
+        free(dft->spectrum);
+        free(dft->power);
+        free(dft);
+    }
+}
+
+// #define FIXED_TEST
+
+#ifdef FIXED_TEST
+#include "slowtime.h"
+#include <time.h>
+#include <complex.h>
+
+// Largest differences from the double path the test accepts. Normalization is exact to the rounding of
+// FIXED_DAC_FRAC. A baseband sample carries the input, mean and mixing roundings (2^-3 DAC each) through
+// a filter gain below 2, the Q15 tables' 2^-16 of the frame's full scale through 2 + filterSize taps,
+// and the final rounding of 2^-3 DAC
+#define FIXED_TEST_BB_DAC 0.875
+#define FIXED_TEST_BB_SCALE (23.0 / 65536)
+// Rounding errors are uncorrelated from frame to frame, so the DFT adds them up to sqrt(numFrames) times
+// the baseband error, not numFrames times. SNR in dB
+#define FIXED_TEST_SNR_DB 0.1
+
+int main()
+{
+    int numFrames = 2000;
+    int numOfSamplers = 512;
+    int blockFrames = 64;
+    int frameRate = 200;
+    int freqTag = (int)(80.0 / frameRate * numFrames);
+
+    // A 13 bit capture around mid-scale: the surface return at sampler 100 and the tag at 300, switched at
+    // 80 Hz, as pulses on the Chipotle carrier, plus noise and one frame holding the counter spike
+    RadarCapture capture = {0};
+    capture.numFrames = numFrames;
+    capture.numOfSamplers = numOfSamplers;
+    capture.frameRate = frameRate;
+    capture.countsPerStep = 100;
+    capture.dacStep = 4;
+    capture.dacMin = 0;
+    uint32_t *counters = (uint32_t *)malloc((size_t)numFrames * numOfSamplers * sizeof(uint32_t));
+    double carrier = CHIPOTLE_CF / CHIPOTLE_FS;
+    double fullScale = 0;
+    for (int n = 0; n < numFrames; n++)
+    {
+        double tag = sin(2 * PI * 80.0 / frameRate * (n + 0.5)) > 0 ? 1 : 0;
+        for (int i = 0; i < numOfSamplers; i++)
+        {
+            double pulses = 2000 * exp(-pow((i - 100) / 8.0, 2)) + 20 * tag * exp(-pow((i - 300) / 8.0, 2));
+            double dac = 4096 + pulses * cos(2 * PI * carrier * i) + 10.0 * (rand() % 100) / 100;
+            fullScale = fmax(fullScale, fabs(dac - 4096));
+            counters[(size_t)n * numOfSamplers + i] = (uint32_t)(dac * capture.countsPerStep / capture.dacStep);
+        }
+    }
+    counters[(size_t)500 * numOfSamplers + 7] = 9000 * capture.countsPerStep / capture.dacStep;
+    capture.counters = counters;
+
+    // Normalization must match salsaFrame() rounded to FIXED_DAC_FRAC bits, spike frames included
+    double *rfFrames = (double *)malloc((size_t)numFrames * numOfSamplers * sizeof(double));
+    int16_t *rfFramesq = (int16_t *)malloc((size_t)numFrames * numOfSamplers * sizeof(int16_t));
+    int normalizeMismatches = 0;
+    for (int n = 0; n < numFrames; n++)
+    {
+        salsaFrame(&capture, n, &rfFrames[(size_t)n * numOfSamplers]);
+        fixedFrame(&capture, n, &rfFramesq[(size_t)n * numOfSamplers]);
+        for (int i = 0; i < numOfSamplers; i++)
+        {
+            long expected = lround(rfFrames[(size_t)n * numOfSamplers + i] * (1 << FIXED_DAC_FRAC));
+            normalizeMismatches += rfFramesq[(size_t)n * numOfSamplers + i] != expected;
+        }
+    }
+    printf("Normalization: %d of %d values differ from salsaFrame() rounded\n", normalizeMismatches, numFrames * numOfSamplers);
+
+    int numBins;
+    int *bins = slowTimeTagBins(freqTag, &numBins);
+    double *tagFT = (double *)malloc(numOfSamplers * sizeof(double));
+    uint32_t *tagFTq = (uint32_t *)malloc(numOfSamplers * sizeof(uint32_t));
+    bool pass = normalizeMismatches == 0;
+
+    for (int decimation = 1; decimation <= 2; decimation++)
+    {
+        DDCPlan *plan = ddcPlanCreate(CHIPOTLE_CF, CHIPOTLE_FS, numOfSamplers, decimation);
+        FixedDDCPlan *fixed = fixedDDCCreate(plan);
+        int outputSize = plan->outputSize;
+        double complex *blockBB = (double complex *)malloc((size_t)blockFrames * outputSize * sizeof(double complex));
+        int16_t *blockBBq = (int16_t *)malloc((size_t)blockFrames * 2 * outputSize * sizeof(int16_t));
+        SlowTimeDFT *dft = slowTimeCreate(numFrames, outputSize, bins, numBins);
+        FixedSlowTimeDFT *dftq = fixedSlowTimeCreate(numFrames, outputSize, bins, numBins);
+
+        double maxErrorBB = 0;
+        double elapsed = 0, elapsedq = 0;
+        for (int n = 0; n < numFrames; n += blockFrames)
+        {
+            int numRead = numFrames - n < blockFrames ? numFrames - n : blockFrames;
+            clock_t start = clock();
+            ddcProcessBlock(plan, &rfFrames[(size_t)n * numOfSamplers], blockBB, numRead);
+            slowTimeAccumulate(dft, blockBB, numRead);
+            elapsed += (double)(clock() - start) / CLOCKS_PER_SEC;
+            start = clock();
+            fixedDDCProcessBlock(fixed, &rfFramesq[(size_t)n * numOfSamplers], blockBBq, numRead);
+            fixedSlowTimeAccumulate(dftq, blockBBq, numRead);
+            elapsedq += (double)(clock() - start) / CLOCKS_PER_SEC;
+            for (int i = 0; i < numRead * outputSize; i++)
+            {
+                double complex value = (blockBBq[2 * i] + I * blockBBq[2 * i + 1]) / FIXED_BB_ONE;
+                maxErrorBB = fmax(maxErrorBB, cabs(value - blockBB[i]));
+            }
+        }
+
+        int tagBin = slowTimeTagFT(dft, freqTag, tagFT);
+        int exponent;
+        int tagBinq = fixedSlowTimeTagFT(dftq, freqTag, tagFTq, &exponent);
+        double maxErrorFT = 0, maxFT = 0;
+        for (int i = 0; i < outputSize; i++)
+        {
+            maxErrorFT = fmax(maxErrorFT, fabs(ldexp(tagFTq[i], exponent) / FIXED_SPECTRUM_ONE - tagFT[i]));
+            maxFT = fmax(maxFT, tagFT[i]);
+        }
+        int peakBin = 0;
+        for (int i = 1; i < outputSize; i++)
+        {
+            peakBin = tagFT[i] > tagFT[peakBin] ? i : peakBin;
+        }
+        int peakBinq = fixedPeakBin(tagFTq, outputSize);
+        double SNR = slowTimeSNR(dft, tagBin, peakBin);
+        double SNRq = fixedSlowTimeSNR(dftq, tagBinq, peakBinq);
+
+        double boundBB = FIXED_TEST_BB_DAC + FIXED_TEST_BB_SCALE * fullScale;
+        bool ok = maxErrorBB <= boundBB && maxErrorFT <= sqrt(numFrames) * boundBB && tagBin == tagBinq && peakBin == peakBinq &&
+                  fabs(SNR - SNRq) <= FIXED_TEST_SNR_DB;
+        pass = pass && ok;
+        printf("Decimation %d: baseband error %.3f DAC (bound %.3f), tag FT error %.2f (bound %.2f, peak %.0f), tag bin %d/%d, "
+               "peak bin %d/%d, SNR %.2f/%.2f dB, %s\n",
+               decimation, maxErrorBB, boundBB, maxErrorFT, sqrt(numFrames) * boundBB, maxFT, tagBin, tagBinq, peakBin * decimation,
+               peakBinq * decimation, SNR, SNRq, ok ? "ok" : "FAILED");
+        printf("    double DDC and DFT %f ms, fixed point %f ms\n", elapsed * 1000, elapsedq * 1000);
+
+        slowTimeFree(dft);
+        fixedSlowTimeFree(dftq);
+        free(blockBB);
+        free(blockBBq);
+        fixedDDCFree(fixed);
+        ddcPlanFree(plan);
+    }
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    // The NEON kernels against plain loops over full scale random inputs. Odd sizes and a window leave
+    // vector tails on every kernel. Other builds run the plain loops themselves, so there is nothing to compare
+    int kernelMismatches = 0;
+    int oddSize = 509;
+    int16_t *rfOdd = (int16_t *)malloc(oddSize * sizeof(int16_t));
+    int16_t *mixedOdd = (int16_t *)calloc(2 * (oddSize + 32), sizeof(int16_t));
+    int16_t *outOdd = (int16_t *)malloc(2 * oddSize * sizeof(int16_t));
+    for (int decimation = 1; decimation <= 3; decimation += 2)
+    {
+        DDCPlan *plan = ddcPlanCreate(CHIPOTLE_CF, CHIPOTLE_FS, oddSize, decimation);
+        ddcPlanWindow(plan, 37 / decimation, 301 / decimation);
+        FixedDDCPlan *fixed = fixedDDCCreate(plan);
+        int16_t mean = (int16_t)(rand() % 32765);
+        for (int i = 0; i < oddSize; i++)
+        {
+            rfOdd[i] = (int16_t)(rand() % 32765);
+        }
+        fixedMix(fixed, rfOdd, mean, mixedOdd);
+        for (int i = fixed->mixStart; i < fixed->mixStart + fixed->mixSize; i++)
+        {
+            for (int k = 0; k < 2; k++)
+            {
+                kernelMismatches += mixedOdd[2 * i + k] != (int16_t)(((rfOdd[i] - mean) * fixed->lo[2 * i + k] + (1 << 14)) >> 15);
+            }
+        }
+
+        for (int i = 0; i < 2 * (oddSize + 32); i++)
+        {
+            mixedOdd[i] = (int16_t)(rand() % 65536 - 32768);
+        }
+        fixedFilter(fixed, mixedOdd, outOdd);
+        for (int m = 0; m < 2 * fixed->outputSize; m++)
+        {
+            int32_t acc = 0;
+            for (int j = 0; j < fixed->filterSize; j++)
+            {
+                acc += mixedOdd[2 * (m / 2) * decimation + m % 2 + 2 * j] * fixed->filterWeights[j];
+            }
+            kernelMismatches += outOdd[m] != fixedSaturate((acc + (1 << 14)) >> 15);
+        }
+        fixedDDCFree(fixed);
+        ddcPlanFree(plan);
+    }
+
+    int64_t *row = (int64_t *)malloc(2 * oddSize * sizeof(int64_t));
+    int64_t *rowRef = (int64_t *)malloc(2 * oddSize * sizeof(int64_t));
+    uint64_t *power = (uint64_t *)malloc(oddSize * sizeof(uint64_t));
+    for (int trial = 0; trial < 4; trial++)
+    {
+        int16_t wr = trial < 2 ? (int16_t)(trial == 0 ? 32767 : -32767) : (int16_t)(rand() % 65535 - 32767);
+        int16_t wi = trial < 2 ? (int16_t)(trial == 0 ? -32767 : 32767) : (int16_t)(rand() % 65535 - 32767);
+        for (int i = 0; i < 2 * oddSize; i++)
+        {
+            mixedOdd[i] = (int16_t)(rand() % 65536 - 32768);
+            row[i] = rowRef[i] = ((int64_t)rand() << 8) - ((int64_t)1 << 38);
+        }
+        fixedAccumulateRow(row, mixedOdd, wr, wi, oddSize);
+        for (int i = 0; i < oddSize; i++)
+        {
+            rowRef[2 * i] += (int32_t)wr * mixedOdd[2 * i] - (int32_t)wi * mixedOdd[2 * i + 1];
+            rowRef[2 * i + 1] += (int32_t)wr * mixedOdd[2 * i + 1] + (int32_t)wi * mixedOdd[2 * i];
+        }
+        kernelMismatches += memcmp(row, rowRef, 2 * oddSize * sizeof(int64_t)) != 0;
+
+        // Rows up to 2^40 shifted by 9 reach the full int32 range of the squares
+        fixedRowPower(row, 9, power, oddSize);
+        for (int i = 0; i < oddSize; i++)
+        {
+            kernelMismatches += power[i] != fixedPower(&row[2 * i], 9);
+        }
+    }
+    printf("Kernels: %d mismatches against plain loops\n", kernelMismatches);
+    pass = pass && kernelMismatches == 0;
+    free(rfOdd);
+    free(mixedOdd);
+    free(outOdd);
+    free(row);
+    free(rowRef);
+    free(power);
+#endif
+
+    printf("%s\n", pass ? "Fixed point matches the double path" : "Fixed point FAILED");
+    free(bins);
+    free(tagFT);
+    free(tagFTq);
+    free(rfFrames);
+    free(rfFramesq);
+    free(counters);
+    return pass ? 0 : 1;
+}
+#endif
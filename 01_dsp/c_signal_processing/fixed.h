@@ -0,0 +1,175 @@
+/*
+ * File:   fixed.h
+ * Author: ericdvet
+ *
+ * Fixed-point normalization, DDC, targeted slow-time DFT and peak search for running on the radar's
+ * BeagleBone. Frames are Q15 int16 from the counters to the DFT, the DFT accumulates in int64 and
+ * magnitudes are taken in Q31. The mixing, filter, DFT and magnitude kernels use NEON when built for the
+ * radar (-mfpu=neon) and give the same bits as their scalar loops
+ */
+
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "salsa.h"
+#include "ddc.h"
+
+// Fractional bits of the normalized DAC values, so the 13 bit DAC range fills int16
+#define FIXED_DAC_FRAC 2
+
+// DAC values above this are the counter spike, as in salsaFrame()
+#define FIXED_SPIKE_DAC 8191
+
+// Shift from the filter accumulator (Q15 weights) to the int16 baseband, which keeps the DAC values'
+// fractional bits. Outputs past 2^15 / 2^FIXED_DAC_FRAC DAC, twice the largest a clean 13 bit frame
+// downconverts to, saturate
+#define FIXED_BB_SHIFT 15
+
+// One unit of ddcProcessBlock()'s baseband in fixedDDCProcessBlock()'s, and of slowTimeAccumulate()'s
+// spectrum in fixedSlowTimeAccumulate()'s (Q15 twiddles)
+#define FIXED_BB_ONE ((double)(1 << FIXED_DAC_FRAC) / (1 << (FIXED_BB_SHIFT - 15)))
+#define FIXED_SPECTRUM_ONE (FIXED_BB_ONE * 32768.0)
+
+/**
+ * @struct FixedDDCPlan
+ * @brief Q15 local oscillator and filter weights of a DDCPlan, with its window and decimation
+ * @author ericdvet */
+typedef struct
+{
+    int frameSize;
+    int outputSize;
+    int outputStart;
+    int decimation;
+    int filterSize;
+    int mixStart;
+    int mixSize;
+    int16_t *lo;            // (sin, cos) pairs in Q15
+    int16_t *filterWeights; // Q15
+    int16_t *pairWeights;   // every weight twice, lined up with the I/Q pairs of the mixed samples
+    int16_t *mixed;         // interleaved I/Q with filterSize / 2 zero samples on either side
+} FixedDDCPlan;
+
+/**
+ * @struct FixedSlowTimeDFT
+ * @brief Integer SlowTimeDFT: Q15 twiddles and 64 bit accumulators, which hold any capture up to
+ *      2^32 frames without overflow
+ * @author ericdvet */
+typedef struct
+{
+    int numFrames;
+    int numOfSamplers;
+    int numBins;
+    int *bins;
+    int *binIndex;
+    int minBin;
+    int binSpan;
+    int16_t *twiddle;  // (cos, -sin) pairs in Q15
+    int64_t *spectrum; // numBins x numOfSamplers interleaved I/Q, FIXED_SPECTRUM_ONE per unit of slowTimeAccumulate()
+    uint64_t *power;   // squared magnitudes of one row, scratch space for fixedSlowTimeTagFT()
+    int frame;
+} FixedSlowTimeDFT;
+
+/**
+ * @function fixedFrame(const RadarCapture *capture, int frame, int16_t *rfSignal)
+ * @param capture - Capture mapped by salsaMap()
+ * @param frame - Index of the frame to normalize
+ * @param rfSignal - Resulting numOfSamplers DAC values with FIXED_DAC_FRAC fractional bits
+ * @return None
+ * @brief Integer salsaFrame(). Each value is salsaFrame()'s rounded to the nearest 2^-FIXED_DAC_FRAC,
+ *      and the spike test is done on the exact integer counters, so the same frames are replaced
+ * @author ericdvet */
+void fixedFrame(const RadarCapture *capture, int frame, int16_t *rfSignal);
+
+/**
+ * @function fixedDDCCreate(const DDCPlan *plan)
+ * @param plan - Plan created by ddcPlanCreate(), possibly windowed by ddcPlanWindow()
+ * @return FixedDDCPlan *
+ * @brief Rounds the plan's local oscillator and filter weights to Q15. NULL on error
+ * @author ericdvet */
+FixedDDCPlan *fixedDDCCreate(const DDCPlan *plan);
+
+/**
+ * @function fixedDDCProcessBlock(FixedDDCPlan *plan, const int16_t *rfFrames, int16_t *basebandFrames, int numFrames)
+ * @param plan - Plan created by fixedDDCCreate()
+ * @param rfFrames - Frames normalized by fixedFrame() (numFrames x frameSize)
+ * @param basebandFrames - Resulting interleaved I/Q frames (numFrames x 2 * outputSize), FIXED_BB_ONE per
+ *      unit of ddcProcessBlock()
+ * @param numFrames - Number of frames in the block
+ * @return None
+ * @brief ddcProcessBlock() in integer arithmetic: 16 x 16 bit products with rounding shifts, 32 bit
+ *      filter accumulators that cannot overflow and outputs saturated to int16
+ * @author ericdvet */
+void fixedDDCProcessBlock(FixedDDCPlan *plan, const int16_t *rfFrames, int16_t *basebandFrames, int numFrames);
+
+/**
+ * @function fixedDDCFree(FixedDDCPlan *plan)
+ * @param plan - FixedDDCPlan to free
+ * @return None
+ * @brief Free a FixedDDCPlan constructed by fixedDDCCreate()
+ * @author ericdvet */
+void fixedDDCFree(FixedDDCPlan *plan);
+
+/**
+ * @function fixedSlowTimeCreate(int numFrames, int numOfSamplers, const int *bins, int numBins)
+ * @param numFrames - Length of the slow-time DFT (frames in the capture)
+ * @param numOfSamplers - Number of range bins per frame
+ * @param bins - Frequency bins to compute, as indices of the numFrames-point FFT (e.g. slowTimeTagBins())
+ * @param numBins - Number of frequency bins
+ * @return FixedSlowTimeDFT *
+ * @brief Integer slowTimeCreate()
+ * @author ericdvet */
+FixedSlowTimeDFT *fixedSlowTimeCreate(int numFrames, int numOfSamplers, const int *bins, int numBins);
+
+/**
+ * @function fixedSlowTimeAccumulate(FixedSlowTimeDFT *dft, const int16_t *framesBB, int numFrames)
+ * @param dft - DFT created by fixedSlowTimeCreate()
+ * @param framesBB - Next baseband frames of fixedDDCProcessBlock() (numFrames x 2 * numOfSamplers)
+ * @param numFrames - Number of frames in the block
+ * @return None
+ * @brief Integer slowTimeAccumulate(). Blocks must be passed in capture order
+ * @author ericdvet */
+void fixedSlowTimeAccumulate(FixedSlowTimeDFT *dft, const int16_t *framesBB, int numFrames);
+
+/**
+ * @function fixedSlowTimeTagFT(const FixedSlowTimeDFT *dft, int freqTag, uint32_t *tagFT, int *exponent)
+ * @param dft - DFT holding the bins returned by slowTimeTagBins()
+ * @param freqTag - Expected frequency bin of the tag
+ * @param tagFT - Resulting magnitude of every range bin at the tag frequency (numOfSamplers)
+ * @param exponent - Resulting block exponent, tagFT[i] * 2^exponent is in units of dft->spectrum
+ * @return int
+ * @brief Integer slowTimeTagFT(). The spectrum is shifted down to Q31 so squared magnitudes fit 64 bits
+ *      and compared without square roots, only the returned magnitudes take an integer square root
+ * @author ericdvet */
+int fixedSlowTimeTagFT(const FixedSlowTimeDFT *dft, int freqTag, uint32_t *tagFT, int *exponent);
+
+/**
+ * @function fixedPeakBin(const uint32_t *tagFT, int numOfSamplers)
+ * @param tagFT - Magnitudes from fixedSlowTimeTagFT()
+ * @param numOfSamplers - Number of range bins in tagFT
+ * @return int
+ * @brief Returns the strongest range bin, the fallback peak of cfarDetect()
+ * @author ericdvet */
+int fixedPeakBin(const uint32_t *tagFT, int numOfSamplers);
+
+/**
+ * @function fixedSlowTimeSNR(const FixedSlowTimeDFT *dft, int freqTag, int peakBin)
+ * @param dft - DFT holding the bins returned by slowTimeTagBins()
+ * @param freqTag - FT isolation of backscatter tag
+ * @param peakBin - Determined peak bin location of backscatter tag
+ * @return double
+ * @brief Integer slowTimeSNR(). The magnitudes are integer, only the final ratio is taken to dB
+ * @author ericdvet */
+double fixedSlowTimeSNR(const FixedSlowTimeDFT *dft, int freqTag, int peakBin);
+
+/**
+ * @function fixedSlowTimeFree(FixedSlowTimeDFT *dft)
+ * @param dft - FixedSlowTimeDFT to free
+ * @return None
+ * @brief Free a FixedSlowTimeDFT constructed by fixedSlowTimeCreate()
+ * @author ericdvet */
+void fixedSlowTimeFree(FixedSlowTimeDFT *dft);
+
+#endif // FIXED_H
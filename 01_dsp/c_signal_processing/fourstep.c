@@ -0,0 +1,417 @@
+/*
+ * File:   fourstep.c
+ * Author: ericdvet
+ *
+ * Out-of-core slow-time FFT of long captures, a four-step (Bailey) decomposition over tiles of a scratch file
+ */
+
+#include "fourstep.h"
+#include <math.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define PI 3.14159265358979323846
+
+/**
+ * @function fourStepReadAt(int fd, void *buffer, size_t size, size_t offset)
+ * @param fd - Scratch file descriptor
+ * @param buffer - Destination buffer
+ * @param size - Number of bytes to read
+ * @param offset - File offset to read from
+ * @return bool
+ * @brief Reads exactly size bytes at offset, retrying short reads
+ * @author ericdvet */
+static bool fourStepReadAt(int fd, void *buffer, size_t size, size_t offset)
+{
+    uint8_t *dst = (uint8_t *)buffer;
+    while (size > 0)
+    {
+        ssize_t numRead = pread(fd, dst, size, (off_t)offset);
+        if (numRead <= 0)
+        {
+            return false;
+        }
+        dst += numRead;
+        offset += numRead;
+        size -= numRead;
+    }
+    return true;
+}
+
+/**
+ * @function fourStepWriteAt(int fd, const void *buffer, size_t size, size_t offset)
+ * @param fd - Scratch file descriptor
+ * @param buffer - Source buffer
+ * @param size - Number of bytes to write
+ * @param offset - File offset to write at
+ * @return bool
+ * @brief Writes exactly size bytes at offset, retrying short writes
+ * @author ericdvet */
+static bool fourStepWriteAt(int fd, const void *buffer, size_t size, size_t offset)
+{
+    const uint8_t *src = (const uint8_t *)buffer;
+    while (size > 0)
+    {
+        ssize_t numWritten = pwrite(fd, src, size, (off_t)offset);
+        if (numWritten <= 0)
+        {
+            return false;
+        }
+        src += numWritten;
+        offset += numWritten;
+        size -= numWritten;
+    }
+    return true;
+}
+
+/**
+ * @function fourStepCreate(int numFrames, int numOfSamplers, const char *scratchDir, size_t memoryBytes)
+ * @param numFrames - Frames in the capture
+ * @param numOfSamplers - Number of range bins per frame
+ * @param scratchDir - Directory the scratch file is created in, which must hold the whole baseband capture
+ * @param memoryBytes - Budget for the tile buffer, the first pass reads as many rows per tile as fit
+ * @return FourStepFFT *
+ * @brief Splits numFrames into rows x columns close to its square root. A length without such a factoring
+ *      is rounded down by fewer than sqrt(numFrames) frames, see numFrames. The scratch file is unlinked
+ *      as soon as it is opened so it never outlives the process
+ * @author ericdvet */
+FourStepFFT *fourStepCreate(int numFrames, int numOfSamplers, const char *scratchDir, size_t memoryBytes)
+{
+    if (numFrames < 4 || numOfSamplers < 1 || scratchDir == NULL)
+    {
+        fprintf(stderr, "ERROR: Invalid out-of-core FFT\n");
+        return NULL;
+    }
+
+    FourStepFFT *fourStep = (FourStepFFT *)calloc(1, sizeof(FourStepFFT));
+    if (!fourStep)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        return NULL;
+    }
+    fourStep->fd = -1;
+
+    // Largest divisor up to the square root. Without one at least half of it, drop the trailing frames that
+    // keep the capture from being a square root sided rectangle
+    int squareRoot = (int)sqrt((double)numFrames);
+    int rows = squareRoot;
+    while (numFrames % rows != 0)
+    {
+        rows--;
+    }
+    if (2 * rows < squareRoot)
+    {
+        rows = squareRoot;
+    }
+    fourStep->rows = rows;
+    fourStep->columns = numFrames / rows;
+    fourStep->numFrames = rows * fourStep->columns;
+    fourStep->numOfSamplers = numOfSamplers;
+    fourStep->frameBytes = (size_t)numOfSamplers * sizeof(double complex);
+
+    // As many rows per tile as the budget allows, a divisor of rows so every tile has the same plan
+    int tileRows = 1;
+    for (int t = rows; t >= 1; t--)
+    {
+        if (rows % t == 0 && (size_t)t * fourStep->columns * fourStep->frameBytes <= memoryBytes)
+        {
+            tileRows = t;
+            break;
+        }
+    }
+    fourStep->tileRows = tileRows;
+    size_t bufferFrames = (size_t)tileRows * fourStep->columns > (size_t)rows ? (size_t)tileRows * fourStep->columns : (size_t)rows;
+
+    char scratchPath[1024];
+    snprintf(scratchPath, sizeof(scratchPath), "%s/wadarFourStepXXXXXX", scratchDir);
+    fourStep->fd = mkstemp(scratchPath);
+    if (fourStep->fd < 0)
+    {
+        fprintf(stderr, "ERROR: Unable to create scratch file in %s\n", scratchDir);
+        fourStepFree(fourStep);
+        return NULL;
+    }
+    unlink(scratchPath);
+
+    fourStep->buffer = (double complex *)fftw_malloc(bufferFrames * fourStep->frameBytes);
+    fourStep->twiddle = (double complex *)malloc((size_t)fourStep->numFrames * sizeof(double complex));
+    if (!fourStep->buffer || !fourStep->twiddle)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        fourStepFree(fourStep);
+        return NULL;
+    }
+
+    // Roots of unity indexed by (n1 * k2) mod numFrames, so long captures do not accumulate phase error
+    for (int n = 0; n < fourStep->numFrames; n++)
+    {
+        fourStep->twiddle[n] = cos(2 * PI * n / fourStep->numFrames) - I * sin(2 * PI * n / fourStep->numFrames);
+    }
+
+    // First pass tile is columns x tileRows frames, transformed over the columns for every row and range bin
+    fftw_complex *buffer = (fftw_complex *)fourStep->buffer;
+    int columns = fourStep->columns;
+    int tileSize = tileRows * numOfSamplers;
+    fourStep->columnPlan = fftw_plan_many_dft(1, &columns, tileSize, buffer, NULL, tileSize, 1, buffer, NULL, tileSize, 1, FFTW_FORWARD,
+                                              FFTW_MEASURE);
+    fourStep->rowPlan = fftw_plan_many_dft(1, &rows, numOfSamplers, buffer, NULL, numOfSamplers, 1, buffer, NULL, numOfSamplers, 1,
+                                           FFTW_FORWARD, FFTW_MEASURE);
+    if (!fourStep->columnPlan || !fourStep->rowPlan)
+    {
+        fprintf(stderr, "ERROR: Unable to plan out-of-core FFT\n");
+        fourStepFree(fourStep);
+        return NULL;
+    }
+    return fourStep;
+}
+
+/**
+ * @function fourStepWrite(FourStepFFT *fourStep, const double complex *framesBB, int numFrames)
+ * @param fourStep - FFT created by fourStepCreate()
+ * @param framesBB - Next baseband frames of the capture (numFrames x numOfSamplers)
+ * @param numFrames - Number of frames in the block
+ * @return int
+ * @brief Appends a block of frames to the scratch file. Frames past fourStep->numFrames are dropped.
+ *      Returns 0 on success, -1 on a write error
+ * @author ericdvet */
+int fourStepWrite(FourStepFFT *fourStep, const double complex *framesBB, int numFrames)
+{
+    int numKept = fourStep->numFrames - fourStep->framesWritten;
+    numKept = numFrames < numKept ? numFrames : numKept;
+    if (numKept <= 0)
+    {
+        return 0;
+    }
+    if (!fourStepWriteAt(fourStep->fd, framesBB, numKept * fourStep->frameBytes, fourStep->framesWritten * fourStep->frameBytes))
+    {
+        fprintf(stderr, "ERROR: Unable to write scratch file\n");
+        return -1;
+    }
+    fourStep->framesWritten += numKept;
+    return 0;
+}
+
+/**
+ * @function fourStepExecute(FourStepFFT *fourStep)
+ * @param fourStep - FFT holding the whole capture
+ * @return int
+ * @brief First pass: reads tiles of tileRows rows from every column, transforms them over the columns,
+ *      applies the twiddles and writes them back in place. Returns 0 on success, -1 on an I/O error
+ * @author ericdvet */
+int fourStepExecute(FourStepFFT *fourStep)
+{
+    if (fourStep->framesWritten != fourStep->numFrames)
+    {
+        fprintf(stderr, "ERROR: Out-of-core FFT holds %d of %d frames\n", fourStep->framesWritten, fourStep->numFrames);
+        return -1;
+    }
+
+    int rows = fourStep->rows;
+    int columns = fourStep->columns;
+    int tileRows = fourStep->tileRows;
+    int numOfSamplers = fourStep->numOfSamplers;
+    size_t tileBytes = tileRows * fourStep->frameBytes;
+
+    for (int firstRow = 0; firstRow < rows; firstRow += tileRows)
+    {
+        // Frames firstRow + rows * n2 onwards, tileRows contiguous frames from each column
+        for (int n2 = 0; n2 < columns; n2++)
+        {
+            if (!fourStepReadAt(fourStep->fd, &fourStep->buffer[(size_t)n2 * tileRows * numOfSamplers], tileBytes,
+                                ((size_t)firstRow + (size_t)rows * n2) * fourStep->frameBytes))
+            {
+                fprintf(stderr, "ERROR: Unable to read scratch file\n");
+                return -1;
+            }
+        }
+
+        fftw_execute(fourStep->columnPlan);
+
+        // Twiddle W^(n1 k2), then write k2 back where column n2 = k2 was read, ready for the second pass
+        for (int k2 = 0; k2 < columns; k2++)
+        {
+            double complex *tile = &fourStep->buffer[(size_t)k2 * tileRows * numOfSamplers];
+            for (int t = 0; t < tileRows; t++)
+            {
+                double complex twiddle = fourStep->twiddle[(long long)(firstRow + t) * k2 % fourStep->numFrames];
+                double complex *frame = &tile[(size_t)t * numOfSamplers];
+                for (int i = 0; i < numOfSamplers; i++)
+                {
+                    frame[i] *= twiddle;
+                }
+            }
+            if (!fourStepWriteAt(fourStep->fd, tile, tileBytes, ((size_t)firstRow + (size_t)rows * k2) * fourStep->frameBytes))
+            {
+                fprintf(stderr, "ERROR: Unable to write scratch file\n");
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @function fourStepBins(FourStepFFT *fourStep, const int *bins, int numBins, double complex *spectrum)
+ * @param fourStep - FFT after fourStepExecute()
+ * @param bins - Frequency bins wanted, as indices of the numFrames-point FFT
+ * @param numBins - Number of frequency bins
+ * @param spectrum - Resulting rows of the capture FT (numBins x numOfSamplers), scaled like computeFFT()
+ * @return int
+ * @brief Second pass, only over the columns that hold a wanted bin: reads each one, transforms it over
+ *      the rows and copies out the wanted bins. Returns 0 on success, -1 on a read error
+ * @author ericdvet */
+int fourStepBins(FourStepFFT *fourStep, const int *bins, int numBins, double complex *spectrum)
+{
+    int numFrames = fourStep->numFrames;
+    int rows = fourStep->rows;
+    int columns = fourStep->columns;
+    int numOfSamplers = fourStep->numOfSamplers;
+
+    // Bin k2 + columns * k1 is row k1 of column k2 after the second pass
+    for (int k2 = 0; k2 < columns; k2++)
+    {
+        bool wanted = false;
+        for (int b = 0; b < numBins && !wanted; b++)
+        {
+            wanted = ((bins[b] % numFrames) + numFrames) % numFrames % columns == k2;
+        }
+        if (!wanted)
+        {
+            continue;
+        }
+
+        if (!fourStepReadAt(fourStep->fd, fourStep->buffer, rows * fourStep->frameBytes, (size_t)rows * k2 * fourStep->frameBytes))
+        {
+            fprintf(stderr, "ERROR: Unable to read scratch file\n");
+            return -1;
+        }
+        fftw_execute(fourStep->rowPlan);
+
+        for (int b = 0; b < numBins; b++)
+        {
+            int bin = ((bins[b] % numFrames) + numFrames) % numFrames;
+            if (bin % columns == k2)
+            {
+                memcpy(&spectrum[(size_t)b * numOfSamplers], &fourStep->buffer[(size_t)(bin / columns) * numOfSamplers], fourStep->frameBytes);
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @function fourStepFree(FourStepFFT *fourStep)
+ * @param fourStep - FourStepFFT to free
+ * @return None
+ * @brief Free a FourStepFFT constructed by fourStepCreate(), closing (and so deleting) its scratch file
+ * @author ericdvet */
+void fourStepFree(FourStepFFT *fourStep)
+{
+    if (fourStep)
+    {
+        if (fourStep->columnPlan)
+        {
+            fftw_destroy_plan(fourStep->columnPlan);
+        }
+        if (fourStep->rowPlan)
+        {
+            fftw_destroy_plan(fourStep->rowPlan);
+        }
+        if (fourStep->fd >= 0)
+        {
+            close(fourStep->fd);
+        }
+        fftw_free(fourStep->buffer);
+        free(fourStep->twiddle);
+        free(fourStep);
+    }
+}
+
+// #define FOURSTEP_TEST
+
+#ifdef FOURSTEP_TEST
+#include <time.h>
+
+int main()
+{
+    int lengths[2] = {4800, 4801};
+    int numOfSamplers = 64;
+    int blockFrames = 64;
+
+    for (int l = 0; l < 2; l++)
+    {
+        int numFrames = lengths[l];
+        double complex *block = (double complex *)malloc((size_t)blockFrames * numOfSamplers * sizeof(double complex));
+
+        // A 1 MB budget forces several first pass tiles
+        FourStepFFT *fourStep = fourStepCreate(numFrames, numOfSamplers, "/tmp", 1 << 20);
+        printf("%d frames: %d x %d, %d rows per tile, %d frames transformed\n", numFrames, fourStep->rows, fourStep->columns,
+               fourStep->tileRows, fourStep->numFrames);
+
+        clock_t start = clock();
+        srand(1);
+        for (int n = 0; n < numFrames; n += blockFrames)
+        {
+            int numRead = numFrames - n < blockFrames ? numFrames - n : blockFrames;
+            for (int k = 0; k < numRead; k++)
+            {
+                for (int i = 0; i < numOfSamplers; i++)
+                {
+                    block[(size_t)k * numOfSamplers + i] = cexp(I * 2 * PI * 0.4 * (n + k)) * exp(-pow(i - 30, 2) / 20.0) +
+                                                           0.01 * (rand() % 100) + 0.01 * I * (rand() % 100);
+                }
+            }
+            fourStepWrite(fourStep, block, numRead);
+        }
+        fourStepExecute(fourStep);
+
+        // Tag search window and noise band of an 80 Hz tag, plus a negative frequency and DC
+        int freqTag = (int)(0.4 * fourStep->numFrames);
+        int bins[9] = {freqTag - 3, freqTag - 2, freqTag - 1, freqTag, freqTag + 1, (int)(freqTag * 0.945) - 1, -5, 0, fourStep->numFrames - 1};
+        double complex *spectrum = (double complex *)malloc(9 * numOfSamplers * sizeof(double complex));
+        fourStepBins(fourStep, bins, 9, spectrum);
+        double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        // Compare with a direct DFT of the same frames, regenerated from the same seed
+        double complex *framesBB = (double complex *)malloc((size_t)fourStep->numFrames * numOfSamplers * sizeof(double complex));
+        srand(1);
+        for (int n = 0; n < numFrames; n++)
+        {
+            for (int i = 0; i < numOfSamplers; i++)
+            {
+                double complex value = cexp(I * 2 * PI * 0.4 * n) * exp(-pow(i - 30, 2) / 20.0) + 0.01 * (rand() % 100) + 0.01 * I * (rand() % 100);
+                if (n < fourStep->numFrames)
+                {
+                    framesBB[(size_t)n * numOfSamplers + i] = value;
+                }
+            }
+        }
+        double maxError = 0;
+        double maxValue = 0;
+        for (int b = 0; b < 9; b++)
+        {
+            int bin = ((bins[b] % fourStep->numFrames) + fourStep->numFrames) % fourStep->numFrames;
+            for (int i = 0; i < numOfSamplers; i++)
+            {
+                double complex direct = 0;
+                for (int n = 0; n < fourStep->numFrames; n++)
+                {
+                    direct += framesBB[(size_t)n * numOfSamplers + i] * fourStep->twiddle[(long long)n * bin % fourStep->numFrames];
+                }
+                maxError = fmax(maxError, cabs(direct - spectrum[(size_t)b * numOfSamplers + i]));
+                maxValue = fmax(maxValue, cabs(direct));
+            }
+        }
+        printf("Max error against direct DFT %g of %g, %f ms\n", maxError, maxValue, elapsed * 1000);
+
+        free(framesBB);
+        free(spectrum);
+        free(block);
+        fourStepFree(fourStep);
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,91 @@
+/*
+ * File:   fourstep.h
+ * Author: ericdvet
+ *
+ * Out-of-core slow-time FFT of long captures, a four-step (Bailey) decomposition over tiles of a scratch file
+ */
+
+#ifndef FOURSTEP_H
+#define FOURSTEP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <complex.h>
+#include <fftw3.h>
+
+/**
+ * @struct FourStepFFT
+ * @brief Scratch file, tile buffer and plans of a slow-time FFT of numFrames = rows x columns frames. Frame
+ *      n1 + rows * n2 is transformed over n2 by the first pass and over n1 by the second
+ * @author ericdvet */
+typedef struct
+{
+    int numFrames;     // frames transformed, the capture rounded down to rows x columns
+    int numOfSamplers;
+    int rows;          // length of the second pass FFTs
+    int columns;       // length of the first pass FFTs
+    int tileRows;      // rows read per first pass tile, a divisor of rows
+    int framesWritten;
+    int fd;
+    size_t frameBytes;
+    double complex *buffer;
+    double complex *twiddle;
+    fftw_plan columnPlan;
+    fftw_plan rowPlan;
+} FourStepFFT;
+
+/**
+ * @function fourStepCreate(int numFrames, int numOfSamplers, const char *scratchDir, size_t memoryBytes)
+ * @param numFrames - Frames in the capture
+ * @param numOfSamplers - Number of range bins per frame
+ * @param scratchDir - Directory the scratch file is created in, which must hold the whole baseband capture
+ * @param memoryBytes - Budget for the tile buffer, the first pass reads as many rows per tile as fit
+ * @return FourStepFFT *
+ * @brief Splits numFrames into rows x columns close to its square root. A length without such a factoring
+ *      is rounded down by fewer than sqrt(numFrames) frames, see numFrames. The scratch file is unlinked
+ *      as soon as it is opened so it never outlives the process
+ * @author ericdvet */
+FourStepFFT *fourStepCreate(int numFrames, int numOfSamplers, const char *scratchDir, size_t memoryBytes);
+
+/**
+ * @function fourStepWrite(FourStepFFT *fourStep, const double complex *framesBB, int numFrames)
+ * @param fourStep - FFT created by fourStepCreate()
+ * @param framesBB - Next baseband frames of the capture (numFrames x numOfSamplers)
+ * @param numFrames - Number of frames in the block
+ * @return int
+ * @brief Appends a block of frames to the scratch file. Frames past fourStep->numFrames are dropped.
+ *      Returns 0 on success, -1 on a write error
+ * @author ericdvet */
+int fourStepWrite(FourStepFFT *fourStep, const double complex *framesBB, int numFrames);
+
+/**
+ * @function fourStepExecute(FourStepFFT *fourStep)
+ * @param fourStep - FFT holding the whole capture
+ * @return int
+ * @brief First pass: reads tiles of tileRows rows from every column, transforms them over the columns,
+ *      applies the twiddles and writes them back in place. Returns 0 on success, -1 on an I/O error
+ * @author ericdvet */
+int fourStepExecute(FourStepFFT *fourStep);
+
+/**
+ * @function fourStepBins(FourStepFFT *fourStep, const int *bins, int numBins, double complex *spectrum)
+ * @param fourStep - FFT after fourStepExecute()
+ * @param bins - Frequency bins wanted, as indices of the numFrames-point FFT
+ * @param numBins - Number of frequency bins
+ * @param spectrum - Resulting rows of the capture FT (numBins x numOfSamplers), scaled like computeFFT()
+ * @return int
+ * @brief Second pass, only over the columns that hold a wanted bin: reads each one, transforms it over
+ *      the rows and copies out the wanted bins. Returns 0 on success, -1 on a read error
+ * @author ericdvet */
+int fourStepBins(FourStepFFT *fourStep, const int *bins, int numBins, double complex *spectrum);
+
+/**
+ * @function fourStepFree(FourStepFFT *fourStep)
+ * @param fourStep - FourStepFFT to free
+ * @return None
+ * @brief Free a FourStepFFT constructed by fourStepCreate(), closing (and so deleting) its scratch file
+ * @author ericdvet */
+void fourStepFree(FourStepFFT *fourStep);
+
+#endif // FOURSTEP_H
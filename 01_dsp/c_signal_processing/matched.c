@@ -0,0 +1,486 @@
+/*
+ * File:   matched.c
+ * Author: ericdvet
+ *
+ * Fast-time matched filter, correlating every baseband frame with the Chipotle pulse in the frequency domain
+ */
+
+#include "matched.h"
+#include "utils.h"
+#include "ddc.h"
+#include <math.h>
+#include <string.h>
+
+#define PI 3.14159265358979323846
+
+/**
+ * @function matchedPulseNormalize(double complex *pulse, int pulseLength)
+ * @param pulse - Pulse scaled in place
+ * @param pulseLength - Number of samples in the pulse
+ * @return int
+ * @brief Scales a pulse to unit energy. Returns -1 for a pulse of zero energy
+ * @author ericdvet */
+static int matchedPulseNormalize(double complex *pulse, int pulseLength)
+{
+    double energy = 0;
+    for (int i = 0; i < pulseLength; i++)
+    {
+        energy += creal(pulse[i]) * creal(pulse[i]) + cimag(pulse[i]) * cimag(pulse[i]);
+    }
+    if (energy <= 0)
+    {
+        return -1;
+    }
+    double scale = 1.0 / sqrt(energy);
+    for (int i = 0; i < pulseLength; i++)
+    {
+        pulse[i] *= scale;
+    }
+    return 0;
+}
+
+/**
+ * @function matchedPulseModel(double CF, double Fs, double bandwidth, double bwrDB, int frameSize, int decimation, int *pulseLength, int *pulseCenter)
+ * @param CF - Center frequency of the radar in Hz
+ * @param Fs - Sampling rate of the radar in Hz
+ * @param bandwidth - Bandwidth of the pulse in Hz
+ * @param bwrDB - dB down from the peak the bandwidth is measured at
+ * @param frameSize - Number of samplers per frame
+ * @param decimation - Decimation of the baseband frames the pulse is matched to
+ * @param pulseLength - Resulting number of baseband samples in the pulse
+ * @param pulseCenter - Resulting index of the pulse peak
+ * @return double complex *
+ * @brief Synthesizes the Gaussian pulse of NoveldaChipParams.m (as gauspuls() does) in the middle of an
+ *      RF frame and downconverts it with the same DDC as the capture, so the template also carries the
+ *      DDC's low-pass. Cut to MATCHED_PULSE_FLOOR and scaled to unit energy. NULL on error
+ * @author ericdvet */
+double complex *matchedPulseModel(double CF, double Fs, double bandwidth, double bwrDB, int frameSize, int decimation, int *pulseLength,
+                                  int *pulseCenter)
+{
+    if (bandwidth <= 0 || bwrDB <= 0)
+    {
+        fprintf(stderr, "ERROR: Invalid pulse bandwidth\n");
+        return NULL;
+    }
+
+    DDCPlan *ddcPlan = ddcPlanCreate(CF, Fs, frameSize, decimation);
+    if (!ddcPlan)
+    {
+        return NULL;
+    }
+    int outputSize = ddcPlan->outputSize;
+    double *rfPulse = (double *)malloc(frameSize * sizeof(double));
+    double complex *basebandPulse = (double complex *)malloc(outputSize * sizeof(double complex));
+    if (!rfPulse || !basebandPulse)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        free(rfPulse);
+        free(basebandPulse);
+        ddcPlanFree(ddcPlan);
+        return NULL;
+    }
+
+    // gauspuls(): envelope exp(-a t^2) that is bwrDB down at +/- bandwidth / 2
+    double ref = pow(10.0, -bwrDB / 20.0);
+    double a = -(PI * bandwidth) * (PI * bandwidth) / (4.0 * log(ref));
+    int rfCenter = (frameSize / 2 / decimation) * decimation;
+    for (int i = 0; i < frameSize; i++)
+    {
+        double t = (i - rfCenter) / Fs;
+        rfPulse[i] = exp(-a * t * t) * cos(2 * PI * CF * t);
+    }
+    ddcProcessBlock(ddcPlan, rfPulse, basebandPulse, 1);
+    ddcPlanFree(ddcPlan);
+    free(rfPulse);
+
+    int peak = 0;
+    for (int i = 1; i < outputSize; i++)
+    {
+        if (cabs(basebandPulse[i]) > cabs(basebandPulse[peak]))
+        {
+            peak = i;
+        }
+    }
+    double pulseFloor = MATCHED_PULSE_FLOOR * cabs(basebandPulse[peak]);
+    int start = peak;
+    int end = peak;
+    while (start > 0 && cabs(basebandPulse[start - 1]) >= pulseFloor)
+    {
+        start--;
+    }
+    while (end < outputSize - 1 && cabs(basebandPulse[end + 1]) >= pulseFloor)
+    {
+        end++;
+    }
+
+    *pulseLength = end - start + 1;
+    *pulseCenter = peak - start;
+    memmove(basebandPulse, &basebandPulse[start], (*pulseLength) * sizeof(double complex));
+    if (matchedPulseNormalize(basebandPulse, *pulseLength) < 0)
+    {
+        fprintf(stderr, "ERROR: Pulse model has no energy\n");
+        free(basebandPulse);
+        return NULL;
+    }
+    return basebandPulse;
+}
+
+/**
+ * @function matchedPulseMeasure(const double complex *meanFrame, int numOfSamplers, int pulseLength, int *pulseCenter)
+ * @param meanFrame - Baseband frame averaged over an air capture, so only the static returns are left
+ * @param numOfSamplers - Number of range bins per frame
+ * @param pulseLength - Number of samples to cut, usually the length of matchedPulseModel()
+ * @param pulseCenter - Resulting index of the direct path within the pulse
+ * @return double complex *
+ * @brief Cuts the direct-path return, the strongest bin of the mean frame, out of an air capture and
+ *      scales it to unit energy. NULL on error
+ * @author ericdvet */
+double complex *matchedPulseMeasure(const double complex *meanFrame, int numOfSamplers, int pulseLength, int *pulseCenter)
+{
+    if (pulseLength < 1 || pulseLength > numOfSamplers)
+    {
+        fprintf(stderr, "ERROR: Invalid pulse length %d\n", pulseLength);
+        return NULL;
+    }
+
+    int peak = 0;
+    for (int i = 1; i < numOfSamplers; i++)
+    {
+        if (cabs(meanFrame[i]) > cabs(meanFrame[peak]))
+        {
+            peak = i;
+        }
+    }
+
+    // Centered on the direct path unless that runs off either end of the frame
+    int start = peak - pulseLength / 2;
+    start = start < 0 ? 0 : start;
+    start = start + pulseLength > numOfSamplers ? numOfSamplers - pulseLength : start;
+
+    double complex *pulse = (double complex *)malloc(pulseLength * sizeof(double complex));
+    if (!pulse)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        return NULL;
+    }
+    memcpy(pulse, &meanFrame[start], pulseLength * sizeof(double complex));
+    if (matchedPulseNormalize(pulse, pulseLength) < 0)
+    {
+        fprintf(stderr, "ERROR: Air capture has no direct-path return\n");
+        free(pulse);
+        return NULL;
+    }
+    *pulseCenter = peak - start;
+    return pulse;
+}
+
+/**
+ * @function matchedFilterCreate(const double complex *pulse, int pulseLength, int pulseCenter, int numOfSamplers, int blockFrames)
+ * @param pulse - Baseband pulse the frames are correlated with
+ * @param pulseLength - Number of samples in the pulse
+ * @param pulseCenter - Index of the pulse peak, which is kept at the range bin of the return
+ * @param numOfSamplers - Number of range bins per frame
+ * @param blockFrames - Most frames filtered by one pass of the batched FFTs
+ * @return MatchedFilter *
+ * @brief Precomputes the pulse spectrum once, so each block of frames costs one batched forward and
+ *      inverse FFT of fftLength. A unit energy pulse leaves the noise power of a range bin unchanged
+ * @author ericdvet */
+MatchedFilter *matchedFilterCreate(const double complex *pulse, int pulseLength, int pulseCenter, int numOfSamplers, int blockFrames)
+{
+    if (pulseLength < 1 || pulseCenter < 0 || pulseCenter >= pulseLength || numOfSamplers < 1 || blockFrames < 1)
+    {
+        fprintf(stderr, "ERROR: Invalid matched filter\n");
+        return NULL;
+    }
+
+    MatchedFilter *matched = (MatchedFilter *)calloc(1, sizeof(MatchedFilter));
+    if (!matched)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        return NULL;
+    }
+    matched->numOfSamplers = numOfSamplers;
+    matched->pulseLength = pulseLength;
+    matched->blockFrames = blockFrames;
+    matched->fftLength = fftFastLength(numOfSamplers + pulseLength - 1);
+    int fftLength = matched->fftLength;
+
+    matched->filter = (double complex *)fftw_malloc(fftLength * sizeof(double complex));
+    matched->filterf = (float complex *)malloc(fftLength * sizeof(float complex));
+    matched->work = (double complex *)fftw_malloc((size_t)blockFrames * fftLength * sizeof(double complex));
+    if (!matched->filter || !matched->filterf || !matched->work)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        matchedFilterFree(matched);
+        return NULL;
+    }
+
+    // One zero-padded frame per row, so the block is a single batched transform
+    fftw_complex *work = (fftw_complex *)matched->work;
+    matched->forward = fftw_plan_many_dft(1, &fftLength, blockFrames, work, NULL, 1, fftLength, work, NULL, 1, fftLength, FFTW_FORWARD,
+                                          FFTW_MEASURE);
+    matched->inverse = fftw_plan_many_dft(1, &fftLength, blockFrames, work, NULL, 1, fftLength, work, NULL, 1, fftLength, FFTW_BACKWARD,
+                                          FFTW_MEASURE);
+    fftw_plan pulsePlan = fftw_plan_dft_1d(fftLength, (fftw_complex *)matched->filter, (fftw_complex *)matched->filter, FFTW_FORWARD,
+                                           FFTW_ESTIMATE);
+    if (!matched->forward || !matched->inverse || !pulsePlan)
+    {
+        fprintf(stderr, "ERROR: Unable to plan matched filter FFTs\n");
+        if (pulsePlan)
+        {
+            fftw_destroy_plan(pulsePlan);
+        }
+        matchedFilterFree(matched);
+        return NULL;
+    }
+
+    // y(n) = sum_m x(n + m) conj(q(m)) with q(m) = pulse(m + pulseCenter), so Y = X conj(Q)
+    memset(matched->filter, 0, fftLength * sizeof(double complex));
+    for (int j = 0; j < pulseLength; j++)
+    {
+        matched->filter[(j - pulseCenter + fftLength) % fftLength] = pulse[j];
+    }
+    fftw_execute(pulsePlan);
+    fftw_destroy_plan(pulsePlan);
+    for (int k = 0; k < fftLength; k++)
+    {
+        matched->filter[k] = conj(matched->filter[k]) / fftLength;
+        matched->filterf[k] = (float complex)matched->filter[k];
+    }
+
+    return matched;
+}
+
+/**
+ * @function matchedFilterApply(MatchedFilter *matched, double complex *framesBB, int numFrames)
+ * @param matched - Filter created by matchedFilterCreate()
+ * @param framesBB - Baseband frames (numFrames x numOfSamplers), replaced by their correlation with the pulse
+ * @param numFrames - Number of frames, any number, filtered blockFrames at a time
+ * @return None
+ * @brief Matched filters a block of frames in place
+ * @author ericdvet */
+void matchedFilterApply(MatchedFilter *matched, double complex *framesBB, int numFrames)
+{
+    int numOfSamplers = matched->numOfSamplers;
+    int fftLength = matched->fftLength;
+
+    for (int blockStart = 0; blockStart < numFrames; blockStart += matched->blockFrames)
+    {
+        int blockFrames = numFrames - blockStart < matched->blockFrames ? numFrames - blockStart : matched->blockFrames;
+        double complex *block = &framesBB[(size_t)blockStart * numOfSamplers];
+
+        for (int n = 0; n < blockFrames; n++)
+        {
+            double complex *row = &matched->work[(size_t)n * fftLength];
+            memcpy(row, &block[(size_t)n * numOfSamplers], numOfSamplers * sizeof(double complex));
+            memset(&row[numOfSamplers], 0, (fftLength - numOfSamplers) * sizeof(double complex));
+        }
+        fftw_execute(matched->forward);
+        for (int n = 0; n < blockFrames; n++)
+        {
+            double complex *row = &matched->work[(size_t)n * fftLength];
+            for (int k = 0; k < fftLength; k++)
+            {
+                row[k] *= matched->filter[k];
+            }
+        }
+        fftw_execute(matched->inverse);
+        for (int n = 0; n < blockFrames; n++)
+        {
+            memcpy(&block[(size_t)n * numOfSamplers], &matched->work[(size_t)n * fftLength], numOfSamplers * sizeof(double complex));
+        }
+    }
+}
+
+/**
+ * @function matchedFilterApplyf(MatchedFilter *matched, float complex *framesBB, int numFrames)
+ * @param matched - Filter created by matchedFilterCreate()
+ * @param framesBB - Baseband frames (numFrames x numOfSamplers), replaced by their correlation with the pulse
+ * @param numFrames - Number of frames, any number, filtered blockFrames at a time
+ * @return int
+ * @brief Single precision matchedFilterApply(). Returns 0 on success, -1 if the float FFTs cannot be planned
+ * @author ericdvet */
+int matchedFilterApplyf(MatchedFilter *matched, float complex *framesBB, int numFrames)
+{
+    int numOfSamplers = matched->numOfSamplers;
+    int fftLength = matched->fftLength;
+
+    if (!matched->workf)
+    {
+        matched->workf = (float complex *)fftwf_malloc((size_t)matched->blockFrames * fftLength * sizeof(float complex));
+        if (!matched->workf)
+        {
+            fprintf(stderr, "ERROR: Memory allocation failure\n");
+            return -1;
+        }
+        fftwf_complex *work = (fftwf_complex *)matched->workf;
+        matched->forwardf = fftwf_plan_many_dft(1, &fftLength, matched->blockFrames, work, NULL, 1, fftLength, work, NULL, 1, fftLength,
+                                                FFTW_FORWARD, FFTW_MEASURE);
+        matched->inversef = fftwf_plan_many_dft(1, &fftLength, matched->blockFrames, work, NULL, 1, fftLength, work, NULL, 1, fftLength,
+                                                FFTW_BACKWARD, FFTW_MEASURE);
+    }
+    if (!matched->forwardf || !matched->inversef)
+    {
+        fprintf(stderr, "ERROR: Unable to plan matched filter FFTs\n");
+        return -1;
+    }
+
+    for (int blockStart = 0; blockStart < numFrames; blockStart += matched->blockFrames)
+    {
+        int blockFrames = numFrames - blockStart < matched->blockFrames ? numFrames - blockStart : matched->blockFrames;
+        float complex *block = &framesBB[(size_t)blockStart * numOfSamplers];
+
+        for (int n = 0; n < blockFrames; n++)
+        {
+            float complex *row = &matched->workf[(size_t)n * fftLength];
+            memcpy(row, &block[(size_t)n * numOfSamplers], numOfSamplers * sizeof(float complex));
+            memset(&row[numOfSamplers], 0, (fftLength - numOfSamplers) * sizeof(float complex));
+        }
+        fftwf_execute(matched->forwardf);
+        for (int n = 0; n < blockFrames; n++)
+        {
+            float complex *row = &matched->workf[(size_t)n * fftLength];
+            for (int k = 0; k < fftLength; k++)
+            {
+                row[k] *= matched->filterf[k];
+            }
+        }
+        fftwf_execute(matched->inversef);
+        for (int n = 0; n < blockFrames; n++)
+        {
+            memcpy(&block[(size_t)n * numOfSamplers], &matched->workf[(size_t)n * fftLength], numOfSamplers * sizeof(float complex));
+        }
+    }
+    return 0;
+}
+
+/**
+ * @function matchedFilterFree(MatchedFilter *matched)
+ * @param matched - MatchedFilter to free
+ * @return None
+ * @brief Free a MatchedFilter constructed by matchedFilterCreate()
+ * @author ericdvet */
+void matchedFilterFree(MatchedFilter *matched)
+{
+    if (matched)
+    {
+        if (matched->forward)
+        {
+            fftw_destroy_plan(matched->forward);
+        }
+        if (matched->inverse)
+        {
+            fftw_destroy_plan(matched->inverse);
+        }
+        if (matched->forwardf)
+        {
+            fftwf_destroy_plan(matched->forwardf);
+        }
+        if (matched->inversef)
+        {
+            fftwf_destroy_plan(matched->inversef);
+        }
+        fftw_free(matched->filter);
+        fftw_free(matched->work);
+        fftwf_free(matched->workf);
+        free(matched->filterf);
+        free(matched);
+    }
+}
+
+// #define MATCHED_TEST
+
+#ifdef MATCHED_TEST
+#include <time.h>
+
+int main()
+{
+    int frameSize = 512;
+    int numFrames = 200;
+    int echoBin = 200;
+
+    int pulseLength;
+    int pulseCenter;
+    double complex *pulse = matchedPulseModel(CHIPOTLE_CF, CHIPOTLE_FS, CHIPOTLE_BW, CHIPOTLE_BWR, frameSize, 1, &pulseLength, &pulseCenter);
+    if (!pulse)
+    {
+        return -1;
+    }
+    MatchedFilter *matched = matchedFilterCreate(pulse, pulseLength, pulseCenter, frameSize, 64);
+
+    // A weak echo of the pulse in unit power complex noise
+    double complex *framesBB = (double complex *)malloc((size_t)numFrames * frameSize * sizeof(double complex));
+    double complex *original = (double complex *)malloc((size_t)numFrames * frameSize * sizeof(double complex));
+    float complex *framesBBf = (float complex *)malloc((size_t)numFrames * frameSize * sizeof(float complex));
+    srand(1);
+    for (int n = 0; n < numFrames; n++)
+    {
+        for (int i = 0; i < frameSize; i++)
+        {
+            double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+            double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+            double complex noise = sqrt(-log(u1)) * cexp(I * 2 * PI * u2);
+            int j = i - echoBin + pulseCenter;
+            framesBB[(size_t)n * frameSize + i] = noise + (j >= 0 && j < pulseLength ? 2.0 * pulse[j] : 0);
+        }
+    }
+    memcpy(original, framesBB, (size_t)numFrames * frameSize * sizeof(double complex));
+    for (size_t k = 0; k < (size_t)numFrames * frameSize; k++)
+    {
+        framesBBf[k] = (float complex)framesBB[k];
+    }
+
+    clock_t start = clock();
+    matchedFilterApply(matched, framesBB, numFrames);
+    double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+    matchedFilterApplyf(matched, framesBBf, numFrames);
+
+    // Against a direct correlation, and the echo to noise power of one frame's bin before and after
+    double maxError = 0;
+    double maxErrorf = 0;
+    double echoBefore = 0, echoAfter = 0, noiseBefore = 0, noiseAfter = 0;
+    int noiseCount = 0;
+    for (int n = 0; n < numFrames; n++)
+    {
+        const double complex *frame = &original[(size_t)n * frameSize];
+        for (int i = 0; i < frameSize; i++)
+        {
+            double complex direct = 0;
+            for (int j = 0; j < pulseLength; j++)
+            {
+                int m = i + j - pulseCenter;
+                if (m >= 0 && m < frameSize)
+                {
+                    direct += frame[m] * conj(pulse[j]);
+                }
+            }
+            maxError = fmax(maxError, cabs(direct - framesBB[(size_t)n * frameSize + i]));
+            maxErrorf = fmax(maxErrorf, cabs(direct - framesBBf[(size_t)n * frameSize + i]));
+        }
+        echoBefore += cabs(frame[echoBin]);
+        echoAfter += cabs(framesBB[(size_t)n * frameSize + echoBin]);
+        for (int i = 0; i < 100; i++)
+        {
+            noiseBefore += pow(cabs(frame[i]), 2);
+            noiseAfter += pow(cabs(framesBB[(size_t)n * frameSize + i]), 2);
+            noiseCount++;
+        }
+    }
+    echoBefore /= numFrames;
+    echoAfter /= numFrames;
+
+    printf("Matched filter of %d samples (center %d) over %d frames: %f ms, FFT length %d\n", pulseLength, pulseCenter, numFrames,
+           elapsed * 1000, matched->fftLength);
+    printf("Max error against direct correlation %g (float %g)\n", maxError, maxErrorf);
+    printf("Echo %.2f -> %.2f, noise power %.3f -> %.3f, per-frame SNR gain %.1f dB\n", echoBefore, echoAfter, noiseBefore / noiseCount,
+           noiseAfter / noiseCount, 10 * log10(echoAfter * echoAfter / (noiseAfter / noiseCount)) -
+                                        10 * log10(echoBefore * echoBefore / (noiseBefore / noiseCount)));
+
+    matchedFilterFree(matched);
+    free(pulse);
+    free(framesBB);
+    free(framesBBf);
+    free(original);
+    return 0;
+}
+#endif
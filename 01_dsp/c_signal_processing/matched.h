@@ -0,0 +1,115 @@
+/*
+ * File:   matched.h
+ * Author: ericdvet
+ *
+ * Fast-time matched filter, correlating every baseband frame with the Chipotle pulse in the frequency domain
+ */
+
+#ifndef MATCHED_H
+#define MATCHED_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <complex.h>
+#include <fftw3.h>
+
+// Chipotle pulse generator, NoveldaChipParams('X1-IPG1', 0, '4mm'): -10 dB cutoffs 435 MHz and 3165 MHz,
+// bandwidth given bwr dB down
+#define CHIPOTLE_BW 2.73E9
+#define CHIPOTLE_BWR 12.0
+
+// The modeled pulse is cut where its envelope falls below this fraction of its peak
+#define MATCHED_PULSE_FLOOR 0.01
+
+/**
+ * @struct MatchedFilter
+ * @brief Conjugate pulse spectrum and batched FFTs that correlate a block of frames with the pulse
+ * @author ericdvet */
+typedef struct
+{
+    int numOfSamplers;
+    int pulseLength;
+    int blockFrames;
+    int fftLength;             // >= numOfSamplers + pulseLength - 1, so the correlation does not wrap
+    double complex *filter;    // conj(FFT(pulse)) / fftLength, the pulse center rotated to index 0
+    double complex *work;      // blockFrames x fftLength, one zero-padded frame per row
+    fftw_plan forward;
+    fftw_plan inverse;
+    float complex *filterf;
+    float complex *workf;
+    fftwf_plan forwardf;       // planned by the first matchedFilterApplyf()
+    fftwf_plan inversef;
+} MatchedFilter;
+
+/**
+ * @function matchedPulseModel(double CF, double Fs, double bandwidth, double bwrDB, int frameSize, int decimation, int *pulseLength, int *pulseCenter)
+ * @param CF - Center frequency of the radar in Hz
+ * @param Fs - Sampling rate of the radar in Hz
+ * @param bandwidth - Bandwidth of the pulse in Hz
+ * @param bwrDB - dB down from the peak the bandwidth is measured at
+ * @param frameSize - Number of samplers per frame
+ * @param decimation - Decimation of the baseband frames the pulse is matched to
+ * @param pulseLength - Resulting number of baseband samples in the pulse
+ * @param pulseCenter - Resulting index of the pulse peak
+ * @return double complex *
+ * @brief Synthesizes the Gaussian pulse of NoveldaChipParams.m (as gauspuls() does) in the middle of an
+ *      RF frame and downconverts it with the same DDC as the capture, so the template also carries the
+ *      DDC's low-pass. Cut to MATCHED_PULSE_FLOOR and scaled to unit energy. NULL on error
+ * @author ericdvet */
+double complex *matchedPulseModel(double CF, double Fs, double bandwidth, double bwrDB, int frameSize, int decimation, int *pulseLength,
+                                  int *pulseCenter);
+
+/**
+ * @function matchedPulseMeasure(const double complex *meanFrame, int numOfSamplers, int pulseLength, int *pulseCenter)
+ * @param meanFrame - Baseband frame averaged over an air capture, so only the static returns are left
+ * @param numOfSamplers - Number of range bins per frame
+ * @param pulseLength - Number of samples to cut, usually the length of matchedPulseModel()
+ * @param pulseCenter - Resulting index of the direct path within the pulse
+ * @return double complex *
+ * @brief Cuts the direct-path return, the strongest bin of the mean frame, out of an air capture and
+ *      scales it to unit energy. NULL on error
+ * @author ericdvet */
+double complex *matchedPulseMeasure(const double complex *meanFrame, int numOfSamplers, int pulseLength, int *pulseCenter);
+
+/**
+ * @function matchedFilterCreate(const double complex *pulse, int pulseLength, int pulseCenter, int numOfSamplers, int blockFrames)
+ * @param pulse - Baseband pulse the frames are correlated with
+ * @param pulseLength - Number of samples in the pulse
+ * @param pulseCenter - Index of the pulse peak, which is kept at the range bin of the return
+ * @param numOfSamplers - Number of range bins per frame
+ * @param blockFrames - Most frames filtered by one pass of the batched FFTs
+ * @return MatchedFilter *
+ * @brief Precomputes the pulse spectrum once, so each block of frames costs one batched forward and
+ *      inverse FFT of fftLength. A unit energy pulse leaves the noise power of a range bin unchanged
+ * @author ericdvet */
+MatchedFilter *matchedFilterCreate(const double complex *pulse, int pulseLength, int pulseCenter, int numOfSamplers, int blockFrames);
+
+/**
+ * @function matchedFilterApply(MatchedFilter *matched, double complex *framesBB, int numFrames)
+ * @param matched - Filter created by matchedFilterCreate()
+ * @param framesBB - Baseband frames (numFrames x numOfSamplers), replaced by their correlation with the pulse
+ * @param numFrames - Number of frames, any number, filtered blockFrames at a time
+ * @return None
+ * @brief Matched filters a block of frames in place
+ * @author ericdvet */
+void matchedFilterApply(MatchedFilter *matched, double complex *framesBB, int numFrames);
+
+/**
+ * @function matchedFilterApplyf(MatchedFilter *matched, float complex *framesBB, int numFrames)
+ * @param matched - Filter created by matchedFilterCreate()
+ * @param framesBB - Baseband frames (numFrames x numOfSamplers), replaced by their correlation with the pulse
+ * @param numFrames - Number of frames, any number, filtered blockFrames at a time
+ * @return int
+ * @brief Single precision matchedFilterApply(). Returns 0 on success, -1 if the float FFTs cannot be planned
+ * @author ericdvet */
+int matchedFilterApplyf(MatchedFilter *matched, float complex *framesBB, int numFrames);
+
+/**
+ * @function matchedFilterFree(MatchedFilter *matched)
+ * @param matched - MatchedFilter to free
+ * @return None
+ * @brief Free a MatchedFilter constructed by matchedFilterCreate()
+ * @author ericdvet */
+void matchedFilterFree(MatchedFilter *matched);
+
+#endif // MATCHED_H
@@ -0,0 +1,281 @@
+/*
+ * File:   pncorr.c
+ * Author: ericdvet
+ *
+ * Slow-time despreading of tags keyed by pseudo-noise codes, by FFT circular correlation across frames
+ */
+
+#include "pncorr.h"
+#include <math.h>
+#include <string.h>
+
+/**
+ * @function pnCorrelatorCreate(const int *codes, int codeLength, int numCodes, double chipRate, double frameRate, int numFrames, int numOfSamplers)
+ * @param codes - Chips of every code, numCodes x codeLength, 0 or 1 like pn[] in radarBackscatter.ino
+ * @param codeLength - Number of chips per code
+ * @param numCodes - Number of codes
+ * @param chipRate - Chips per second sent by the tag, 1 / period of radarBackscatter.ino
+ * @param frameRate - Frame rate of the radar in Hz
+ * @param numFrames - Frames in the capture, the length of the correlation
+ * @param numOfSamplers - Number of range bins per frame
+ * @return PNCorrelator *
+ * @brief Samples each code as +/-1 at the frame times, repeating it over the capture, and keeps the
+ *      conjugate of its spectrum with the DC bin removed so static clutter does not correlate
+ * @author ericdvet */
+PNCorrelator *pnCorrelatorCreate(const int *codes, int codeLength, int numCodes, double chipRate, double frameRate, int numFrames,
+                                 int numOfSamplers)
+{
+    if (codeLength < 1 || numCodes < 1 || chipRate <= 0 || frameRate <= 0 || numFrames < 2 || numOfSamplers < 1)
+    {
+        fprintf(stderr, "ERROR: Invalid PN correlator\n");
+        return NULL;
+    }
+
+    PNCorrelator *pn = (PNCorrelator *)calloc(1, sizeof(PNCorrelator));
+    if (!pn)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        return NULL;
+    }
+    pn->numFrames = numFrames;
+    pn->numOfSamplers = numOfSamplers;
+    pn->numCodes = numCodes;
+    pn->chipFrames = frameRate / chipRate;
+    pn->codeFrames = codeLength * pn->chipFrames;
+
+    pn->codeFT = (double complex *)fftw_malloc((size_t)numCodes * numFrames * sizeof(double complex));
+    pn->correlation = (double complex *)fftw_malloc((size_t)numFrames * numOfSamplers * sizeof(double complex));
+    pn->lagEnergy = (double *)malloc(numFrames * sizeof(double));
+    if (!pn->codeFT || !pn->correlation || !pn->lagEnergy)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        pnCorrelatorFree(pn);
+        return NULL;
+    }
+
+    // Every range bin is a column of the frame-major capture FT, so one plan inverts all of them in place
+    fftw_complex *correlation = (fftw_complex *)pn->correlation;
+    pn->inverse = fftw_plan_many_dft(1, &numFrames, numOfSamplers, correlation, NULL, numOfSamplers, 1, correlation, NULL, numOfSamplers, 1,
+                                     FFTW_BACKWARD, FFTW_ESTIMATE);
+    if (!pn->inverse)
+    {
+        fprintf(stderr, "ERROR: Unable to plan PN correlation FFT\n");
+        pnCorrelatorFree(pn);
+        return NULL;
+    }
+
+    for (int code = 0; code < numCodes; code++)
+    {
+        double complex *codeFT = &pn->codeFT[(size_t)code * numFrames];
+        fftw_plan forward = fftw_plan_dft_1d(numFrames, (fftw_complex *)codeFT, (fftw_complex *)codeFT, FFTW_FORWARD, FFTW_ESTIMATE);
+        if (!forward)
+        {
+            fprintf(stderr, "ERROR: Unable to plan PN code FFT\n");
+            pnCorrelatorFree(pn);
+            return NULL;
+        }
+
+        // The tag is not synchronized to the radar, so the chip under each frame is taken from the frame time
+        for (int n = 0; n < numFrames; n++)
+        {
+            int chip = (int)((long)floor(n / pn->chipFrames) % codeLength);
+            codeFT[n] = codes[(size_t)code * codeLength + chip] ? 1 : -1;
+        }
+        fftw_execute(forward);
+        fftw_destroy_plan(forward);
+
+        // Conjugate for correlation, with the 1 / numFrames of the inverse FFT folded in
+        codeFT[0] = 0;
+        for (int k = 1; k < numFrames; k++)
+        {
+            codeFT[k] = conj(codeFT[k]) / numFrames;
+        }
+    }
+
+    return pn;
+}
+
+/**
+ * @function pnCorrelatorDespread(PNCorrelator *pn, const double complex *captureFT, int code, double *codeFT)
+ * @param pn - Correlator created by pnCorrelatorCreate()
+ * @param captureFT - Slow-time FFT of the capture from computeFFT() (numFrames x numOfSamplers)
+ * @param code - Index of the code to despread
+ * @param codeFT - Resulting magnitude of every range bin's correlation with the code at the best lag
+ *      (numOfSamplers), used like the tag FT of procRadarFrames()
+ * @return int
+ * @brief Circularly correlates every range bin with the code in one batched inverse FFT and returns the
+ *      lag, in frames, with the most correlation energy over all range bins
+ * @author ericdvet */
+int pnCorrelatorDespread(PNCorrelator *pn, const double complex *captureFT, int code, double *codeFT)
+{
+    int numFrames = pn->numFrames;
+    int numOfSamplers = pn->numOfSamplers;
+    const double complex *reference = &pn->codeFT[(size_t)code * numFrames];
+
+    for (int k = 0; k < numFrames; k++)
+    {
+        const double complex *row = &captureFT[(size_t)k * numOfSamplers];
+        double complex *out = &pn->correlation[(size_t)k * numOfSamplers];
+        for (int i = 0; i < numOfSamplers; i++)
+        {
+            out[i] = row[i] * reference[k];
+        }
+    }
+    fftw_execute(pn->inverse);
+
+    // The tag's code phase is the same in every range bin, so the lag is chosen once for the whole profile
+    pn->lag = 0;
+    for (int n = 0; n < numFrames; n++)
+    {
+        const double complex *row = &pn->correlation[(size_t)n * numOfSamplers];
+        double energy = 0;
+        for (int i = 0; i < numOfSamplers; i++)
+        {
+            energy += creal(row[i]) * creal(row[i]) + cimag(row[i]) * cimag(row[i]);
+        }
+        pn->lagEnergy[n] = energy;
+        if (energy > pn->lagEnergy[pn->lag])
+        {
+            pn->lag = n;
+        }
+    }
+
+    const double complex *best = &pn->correlation[(size_t)pn->lag * numOfSamplers];
+    for (int i = 0; i < numOfSamplers; i++)
+    {
+        codeFT[i] = cabs(best[i]);
+    }
+    return pn->lag;
+}
+
+/**
+ * @function pnCorrelatorSNR(const PNCorrelator *pn, int peakBin)
+ * @param pn - Correlator after pnCorrelatorDespread()
+ * @param peakBin - Determined peak bin location of backscatter tag
+ * @return double
+ * @brief Power of the correlation peak at peakBin over the mean power of the lags away from it and from
+ *      its repeats every code period, in dB
+ * @author ericdvet */
+double pnCorrelatorSNR(const PNCorrelator *pn, int peakBin)
+{
+    if (peakBin < 0 || peakBin >= pn->numOfSamplers)
+    {
+        return 0;
+    }
+
+    int numFrames = pn->numFrames;
+    double guard = ceil(pn->chipFrames) + 1;
+    double noise = 0;
+    int numNoise = 0;
+    for (int n = 0; n < numFrames; n++)
+    {
+        // A periodic code correlates as strongly one code period away, so those lags are not noise
+        int offset = (n - pn->lag + numFrames) % numFrames;
+        double distance = fmin(offset, numFrames - offset);
+        if (pn->codeFrames < numFrames)
+        {
+            double phase = fmod(offset, pn->codeFrames);
+            distance = fmin(distance, fmin(phase, pn->codeFrames - phase));
+        }
+        if (distance > guard)
+        {
+            double complex value = pn->correlation[(size_t)n * pn->numOfSamplers + peakBin];
+            noise += creal(value) * creal(value) + cimag(value) * cimag(value);
+            numNoise++;
+        }
+    }
+    if (numNoise == 0 || noise == 0)
+    {
+        return 0;
+    }
+
+    double complex peak = pn->correlation[(size_t)pn->lag * pn->numOfSamplers + peakBin];
+    double signal = creal(peak) * creal(peak) + cimag(peak) * cimag(peak);
+    return 10 * log10(signal / (noise / numNoise));
+}
+
+/**
+ * @function pnCorrelatorFree(PNCorrelator *pn)
+ * @param pn - PNCorrelator to free
+ * @return None
+ * @brief Free a PNCorrelator constructed by pnCorrelatorCreate()
+ * @author ericdvet */
+void pnCorrelatorFree(PNCorrelator *pn)
+{
+    if (pn)
+    {
+        if (pn->inverse)
+        {
+            fftw_destroy_plan(pn->inverse);
+        }
+        fftw_free(pn->codeFT);
+        fftw_free(pn->correlation);
+        free(pn->lagEnergy);
+        free(pn);
+    }
+}
+
+// #define PNCORR_TEST
+
+#ifdef PNCORR_TEST
+#include "utils.h"
+
+int main()
+{
+    int numFrames = 2000;
+    int numOfSamplers = 512;
+    double frameRate = 200;
+    double chipRate = 160;
+    int codeLength = 32;
+
+    // Second code is the commented out pn[] of radarBackscatter.ino, first is a random one
+    int codes[2 * 32] = {0};
+    for (int c = 0; c < codeLength; c++)
+    {
+        codes[c] = rand() % 2;
+    }
+    int pnSequence[32] = {0, 1, 1, 0, 1, 0, 1, 0, 1, 1, 1, 0, 0, 0, 0, 1, 0, 1, 1, 1, 1, 0, 0, 1, 1, 0, 1, 0, 1, 0, 1, 0};
+    memcpy(&codes[codeLength], pnSequence, sizeof(pnSequence));
+
+    // Two tags in the same band at range bins 200 and 320, with code offsets of 7 and 19 chips, over clutter
+    int tagBins[2] = {200, 320};
+    int tagChips[2] = {7, 19};
+    double complex *framesBB = (double complex *)malloc((size_t)numFrames * numOfSamplers * sizeof(double complex));
+    double complex *captureFT = (double complex *)malloc((size_t)numFrames * numOfSamplers * sizeof(double complex));
+    for (int n = 0; n < numFrames; n++)
+    {
+        for (int i = 0; i < numOfSamplers; i++)
+        {
+            double complex sample = 5 * exp(-pow(i - 100, 2) / 800.0) + 0.2 * ((rand() % 100) / 100.0 - 0.5) +
+                                    0.2 * I * ((rand() % 100) / 100.0 - 0.5);
+            for (int t = 0; t < 2; t++)
+            {
+                int chip = ((int)floor(n * chipRate / frameRate) + tagChips[t]) % codeLength;
+                sample += (codes[t * codeLength + chip] ? 0.05 : -0.05) * exp(-pow(i - tagBins[t], 2) / 50.0);
+            }
+            framesBB[(size_t)n * numOfSamplers + i] = sample;
+        }
+    }
+    computeFFT(framesBB, captureFT, numFrames, numOfSamplers);
+
+    PNCorrelator *pn = pnCorrelatorCreate(codes, codeLength, 2, chipRate, frameRate, numFrames, numOfSamplers);
+    double *codeFT = (double *)malloc(numOfSamplers * sizeof(double));
+    for (int code = 0; code < 2; code++)
+    {
+        int lag = pnCorrelatorDespread(pn, captureFT, code, codeFT);
+        int peakBin = 0;
+        for (int i = 1; i < numOfSamplers; i++)
+        {
+            peakBin = codeFT[i] > codeFT[peakBin] ? i : peakBin;
+        }
+        printf("Code %d: lag %d frames, peak bin %d (expected %d), SNR %.2f dB\n", code, lag, peakBin, tagBins[code],
+               pnCorrelatorSNR(pn, peakBin));
+    }
+
+    pnCorrelatorFree(pn);
+    free(codeFT);
+    free(framesBB);
+    free(captureFT);
+    return 0;
+}
+#endif
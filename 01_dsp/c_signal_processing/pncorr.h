@@ -0,0 +1,82 @@
+/*
+ * File:   pncorr.h
+ * Author: ericdvet
+ *
+ * Slow-time despreading of tags keyed by pseudo-noise codes, by FFT circular correlation across frames
+ */
+
+#ifndef PNCORR_H
+#define PNCORR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <complex.h>
+#include <fftw3.h>
+
+/**
+ * @struct PNCorrelator
+ * @brief Conjugate spectra of the code references sampled at the frame times, and the batched inverse FFT
+ *      that correlates every range bin with one of them
+ * @author ericdvet */
+typedef struct
+{
+    int numFrames;
+    int numOfSamplers;
+    int numCodes;
+    double chipFrames;
+    double codeFrames;
+    double complex *codeFT;
+    double complex *correlation;
+    fftw_plan inverse;
+    double *lagEnergy;
+    int lag;
+} PNCorrelator;
+
+/**
+ * @function pnCorrelatorCreate(const int *codes, int codeLength, int numCodes, double chipRate, double frameRate, int numFrames, int numOfSamplers)
+ * @param codes - Chips of every code, numCodes x codeLength, 0 or 1 like pn[] in radarBackscatter.ino
+ * @param codeLength - Number of chips per code
+ * @param numCodes - Number of codes
+ * @param chipRate - Chips per second sent by the tag, 1 / period of radarBackscatter.ino
+ * @param frameRate - Frame rate of the radar in Hz
+ * @param numFrames - Frames in the capture, the length of the correlation
+ * @param numOfSamplers - Number of range bins per frame
+ * @return PNCorrelator *
+ * @brief Samples each code as +/-1 at the frame times, repeating it over the capture, and keeps the
+ *      conjugate of its spectrum with the DC bin removed so static clutter does not correlate
+ * @author ericdvet */
+PNCorrelator *pnCorrelatorCreate(const int *codes, int codeLength, int numCodes, double chipRate, double frameRate, int numFrames,
+                                 int numOfSamplers);
+
+/**
+ * @function pnCorrelatorDespread(PNCorrelator *pn, const double complex *captureFT, int code, double *codeFT)
+ * @param pn - Correlator created by pnCorrelatorCreate()
+ * @param captureFT - Slow-time FFT of the capture from computeFFT() (numFrames x numOfSamplers)
+ * @param code - Index of the code to despread
+ * @param codeFT - Resulting magnitude of every range bin's correlation with the code at the best lag
+ *      (numOfSamplers), used like the tag FT of procRadarFrames()
+ * @return int
+ * @brief Circularly correlates every range bin with the code in one batched inverse FFT and returns the
+ *      lag, in frames, with the most correlation energy over all range bins
+ * @author ericdvet */
+int pnCorrelatorDespread(PNCorrelator *pn, const double complex *captureFT, int code, double *codeFT);
+
+/**
+ * @function pnCorrelatorSNR(const PNCorrelator *pn, int peakBin)
+ * @param pn - Correlator after pnCorrelatorDespread()
+ * @param peakBin - Determined peak bin location of backscatter tag
+ * @return double
+ * @brief Power of the correlation peak at peakBin over the mean power of the lags away from it and from
+ *      its repeats every code period, in dB
+ * @author ericdvet */
+double pnCorrelatorSNR(const PNCorrelator *pn, int peakBin);
+
+/**
+ * @function pnCorrelatorFree(PNCorrelator *pn)
+ * @param pn - PNCorrelator to free
+ * @return None
+ * @brief Free a PNCorrelator constructed by pnCorrelatorCreate()
+ * @author ericdvet */
+void pnCorrelatorFree(PNCorrelator *pn);
+
+#endif // PNCORR_H
@@ -8,11 +8,1416 @@
 #include "proc.h"
 #include "utils.h"
 #include "salsa.h"
+#include "ddc.h"
+#include "slowtime.h"
+#include "tracker.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 #include <complex.h>
-#include "wavelib/header/wavelib.h"
+#include "cwtfft.h"
+#include "ridge.h"
+#include "tagcorr.h"
+#include "cfar.h"
+#include "pncorr.h"
+#include "czt.h"
+#include "psd.h"
+#include "fourstep.h"
+#include "matched.h"
+#include "clutter.h"
+#include "fixed.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Number of frames normalized and downconverted together
+#define DDC_BLOCK_FRAMES 64
+
+// Number of wavelet scales searched for ridge lines by procCaptureCWT()
+#define CWT_NUM_SCALES 32
+
+// Initial size of the arena holding the peaks and ridge lines of procCaptureCWT()
+#define RIDGE_ARENA_SIZE (256 * 1024)
+
+// Width of the chirp-Z zoom band in slow-time bins, centered on the tag frequency
+#define ZOOM_BAND_BINS 5.0
+
+// Default tile memory of the out-of-core slow-time FFT in MB
+#define OUT_OF_CORE_MB 256
+
+// Samplers kept on either side of ProcOptions.rangeStart and rangeStop for the filter and wavelet edges
+#define RANGE_GUARD_SAMPLERS 32
+
+// Distance in air between two samplers in meters
+#define SAMPLER_METERS 0.003790984152165
+
+// Calibrated VWC treated as saturated soil by procSoilMaxPermittivity()
+#define SATURATED_VWC 0.5
+
+// Most tags procMultiTag() detects at the same time
+#define PROC_MAX_WORKERS 16
+
+static CWTPlan *procCWTPlan = NULL;
+static RidgeArena *procRidgeArena = NULL;
+static CZTPlan *procZoomPlan = NULL;
+static PSDEstimator *procPSD = NULL;
+
+// One wavelet plan and ridge arena per procMultiTag() worker, since neither can be shared between threads
+static CWTPlan *procWorkerCWTPlans[PROC_MAX_WORKERS];
+static RidgeArena *procWorkerRidgeArenas[PROC_MAX_WORKERS];
+
+/**
+ * @struct ProcTemplateCache
+ * @brief Tag template built from ProcOptions.templateCapture, kept until a different template is asked for
+ * @author ericdvet */
+typedef struct
+{
+    TagTemplate *tagTemplate;
+    char fullPath[1024];
+    double tagHz;
+    int decimation;
+    int rangeStart;
+    int rangeStop;
+} ProcTemplateCache;
+
+static ProcTemplateCache procTemplateCache;
+
+/**
+ * @struct ProcMatchedCache
+ * @brief Matched filter built for ProcOptions.matchedFilter, kept until a different pulse or block size is asked for
+ * @author ericdvet */
+typedef struct
+{
+    MatchedFilter *matched;
+    char pulsePath[1024];
+    int frameSize;
+    int numOfSamplers;
+    int decimation;
+    int blockFrames;
+} ProcMatchedCache;
+
+static ProcMatchedCache procMatchedCache;
+
+/**
+ * @struct ProcCFARCache
+ * @brief CFAR detector built for ProcOptions.detector, kept until a different detector or capture size is asked for
+ * @author ericdvet */
+typedef struct
+{
+    CFARDetector *cfar;
+    int detector;
+    int guardCells;
+    int trainingCells;
+    double falseAlarmRate;
+} ProcCFARCache;
+
+// One CFAR detector for serial detection and one per procMultiTag() worker, since the scratch space cannot be shared
+static ProcCFARCache procCFARCache;
+static ProcCFARCache procWorkerCFARCaches[PROC_MAX_WORKERS];
+
+/**
+ * @function procCFARPeak(ProcCFARCache *cache, const ProcOptions *options, double *tagFT, int numOfSamplers)
+ * @param cache - Detector kept from the last call, rebuilt if missing or built for other options or sizes
+ * @param options - Processing options with the CFAR type and parameters
+ * @param tagFT - FT of the tag's frequency isolated
+ * @param numOfSamplers - Number of range bins in tagFT
+ * @return int
+ * @brief Peak bin of the tag from a CFAR detector. The threshold factors are only worked out again when the
+ *      options or capture size change
+ * @author ericdvet */
+static int procCFARPeak(ProcCFARCache *cache, const ProcOptions *options, double *tagFT, int numOfSamplers)
+{
+    if (cache->cfar == NULL || cache->cfar->numOfSamplers != numOfSamplers || cache->detector != options->detector ||
+        cache->guardCells != options->cfarGuardCells || cache->trainingCells != options->cfarTrainingCells ||
+        cache->falseAlarmRate != options->cfarFalseAlarmRate)
+    {
+        cfarFree(cache->cfar);
+        cache->cfar = cfarCreate(options->detector == PROC_DETECTOR_CFAR_CA ? CFAR_CA : CFAR_OS, options->cfarGuardCells,
+                                 options->cfarTrainingCells, options->cfarFalseAlarmRate, numOfSamplers);
+        if (cache->cfar == NULL)
+        {
+            return -1;
+        }
+        cache->detector = options->detector;
+        cache->guardCells = options->cfarGuardCells;
+        cache->trainingCells = options->cfarTrainingCells;
+        cache->falseAlarmRate = options->cfarFalseAlarmRate;
+    }
+    return cfarDetect(cache->cfar, tagFT);
+}
+
+/**
+ * @function procPeakBin(const ProcOptions *options, TagTemplate *tagTemplate, double *tagFT, int numOfSamplers)
+ * @param options - Processing options selecting the detector
+ * @param tagTemplate - Template used to locate the tag, NULL to use options->detector
+ * @param tagFT - FT of the tag's frequency isolated
+ * @param numOfSamplers - Number of range bins in tagFT
+ * @return int
+ * @brief Peak bin of the tag from the selected detector
+ * @author ericdvet */
+static int procPeakBin(const ProcOptions *options, TagTemplate *tagTemplate, double *tagFT, int numOfSamplers)
+{
+    if (tagTemplate)
+    {
+        return tagTemplateLocate(tagTemplate, tagFT);
+    }
+    if (options->detector == PROC_DETECTOR_CFAR_CA || options->detector == PROC_DETECTOR_CFAR_OS)
+    {
+        return procCFARPeak(&procCFARCache, options, tagFT, numOfSamplers);
+    }
+    return procCaptureCWT(tagFT, numOfSamplers);
+}
+
+/**
+ * @function procTagSearch(const double complex *captureFT, int numOfSamplers, int freqTag, double *tagFT)
+ * @param captureFT - Slow-time FFT of the capture from computeFFT()
+ * @param numOfSamplers - Number of range bins per frame
+ * @param freqTag - Expected frequency bin of the tag
+ * @param tagFT - Resulting magnitude of every range bin at the tag frequency (numOfSamplers)
+ * @return int
+ * @brief Picks the strongest bin of the tag search window freqTag +/- 2 and returns it after filling tagFT
+ * @author ericdvet */
+static int procTagSearch(const double complex *captureFT, int numOfSamplers, int freqTag, double *tagFT)
+{
+    double maxFTPeak;
+    int idx_maxFTPeak = freqTag;
+    maxFTPeak = 0;
+
+    for (int j = freqTag - 2; j <= freqTag + 2; j++)
+    {
+        for (int i = 0; i < numOfSamplers; i++)
+        {
+            if (cabs(captureFT[i + numOfSamplers * (j - 1)]) > maxFTPeak)
+            {
+                maxFTPeak = cabs(captureFT[i + numOfSamplers * (j - 1)]);
+                idx_maxFTPeak = j;
+            }
+        }
+    }
+
+    for (int i = 0; i < numOfSamplers; i++)
+    {
+        tagFT[i] = (double)cabs(captureFT[i + numOfSamplers * (idx_maxFTPeak - 1)]);
+    }
+    return idx_maxFTPeak;
+}
+
+/**
+ * @function procTagSpectrum(CaptureData *captureData, double complex *framesBB, int numFrames, int numOfSamplers, int frameRate, double tagHz, const ProcOptions *options, TagTemplate *tagTemplate)
+ * @param captureData - Resulting capture FT, tag FT, peak bin and SNR
+ * @param framesBB - Baseband frames (numFrames x numOfSamplers)
+ * @param numFrames - Number of frames
+ * @param numOfSamplers - Number of samplers per frame
+ * @param frameRate - Frame rate of the capture in Hz
+ * @param tagHz - Frequency at which tag is oscillating in Hz
+ * @param options - Processing options (detector selection is used here)
+ * @param tagTemplate - Template used to locate the tag, NULL to use options->detector
+ * @return None
+ * @brief Slow-time FFT of the baseband frames followed by tag isolation, peak detection and SNR
+ * @author ericdvet */
+static void procTagSpectrum(CaptureData *captureData, double complex *framesBB, int numFrames, int numOfSamplers, int frameRate, double tagHz,
+                            const ProcOptions *options, TagTemplate *tagTemplate)
+{
+    // Find Tag FT
+    int freqTag = (int)(tagHz / frameRate * numFrames);
+
+    captureData->captureFT = (double complex *)malloc(numFrames * numOfSamplers * sizeof(double complex));
+
+    computeFFT(framesBB, captureData->captureFT, numFrames, numOfSamplers);
+
+    // for (int i = 0; i < numOfSamplers; i++) {
+    //     printf("%f\n", creal(captureData->captureFT[i]));
+    // }
+
+    captureData->tagFT = (double *)malloc(numOfSamplers * sizeof(double *));
+    freqTag = procTagSearch(captureData->captureFT, numOfSamplers, freqTag, captureData->tagFT);
+
+    // smoothData(captureData->tagFT, numOfSamplers, 10);
+
+    for (int i = 0; i < numOfSamplers; i++)
+    {
+        // captureData->tagFT[i] = (float) cabs(captureData->captureFT[i + numOfSamplers * (idx_maxFTPeak)]);
+        // printf("%d: %f\n", i, captureData->tagFT[i]);
+    }
+
+    // peakBin = procLargestPeak(captureData->tagFT);
+    captureData->peakBin = procPeakBin(options, tagTemplate, captureData->tagFT, numOfSamplers);
+
+    // printf("\nPeak of %f at %d\n", captureData->tagFT[captureData->peakBin], captureData->peakBin);
+
+    captureData->SNRdB = calculateSNR(captureData->captureFT, numOfSamplers, freqTag, captureData->peakBin);
+
+    // printf("SNR of %f\n", SNR);
+
+    captureData->numFrames = numFrames;
+    captureData->procSuccess = true;
+
+}
+
+/**
+ * @function procTagSpectrumf(CaptureData *captureData, float complex *framesBB, int numFrames, int numOfSamplers, int frameRate, double tagHz, const ProcOptions *options, TagTemplate *tagTemplate)
+ * @param captureData - Resulting single precision capture FT, tag FT, peak bin and SNR
+ * @param framesBB - Baseband frames (numFrames x numOfSamplers)
+ * @param numFrames - Number of frames
+ * @param numOfSamplers - Number of samplers per frame
+ * @param frameRate - Frame rate of the capture in Hz
+ * @param tagHz - Frequency at which tag is oscillating in Hz
+ * @param options - Processing options (detector selection is used here)
+ * @param tagTemplate - Template used to locate the tag, NULL to use options->detector
+ * @return None
+ * @brief Single precision procTagSpectrum(). The capture FT is kept in captureFTf; tagFT stays double
+ *      for the CWT
+ * @author ericdvet */
+static void procTagSpectrumf(CaptureData *captureData, float complex *framesBB, int numFrames, int numOfSamplers, int frameRate, double tagHz,
+                             const ProcOptions *options, TagTemplate *tagTemplate)
+{
+    // Find Tag FT
+    int freqTag = (int)(tagHz / frameRate * numFrames);
+
+    captureData->captureFTf = (float complex *)malloc((size_t)numFrames * numOfSamplers * sizeof(float complex));
+
+    computeFFTf(framesBB, captureData->captureFTf, numFrames, numOfSamplers);
+
+    captureData->tagFT = (double *)malloc(numOfSamplers * sizeof(double));
+
+    float maxFTPeak = 0;
+    int idx_maxFTPeak = freqTag;
+
+    for (int j = freqTag - 2; j <= freqTag + 2; j++)
+    {
+        for (int i = 0; i < numOfSamplers; i++)
+        {
+            if (cabsf(captureData->captureFTf[i + numOfSamplers * (j - 1)]) > maxFTPeak)
+            {
+                maxFTPeak = cabsf(captureData->captureFTf[i + numOfSamplers * (j - 1)]);
+                idx_maxFTPeak = j;
+            }
+        }
+    }
+    freqTag = idx_maxFTPeak;
+
+    for (int i = 0; i < numOfSamplers; i++)
+    {
+        captureData->tagFT[i] = cabsf(captureData->captureFTf[i + numOfSamplers * (idx_maxFTPeak - 1)]);
+    }
+
+    captureData->peakBin = procPeakBin(options, tagTemplate, captureData->tagFT, numOfSamplers);
+    captureData->SNRdB = calculateSNRf(captureData->captureFTf, numOfSamplers, freqTag, captureData->peakBin);
+    captureData->numFrames = numFrames;
+    captureData->procSuccess = true;
+}
+
+/**
+ * @function procCapturePath(char *fullPath, size_t size, const char *fullDataPath, const char *captureName)
+ * @param fullPath - Resulting local path to the capture
+ * @param size - Size of fullPath
+ * @param fullDataPath - Full data file path to radar capture, optionally in the format "user@ip:path"
+ * @param captureName - Name of radar capture file
+ * @return None
+ * @brief Builds the local path to a capture, dropping any "user@ip:" prefix
+ * @author ericdvet */
+static void procCapturePath(char *fullPath, size_t size, const char *fullDataPath, const char *captureName)
+{
+    const char *colon = strchr(fullDataPath, ':');
+    if (colon != NULL) {
+        fullDataPath = colon + 1;
+    }
+    snprintf(fullPath, size, "%s/%s", fullDataPath, captureName);
+}
+
+/**
+ * @function procMatchedFilter(const char *fullPath, const ProcOptions *options, int frameSize, int numOfSamplers, int blockFrames)
+ * @param fullPath - Local path to the radar capture, whose directory holds options->pulseCapture
+ * @param options - Processing options (pulseCapture and decimation are used here)
+ * @param frameSize - Number of samplers per frame
+ * @param numOfSamplers - Number of range bins of the baseband frames, fewer than frameSize with a range of interest
+ * @param blockFrames - Most frames downconverted per block
+ * @return MatchedFilter *
+ * @brief Builds the matched filter for the Chipotle pulse model, or for the direct path of the air capture
+ *      options->pulseCapture, cut to the model's length. The air capture's frames are averaged before
+ *      the DDC, which is linear, so only one frame is downconverted. Cached between captures, NULL on error
+ * @author ericdvet */
+static MatchedFilter *procMatchedFilter(const char *fullPath, const ProcOptions *options, int frameSize, int numOfSamplers, int blockFrames)
+{
+    int decimation = options->decimation > 1 ? options->decimation : 1;
+    char pulsePath[1024] = "";
+    if (options->pulseCapture)
+    {
+        const char *slash = strrchr(fullPath, '/');
+        int dirLength = slash ? (int)(slash - fullPath) : 1;
+        snprintf(pulsePath, sizeof(pulsePath), "%.*s/%s", dirLength, slash ? fullPath : ".", options->pulseCapture);
+    }
+
+    if (procMatchedCache.matched && strcmp(procMatchedCache.pulsePath, pulsePath) == 0 && procMatchedCache.frameSize == frameSize &&
+        procMatchedCache.numOfSamplers == numOfSamplers && procMatchedCache.decimation == decimation && procMatchedCache.blockFrames == blockFrames)
+    {
+        return procMatchedCache.matched;
+    }
+    procMatchedCleanup();
+
+    int pulseLength;
+    int pulseCenter;
+    double complex *pulse = matchedPulseModel(CHIPOTLE_CF, CHIPOTLE_FS, CHIPOTLE_BW, CHIPOTLE_BWR, frameSize, decimation, &pulseLength,
+                                              &pulseCenter);
+    if (pulse == NULL)
+    {
+        return NULL;
+    }
+    int fullSamplers = (frameSize + decimation - 1) / decimation;
+
+    if (options->pulseCapture)
+    {
+        free(pulse);
+        pulse = NULL;
+        RadarCapture *airData = salsaMap(pulsePath);
+        DDCPlan *ddcPlan = ddcPlanCreate(CHIPOTLE_CF, CHIPOTLE_FS, frameSize, decimation);
+        double *rfSignal = (double *)malloc(frameSize * sizeof(double));
+        double *meanSignal = (double *)calloc(frameSize, sizeof(double));
+        double complex *meanFrame = (double complex *)malloc(fullSamplers * sizeof(double complex));
+        if (!airData || airData->numOfSamplers != frameSize || airData->numFrames < 1)
+        {
+            fprintf(stderr, "ERROR: Pulse capture %s invalid\n", options->pulseCapture);
+        }
+        else if (!ddcPlan || !rfSignal || !meanSignal || !meanFrame)
+        {
+            fprintf(stderr, "ERROR: Memory allocation failure");
+        }
+        else
+        {
+            for (int n = 0; n < airData->numFrames; n++)
+            {
+                salsaFrame(airData, n, rfSignal);
+                for (int i = 0; i < frameSize; i++)
+                {
+                    meanSignal[i] += rfSignal[i] / airData->numFrames;
+                }
+            }
+            ddcProcessBlock(ddcPlan, meanSignal, meanFrame, 1);
+            pulse = matchedPulseMeasure(meanFrame, fullSamplers, pulseLength, &pulseCenter);
+        }
+        free(meanFrame);
+        free(meanSignal);
+        free(rfSignal);
+        ddcPlanFree(ddcPlan);
+        salsaUnmap(airData);
+        if (pulse == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    procMatchedCache.matched = matchedFilterCreate(pulse, pulseLength, pulseCenter, numOfSamplers, blockFrames);
+    free(pulse);
+    snprintf(procMatchedCache.pulsePath, sizeof(procMatchedCache.pulsePath), "%s", pulsePath);
+    procMatchedCache.frameSize = frameSize;
+    procMatchedCache.numOfSamplers = numOfSamplers;
+    procMatchedCache.decimation = decimation;
+    procMatchedCache.blockFrames = blockFrames;
+    return procMatchedCache.matched;
+}
+
+/**
+ * @function procDDCWindow(DDCPlan *plan, const ProcOptions *options)
+ * @param plan - Plan created by ddcPlanCreate() with options->decimation
+ * @param options - Processing options, the range of interest is used here
+ * @return int
+ * @brief Restricts the plan to options->rangeStart to rangeStop and their guard bands. Returns 0 on
+ *      success or without a range of interest, -1 otherwise
+ * @author ericdvet */
+static int procDDCWindow(DDCPlan *plan, const ProcOptions *options)
+{
+    if (options->rangeStop <= 0)
+    {
+        return 0;
+    }
+    int rangeStop = options->rangeStop + RANGE_GUARD_SAMPLERS < plan->frameSize ? options->rangeStop + RANGE_GUARD_SAMPLERS : plan->frameSize;
+    int firstBin = procRangeOffset(options) / plan->decimation;
+    return ddcPlanWindow(plan, firstBin, (rangeStop - 1) / plan->decimation - firstBin + 1);
+}
+
+/**
+ * @struct ProcBasebandStream
+ * @brief Capture source and DDC plan that deliver baseband frames one block at a time
+ * @author ericdvet */
+typedef struct
+{
+    RadarCapture *radarData;
+    SalsaStream *stream;
+    DDCPlan *ddcPlan;
+    MatchedFilter *matched; // owned by procMatchedCache, NULL without ProcOptions.matchedFilter
+    ClutterFilter *clutter; // NULL without ProcOptions.clutter
+    double *rfSignal;
+    float *rfSignalf;
+    int numFrames;
+    int numOfSamplers;
+    int blockFrames;
+    int blockStart;
+    int nextFrame;
+} ProcBasebandStream;
+
+/**
+ * @function procBasebandClose(ProcBasebandStream *baseband)
+ * @param baseband - ProcBasebandStream to close
+ * @return None
+ * @brief Free a ProcBasebandStream opened by procBasebandOpen()
+ * @author ericdvet */
+static void procBasebandClose(ProcBasebandStream *baseband)
+{
+    if (baseband)
+    {
+        free(baseband->rfSignal);
+        free(baseband->rfSignalf);
+        clutterFree(baseband->clutter);
+        ddcPlanFree(baseband->ddcPlan);
+        salsaStreamClose(baseband->stream);
+        salsaUnmap(baseband->radarData);
+        free(baseband);
+    }
+}
+
+/**
+ * @function procBasebandOpen(const char *fullPath, const ProcOptions *options)
+ * @param fullPath - Local path to the radar capture
+ * @param options - Processing options (loader, decimation, range of interest, matched filter and clutter map are used here)
+ * @return ProcBasebandStream *
+ * @brief Opens a capture for block-wise digital downconversion. The capture is memory-mapped, or read
+ *      through a SalsaStream when options->blockFrames is set. With options->rangeStop only the range
+ *      of interest and its guard bands are downconverted, so numOfSamplers is the window's length
+ * @author ericdvet */
+static ProcBasebandStream *procBasebandOpen(const char *fullPath, const ProcOptions *options)
+{
+    int decimation = options->decimation > 1 ? options->decimation : 1;
+    int frameSize;
+
+    ProcBasebandStream *baseband = (ProcBasebandStream *)calloc(1, sizeof(ProcBasebandStream));
+    if (!baseband)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure");
+        return NULL;
+    }
+
+    if (options->blockFrames > 0)
+    {
+        baseband->stream = salsaStreamOpen(fullPath, options->blockFrames);
+        if (baseband->stream == NULL)
+        {
+            procBasebandClose(baseband);
+            return NULL;
+        }
+        baseband->numFrames = baseband->stream->numFrames;
+        baseband->blockFrames = options->blockFrames;
+        frameSize = baseband->stream->numOfSamplers;
+    }
+    else
+    {
+        baseband->radarData = salsaMap(fullPath);
+        if (baseband->radarData == NULL)
+        {
+            procBasebandClose(baseband);
+            return NULL;
+        }
+        baseband->numFrames = baseband->radarData->numFrames;
+        baseband->blockFrames = DDC_BLOCK_FRAMES;
+        frameSize = baseband->radarData->numOfSamplers;
+        baseband->rfSignal = (double *)malloc(DDC_BLOCK_FRAMES * frameSize * sizeof(double));
+    }
+
+    baseband->ddcPlan = ddcPlanCreate(CHIPOTLE_CF, CHIPOTLE_FS, frameSize, decimation);
+    if (!baseband->ddcPlan || (baseband->radarData && !baseband->rfSignal))
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure");
+        procBasebandClose(baseband);
+        return NULL;
+    }
+    if (procDDCWindow(baseband->ddcPlan, options) < 0)
+    {
+        procBasebandClose(baseband);
+        return NULL;
+    }
+    baseband->numOfSamplers = baseband->ddcPlan->outputSize;
+
+    if (options->matchedFilter)
+    {
+        baseband->matched = procMatchedFilter(fullPath, options, frameSize, baseband->numOfSamplers, baseband->blockFrames);
+        if (baseband->matched == NULL)
+        {
+            procBasebandClose(baseband);
+            return NULL;
+        }
+    }
+    if (options->clutter != PROC_CLUTTER_NONE)
+    {
+        int mode = options->clutter == PROC_CLUTTER_STATIC     ? CLUTTER_STATIC
+                   : options->clutter == PROC_CLUTTER_ADAPTIVE ? CLUTTER_ADAPTIVE
+                                                               : CLUTTER_MTI;
+        baseband->clutter = clutterCreate(mode, baseband->numOfSamplers, options->clutterBeta);
+        if (baseband->clutter == NULL)
+        {
+            procBasebandClose(baseband);
+            return NULL;
+        }
+    }
+
+    return baseband;
+}
+
+/**
+ * @function procBasebandNext(ProcBasebandStream *baseband, double complex *framesBB)
+ * @param baseband - Stream opened by procBasebandOpen()
+ * @param framesBB - Resulting baseband frames (up to blockFrames x numOfSamplers)
+ * @return int
+ * @brief Loads and downconverts the next block of frames. Returns the number of frames in the block,
+ *      0 at the end of the capture or -1 on a read error. The block starts at frame blockStart
+ * @author ericdvet */
+static int procBasebandNext(ProcBasebandStream *baseband, double complex *framesBB)
+{
+    int numRead;
+    baseband->blockStart = baseband->nextFrame;
+
+    if (baseband->stream)
+    {
+        numRead = salsaStreamNext(baseband->stream);
+        if (numRead <= 0)
+        {
+            return numRead;
+        }
+        ddcProcessBlock(baseband->ddcPlan, baseband->stream->frames, framesBB, numRead);
+    }
+    else
+    {
+        numRead = baseband->numFrames - baseband->nextFrame;
+        numRead = numRead < DDC_BLOCK_FRAMES ? numRead : DDC_BLOCK_FRAMES;
+        int frameSize = baseband->ddcPlan->frameSize;
+        for (int k = 0; k < numRead; k++)
+        {
+            salsaFrame(baseband->radarData, baseband->nextFrame + k, &baseband->rfSignal[k * frameSize]);
+        }
+        if (numRead > 0)
+        {
+            ddcProcessBlock(baseband->ddcPlan, baseband->rfSignal, framesBB, numRead);
+        }
+    }
+    if (baseband->matched)
+    {
+        matchedFilterApply(baseband->matched, framesBB, numRead);
+    }
+    if (baseband->clutter)
+    {
+        clutterApply(baseband->clutter, framesBB, numRead);
+    }
+
+    baseband->nextFrame += numRead;
+    return numRead;
+}
+
+/**
+ * @function procBasebandAccumulate(ProcBasebandStream *baseband, SlowTimeDFT *dft, const double complex *framesBB, int numFrames, const ProcOptions *options, int frameRate)
+ * @param baseband - Stream the block was read from by procBasebandNext()
+ * @param dft - Targeted DFT the block is added to
+ * @param framesBB - Block of baseband frames (numFrames x numOfSamplers)
+ * @param numFrames - Number of frames in the block
+ * @param options - Processing options, frameTimes is used here
+ * @param frameRate - Nominal frame rate of the capture in Hz
+ * @return None
+ * @brief Adds a block to a targeted DFT on the uniform frame grid, or at the frames' logged times with
+ *      options->frameTimes
+ * @author ericdvet */
+static void procBasebandAccumulate(ProcBasebandStream *baseband, SlowTimeDFT *dft, const double complex *framesBB, int numFrames,
+                                   const ProcOptions *options, int frameRate)
+{
+    if (options->frameTimes)
+    {
+        const double *times = baseband->stream ? baseband->stream->times : &baseband->radarData->times[baseband->blockStart];
+        slowTimeAccumulateTimes(dft, framesBB, times, numFrames, frameRate);
+    }
+    else
+    {
+        slowTimeAccumulate(dft, framesBB, numFrames);
+    }
+}
+
+/**
+ * @function procBasebandNextf(ProcBasebandStream *baseband, float complex *framesBB)
+ * @param baseband - Stream opened by procBasebandOpen()
+ * @param framesBB - Resulting baseband frames (up to blockFrames x numOfSamplers)
+ * @return int
+ * @brief Single precision procBasebandNext()
+ * @author ericdvet */
+static int procBasebandNextf(ProcBasebandStream *baseband, float complex *framesBB)
+{
+    int frameSize = baseband->ddcPlan->frameSize;
+    if (!baseband->rfSignalf)
+    {
+        baseband->rfSignalf = (float *)malloc((size_t)baseband->blockFrames * frameSize * sizeof(float));
+        if (!baseband->rfSignalf)
+        {
+            fprintf(stderr, "ERROR: Memory allocation failure");
+            return -1;
+        }
+    }
+
+    int numRead;
+    baseband->blockStart = baseband->nextFrame;
+
+    if (baseband->stream)
+    {
+        numRead = salsaStreamNext(baseband->stream);
+        for (int k = 0; k < numRead * frameSize; k++)
+        {
+            baseband->rfSignalf[k] = (float)baseband->stream->frames[k];
+        }
+    }
+    else
+    {
+        numRead = baseband->numFrames - baseband->nextFrame;
+        numRead = numRead < DDC_BLOCK_FRAMES ? numRead : DDC_BLOCK_FRAMES;
+        for (int k = 0; k < numRead; k++)
+        {
+            salsaFramef(baseband->radarData, baseband->nextFrame + k, &baseband->rfSignalf[k * frameSize]);
+        }
+    }
+    if (numRead <= 0)
+    {
+        return numRead;
+    }
+
+    ddcProcessBlockf(baseband->ddcPlan, baseband->rfSignalf, framesBB, numRead);
+    if (baseband->matched && matchedFilterApplyf(baseband->matched, framesBB, numRead) < 0)
+    {
+        return -1;
+    }
+    if (baseband->clutter)
+    {
+        clutterApplyf(baseband->clutter, framesBB, numRead);
+    }
+    baseband->nextFrame += numRead;
+    return numRead;
+}
+
+/**
+ * @function procBaseband(const char *fullPath, const ProcOptions *options, int *numFrames, int *numOfSamplers)
+ * @param fullPath - Local path to the radar capture
+ * @param options - Processing options (loader and decimation are used here)
+ * @param numFrames - Resulting number of frames
+ * @param numOfSamplers - Resulting number of baseband samples per frame
+ * @return double complex *
+ * @brief Loads a capture and digitally downconverts every frame
+ * @author ericdvet */
+static double complex *procBaseband(const char *fullPath, const ProcOptions *options, int *numFrames, int *numOfSamplers)
+{
+    ProcBasebandStream *baseband = procBasebandOpen(fullPath, options);
+    if (baseband == NULL)
+    {
+        return NULL;
+    }
+    *numFrames = baseband->numFrames;
+    *numOfSamplers = baseband->numOfSamplers;
+
+    double complex *framesBB = (double complex *)malloc((size_t)(*numFrames) * (*numOfSamplers) * sizeof(double complex));
+    if (!framesBB)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure");
+        procBasebandClose(baseband);
+        return NULL;
+    }
+
+    // Baseband Conversion, one block at a time
+    int numRead;
+    do
+    {
+        numRead = procBasebandNext(baseband, &framesBB[(size_t)baseband->nextFrame * (*numOfSamplers)]);
+    } while (numRead > 0);
+    if (numRead < 0)
+    {
+        free(framesBB);
+        framesBB = NULL;
+    }
+
+    procBasebandClose(baseband);
+    return framesBB;
+}
+
+/**
+ * @function procBasebandf(const char *fullPath, const ProcOptions *options, int *numFrames, int *numOfSamplers)
+ * @param fullPath - Local path to the radar capture
+ * @param options - Processing options (loader and decimation are used here)
+ * @param numFrames - Resulting number of frames
+ * @param numOfSamplers - Resulting number of baseband samples per frame
+ * @return float complex *
+ * @brief Single precision procBaseband()
+ * @author ericdvet */
+static float complex *procBasebandf(const char *fullPath, const ProcOptions *options, int *numFrames, int *numOfSamplers)
+{
+    ProcBasebandStream *baseband = procBasebandOpen(fullPath, options);
+    if (baseband == NULL)
+    {
+        return NULL;
+    }
+    *numFrames = baseband->numFrames;
+    *numOfSamplers = baseband->numOfSamplers;
+
+    float complex *framesBB = (float complex *)malloc((size_t)(*numFrames) * (*numOfSamplers) * sizeof(float complex));
+    if (!framesBB)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure");
+        procBasebandClose(baseband);
+        return NULL;
+    }
+
+    int numRead;
+    do
+    {
+        numRead = procBasebandNextf(baseband, &framesBB[(size_t)baseband->nextFrame * (*numOfSamplers)]);
+    } while (numRead > 0);
+    if (numRead < 0)
+    {
+        free(framesBB);
+        framesBB = NULL;
+    }
+
+    procBasebandClose(baseband);
+    return framesBB;
+}
+
+/**
+ * @function procTargetedResult(CaptureData *captureData, const SlowTimeDFT *dft, const ProcOptions *options, int freqTag, TagTemplate *tagTemplate)
+ * @param captureData - Resulting tag FT, peak bin and SNR. captureFT is left NULL
+ * @param dft - Targeted DFT holding the bins of slowTimeTagBins() or slowTimeHarmonicBins() for the whole capture
+ * @param options - Processing options (harmonics and detector are used here)
+ * @param freqTag - Expected frequency bin of the tag
+ * @param tagTemplate - Template used to locate the tag, NULL to use options->detector
+ * @return None
+ * @brief Tag isolation, peak detection and SNR from a targeted DFT, with the tag's harmonics if asked for
+ * @author ericdvet */
+static void procTargetedResult(CaptureData *captureData, const SlowTimeDFT *dft, const ProcOptions *options, int freqTag,
+                               TagTemplate *tagTemplate)
+{
+    int numOfSamplers = dft->numOfSamplers;
+    captureData->captureFT = NULL;
+    captureData->tagFT = (double *)malloc(numOfSamplers * sizeof(double));
+    if (options->harmonics > 1)
+    {
+        freqTag = slowTimeHarmonicFT(dft, freqTag, options->harmonics, options->coherentHarmonics, captureData->tagFT);
+    }
+    else
+    {
+        freqTag = slowTimeTagFT(dft, freqTag, captureData->tagFT);
+    }
+
+    captureData->peakBin = procPeakBin(options, tagTemplate, captureData->tagFT, numOfSamplers);
+    if (options->harmonics > 1)
+    {
+        captureData->SNRdB = slowTimeHarmonicSNR(dft, freqTag, options->harmonics, options->coherentHarmonics, captureData->peakBin);
+    }
+    else
+    {
+        captureData->SNRdB = slowTimeSNR(dft, freqTag, captureData->peakBin);
+    }
+    captureData->numFrames = dft->numFrames;
+    captureData->numOfSamplers = numOfSamplers;
+    captureData->procSuccess = true;
+}
+
+/**
+ * @function procTargetedSpectrum(CaptureData *captureData, const char *fullPath, const ProcOptions *options, int frameRate, double tagHz, TagTemplate *tagTemplate)
+ * @param captureData - Resulting tag FT, peak bin and SNR. captureFT is left NULL
+ * @param fullPath - Local path to the radar capture
+ * @param options - Processing options
+ * @param frameRate - Frame rate of the capture in Hz
+ * @param tagHz - Frequency at which tag is oscillating in Hz
+ * @param tagTemplate - Template used to locate the tag, NULL to use options->detector
+ * @return int
+ * @brief Same result as procTagSpectrum() but only the slow-time bins around the tag and the SNR noise
+ *      band are computed, accumulated block by block as the frames are downconverted. Neither the
+ *      baseband frames nor the capture FT are held whole. Returns 0 on success, -1 otherwise
+ * @author ericdvet */
+static int procTargetedSpectrum(CaptureData *captureData, const char *fullPath, const ProcOptions *options, int frameRate, double tagHz,
+                                TagTemplate *tagTemplate)
+{
+    ProcBasebandStream *baseband = procBasebandOpen(fullPath, options);
+    if (baseband == NULL)
+    {
+        return -1;
+    }
+    int numFrames = baseband->numFrames;
+    int numOfSamplers = baseband->numOfSamplers;
+    int freqTag = (int)(tagHz / frameRate * numFrames);
+
+    int numBins;
+    int *bins = options->harmonics > 1 ? slowTimeHarmonicBins(freqTag, options->harmonics, &numBins) : slowTimeTagBins(freqTag, &numBins);
+    SlowTimeDFT *dft = bins ? slowTimeCreate(numFrames, numOfSamplers, bins, numBins) : NULL;
+    double complex *blockBB = (double complex *)malloc((size_t)baseband->blockFrames * numOfSamplers * sizeof(double complex));
+    free(bins);
+    if (!dft || !blockBB)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure");
+        free(blockBB);
+        slowTimeFree(dft);
+        procBasebandClose(baseband);
+        return -1;
+    }
+
+    int numRead;
+    while ((numRead = procBasebandNext(baseband, blockBB)) > 0)
+    {
+        procBasebandAccumulate(baseband, dft, blockBB, numRead, options, frameRate);
+    }
+    free(blockBB);
+    procBasebandClose(baseband);
+    if (numRead < 0)
+    {
+        slowTimeFree(dft);
+        return -1;
+    }
+
+    procTargetedResult(captureData, dft, options, freqTag, tagTemplate);
+    slowTimeFree(dft);
+    return 0;
+}
+
+/**
+ * @function procOutOfCoreSpectrum(CaptureData *captureData, const char *fullPath, const ProcOptions *options, int frameRate, double tagHz, TagTemplate *tagTemplate)
+ * @param captureData - Resulting tag FT, peak bin and SNR. captureFT is left NULL
+ * @param fullPath - Local path to the radar capture
+ * @param options - Processing options with the scratch directory and memory budget
+ * @param frameRate - Frame rate of the capture in Hz
+ * @param tagHz - Frequency at which tag is oscillating in Hz
+ * @param tagTemplate - Template used to locate the tag, NULL to use options->detector
+ * @return int
+ * @brief Same result as procTargetedSpectrum() for captures too long to transform in memory. The
+ *      downconverted frames are written to a scratch file, transformed there by a four-step FFT in
+ *      tiles that fit options->outOfCoreMB, and only the tag and noise bins are read back. Returns 0
+ *      on success, -1 otherwise
+ * @author ericdvet */
+static int procOutOfCoreSpectrum(CaptureData *captureData, const char *fullPath, const ProcOptions *options, int frameRate, double tagHz,
+                                 TagTemplate *tagTemplate)
+{
+    ProcBasebandStream *baseband = procBasebandOpen(fullPath, options);
+    if (baseband == NULL)
+    {
+        return -1;
+    }
+    int numOfSamplers = baseband->numOfSamplers;
+    size_t memoryBytes = (size_t)(options->outOfCoreMB > 0 ? options->outOfCoreMB : OUT_OF_CORE_MB) << 20;
+
+    FourStepFFT *fourStep = fourStepCreate(baseband->numFrames, numOfSamplers, options->outOfCoreDir, memoryBytes);
+    double complex *blockBB = (double complex *)malloc((size_t)baseband->blockFrames * numOfSamplers * sizeof(double complex));
+    if (!fourStep || !blockBB)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure");
+        free(blockBB);
+        fourStepFree(fourStep);
+        procBasebandClose(baseband);
+        return -1;
+    }
+    if (fourStep->numFrames < baseband->numFrames)
+    {
+        fprintf(stderr, "WARNING: Out-of-core FFT drops the last %d of %d frames, so its bins differ from the in-core FFT\n",
+                baseband->numFrames - fourStep->numFrames, baseband->numFrames);
+    }
+
+    int numRead;
+    while ((numRead = procBasebandNext(baseband, blockBB)) > 0)
+    {
+        if (fourStepWrite(fourStep, blockBB, numRead) < 0)
+        {
+            numRead = -1;
+            break;
+        }
+    }
+    free(blockBB);
+    procBasebandClose(baseband);
+    if (numRead < 0 || fourStepExecute(fourStep) < 0)
+    {
+        fourStepFree(fourStep);
+        return -1;
+    }
+
+    // Bins are on the grid of the frames transformed, which may be a few fewer than the capture
+    int numFrames = fourStep->numFrames;
+    int freqTag = (int)(tagHz / frameRate * numFrames);
+    int numBins;
+    int *bins = options->harmonics > 1 ? slowTimeHarmonicBins(freqTag, options->harmonics, &numBins) : slowTimeTagBins(freqTag, &numBins);
+    SlowTimeDFT *dft = bins ? slowTimeCreate(numFrames, numOfSamplers, bins, numBins) : NULL;
+    free(bins);
+    if (!dft || fourStepBins(fourStep, dft->bins, dft->numBins, dft->spectrum) < 0)
+    {
+        slowTimeFree(dft);
+        fourStepFree(fourStep);
+        return -1;
+    }
+    dft->frame = numFrames;
+    fourStepFree(fourStep);
+
+    procTargetedResult(captureData, dft, options, freqTag, tagTemplate);
+    slowTimeFree(dft);
+    return 0;
+}
+
+/**
+ * @function procFixedSpectrum(CaptureData *captureData, const char *fullPath, const ProcOptions *options, int frameRate, double tagHz)
+ * @param captureData - Resulting tag FT, peak bin and SNR. captureFT is left NULL
+ * @param fullPath - Local path to the radar capture
+ * @param options - Processing options, decimation and the range of interest apply, any other stage is an
+ *      error
+ * @param frameRate - Frame rate of the capture in Hz
+ * @param tagHz - Frequency at which tag is oscillating in Hz
+ * @return int
+ * @brief procTargetedSpectrum() in fixed point for the radar node: the counters are normalized,
+ *      downconverted and accumulated into the tag and noise bins as integers, and the peak is the
+ *      strongest range bin. Only the tag FT handed back is converted to double. Returns 0 on success,
+ *      -1 otherwise
+ * @author ericdvet */
+static int procFixedSpectrum(CaptureData *captureData, const char *fullPath, const ProcOptions *options, int frameRate, double tagHz)
+{
+    // The fixed-point DFT is always targeted, every other stage would need its own integer version. The
+    // capture is always mapped and the peak is always the strongest range bin
+    if (options->templateCapture || options->matchedFilter || options->clutter != PROC_CLUTTER_NONE || options->harmonics > 1 ||
+        options->frameTimes || options->spectrum != PROC_SPECTRUM_PERIODOGRAM || options->zoomPoints > 0 || options->outOfCoreDir ||
+        options->planarLayout || options->singlePrecision || options->detector != PROC_DETECTOR_CWT || options->blockFrames > 0)
+    {
+        fprintf(stderr, "ERROR: Fixed point only supports decimation and a range of interest\n");
+        return -1;
+    }
+
+    RadarCapture *radarData = salsaMap(fullPath);
+    if (radarData == NULL)
+    {
+        return -1;
+    }
+    int numFrames = radarData->numFrames;
+    int frameSize = radarData->numOfSamplers;
+    int freqTag = (int)(tagHz / frameRate * numFrames);
+
+    DDCPlan *plan = ddcPlanCreate(CHIPOTLE_CF, CHIPOTLE_FS, frameSize, options->decimation > 1 ? options->decimation : 1);
+    FixedDDCPlan *fixedPlan = plan && procDDCWindow(plan, options) == 0 ? fixedDDCCreate(plan) : NULL;
+    ddcPlanFree(plan);
+    if (fixedPlan == NULL)
+    {
+        salsaUnmap(radarData);
+        return -1;
+    }
+    int numOfSamplers = fixedPlan->outputSize;
+
+    int numBins;
+    int *bins = slowTimeTagBins(freqTag, &numBins);
+    FixedSlowTimeDFT *dft = bins ? fixedSlowTimeCreate(numFrames, numOfSamplers, bins, numBins) : NULL;
+    int16_t *rfSignal = (int16_t *)malloc((size_t)DDC_BLOCK_FRAMES * frameSize * sizeof(int16_t));
+    int16_t *blockBB = (int16_t *)malloc((size_t)DDC_BLOCK_FRAMES * 2 * numOfSamplers * sizeof(int16_t));
+    uint32_t *tagFT = (uint32_t *)malloc(numOfSamplers * sizeof(uint32_t));
+    captureData->tagFT = (double *)malloc(numOfSamplers * sizeof(double));
+    free(bins);
+    if (!dft || !rfSignal || !blockBB || !tagFT || !captureData->tagFT)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure");
+        free(rfSignal);
+        free(blockBB);
+        free(tagFT);
+        fixedSlowTimeFree(dft);
+        fixedDDCFree(fixedPlan);
+        salsaUnmap(radarData);
+        return -1;
+    }
+
+    for (int n = 0; n < numFrames; n += DDC_BLOCK_FRAMES)
+    {
+        int numRead = numFrames - n < DDC_BLOCK_FRAMES ? numFrames - n : DDC_BLOCK_FRAMES;
+        for (int k = 0; k < numRead; k++)
+        {
+            fixedFrame(radarData, n + k, &rfSignal[(size_t)k * frameSize]);
+        }
+        fixedDDCProcessBlock(fixedPlan, rfSignal, blockBB, numRead);
+        fixedSlowTimeAccumulate(dft, blockBB, numRead);
+    }
+
+    int exponent;
+    freqTag = fixedSlowTimeTagFT(dft, freqTag, tagFT, &exponent);
+    for (int i = 0; i < numOfSamplers; i++)
+    {
+        captureData->tagFT[i] = ldexp(tagFT[i], exponent) / FIXED_SPECTRUM_ONE;
+    }
+    captureData->peakBin = fixedPeakBin(tagFT, numOfSamplers);
+    captureData->SNRdB = fixedSlowTimeSNR(dft, freqTag, captureData->peakBin);
+    captureData->numFrames = numFrames;
+    captureData->numOfSamplers = numOfSamplers;
+    captureData->procSuccess = true;
+
+    free(rfSignal);
+    free(blockBB);
+    free(tagFT);
+    fixedSlowTimeFree(dft);
+    fixedDDCFree(fixedPlan);
+    salsaUnmap(radarData);
+    return 0;
+}
+
+/**
+ * @function procZoomSpectrum(CaptureData *captureData, const char *fullPath, const ProcOptions *options, int frameRate, double tagHz, TagTemplate *tagTemplate)
+ * @param captureData - Resulting tag FT, tag frequency, peak bin and SNR. captureFT is left NULL
+ * @param fullPath - Local path to the radar capture
+ * @param options - Processing options
+ * @param frameRate - Frame rate of the capture in Hz
+ * @param tagHz - Frequency at which tag is oscillating in Hz
+ * @param tagTemplate - Template used to locate the tag, NULL to use options->detector
+ * @return int
+ * @brief Instead of searching the nearest slow-time bins, evaluates options->zoomPoints frequencies over
+ *      the same band with a chirp-Z transform of every range bin and takes the tag FT at the strongest,
+ *      so a tag between two bins keeps its energy. The frames are loaded block by block and the SNR
+ *      noise band is accumulated alongside. Returns 0 on success, -1 otherwise
+ * @author ericdvet */
+static int procZoomSpectrum(CaptureData *captureData, const char *fullPath, const ProcOptions *options, int frameRate, double tagHz,
+                            TagTemplate *tagTemplate)
+{
+    ProcBasebandStream *baseband = procBasebandOpen(fullPath, options);
+    if (baseband == NULL)
+    {
+        return -1;
+    }
+    int numFrames = baseband->numFrames;
+    int numOfSamplers = baseband->numOfSamplers;
+    int numPoints = options->zoomPoints;
+    int freqTag = (int)(tagHz / frameRate * numFrames);
+
+    // The chirps and kernel spectrum are kept for the next capture of the same size and band
+    double startFreq = tagHz / frameRate - ZOOM_BAND_BINS / 2 / numFrames;
+    double stepFreq = ZOOM_BAND_BINS / numFrames / numPoints;
+    if (procZoomPlan == NULL || procZoomPlan->numFrames != numFrames || procZoomPlan->numOfSamplers != numOfSamplers ||
+        procZoomPlan->numPoints != numPoints || procZoomPlan->startFreq != startFreq || procZoomPlan->stepFreq != stepFreq)
+    {
+        cztPlanFree(procZoomPlan);
+        procZoomPlan = cztPlanCreate(numFrames, numOfSamplers, startFreq, stepFreq, numPoints);
+    }
+
+    // The zoom band reaches half a bin further than freqTag +/- 2, so the noise band of one bin higher is kept too
+    int numBins;
+    int *bins = slowTimeTagBins(freqTag + 1, &numBins);
+    SlowTimeDFT *dft = bins ? slowTimeCreate(numFrames, numOfSamplers, bins, numBins) : NULL;
+    double complex *blockBB = (double complex *)malloc((size_t)baseband->blockFrames * numOfSamplers * sizeof(double complex));
+    free(bins);
+    if (!procZoomPlan || !dft || !blockBB)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure");
+        free(blockBB);
+        slowTimeFree(dft);
+        procBasebandClose(baseband);
+        return -1;
+    }
+
+    int numRead;
+    while ((numRead = procBasebandNext(baseband, blockBB)) > 0)
+    {
+        cztPlanLoad(procZoomPlan, blockBB, numRead, baseband->blockStart);
+        slowTimeAccumulate(dft, blockBB, numRead);
+    }
+    free(blockBB);
+    procBasebandClose(baseband);
+    if (numRead < 0)
+    {
+        slowTimeFree(dft);
+        return -1;
+    }
+
+    const double complex *zoomFT = cztPlanExecute(procZoomPlan);
+    double maxFTPeak = 0;
+    int peakPoint = 0;
+    for (int k = 0; k < numPoints; k++)
+    {
+        for (int i = 0; i < numOfSamplers; i++)
+        {
+            if (cabs(zoomFT[(size_t)k * numOfSamplers + i]) > maxFTPeak)
+            {
+                maxFTPeak = cabs(zoomFT[(size_t)k * numOfSamplers + i]);
+                peakPoint = k;
+            }
+        }
+    }
+
+    captureData->captureFT = NULL;
+    captureData->tagFT = (double *)malloc(numOfSamplers * sizeof(double));
+    for (int i = 0; i < numOfSamplers; i++)
+    {
+        captureData->tagFT[i] = cabs(zoomFT[(size_t)peakPoint * numOfSamplers + i]);
+    }
+    captureData->tagHz = (startFreq + peakPoint * stepFreq) * frameRate;
+
+    captureData->peakBin = procPeakBin(options, tagTemplate, captureData->tagFT, numOfSamplers);
+
+    // Noise band of the slow-time bin nearest the zoom peak, 1-based like procRadarFrames()
+    int zoomTag = (int)lround(captureData->tagHz / frameRate * numFrames) + 1;
+    zoomTag = zoomTag < freqTag - 1 ? freqTag - 1 : (zoomTag > freqTag + 3 ? freqTag + 3 : zoomTag);
+    double noiseMag = captureData->peakBin >= 0 ? slowTimeNoise(dft, zoomTag, captureData->peakBin) : 0;
+    captureData->SNRdB = noiseMag > 0 ? 10 * log10(captureData->tagFT[captureData->peakBin] / noiseMag) : 0;
+    captureData->numFrames = numFrames;
+    captureData->numOfSamplers = numOfSamplers;
+    captureData->procSuccess = true;
+
+    slowTimeFree(dft);
+    return 0;
+}
+
+/**
+ * @function procEstimatedSpectrum(CaptureData *captureData, const char *fullPath, const ProcOptions *options, int frameRate, double tagHz, TagTemplate *tagTemplate)
+ * @param captureData - Resulting tag FT, peak bin and SNR. captureFT is left NULL
+ * @param fullPath - Local path to the radar capture
+ * @param options - Processing options selecting the estimator
+ * @param frameRate - Frame rate of the capture in Hz
+ * @param tagHz - Frequency at which tag is oscillating in Hz
+ * @param tagTemplate - Template used to locate the tag, NULL to use options->detector
+ * @return int
+ * @brief Reads the tag FT and SNR from a Welch or multitaper estimate instead of the single periodogram,
+ *      trading frequency resolution for a smoother noise floor. The frames are fed to the estimator
+ *      block by block as they are downconverted. Returns 0 on success, -1 otherwise
+ * @author ericdvet */
+static int procEstimatedSpectrum(CaptureData *captureData, const char *fullPath, const ProcOptions *options, int frameRate, double tagHz,
+                                 TagTemplate *tagTemplate)
+{
+    ProcBasebandStream *baseband = procBasebandOpen(fullPath, options);
+    if (baseband == NULL)
+    {
+        return -1;
+    }
+    int numFrames = baseband->numFrames;
+    int numOfSamplers = baseband->numOfSamplers;
+    int method = options->spectrum == PROC_SPECTRUM_WELCH ? PSD_WELCH : PSD_MULTITAPER;
+
+    // The tapers and plan are kept for the next capture of the same size
+    int segmentFrames = options->spectrumSegmentFrames > 0 ? options->spectrumSegmentFrames
+                                                           : (method == PSD_WELCH ? numFrames / PSD_WELCH_SEGMENTS : numFrames);
+    int numTapers = method == PSD_WELCH ? 1 : (options->spectrumTapers > 0 ? options->spectrumTapers : PSD_MULTITAPER_TAPERS);
+    if (procPSD == NULL || procPSD->method != method || procPSD->numFrames != numFrames || procPSD->numOfSamplers != numOfSamplers ||
+        procPSD->segmentFrames != segmentFrames || procPSD->numTapers != numTapers)
+    {
+        psdFree(procPSD);
+        procPSD = psdCreate(method, numFrames, numOfSamplers, segmentFrames, numTapers);
+    }
+    double complex *blockBB = (double complex *)malloc((size_t)baseband->blockFrames * numOfSamplers * sizeof(double complex));
+    if (!procPSD || !blockBB)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure");
+        free(blockBB);
+        procBasebandClose(baseband);
+        return -1;
+    }
+
+    psdReset(procPSD);
+    int numRead;
+    while ((numRead = procBasebandNext(baseband, blockBB)) > 0)
+    {
+        psdAccumulate(procPSD, blockBB, numRead);
+    }
+    free(blockBB);
+    procBasebandClose(baseband);
+    if (numRead < 0)
+    {
+        return -1;
+    }
+    psdSpectrum(procPSD);
+
+    // Tag bin on the segment grid, 1-based like procRadarFrames()
+    int freqTag = (int)(tagHz / frameRate * procPSD->segmentFrames);
+    captureData->captureFT = NULL;
+    captureData->tagFT = (double *)malloc(numOfSamplers * sizeof(double));
+    freqTag = psdTagFT(procPSD, freqTag, captureData->tagFT);
+
+    captureData->peakBin = procPeakBin(options, tagTemplate, captureData->tagFT, numOfSamplers);
+    captureData->SNRdB = captureData->peakBin >= 0 ? psdSNR(procPSD, freqTag, captureData->peakBin) : 0;
+    captureData->numFrames = numFrames;
+    captureData->numOfSamplers = numOfSamplers;
+    captureData->procSuccess = true;
+    return 0;
+}
+
+/**
+ * @function procPlanarSpectrum(CaptureData *captureData, const char *fullPath, const ProcOptions *options, int frameRate, double tagHz, TagTemplate *tagTemplate)
+ * @param captureData - Resulting planar capture FT, tag FT, peak bin and SNR. captureFT is left NULL
+ * @param fullPath - Local path to the radar capture
+ * @param options - Processing options
+ * @param frameRate - Frame rate of the capture in Hz
+ * @param tagHz - Frequency at which tag is oscillating in Hz
+ * @param tagTemplate - Template used to locate the tag, NULL to use options->detector
+ * @return int
+ * @brief Same result as procTagSpectrum() with the capture held as separate real and imaginary planes
+ *      ordered by range bin. Each downconverted block is transposed straight into the planes, so the
+ *      slow-time FFT, tag search and SNR all walk contiguous memory. Returns 0 on success, -1 otherwise
+ * @author ericdvet */
+static int procPlanarSpectrum(CaptureData *captureData, const char *fullPath, const ProcOptions *options, int frameRate, double tagHz,
+                              TagTemplate *tagTemplate)
+{
+    ProcBasebandStream *baseband = procBasebandOpen(fullPath, options);
+    if (baseband == NULL)
+    {
+        return -1;
+    }
+    int numFrames = baseband->numFrames;
+    int numOfSamplers = baseband->numOfSamplers;
+    size_t size = (size_t)numFrames * numOfSamplers;
+
+    double *re = (double *)fftw_malloc(size * sizeof(double));
+    double *im = (double *)fftw_malloc(size * sizeof(double));
+    double complex *blockBB = (double complex *)malloc((size_t)baseband->blockFrames * numOfSamplers * sizeof(double complex));
+    if (!re || !im || !blockBB)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure");
+        fftw_free(re);
+        fftw_free(im);
+        free(blockBB);
+        procBasebandClose(baseband);
+        return -1;
+    }
+
+    int numRead;
+    while ((numRead = procBasebandNext(baseband, blockBB)) > 0)
+    {
+        transposeToPlanar(blockBB, numRead, numOfSamplers, re, im, numFrames, baseband->blockStart);
+    }
+    free(blockBB);
+    procBasebandClose(baseband);
+    captureData->captureFTRe = re;
+    captureData->captureFTIm = im;
+    if (numRead < 0)
+    {
+        return -1;
+    }
+
+    computeFFTPlanar(re, im, numFrames, numOfSamplers);
+
+    // Find Tag FT
+    int freqTag = (int)(tagHz / frameRate * numFrames);
+    double maxFTPeak = 0;
+    int idx_maxFTPeak = freqTag;
+    for (int i = 0; i < numOfSamplers; i++)
+    {
+        const double *rowRe = &re[(size_t)i * numFrames];
+        const double *rowIm = &im[(size_t)i * numFrames];
+        for (int j = freqTag - 2; j <= freqTag + 2; j++)
+        {
+            double magnitude = hypot(rowRe[j - 1], rowIm[j - 1]);
+            // Ties go to the lowest j like the frame-major search
+            if (magnitude > maxFTPeak || (magnitude == maxFTPeak && j < idx_maxFTPeak))
+            {
+                maxFTPeak = magnitude;
+                idx_maxFTPeak = j;
+            }
+        }
+    }
+    freqTag = idx_maxFTPeak;
+
+    captureData->tagFT = (double *)malloc(numOfSamplers * sizeof(double));
+    for (int i = 0; i < numOfSamplers; i++)
+    {
+        captureData->tagFT[i] = hypot(re[(size_t)i * numFrames + freqTag - 1], im[(size_t)i * numFrames + freqTag - 1]);
+    }
+
+    captureData->peakBin = procPeakBin(options, tagTemplate, captureData->tagFT, numOfSamplers);
+    captureData->SNRdB = calculateSNRPlanar(re, im, numFrames, freqTag, captureData->peakBin);
+    captureData->numFrames = numFrames;
+    captureData->numOfSamplers = numOfSamplers;
+    captureData->procSuccess = true;
+    return 0;
+}
+
+/**
+ * @function procTagTemplate(const char *fullDataPath, const ProcOptions *options, double tagHz)
+ * @param fullDataPath - Full data file path to the template capture, optionally in the format "user@ip:path"
+ * @param options - Processing options naming the template capture
+ * @param tagHz - Frequency at which tag is oscillating in Hz
+ * @return TagTemplate *
+ * @brief Processes the template capture with the CWT detector and builds its tag template. The template is
+ *      cached so a batch of captures only processes it once. NULL on error
+ * @author ericdvet */
+static TagTemplate *procTagTemplate(const char *fullDataPath, const ProcOptions *options, double tagHz)
+{
+    char fullPath[1024];
+    procCapturePath(fullPath, sizeof(fullPath), fullDataPath, options->templateCapture);
+    int decimation = options->decimation > 1 ? options->decimation : 1;
+
+    if (procTemplateCache.tagTemplate && strcmp(procTemplateCache.fullPath, fullPath) == 0 && procTemplateCache.tagHz == tagHz &&
+        procTemplateCache.decimation == decimation && procTemplateCache.rangeStart == options->rangeStart &&
+        procTemplateCache.rangeStop == options->rangeStop)
+    {
+        return procTemplateCache.tagTemplate;
+    }
+    procTemplateCleanup();
+
+    ProcOptions templateOptions = *options;
+    templateOptions.templateCapture = NULL;
+    CaptureData *templateData = procRadarFramesOpts(fullDataPath, options->templateCapture, tagHz, &templateOptions);
+    if (!templateData || !templateData->procSuccess)
+    {
+        fprintf(stderr, "ERROR: Template capture %s invalid\n", options->templateCapture);
+        freeCaptureData(templateData);
+        return NULL;
+    }
+
+    procTemplateCache.tagTemplate = tagTemplateCreate(templateData->tagFT, templateData->numOfSamplers, templateData->peakBin);
+    freeCaptureData(templateData);
+    snprintf(procTemplateCache.fullPath, sizeof(procTemplateCache.fullPath), "%s", fullPath);
+    procTemplateCache.tagHz = tagHz;
+    procTemplateCache.decimation = decimation;
+    procTemplateCache.rangeStart = options->rangeStart;
+    procTemplateCache.rangeStop = options->rangeStop;
+    return procTemplateCache.tagTemplate;
+}
+
+/**
+ * @function procZoomCleanup(void)
+ * @return None
+ * @brief Releases the chirp-Z plan kept for ProcOptions.zoomPoints between captures
+ * @author ericdvet */
+void procZoomCleanup(void)
+{
+    cztPlanFree(procZoomPlan);
+    procZoomPlan = NULL;
+}
+
+/**
+ * @function procSpectrumCleanup(void)
+ * @return None
+ * @brief Releases the spectral estimator kept for ProcOptions.spectrum between captures
+ * @author ericdvet */
+void procSpectrumCleanup(void)
+{
+    psdFree(procPSD);
+    procPSD = NULL;
+}
+
+/**
+ * @function procTemplateCleanup(void)
+ * @return None
+ * @brief Releases the tag template cached for ProcOptions.templateCapture
+ * @author ericdvet */
+void procTemplateCleanup(void)
+{
+    tagTemplateFree(procTemplateCache.tagTemplate);
+    memset(&procTemplateCache, 0, sizeof(procTemplateCache));
+}
+
+/**
+ * @function procMatchedCleanup(void)
+ * @return None
+ * @brief Releases the matched filter cached for ProcOptions.matchedFilter
+ * @author ericdvet */
+void procMatchedCleanup(void)
+{
+    matchedFilterFree(procMatchedCache.matched);
+    memset(&procMatchedCache, 0, sizeof(procMatchedCache));
+}
+
+/**
+ * @function procCFARCleanup(void)
+ * @return None
+ * @brief Releases the CFAR detectors kept for ProcOptions.detector by procRadarFramesOpts() and procMultiTag()
+ * @author ericdvet */
+void procCFARCleanup(void)
+{
+    cfarFree(procCFARCache.cfar);
+    memset(&procCFARCache, 0, sizeof(procCFARCache));
+    for (int worker = 0; worker < PROC_MAX_WORKERS; worker++)
+    {
+        cfarFree(procWorkerCFARCaches[worker].cfar);
+        memset(&procWorkerCFARCaches[worker], 0, sizeof(procWorkerCFARCaches[worker]));
+    }
+}
 
 /**
  * @function procRadarFrames(const char *fullDataPath, const char *captureName, double tagHz)
@@ -24,129 +1429,325 @@
  */
 CaptureData *procRadarFrames(const char *fullDataPath, const char *captureName, double tagHz)
 {
+    return procRadarFramesOpts(fullDataPath, captureName, tagHz, NULL);
+}
 
-    CaptureData *captureData = (CaptureData *)malloc(sizeof(CaptureData));
+/**
+ * @function procRadarFramesStream(const char *fullDataPath, const char *captureName, double tagHz, int blockFrames)
+ * @param fullDataPath - Full data file path to radar capture. Must be in the format "user@ip:path". Example: "ericdvet@192.168.7.2:/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data"
+ * @param captureName - Name of radar capture file
+ * @param tagHz - Frequency at which tag is oscillating in Hz
+ * @param blockFrames - Number of frames read and downconverted per block
+ * @return CaptureData *
+ * @brief Same processing as procRadarFrames() but the capture is read through a SalsaStream, so neither
+ *      the raw counters nor the normalized frames are ever held (or mapped) whole
+ * @author ericdvet */
+CaptureData *procRadarFramesStream(const char *fullDataPath, const char *captureName, double tagHz, int blockFrames)
+{
+    ProcOptions options = {0};
+    options.blockFrames = blockFrames;
+    return procRadarFramesOpts(fullDataPath, captureName, tagHz, &options);
+}
 
-    // Processing parameters
-    int frameRate = 200;
-    int numOfSamplers = 512;
+/**
+ * @function procCheckOptions(const ProcOptions *options)
+ * @param options - Processing options for procRadarFramesOpts()
+ * @return int
+ * @brief Each of zoom, out-of-core, targeted bins, Welch or multitaper, planar layout and single precision
+ *      replaces the slow-time FFT of the whole capture with its own transform, so at most one of them can
+ *      be asked for. Harmonics and logged frame times are only computed as targeted bins, though harmonics
+ *      are read from the out-of-core bins as well. A template replaces the detector. Returns 0 if the
+ *      options can all be honoured, -1 otherwise
+ * @author ericdvet */
+static int procCheckOptions(const ProcOptions *options)
+{
+    const char *transforms[] = {"zoom", "out-of-core", "targeted bins, harmonics or frame times", "Welch or multitaper spectrum",
+                                "planar layout", "single precision"};
+    bool selected[] = {options->zoomPoints > 0,
+                       options->outOfCoreDir != NULL,
+                       options->targetedBins || options->frameTimes || (options->harmonics > 1 && !options->outOfCoreDir),
+                       options->spectrum != PROC_SPECTRUM_PERIODOGRAM,
+                       options->planarLayout,
+                       options->singlePrecision};
+    int first = -1;
+    for (int i = 0; i < (int)(sizeof(selected) / sizeof(selected[0])); i++)
+    {
+        if (!selected[i])
+        {
+            continue;
+        }
+        if (first >= 0)
+        {
+            fprintf(stderr, "ERROR: Cannot combine %s with %s\n", transforms[first], transforms[i]);
+            return -1;
+        }
+        first = i;
+    }
 
-    // Load Capture
-    char fullPath[1024];
-    const char *colon = strchr(fullDataPath, ':');
-    if (colon != NULL) {
-        fullDataPath = colon + 1;
+    if (options->templateCapture && options->detector != PROC_DETECTOR_CWT)
+    {
+        fprintf(stderr, "ERROR: Cannot combine a template with a CFAR detector\n");
+        return -1;
     }
-    sprintf(fullPath, "%s/%s", fullDataPath, captureName);
-    RadarData *radarData = salsaLoad(fullPath);
-    if (radarData == NULL)
+    return 0;
+}
+
+/**
+ * @function procRadarFramesOpts(const char *fullDataPath, const char *captureName, double tagHz, const ProcOptions *options)
+ * @param fullDataPath - Full data file path to radar capture. Must be in the format "user@ip:path". Example: "ericdvet@192.168.7.2:/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data"
+ * @param captureName - Name of radar capture file
+ * @param tagHz - Frequency at which tag is oscillating in Hz
+ * @param options - Processing options, NULL for the defaults of procRadarFrames()
+ * @return CaptureData *
+ * @brief procRadarFrames() with optional processing stages
+ * @author ericdvet */
+CaptureData *procRadarFramesOpts(const char *fullDataPath, const char *captureName, double tagHz, const ProcOptions *options)
+{
+    ProcOptions defaultOptions = {0};
+    if (options == NULL)
+    {
+        options = &defaultOptions;
+    }
+    if (procCheckOptions(options) < 0)
     {
-        return false;
+        return NULL;
     }
 
-    double *rfSignal;
-    double complex *framesBB;
-    double complex *temp;
+    // Processing parameters
+    int frameRate = 200;
+    int numFrames;
+    int numOfSamplers;
 
-    rfSignal = (double *)malloc(numOfSamplers * sizeof(double));
-    framesBB = (double complex *)malloc((radarData->numFrames) * numOfSamplers * sizeof(double complex));
-    temp = (double complex *)malloc(numOfSamplers * sizeof(double complex));
+    char fullPath[1024];
+    procCapturePath(fullPath, sizeof(fullPath), fullDataPath, captureName);
 
-    // Baseband Conversion
-    for (int i = 0; i < radarData->numFrames; i++)
+    CaptureData *captureData = (CaptureData *)calloc(1, sizeof(CaptureData));
+    if (!captureData)
     {
-        for (int j = 0; j < numOfSamplers; j++)
+        fprintf(stderr, "ERROR: Memory allocation failure");
+        return NULL;
+    }
+    captureData->decimation = options->decimation > 1 ? options->decimation : 1;
+    captureData->rangeOffset = procRangeOffset(options);
+
+    if (options->fixedPoint)
+    {
+        if (procFixedSpectrum(captureData, fullPath, options, frameRate, tagHz) < 0)
         {
-            rfSignal[j] = radarData->frameTot[j + i * numOfSamplers];
+            freeCaptureData(captureData);
+            return NULL;
         }
-        NoveldaDDC(rfSignal, temp);
-        for (int j = 0; j < numOfSamplers; j++)
+        return captureData;
+    }
+
+    TagTemplate *tagTemplate = NULL;
+    if (options->templateCapture)
+    {
+        tagTemplate = procTagTemplate(fullDataPath, options, tagHz);
+        if (tagTemplate == NULL)
         {
-            framesBB[j + i * numOfSamplers] = temp[j];
-            // printf("%d ", j + i * numOfSamplers);
+            freeCaptureData(captureData);
+            return NULL;
         }
     }
 
-    // for (int i = 500; i < numOfSamplers; i++) {
-    //     printf("%f ", creal(framesBB[i]));
-    // }
-    // printf("\n");
-
-    // Find Tag FT
-    int freqTag = (int)(tagHz / frameRate * radarData->numFrames);
+    if (options->zoomPoints > 0)
+    {
+        if (procZoomSpectrum(captureData, fullPath, options, frameRate, tagHz, tagTemplate) < 0)
+        {
+            freeCaptureData(captureData);
+            return NULL;
+        }
+        return captureData;
+    }
 
-    captureData->captureFT = (double complex *)malloc(radarData->numFrames * numOfSamplers * sizeof(double complex));
+    if (options->outOfCoreDir)
+    {
+        if (procOutOfCoreSpectrum(captureData, fullPath, options, frameRate, tagHz, tagTemplate) < 0)
+        {
+            freeCaptureData(captureData);
+            return NULL;
+        }
+        return captureData;
+    }
 
-    computeFFT(framesBB, captureData->captureFT, radarData->numFrames, numOfSamplers);
+    // Harmonics and logged frame times are only computed as targeted bins
+    if (options->targetedBins || options->harmonics > 1 || options->frameTimes)
+    {
+        if (procTargetedSpectrum(captureData, fullPath, options, frameRate, tagHz, tagTemplate) < 0)
+        {
+            freeCaptureData(captureData);
+            return NULL;
+        }
+        return captureData;
+    }
 
-    // for (int i = 0; i < numOfSamplers; i++) {
-    //     printf("%f\n", creal(captureData->captureFT[i]));
-    // }
+    if (options->spectrum == PROC_SPECTRUM_WELCH || options->spectrum == PROC_SPECTRUM_MULTITAPER)
+    {
+        if (procEstimatedSpectrum(captureData, fullPath, options, frameRate, tagHz, tagTemplate) < 0)
+        {
+            freeCaptureData(captureData);
+            return NULL;
+        }
+        return captureData;
+    }
 
-    captureData->tagFT = (double *)malloc(numOfSamplers * sizeof(double *));
+    if (options->planarLayout)
+    {
+        if (procPlanarSpectrum(captureData, fullPath, options, frameRate, tagHz, tagTemplate) < 0)
+        {
+            freeCaptureData(captureData);
+            return NULL;
+        }
+        return captureData;
+    }
 
-    double maxFTPeak;
-    int idx_maxFTPeak;
-    maxFTPeak = 0;
+    bool singlePrecision = options->singlePrecision;
+#ifdef PROC_SINGLE_PRECISION
+    singlePrecision = true;
+#endif
 
-    for (int j = freqTag - 2; j <= freqTag + 2; j++)
+    if (singlePrecision)
     {
-        for (int i = 0; i < numOfSamplers; i++)
+        float complex *framesBBf = procBasebandf(fullPath, options, &numFrames, &numOfSamplers);
+        if (framesBBf == NULL)
         {
-            if (cabs(captureData->captureFT[i + numOfSamplers * (j - 1)]) > maxFTPeak)
-            {
-                maxFTPeak = cabs(captureData->captureFT[i + numOfSamplers * (j - 1)]);
-                idx_maxFTPeak = j;
-            }
+            free(captureData);
+            return NULL;
         }
+        captureData->numOfSamplers = numOfSamplers;
+        procTagSpectrumf(captureData, framesBBf, numFrames, numOfSamplers, frameRate, tagHz, options, tagTemplate);
+        free(framesBBf);
+        return captureData;
     }
-    freqTag = idx_maxFTPeak;
 
-    for (int i = 0; i < numOfSamplers; i++)
+    // Load Capture
+    double complex *framesBB = procBaseband(fullPath, options, &numFrames, &numOfSamplers);
+    if (framesBB == NULL)
     {
-        captureData->tagFT[i] = (double)cabs(captureData->captureFT[i + numOfSamplers * (idx_maxFTPeak - 1)]);
-        // printf("%f\n", captureData->tagFT[i]);
+        free(captureData);
+        return NULL;
     }
+    captureData->numOfSamplers = numOfSamplers;
 
-    // smoothData(captureData->tagFT, numOfSamplers, 10);
+    procTagSpectrum(captureData, framesBB, numFrames, numOfSamplers, frameRate, tagHz, options, tagTemplate);
 
-    for (int i = 0; i < numOfSamplers; i++)
+    free(framesBB);
+
+    return captureData;
+}
+
+/**
+ * @function procTrack(const char *fullDataPath, const char *captureName, double tagHz, const ProcOptions *options, int windowFrames, int updateFrames, void (*onUpdate)(const TagTracker *tracker, void *context), void *context)
+ * @param fullDataPath - Full data file path to radar capture. Must be in the format "user@ip:path". Example: "ericdvet@192.168.7.2:/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data"
+ * @param captureName - Name of radar capture file
+ * @param tagHz - Frequency at which tag is oscillating in Hz
+ * @param options - Processing options, NULL for the defaults of procRadarFrames()
+ * @param windowFrames - Number of most recent frames each estimate is computed over
+ * @param updateFrames - Number of frames between estimates
+ * @param onUpdate - Called with the tracker every time it holds a new estimate
+ * @param context - Passed through to onUpdate
+ * @return int
+ * @brief Runs a capture frame by frame through a TagTracker, so the tag is followed through the capture
+ *      instead of estimated once. Returns the number of estimates made, or -1 on error
+ * @author ericdvet */
+int procTrack(const char *fullDataPath, const char *captureName, double tagHz, const ProcOptions *options, int windowFrames, int updateFrames,
+              void (*onUpdate)(const TagTracker *tracker, void *context), void *context)
+{
+    ProcOptions defaultOptions = {0};
+    if (options == NULL)
     {
-        // captureData->tagFT[i] = (float) cabs(captureData->captureFT[i + numOfSamplers * (idx_maxFTPeak)]);
-        // printf("%d: %f\n", i, captureData->tagFT[i]);
+        options = &defaultOptions;
     }
 
-    // peakBin = procLargestPeak(captureData->tagFT);
-    captureData->peakBin = procCaptureCWT(captureData->tagFT);
+    // Processing parameters
+    int frameRate = 200;
 
-    // printf("\nPeak of %f at %d\n", captureData->tagFT[captureData->peakBin], captureData->peakBin);
+    char fullPath[1024];
+    procCapturePath(fullPath, sizeof(fullPath), fullDataPath, captureName);
+    ProcBasebandStream *baseband = procBasebandOpen(fullPath, options);
+    if (baseband == NULL)
+    {
+        return -1;
+    }
 
-    captureData->SNRdB = calculateSNR(captureData->captureFT, numOfSamplers, freqTag, captureData->peakBin);
+    TagTracker *tracker = trackerCreate(windowFrames, baseband->numOfSamplers, frameRate, tagHz, updateFrames);
+    double complex *blockBB = (double complex *)malloc((size_t)baseband->blockFrames * baseband->numOfSamplers * sizeof(double complex));
+    if (!tracker || !blockBB)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure");
+        free(blockBB);
+        trackerFree(tracker);
+        procBasebandClose(baseband);
+        return -1;
+    }
 
-    // printf("SNR of %f\n", SNR);
+    int numUpdates = 0;
+    int numRead;
+    while ((numRead = procBasebandNext(baseband, blockBB)) > 0)
+    {
+        for (int k = 0; k < numRead; k++)
+        {
+            if (trackerPush(tracker, &blockBB[(size_t)k * baseband->numOfSamplers]))
+            {
+                onUpdate(tracker, context);
+                numUpdates++;
+            }
+        }
+    }
 
-    captureData->numFrames = radarData->numFrames;
-    captureData->procSuccess = true;
+    free(blockBB);
+    trackerFree(tracker);
+    procBasebandClose(baseband);
+    return numRead < 0 ? -1 : numUpdates;
+}
 
-    free(rfSignal);
-    free(framesBB);
-    free(temp);
-    freeRadarData(radarData);
+/**
+ * @function procRangeBin(const CaptureData *captureData, int bin)
+ * @param captureData - Processed capture
+ * @param bin - Range bin of captureData (e.g. peakBin)
+ * @return double
+ * @brief Maps a range bin of a possibly decimated or range gated capture back to the original sampler
+ *      expected by procSoilMoisture()
+ * @author ericdvet */
+double procRangeBin(const CaptureData *captureData, int bin)
+{
+    return captureData->rangeOffset + (double)bin * captureData->decimation;
+}
 
-    return captureData;
+/**
+ * @function procRangeOffset(const ProcOptions *options)
+ * @param options - Processing options, NULL for the defaults
+ * @return int
+ * @brief Returns the original sampler of range bin 0, the start of options->rangeStart's guard band
+ *      rounded down to the decimation, or 0 without a range of interest
+ * @author ericdvet */
+int procRangeOffset(const ProcOptions *options)
+{
+    if (options == NULL || options->rangeStop <= 0)
+    {
+        return 0;
+    }
+    int decimation = options->decimation > 1 ? options->decimation : 1;
+    int rangeStart = options->rangeStart - RANGE_GUARD_SAMPLERS > 0 ? options->rangeStart - RANGE_GUARD_SAMPLERS : 0;
+    return rangeStart / decimation * decimation;
 }
 
 /**
- * @function procTagTest(const char *fullDataPath, const char *captureName, double tagHz)
+ * @function procTagTest(const char *fullDataPath, const char *captureName, double tagHz, const ProcOptions *options)
  * @param fullDataPath - Full data file path to radar capture. Must be in the format "user@ip:path". Example: "ericdvet@192.168.7.2:/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data"
  * @param captureName - Name of radar capture file
  * @param captureName - Frequency at which tag is oscillating in Hz
+ * @param options - Processing options, NULL for the defaults of procRadarFrames()
  * @return None
  * @brief Function prints capture FT and tag FT to CSV files
  */
-double procTagTest(const char *fullDataPath, const char *captureName, double tagHz) {
+double procTagTest(const char *fullDataPath, const char *captureName, double tagHz, const ProcOptions *options) {
     CaptureData *captureData;
-    captureData = procRadarFrames(fullDataPath, captureName, tagHz);
+    captureData = procRadarFramesOpts(fullDataPath, captureName, tagHz, options);
+    if (captureData == NULL) {
+        return -1;
+    }
 
     char tagFTFileName[1024];
     char captureFTFileName[1024];
@@ -174,23 +1775,36 @@ double procTagTest(const char *fullDataPath, const char *captureName, double tag
         return -1;
     }
 
-    for (int i = 0; i < 512; i++) {
+    int numOfSamplers = captureData->numOfSamplers;
+    for (int i = 0; i < numOfSamplers; i++) {
         fprintf(fileTagFT, "%.2f\n", captureData->tagFT[i]);  // Write to file in CSV format
     }
 
-    FILE *fileCaptureFT = fopen(captureFTFileName, "w");
-    if (fileCaptureFT == NULL) {
-        perror("Error opening file");
-        return -1;
-    }
+    // Targeted processing never forms the full capture FT
+    if (captureData->captureFT != NULL || captureData->captureFTf != NULL || captureData->captureFTRe != NULL) {
+        FILE *fileCaptureFT = fopen(captureFTFileName, "w");
+        if (fileCaptureFT == NULL) {
+            perror("Error opening file");
+            return -1;
+        }
 
-    for (int j = 0; j < 512; j++)
-    {
-        for (int i = 0; i < captureData->numFrames - 1; i++)
+        for (int j = 0; j < numOfSamplers; j++)
         {
-            fprintf(fileCaptureFT, "%.2f, ", fabs(captureData->captureFT[j + i * 512]));
+            for (int i = 0; i < captureData->numFrames; i++)
+            {
+                size_t idx = j + (size_t)i * numOfSamplers;
+                double value;
+                if (captureData->captureFTRe)
+                {
+                    value = fabs(captureData->captureFTRe[(size_t)j * captureData->numFrames + i]);
+                }
+                else
+                {
+                    value = captureData->captureFT ? fabs(captureData->captureFT[idx]) : fabsf(captureData->captureFTf[idx]);
+                }
+                fprintf(fileCaptureFT, i < captureData->numFrames - 1 ? "%.2f, " : "%.2f\n", value);
+            }
         }
-        fprintf(fileCaptureFT, "%.2f\n", fabs(captureData->captureFT[j + (captureData->numFrames-1) * 512]));
     }
 
     double SNR = captureData->SNRdB;
@@ -202,134 +1816,73 @@ double procTagTest(const char *fullDataPath, const char *captureName, double tag
     return SNR;
 }
 
-CaptureData *procTwoTag(const char *fullDataPath, const char *captureName, double tag1Hz, double tag2Hz) {
-    CaptureData *captureData = (CaptureData *)malloc(sizeof(CaptureData));
-
-    // Processing parameters
-    int frameRate = 200;
-    int numOfSamplers = 512;
-
-    // Load Capture
-    char fullPath[1024];
-    sprintf(fullPath, "%s/%s", fullDataPath, captureName);
-    RadarData *radarData = salsaLoad(fullPath);
-    if (radarData == NULL)
-    {
-        return false;
-    }
-
-    double *rfSignal;
-    double complex *framesBB;
-    double complex *temp;
-
-    rfSignal = (double *)malloc(numOfSamplers * sizeof(double));
-    framesBB = (double complex *)malloc((radarData->numFrames) * numOfSamplers * sizeof(double complex));
-    temp = (double complex *)malloc(numOfSamplers * sizeof(double complex));
-
-    // Baseband Conversion
-    for (int i = 0; i < radarData->numFrames; i++)
-    {
-        for (int j = 0; j < numOfSamplers; j++)
-        {
-            rfSignal[j] = radarData->frameTot[j + i * numOfSamplers];
-        }
-        NoveldaDDC(rfSignal, temp);
-        for (int j = 0; j < numOfSamplers; j++)
-        {
-            framesBB[j + i * numOfSamplers] = temp[j];
-            // printf("%d ", j + i * numOfSamplers);
-        }
-    }
-
-    // for (int i = 500; i < numOfSamplers; i++) {
-    //     printf("%f ", creal(framesBB[i]));
-    // }
-    // printf("\n");
-
-    // Find Tag FT
-    int freqTag1 = (int)(tag1Hz / frameRate * radarData->numFrames);
-    int freqTag2 = (int)(tag2Hz / frameRate * radarData->numFrames);
-
-    captureData->captureFT = (double complex *)malloc(radarData->numFrames * numOfSamplers * sizeof(double complex));
-
-    computeFFT(framesBB, captureData->captureFT, radarData->numFrames, numOfSamplers);
-
-    // for (int i = 0; i < numOfSamplers; i++) {
-    //     printf("%f\n", creal(captureData->captureFT[i]));
-    // }
-
-    captureData->tagFT = (double *)malloc(numOfSamplers * sizeof(double *));
-    captureData->tagFT2 = (double *)malloc(numOfSamplers * sizeof(double *));
-
-    double maxFTPeak1, maxFTPeak2;
-    int idx_maxFTPeak1, idx_maxFTPeak2;
-    maxFTPeak1 = 0;
-    maxFTPeak2 = 0;
-
-    for (int j = freqTag1 - 2; j <= freqTag1 + 2; j++)
-    {
-        for (int i = 0; i < numOfSamplers; i++)
-        {
-            if (cabs(captureData->captureFT[i + numOfSamplers * (j - 1)]) > maxFTPeak1)
-            {
-                maxFTPeak1 = cabs(captureData->captureFT[i + numOfSamplers * (j - 1)]);
-                idx_maxFTPeak1 = j;
-            }
-        }
-    }
-    freqTag1 = idx_maxFTPeak1;
-
-    for (int j = freqTag2 - 2; j <= freqTag2 + 2; j++)
+/**
+ * @function procPrecisionReport(const char *fullDataPath, const char *captureName, double tagHz, const ProcOptions *options)
+ * @param fullDataPath - Full data file path to radar capture. Must be in the format "user@ip:path". Example: "ericdvet@192.168.7.2:/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data"
+ * @param captureName - Name of radar capture file
+ * @param tagHz - Frequency at which tag is oscillating in Hz
+ * @param options - Processing options used for both runs, NULL for the defaults of procRadarFrames()
+ * @return double
+ * @brief Processes a capture in double and in single precision and prints how far the float path is
+ *      from the double one. Returns the largest tag FT error relative to the tag FT peak, -1 on error
+ * @author ericdvet */
+double procPrecisionReport(const char *fullDataPath, const char *captureName, double tagHz, const ProcOptions *options)
+{
+    ProcOptions reportOptions = {0};
+    if (options != NULL)
     {
-        for (int i = 0; i < numOfSamplers; i++)
-        {
-            if (cabs(captureData->captureFT[i + numOfSamplers * (j - 1)]) > maxFTPeak2)
-            {
-                maxFTPeak2 = cabs(captureData->captureFT[i + numOfSamplers * (j - 1)]);
-                idx_maxFTPeak2 = j;
-            }
-        }
+        reportOptions = *options;
     }
-    freqTag2 = idx_maxFTPeak2;
-
-    for (int i = 0; i < numOfSamplers; i++)
+    reportOptions.targetedBins = false;
+    reportOptions.planarLayout = false;
+    reportOptions.harmonics = 0;
+    reportOptions.zoomPoints = 0;
+    reportOptions.spectrum = PROC_SPECTRUM_PERIODOGRAM;
+    reportOptions.frameTimes = false;
+    reportOptions.outOfCoreDir = NULL;
+    reportOptions.fixedPoint = false;
+
+    reportOptions.singlePrecision = false;
+    CaptureData *reference = procRadarFramesOpts(fullDataPath, captureName, tagHz, &reportOptions);
+    reportOptions.singlePrecision = true;
+    CaptureData *single = procRadarFramesOpts(fullDataPath, captureName, tagHz, &reportOptions);
+    if (!reference || !single || !reference->procSuccess || !single->procSuccess || !reference->captureFT || !single->captureFTf)
     {
-        captureData->tagFT[i] = (double)cabs(captureData->captureFT[i + numOfSamplers * (idx_maxFTPeak1 - 1)]);
-        captureData->tagFT2[i] = (double)cabs(captureData->captureFT[i + numOfSamplers * (idx_maxFTPeak2 - 1)]);
-        // printf("%f\n", captureData->tagFT[i]);
+        freeCaptureData(reference);
+        freeCaptureData(single);
+        return -1;
     }
 
-    smoothData(captureData->tagFT, numOfSamplers, 10);
+    int numOfSamplers = reference->numOfSamplers;
+    size_t size = (size_t)reference->numFrames * numOfSamplers;
 
+    double maxTagFT = 0;
+    double maxTagError = 0;
     for (int i = 0; i < numOfSamplers; i++)
     {
-        // captureData->tagFT[i] = (float) cabs(captureData->captureFT[i + numOfSamplers * (idx_maxFTPeak)]);
-        // printf("%d: %f\n", i, captureData->tagFT[i]);
+        maxTagFT = fmax(maxTagFT, reference->tagFT[i]);
+        maxTagError = fmax(maxTagError, fabs(reference->tagFT[i] - single->tagFT[i]));
     }
 
-    // peakBin = procLargestPeak(captureData->tagFT);
-    captureData->peakBin = procCaptureCWT(captureData->tagFT);
-    captureData->peakBin2 = procCaptureCWT(captureData->tagFT2);
-
-    printf("\nPeak of %f at %d\n", captureData->tagFT[captureData->peakBin], captureData->peakBin);
-    printf("\nPeak 2 of %f at %d\n", captureData->tagFT[captureData->peakBin2], captureData->peakBin2);
-
-    captureData->SNRdB = calculateSNR(captureData->captureFT, numOfSamplers, freqTag1, captureData->peakBin);
-    captureData->SNRdB2 = calculateSNR(captureData->captureFT, numOfSamplers, freqTag2, captureData->peakBin2);     
-
-
-
-    // printf("SNR of %f\n", SNR);
-
-    captureData->numFrames = radarData->numFrames;
-    captureData->procSuccess = true;
-
-    free(rfSignal);
-    free(framesBB);
-    free(temp);
-    freeRadarData(radarData);
+    double maxCaptureFT = 0;
+    double maxCaptureError = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        maxCaptureFT = fmax(maxCaptureFT, cabs(reference->captureFT[i]));
+        maxCaptureError = fmax(maxCaptureError, cabs(reference->captureFT[i] - single->captureFTf[i]));
+    }
 
-    return captureData;
+    printf("Precision report for %s\n", captureName);
+    printf("Capture FT: max error %g (%g of peak)\n", maxCaptureError, maxCaptureError / maxCaptureFT);
+    printf("Tag FT: max error %g (%g of peak)\n", maxTagError, maxTagError / maxTagFT);
+    printf("Peak bin: double %d, float %d\n", reference->peakBin, single->peakBin);
+    printf("SNR: double %d dB, float %d dB\n", reference->SNRdB, single->SNRdB);
+    printf("Capture FT memory: double %zu bytes, float %zu bytes\n", size * sizeof(double complex), size * sizeof(float complex));
+
+    double relativeError = maxTagError / maxTagFT;
+    freeCaptureData(reference);
+    freeCaptureData(single);
+    return relativeError;
 }
 
 /**
@@ -343,7 +1896,11 @@ void freeCaptureData(CaptureData *captureData)
     if (captureData)
     {
         free(captureData->tagFT);
+        free(captureData->tagFT2);
         free(captureData->captureFT);
+        free(captureData->captureFTf);
+        fftw_free(captureData->captureFTRe);
+        fftw_free(captureData->captureFTIm);
         free(captureData);
     }
 }
@@ -394,12 +1951,47 @@ int procLargestPeak(double *tagFT)
 }
 
 /**
- * @function procCaptureCWT(double *tagFT)
- * @param *tagFT - pointer to FT of the tag's frequency isolated
+ * @function procCWTReserve(CWTPlan **cwtPlan, RidgeArena **ridgeArena, int numOfSamplers)
+ * @param cwtPlan - Wavelet plan, created or replaced if missing or sized for another capture
+ * @param ridgeArena - Arena for the peaks and ridge lines, created if missing
+ * @param numOfSamplers - Number of range bins in the tag FT
  * @return int
- * @brief Returns bin corresponding to the peak most similar to the ricker wavelet based
+ * @brief Makes sure a wavelet plan and ridge arena exist for procCWTPeak(). Planning is not thread safe,
+ *      so this is called before any detection runs in parallel. Returns 0 on success, -1 otherwise
+ * @author ericdvet */
+static int procCWTReserve(CWTPlan **cwtPlan, RidgeArena **ridgeArena, int numOfSamplers)
+{
+    // Continuous Wavelet Transform, DoG m = 2 at linear scales 1, 3, ..., 63. The plan is kept for the next capture
+    if (*cwtPlan == NULL || (*cwtPlan)->signalLength != numOfSamplers)
+    {
+        cwtPlanFree(*cwtPlan);
+        *cwtPlan = cwtPlanCreate(numOfSamplers, 2, CWT_NUM_SCALES, 1, 2);
+        if (*cwtPlan == NULL)
+        {
+            return -1;
+        }
+    }
+    if (*ridgeArena == NULL)
+    {
+        *ridgeArena = ridgeArenaCreate(RIDGE_ARENA_SIZE);
+        if (*ridgeArena == NULL)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @function procCWTPeak(CWTPlan *cwtPlan, RidgeArena *ridgeArena, double *tagFT, int numOfSamplers)
+ * @param cwtPlan - Wavelet plan from procCWTReserve()
+ * @param ridgeArena - Ridge arena from procCWTReserve()
+ * @param tagFT - FT of the tag's frequency isolated
+ * @param numOfSamplers - Number of range bins in tagFT
+ * @return int
+ * @brief procCaptureCWT() on a given plan and arena, so several tag FTs can be searched at once
  * @author ericdvet */
-int procCaptureCWT(double *tagFT)
+static int procCWTPeak(CWTPlan *cwtPlan, RidgeArena *ridgeArena, double *tagFT, int numOfSamplers)
 {
 
     // Control variables
@@ -408,105 +2000,40 @@ int procCaptureCWT(double *tagFT)
     // float SNRThreshold = 3.0;
     float ridgeLengthThreshold = 5;
 
-    // Continuous Wavelet Transform
-    cwt_object cwtInfo;
-    cwtInfo = cwt_init("dog", 2, 512, 1, 32);
-    setCWTScales(cwtInfo, 1, 2, "linear", 1);   
-    cwt(cwtInfo, tagFT);
+    const double *cwtOutput = cwtPlanExecute(cwtPlan, tagFT);
+    int numScales = cwtPlan->numScales;
+    int npad = cwtPlan->npad;
 
-    // More control variables
-    double amplThreshold;
-    amplThreshold = 0;
-    for (int i = 0; i < cwtInfo->J * cwtInfo->siglength; i++)
+    // Everything below is drawn from the arena, which is rewound rather than freed for the next capture
+    ridgeArenaReset(ridgeArena);
+
+    // Find local maximums in each cwt
+    double *cwtScaleCoeffs = (double *)ridgeArenaAlloc(ridgeArena, numOfSamplers * sizeof(double));
+    int *numPeaks = (int *)ridgeArenaAlloc(ridgeArena, numScales * sizeof(int));
+    int **peaks = (int **)ridgeArenaAlloc(ridgeArena, numScales * sizeof(int *));
+    if (!cwtScaleCoeffs || !numPeaks || !peaks)
     {
-        if (cwtInfo->output[i].re > amplThreshold)
+        return -1;
+    }
+    for (int scale = 0; scale < numScales; scale++)
+    {
+        for (int i = 0; i < numOfSamplers; i++)
         {
-            amplThreshold = cwtInfo->output[i].re;
+            cwtScaleCoeffs[i] = fabs(cwtOutput[(size_t)scale * npad + i]);
         }
-    }
-    amplThreshold = 0.1 * amplThreshold;
-
-
-    // Find local maximums in each cwt
-    double *cwtScaleCoeffs;
-    int *numPeaks;
-    int **peaks;
-    peaks = (int **)malloc(cwtInfo->J * sizeof(int *));
-    numPeaks = (int *)malloc(cwtInfo->J * sizeof(int));
-    cwtScaleCoeffs = (double *)malloc(512 * sizeof(double));
-    for (int i = 0; i < cwtInfo->J * cwtInfo->siglength; i++)
-    {
-        cwtScaleCoeffs[i % 512] = fabs(cwtInfo->output[i].re);
-        if (i % 512 == 0 && i != 0)
-        {
-            peaks[(i / 512) - 1] = findPeaks(cwtScaleCoeffs, 512, &(numPeaks[(i / 512) - 1]), 0); // Fuck this line of code for the 2 hours of seg fault headaches
-            for (int j = 0; j < numPeaks[(i / 512) - 1]; j++)
-            {
-            }
+        peaks[scale] = ridgeFindPeaks(ridgeArena, cwtScaleCoeffs, numOfSamplers, &numPeaks[scale]);
+        if (!peaks[scale])
+        {
+            return -1;
         }
     }
-    peaks[((cwtInfo->J * cwtInfo->siglength) / 512) - 1] = findPeaks(cwtScaleCoeffs, 512, &(numPeaks[((cwtInfo->J * cwtInfo->siglength) / 512) - 1]), 0);
 
     // Find all ridge lines
-    RidgeLine *ridgeLines;
-    ridgeLines = (RidgeLine *)malloc(1000 * sizeof(RidgeLine));
-    int numRidgeLines = 0;
-    for (int scale = cwtInfo->J - 1; scale >= 0; scale--)
-    {
-        // printf("test: %d @ %d\n", numPeaks[scale], scale);
-        for (int i = 0; i < numPeaks[scale]; i++)
-        {
-            int peak = peaks[scale][i];
-            RidgeLine ridgeLine;
-            ridgeLine.pointScales = (int *)malloc(cwtInfo->J * sizeof(int));
-            ridgeLine.pointLocations = (int *)malloc(cwtInfo->J * sizeof(int));
-            if (ridgeLine.pointScales == NULL || ridgeLine.pointLocations == NULL)
-            {
-                return -1;
-            }
-            ridgeLine.length = 1;
-            ridgeLine.pointScales[0] = scale;
-            ridgeLine.pointLocations[0] = peak;
-
-            int gap = 0;
-            for (int s = scale - 1; s >= 0 && gap <= gapThreshold; s--)
-            {
-                int closestMaxIdx = -1;
-                double closestGap = slidingWindowThreshold * s;
-                for (int j = 0; j < numPeaks[s]; j++)
-                {
-                    double currentGap = fabs(peak - peaks[s][j]);
-                    if (currentGap < closestGap)
-                    {
-                        closestGap = currentGap;
-                        closestMaxIdx = j;
-                    }
-                }
-                if (closestMaxIdx != -1)
-                {
-                    ridgeLine.pointScales[ridgeLine.length] = s;
-                    ridgeLine.pointLocations[ridgeLine.length] = peaks[s][closestMaxIdx];
-                    ridgeLine.length++;
-                    numPeaks[s]--;
-                    gap = 0;
-                }
-                else
-                {
-                    gap++;
-                }
-            }
-
-            if (ridgeLine.length > 1)
-            {
-                ridgeLines[numRidgeLines] = ridgeLine;
-                numRidgeLines++;
-            }
-            else
-            {
-                free(ridgeLine.pointScales);
-                free(ridgeLine.pointLocations);
-            }
-        }
+    int numRidgeLines;
+    RidgeLine *ridgeLines = ridgeTrack(ridgeArena, peaks, numPeaks, numScales, gapThreshold, slidingWindowThreshold, &numRidgeLines);
+    if (!ridgeLines)
+    {
+        return -1;
     }
 
     // Process ridges
@@ -532,37 +2059,449 @@ int procCaptureCWT(double *tagFT)
         }
     }
 
-    free(numPeaks);
-    free(cwtScaleCoeffs);
-    for (int i = 0; i < cwtInfo->J; i++)
+    return peakBin;
+}
+
+/**
+ * @function procCaptureCWT(double *tagFT, int numOfSamplers)
+ * @param *tagFT - pointer to FT of the tag's frequency isolated
+ * @param numOfSamplers - Number of range bins in tagFT
+ * @return int
+ * @brief Returns bin corresponding to the peak most similar to the ricker wavelet based
+ * @author ericdvet */
+int procCaptureCWT(double *tagFT, int numOfSamplers)
+{
+    if (procCWTReserve(&procCWTPlan, &procRidgeArena, numOfSamplers) < 0)
+    {
+        return -1;
+    }
+    return procCWTPeak(procCWTPlan, procRidgeArena, tagFT, numOfSamplers);
+}
+
+/**
+ * @function procCaptureCWTCleanup(void)
+ * @return None
+ * @brief Releases the wavelet plans and ridge arenas kept by procCaptureCWT() and procMultiTag() between captures
+ * @author ericdvet */
+void procCaptureCWTCleanup(void)
+{
+    cwtPlanFree(procCWTPlan);
+    procCWTPlan = NULL;
+    ridgeArenaFree(procRidgeArena);
+    procRidgeArena = NULL;
+    for (int worker = 0; worker < PROC_MAX_WORKERS; worker++)
     {
-        free(peaks[i]);
+        cwtPlanFree(procWorkerCWTPlans[worker]);
+        procWorkerCWTPlans[worker] = NULL;
+        ridgeArenaFree(procWorkerRidgeArenas[worker]);
+        procWorkerRidgeArenas[worker] = NULL;
     }
-    free(peaks);
-    for (int i = 0; i < numRidgeLines; i++) {
-        free(ridgeLines[i].pointScales);
-        free(ridgeLines[i].pointLocations);
+}
+
+/**
+ * @function procMultiTagSmoothed(const char *fullDataPath, const char *captureName, const double *tagHz, int numTags, const ProcOptions *options, const int *smoothWindows)
+ * @param fullDataPath - Full data file path to radar capture. Must be in the format "user@ip:path". Example: "ericdvet@192.168.7.2:/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data"
+ * @param captureName - Name of radar capture file
+ * @param tagHz - Frequency at which each tag is oscillating in Hz (numTags)
+ * @param numTags - Number of tags in the capture
+ * @param options - Processing options, NULL for the defaults
+ * @param smoothWindows - Window smoothData() runs over each tag's FT before its peak is detected, 0 to leave
+ *      it as is (numTags). NULL smooths no tag
+ * @return MultiTagData *
+ * @brief procMultiTag() with optionally smoothed tag FTs
+ * @author ericdvet */
+static MultiTagData *procMultiTagSmoothed(const char *fullDataPath, const char *captureName, const double *tagHz, int numTags,
+                                          const ProcOptions *options, const int *smoothWindows)
+{
+    ProcOptions defaultOptions = {0};
+    if (options == NULL)
+    {
+        options = &defaultOptions;
+    }
+    if (numTags < 1)
+    {
+        fprintf(stderr, "ERROR: No tag frequencies given\n");
+        return NULL;
+    }
+    if (options->templateCapture || options->zoomPoints > 0 || options->spectrum != PROC_SPECTRUM_PERIODOGRAM || options->outOfCoreDir ||
+        options->singlePrecision || options->planarLayout || options->fixedPoint)
+    {
+        fprintf(stderr, "ERROR: Multiple tags only support the loader, decimation, targeted bins, harmonics, frame times, detector, "
+                        "matched filter, clutter and range options\n");
+        return NULL;
     }
-    free(ridgeLines);
-    cwt_free(cwtInfo);
 
-    return peakBin;
+    // Processing parameters
+    int frameRate = 200;
+    int numOfSamplers;
+    int numFrames;
+
+    char fullPath[1024];
+    procCapturePath(fullPath, sizeof(fullPath), fullDataPath, captureName);
+
+    // Load and downconvert once for all tags, then either the full slow-time FFT or a single targeted DFT
+    // holding the search window and noise band of every tag
+    double complex *captureFT = NULL;
+    SlowTimeDFT *dft = NULL;
+    if (options->targetedBins || options->harmonics > 1 || options->frameTimes)
+    {
+        ProcBasebandStream *baseband = procBasebandOpen(fullPath, options);
+        if (baseband == NULL)
+        {
+            return NULL;
+        }
+        numFrames = baseband->numFrames;
+        numOfSamplers = baseband->numOfSamplers;
+
+        int numBins = 0;
+        int *bins = NULL;
+        for (int t = 0; t < numTags; t++)
+        {
+            int numTagBins;
+            int tagFreq = (int)(tagHz[t] / frameRate * numFrames);
+            int *tagBins = options->harmonics > 1 ? slowTimeHarmonicBins(tagFreq, options->harmonics, &numTagBins)
+                                                  : slowTimeTagBins(tagFreq, &numTagBins);
+            int *grown = tagBins ? (int *)realloc(bins, (numBins + numTagBins) * sizeof(int)) : NULL;
+            if (grown == NULL)
+            {
+                free(tagBins);
+                numBins = 0;
+                break;
+            }
+            bins = grown;
+            memcpy(&bins[numBins], tagBins, numTagBins * sizeof(int));
+            numBins += numTagBins;
+            free(tagBins);
+        }
+        dft = numBins > 0 ? slowTimeCreate(numFrames, numOfSamplers, bins, numBins) : NULL;
+        double complex *blockBB = (double complex *)malloc((size_t)baseband->blockFrames * numOfSamplers * sizeof(double complex));
+        free(bins);
+        if (!dft || !blockBB)
+        {
+            fprintf(stderr, "ERROR: Memory allocation failure\n");
+            free(blockBB);
+            slowTimeFree(dft);
+            procBasebandClose(baseband);
+            return NULL;
+        }
+
+        int numRead;
+        while ((numRead = procBasebandNext(baseband, blockBB)) > 0)
+        {
+            procBasebandAccumulate(baseband, dft, blockBB, numRead, options, frameRate);
+        }
+        free(blockBB);
+        procBasebandClose(baseband);
+        if (numRead < 0)
+        {
+            slowTimeFree(dft);
+            return NULL;
+        }
+    }
+    else
+    {
+        double complex *framesBB = procBaseband(fullPath, options, &numFrames, &numOfSamplers);
+        if (framesBB == NULL)
+        {
+            return NULL;
+        }
+        captureFT = (double complex *)malloc((size_t)numFrames * numOfSamplers * sizeof(double complex));
+        if (captureFT == NULL)
+        {
+            fprintf(stderr, "ERROR: Memory allocation failure\n");
+            free(framesBB);
+            return NULL;
+        }
+        computeFFT(framesBB, captureFT, numFrames, numOfSamplers);
+        free(framesBB);
+    }
+
+    MultiTagData *multiTagData = (MultiTagData *)calloc(1, sizeof(MultiTagData));
+    if (multiTagData)
+    {
+        multiTagData->captureFT = captureFT;
+        multiTagData->tagFT = (double *)malloc((size_t)numTags * numOfSamplers * sizeof(double));
+        multiTagData->tagBin = (int *)malloc(numTags * sizeof(int));
+        multiTagData->peakBin = (int *)malloc(numTags * sizeof(int));
+        multiTagData->SNRdB = (double *)malloc(numTags * sizeof(double));
+    }
+    if (!multiTagData || !multiTagData->tagFT || !multiTagData->tagBin || !multiTagData->peakBin || !multiTagData->SNRdB)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        if (multiTagData)
+        {
+            freeMultiTagData(multiTagData);
+        }
+        else
+        {
+            free(captureFT);
+        }
+        slowTimeFree(dft);
+        return NULL;
+    }
+    multiTagData->numTags = numTags;
+    multiTagData->numFrames = numFrames;
+    multiTagData->numOfSamplers = numOfSamplers;
+    multiTagData->decimation = options->decimation > 1 ? options->decimation : 1;
+    multiTagData->rangeOffset = procRangeOffset(options);
+
+    // Wavelet plans are made here, one per worker, because FFTW planning is not thread safe
+    int numWorkers = 1;
+#ifdef _OPENMP
+    numWorkers = omp_get_max_threads();
+#endif
+    numWorkers = numWorkers < numTags ? numWorkers : numTags;
+    numWorkers = numWorkers < PROC_MAX_WORKERS ? numWorkers : PROC_MAX_WORKERS;
+    bool useCWT = options->detector != PROC_DETECTOR_CFAR_CA && options->detector != PROC_DETECTOR_CFAR_OS;
+    for (int worker = 0; useCWT && worker < numWorkers; worker++)
+    {
+        if (procCWTReserve(&procWorkerCWTPlans[worker], &procWorkerRidgeArenas[worker], numOfSamplers) < 0)
+        {
+            freeMultiTagData(multiTagData);
+            slowTimeFree(dft);
+            return NULL;
+        }
+    }
+
+    // Tags only read the shared spectrum and write their own row, so they are independent
+#pragma omp parallel for num_threads(numWorkers) schedule(dynamic)
+    for (int t = 0; t < numTags; t++)
+    {
+        int worker = 0;
+#ifdef _OPENMP
+        worker = omp_get_thread_num();
+#endif
+        double *tagFT = &multiTagData->tagFT[(size_t)t * numOfSamplers];
+        int freqTag = (int)(tagHz[t] / frameRate * numFrames);
+
+        if (dft && options->harmonics > 1)
+        {
+            freqTag = slowTimeHarmonicFT(dft, freqTag, options->harmonics, options->coherentHarmonics, tagFT);
+        }
+        else if (dft)
+        {
+            freqTag = slowTimeTagFT(dft, freqTag, tagFT);
+        }
+        else
+        {
+            freqTag = procTagSearch(captureFT, numOfSamplers, freqTag, tagFT);
+        }
+        multiTagData->tagBin[t] = freqTag;
+        if (smoothWindows && smoothWindows[t] > 0)
+        {
+            smoothData(tagFT, numOfSamplers, smoothWindows[t]);
+        }
+
+        int peakBin = useCWT ? procCWTPeak(procWorkerCWTPlans[worker], procWorkerRidgeArenas[worker], tagFT, numOfSamplers)
+                             : procCFARPeak(&procWorkerCFARCaches[worker], options, tagFT, numOfSamplers);
+        multiTagData->peakBin[t] = peakBin;
+        if (dft && options->harmonics > 1)
+        {
+            multiTagData->SNRdB[t] = slowTimeHarmonicSNR(dft, freqTag, options->harmonics, options->coherentHarmonics, peakBin);
+        }
+        else
+        {
+            multiTagData->SNRdB[t] = dft ? slowTimeSNR(dft, freqTag, peakBin) : calculateSNR(captureFT, numOfSamplers, freqTag, peakBin);
+        }
+    }
+
+    slowTimeFree(dft);
+    multiTagData->procSuccess = true;
+    return multiTagData;
 }
 
 /**
- * @function procSoilMoisture(double wetPeakBin, double airPeakBin, const char* soilType, double distance)
- * @param wetPeakBin - peak bin of backscatter tag covered by wet soil
- * @param airPeakBin - peak bin of backscatter tag uncovered by soil
- * @param soilType - type of soil
- * @param distance - distance between backscatter tag and surface in meters
- * @return double 
- * @brief Returns VWC calculated based on ToF and teros-12 sensor calibrations
+ * @function procMultiTag(const char *fullDataPath, const char *captureName, const double *tagHz, int numTags, const ProcOptions *options)
+ * @param fullDataPath - Full data file path to radar capture. Must be in the format "user@ip:path". Example: "ericdvet@192.168.7.2:/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data"
+ * @param captureName - Name of radar capture file
+ * @param tagHz - Frequency at which each tag is oscillating in Hz (numTags)
+ * @param numTags - Number of tags in the capture
+ * @param options - Processing options, NULL for the defaults. The loader, decimation, targeted bins, harmonics, frame times,
+ *      detector, matched filter, clutter and range are used, any other stage is an error
+ * @return MultiTagData *
+ * @brief Separates tags oscillating at different frequencies with one load, one DDC and one slow-time
+ *      transform of the capture. Each tag's FT is read from the shared spectrum and the tags are
+ *      detected in parallel when built with OpenMP
  * @author ericdvet */
-double procSoilMoisture(double wetPeakBin, double airPeakBin, const char* soilType, double distance) {
-    double t = ((wetPeakBin - airPeakBin + distance / 0.003790984152165) * 0.003790984152165) / 299792458.0;
+MultiTagData *procMultiTag(const char *fullDataPath, const char *captureName, const double *tagHz, int numTags, const ProcOptions *options)
+{
+    return procMultiTagSmoothed(fullDataPath, captureName, tagHz, numTags, options, NULL);
+}
 
-    double radar_perm = pow((299792458.0 * t) / distance, 2);
+CaptureData *procTwoTag(const char *fullDataPath, const char *captureName, double tag1Hz, double tag2Hz) {
+    return procTwoTagOpts(fullDataPath, captureName, tag1Hz, tag2Hz, NULL);
+}
+
+/**
+ * @function procTwoTagOpts(const char *fullDataPath, const char *captureName, double tag1Hz, double tag2Hz, const ProcOptions *options)
+ * @param fullDataPath - Full data file path to radar capture. Must be in the format "user@ip:path". Example: "ericdvet@192.168.7.2:/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data"
+ * @param captureName - Name of radar capture file
+ * @param tag1Hz - Frequency at which the first tag is oscillating in Hz
+ * @param tag2Hz - Frequency at which the second tag is oscillating in Hz
+ * @param options - Processing options, NULL for the defaults of procTwoTag(). Passed to procMultiTag()
+ * @return CaptureData *
+ * @brief procTwoTag() with processing options. The first tag's FT is smoothed over 10 range bins before
+ *      its peak is detected, and both peaks are printed from it, as procTwoTag() always has
+ * @author ericdvet */
+CaptureData *procTwoTagOpts(const char *fullDataPath, const char *captureName, double tag1Hz, double tag2Hz, const ProcOptions *options) {
+    double tagHz[2] = {tag1Hz, tag2Hz};
+    int smoothWindows[2] = {10, 0};
+    MultiTagData *multiTagData = procMultiTagSmoothed(fullDataPath, captureName, tagHz, 2, options, smoothWindows);
+    if (multiTagData == NULL)
+    {
+        return NULL;
+    }
+
+    int numOfSamplers = multiTagData->numOfSamplers;
+    CaptureData *captureData = (CaptureData *)calloc(1, sizeof(CaptureData));
+    captureData->tagFT = (double *)malloc(numOfSamplers * sizeof(double));
+    captureData->tagFT2 = (double *)malloc(numOfSamplers * sizeof(double));
+    if (!captureData->tagFT || !captureData->tagFT2)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        freeCaptureData(captureData);
+        freeMultiTagData(multiTagData);
+        return NULL;
+    }
+    memcpy(captureData->tagFT, multiTagData->tagFT, numOfSamplers * sizeof(double));
+    memcpy(captureData->tagFT2, &multiTagData->tagFT[numOfSamplers], numOfSamplers * sizeof(double));
+
+    // The shared capture FT is handed over rather than copied
+    captureData->captureFT = multiTagData->captureFT;
+    multiTagData->captureFT = NULL;
+
+    captureData->peakBin = multiTagData->peakBin[0];
+    captureData->peakBin2 = multiTagData->peakBin[1];
+    captureData->SNRdB = multiTagData->SNRdB[0];
+    captureData->SNRdB2 = multiTagData->SNRdB[1];
+
+    printf("\nPeak of %f at %d\n", captureData->peakBin >= 0 ? captureData->tagFT[captureData->peakBin] : 0, captureData->peakBin);
+    printf("\nPeak 2 of %f at %d\n", captureData->peakBin2 >= 0 ? captureData->tagFT[captureData->peakBin2] : 0, captureData->peakBin2);
+
+    captureData->numFrames = multiTagData->numFrames;
+    captureData->numOfSamplers = numOfSamplers;
+    captureData->decimation = multiTagData->decimation;
+    captureData->rangeOffset = multiTagData->rangeOffset;
+    captureData->procSuccess = true;
+
+    freeMultiTagData(multiTagData);
+    return captureData;
+}
+
+/**
+ * @function procPNTags(const char *fullDataPath, const char *captureName, const int *codes, int codeLength, int numCodes, double chipRate, const ProcOptions *options)
+ * @param fullDataPath - Full data file path to radar capture. Must be in the format "user@ip:path". Example: "ericdvet@192.168.7.2:/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data"
+ * @param captureName - Name of radar capture file
+ * @param codes - Chips of every tag's code, numCodes x codeLength, 0 or 1 like pn[] in radarBackscatter.ino
+ * @param codeLength - Number of chips per code
+ * @param numCodes - Number of tags
+ * @param chipRate - Chips per second sent by the tags
+ * @param options - Processing options, NULL for the defaults. Only the loader, decimation, detector, matched
+ *      filter, clutter and range options are supported, any other option is an error
+ * @return MultiTagData *
+ * @brief Finds tags that share one band but send different pseudo-noise codes by despreading each code
+ *      from the slow-time FFT of the capture. Row t of tagFT is the correlation magnitude of code t
+ * @author ericdvet */
+MultiTagData *procPNTags(const char *fullDataPath, const char *captureName, const int *codes, int codeLength, int numCodes, double chipRate,
+                         const ProcOptions *options)
+{
+    ProcOptions defaultOptions = {0};
+    if (options == NULL)
+    {
+        options = &defaultOptions;
+    }
+    // The codes are despread from the double precision slow-time FFT of the whole capture
+    if (options->templateCapture || options->zoomPoints > 0 || options->spectrum != PROC_SPECTRUM_PERIODOGRAM || options->outOfCoreDir ||
+        options->singlePrecision || options->planarLayout || options->fixedPoint || options->targetedBins || options->harmonics > 1 ||
+        options->frameTimes)
+    {
+        fprintf(stderr, "ERROR: Pseudo-noise tags only support the loader, decimation, detector, matched filter, clutter and range options\n");
+        return NULL;
+    }
+
+    // Processing parameters
+    int frameRate = 200;
+    int numOfSamplers;
+    int numFrames;
+
+    // Load Capture
+    char fullPath[1024];
+    procCapturePath(fullPath, sizeof(fullPath), fullDataPath, captureName);
+    double complex *framesBB = procBaseband(fullPath, options, &numFrames, &numOfSamplers);
+    if (framesBB == NULL)
+    {
+        return NULL;
+    }
+
+    PNCorrelator *pn = pnCorrelatorCreate(codes, codeLength, numCodes, chipRate, frameRate, numFrames, numOfSamplers);
+    MultiTagData *multiTagData = (MultiTagData *)calloc(1, sizeof(MultiTagData));
+    if (multiTagData)
+    {
+        multiTagData->captureFT = (double complex *)malloc((size_t)numFrames * numOfSamplers * sizeof(double complex));
+        multiTagData->tagFT = (double *)malloc((size_t)numCodes * numOfSamplers * sizeof(double));
+        multiTagData->tagBin = (int *)malloc(numCodes * sizeof(int));
+        multiTagData->peakBin = (int *)malloc(numCodes * sizeof(int));
+        multiTagData->SNRdB = (double *)malloc(numCodes * sizeof(double));
+    }
+    if (!pn || !multiTagData || !multiTagData->captureFT || !multiTagData->tagFT || !multiTagData->tagBin || !multiTagData->peakBin ||
+        !multiTagData->SNRdB)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        pnCorrelatorFree(pn);
+        freeMultiTagData(multiTagData);
+        free(framesBB);
+        return NULL;
+    }
+    multiTagData->numTags = numCodes;
+    multiTagData->numFrames = numFrames;
+    multiTagData->numOfSamplers = numOfSamplers;
+    multiTagData->decimation = options->decimation > 1 ? options->decimation : 1;
+    multiTagData->rangeOffset = procRangeOffset(options);
+
+    // The correlation with every code is read from the same slow-time FFT
+    computeFFT(framesBB, multiTagData->captureFT, numFrames, numOfSamplers);
+    free(framesBB);
+
+    for (int code = 0; code < numCodes; code++)
+    {
+        double *tagFT = &multiTagData->tagFT[(size_t)code * numOfSamplers];
+        multiTagData->tagBin[code] = pnCorrelatorDespread(pn, multiTagData->captureFT, code, tagFT);
+        multiTagData->peakBin[code] = procPeakBin(options, NULL, tagFT, numOfSamplers);
+        multiTagData->SNRdB[code] = pnCorrelatorSNR(pn, multiTagData->peakBin[code]);
+    }
 
+    pnCorrelatorFree(pn);
+    multiTagData->procSuccess = true;
+    return multiTagData;
+}
+
+/**
+ * @function freeMultiTagData(MultiTagData *multiTagData)
+ * @param multiTagData - MultiTagData struct to free
+ * @return None
+ * @brief Free MultiTagData constructed by procMultiTag()
+ * @author ericdvet */
+void freeMultiTagData(MultiTagData *multiTagData)
+{
+    if (multiTagData)
+    {
+        free(multiTagData->captureFT);
+        free(multiTagData->tagFT);
+        free(multiTagData->tagBin);
+        free(multiTagData->peakBin);
+        free(multiTagData->SNRdB);
+        free(multiTagData);
+    }
+}
+
+/**
+ * @function procSoilVWC(double radar_perm, const char* soilType)
+ * @param radar_perm - radar permittivity of the soil
+ * @param soilType - type of soil
+ * @return double
+ * @brief Returns VWC from the teros-12 sensor calibration of the soil type, -1 for an unknown soil type
+ * @author ericdvet */
+static double procSoilVWC(double radar_perm, const char* soilType) {
     double perm_to_RAW = (0.01018 * pow(radar_perm, 3)) - (1.479 * pow(radar_perm, 2)) + (77.47 * radar_perm) + 1711;
 
     double VWC;
@@ -584,6 +2523,73 @@ double procSoilMoisture(double wetPeakBin, double airPeakBin, const char* soilTy
     return VWC;
 }
 
+/**
+ * @function procSoilMoisture(double wetPeakBin, double airPeakBin, const char* soilType, double distance)
+ * @param wetPeakBin - peak bin of backscatter tag covered by wet soil
+ * @param airPeakBin - peak bin of backscatter tag uncovered by soil
+ * @param soilType - type of soil
+ * @param distance - distance between backscatter tag and surface in meters
+ * @return double 
+ * @brief Returns VWC calculated based on ToF and teros-12 sensor calibrations
+ * @author ericdvet */
+double procSoilMoisture(double wetPeakBin, double airPeakBin, const char* soilType, double distance) {
+    double t = ((wetPeakBin - airPeakBin + distance / SAMPLER_METERS) * SAMPLER_METERS) / 299792458.0;
+
+    double radar_perm = pow((299792458.0 * t) / distance, 2);
+
+    return procSoilVWC(radar_perm, soilType);
+}
+
+/**
+ * @function procSoilMaxPermittivity(const char *soilType)
+ * @param soilType - type of soil
+ * @return double
+ * @brief Returns the largest radar permittivity the soil type's calibration maps to a VWC, where the
+ *      calibration reaches SATURATED_VWC or turns over, whichever comes first. -1 for an unknown soil type
+ * @author ericdvet */
+double procSoilMaxPermittivity(const char *soilType) {
+    double previous = procSoilVWC(1.0, soilType);
+    if (previous == -1.0) {
+        return -1.0;
+    }
+
+    double perm = 1.0;
+    while (perm < 80.0) {
+        double VWC = procSoilVWC(perm + 0.1, soilType);
+        if (VWC < previous || VWC > SATURATED_VWC) {
+            break;
+        }
+        previous = VWC;
+        perm += 0.1;
+    }
+    return perm;
+}
+
+/**
+ * @function procRangeOfInterest(double airPeakBin, const char *soilType, double distance, int *rangeStart, int *rangeStop)
+ * @param airPeakBin - peak bin of backscatter tag uncovered by soil, in original samplers
+ * @param soilType - type of soil
+ * @param distance - distance between backscatter tag and surface in meters
+ * @param rangeStart - Resulting first sampler of the range of interest
+ * @param rangeStop - Resulting sampler past the range of interest
+ * @return int
+ * @brief The buried tag can only appear between its air peak bin and the delay of distance through
+ *      soil of procSoilMaxPermittivity(), so that is the range of interest for ProcOptions. Returns 0
+ *      on success, -1 for an unknown soil type
+ * @author ericdvet */
+int procRangeOfInterest(double airPeakBin, const char *soilType, double distance, int *rangeStart, int *rangeStop) {
+    double maxPerm = procSoilMaxPermittivity(soilType);
+    if (maxPerm < 0) {
+        return -1;
+    }
+
+    // procSoilMoisture() inverted at the largest permittivity
+    double maxDelay = (sqrt(maxPerm) - 1.0) * distance / SAMPLER_METERS;
+    *rangeStart = (int)floor(airPeakBin);
+    *rangeStop = (int)ceil(airPeakBin + maxDelay) + 1;
+    return 0;
+}
+
 // #define PROC_TEST
 
 #ifdef PROC_TEST
@@ -591,8 +2597,9 @@ int main()
 {
     // CaptureData *captureData;
     // captureData = procRadarFrames("/home/ericdvet/jlab/wadar/signal_processing/", "testFile.frames", 80);
-    procTagTest("/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data", "2024-10-10__testNoTag_C1.frames", 64);
+    procTagTest("/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data", "2024-10-10__testNoTag_C1.frames", 64, NULL);
     // procTwoTag("/home/ericdvet/jlab/wadar/signal_processing/", "testFile.frames", 79, 80);
+    // procPrecisionReport("/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data", "2024-10-10__testNoTag_C1.frames", 64, NULL);
 
     // freeCaptureData(captureData);
 
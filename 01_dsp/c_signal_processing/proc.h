@@ -16,6 +16,7 @@
 #include <complex.h>
 #include <string.h>
 #include "salsa.h"
+#include "tracker.h"
 
 /**
  * @struct CaptureData
@@ -25,6 +26,9 @@ typedef struct
 {
     bool procSuccess;
     double complex *captureFT;
+    float complex *captureFTf;
+    double *captureFTRe;
+    double *captureFTIm;
     double *tagFT;
     double *tagFT2;
     int peakBin;
@@ -32,18 +36,81 @@ typedef struct
     int SNRdB;
     int SNRdB2;
     int numFrames;
+    int numOfSamplers;
+    int decimation;
+    double tagHz; // tag frequency found on the chirp-Z grid, 0 without ProcOptions.zoomPoints
+    int rangeOffset; // original sampler of range bin 0, nonzero with ProcOptions.rangeStop
 } CaptureData;
 
 /**
- * @struct RidgeLine
- * @brief Stores ridge line information for procCaptureCWT()
+ * @struct MultiTagData
+ * @brief Stores the tag FT, peak bin and SNR of every tag found by procMultiTag() in one capture
  * @author ericdvet */
 typedef struct
 {
-    int *pointScales;
-    int *pointLocations;
-    int length;
-} RidgeLine;
+    bool procSuccess;
+    double complex *captureFT; // shared slow-time FFT, NULL with ProcOptions.targetedBins, harmonics or frameTimes
+    int numTags;
+    double *tagFT;             // numTags x numOfSamplers, row t belongs to tag t
+    int *tagBin;               // slow-time bin each tag was found at, or code lag in frames for procPNTags()
+    int *peakBin;
+    double *SNRdB;
+    int numFrames;
+    int numOfSamplers;
+    int decimation;
+    int rangeOffset;           // original sampler of range bin 0, nonzero with ProcOptions.rangeStop
+} MultiTagData;
+
+// Peak detectors selectable through ProcOptions.detector
+#define PROC_DETECTOR_CWT 0     // procCaptureCWT() ridge lines
+#define PROC_DETECTOR_CFAR_CA 1 // cell averaging CFAR
+#define PROC_DETECTOR_CFAR_OS 2 // order statistic CFAR
+
+// Slow-time spectral estimates selectable through ProcOptions.spectrum
+#define PROC_SPECTRUM_PERIODOGRAM 0 // one slow-time FFT of the whole capture
+#define PROC_SPECTRUM_WELCH 1       // averaged Hann-windowed segments overlapping by half
+#define PROC_SPECTRUM_MULTITAPER 2  // averaged DPSS tapers
+
+// Clutter maps selectable through ProcOptions.clutter
+#define PROC_CLUTTER_NONE 0     // baseband frames go straight to the slow-time transform
+#define PROC_CLUTTER_STATIC 1   // mean of the first frames, then held
+#define PROC_CLUTTER_ADAPTIVE 2 // exponential average that follows slow changes
+#define PROC_CLUTTER_MTI 3      // 3 pulse MTI canceller
+
+/**
+ * @struct ProcOptions
+ * @brief Optional processing stages for procRadarFramesOpts(). A zero-initialized struct gives the
+ *      processing of procRadarFrames()
+ * @author ericdvet */
+typedef struct
+{
+    int blockFrames;             // > 0 reads the capture through a SalsaStream in blocks of this many frames
+    int decimation;              // > 1 decimates the baseband frames by this factor in the DDC
+    bool targetedBins;           // only compute the slow-time bins around the tag and the SNR noise band (no captureFT)
+    bool singlePrecision;        // load, downconvert and FFT in float into captureFTf (forced by -DPROC_SINGLE_PRECISION)
+    bool planarLayout;           // keep the capture FT as range-bin-major real/imaginary planes in captureFTRe/captureFTIm
+    const char *templateCapture; // locate the tag by correlation with this capture's tag FT instead of procCaptureCWT()
+    int detector;                // PROC_DETECTOR_* used to find the peak bin when there is no template
+    int cfarGuardCells;          // CFAR guard cells on each side, 0 for the default
+    int cfarTrainingCells;       // CFAR training cells on each side, 0 for the default
+    double cfarFalseAlarmRate;   // CFAR false alarm rate, 0 for the default
+    int harmonics;               // > 1 combines this many odd harmonics of the tag, read from targeted bins
+    bool coherentHarmonics;      // phase align the harmonics instead of adding their power
+    int zoomPoints;              // > 0 searches for the tag on a chirp-Z grid of this many points over freqTag +/- 2.5 bins
+    int spectrum;                // PROC_SPECTRUM_* the tag FT and SNR are read from
+    int spectrumSegmentFrames;   // Welch or multitaper segment length, 0 for the default
+    int spectrumTapers;          // multitaper DPSS tapers, 0 for the default
+    bool frameTimes;             // evaluate the targeted bins at the logged frame times instead of a uniform frame rate
+    const char *outOfCoreDir;    // run the slow-time FFT out of core through a scratch file in this directory
+    int outOfCoreMB;             // out-of-core tile memory budget in MB, 0 for the default
+    bool matchedFilter;          // correlate every baseband frame with the Chipotle pulse before the slow-time transform
+    const char *pulseCapture;    // with matchedFilter, take the pulse from this air capture's direct path instead of the chip model
+    int clutter;                 // PROC_CLUTTER_* map removed from the baseband frames before the slow-time transform
+    double clutterBeta;          // adaptation rate of PROC_CLUTTER_ADAPTIVE, 0 for the default
+    int rangeStart;              // first original sampler of the range of interest
+    int rangeStop;               // > 0 only processes samplers rangeStart to rangeStop - 1, plus guard bands
+    bool fixedPoint;             // normalize, downconvert, DFT the tag bins and pick the peak in Q15/Q31 integer arithmetic
+} ProcOptions;
 
 /**
  * @function procRadarFrames(const char *fullDataPath, const char *captureName, double tagHz)
@@ -56,14 +123,86 @@ typedef struct
 CaptureData *procRadarFrames(const char *fullDataPath, const char *captureName, double tagHz);
 
 /**
- * @function procTagTest(const char *fullDataPath, const char *captureName, double tagHz)
+ * @function procRadarFramesStream(const char *fullDataPath, const char *captureName, double tagHz, int blockFrames)
+ * @param fullDataPath - Full data file path to radar capture. Must be in the format "user@ip:path". Example: "ericdvet@192.168.7.2:/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data"
+ * @param captureName - Name of radar capture file
+ * @param tagHz - Frequency at which tag is oscillating in Hz
+ * @param blockFrames - Number of frames read and downconverted per block
+ * @return CaptureData *
+ * @brief Same processing as procRadarFrames() but the capture is read through a SalsaStream, so neither
+ *      the raw counters nor the normalized frames are ever held (or mapped) whole
+ * @author ericdvet */
+CaptureData *procRadarFramesStream(const char *fullDataPath, const char *captureName, double tagHz, int blockFrames);
+
+/**
+ * @function procRadarFramesOpts(const char *fullDataPath, const char *captureName, double tagHz, const ProcOptions *options)
+ * @param fullDataPath - Full data file path to radar capture. Must be in the format "user@ip:path". Example: "ericdvet@192.168.7.2:/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data"
+ * @param captureName - Name of radar capture file
+ * @param tagHz - Frequency at which tag is oscillating in Hz
+ * @param options - Processing options, NULL for the defaults of procRadarFrames()
+ * @return CaptureData *
+ * @brief procRadarFrames() with optional processing stages
+ * @author ericdvet */
+CaptureData *procRadarFramesOpts(const char *fullDataPath, const char *captureName, double tagHz, const ProcOptions *options);
+
+/**
+ * @function procTrack(const char *fullDataPath, const char *captureName, double tagHz, const ProcOptions *options, int windowFrames, int updateFrames, void (*onUpdate)(const TagTracker *tracker, void *context), void *context)
+ * @param fullDataPath - Full data file path to radar capture. Must be in the format "user@ip:path". Example: "ericdvet@192.168.7.2:/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data"
+ * @param captureName - Name of radar capture file
+ * @param tagHz - Frequency at which tag is oscillating in Hz
+ * @param options - Processing options, NULL for the defaults of procRadarFrames()
+ * @param windowFrames - Number of most recent frames each estimate is computed over
+ * @param updateFrames - Number of frames between estimates
+ * @param onUpdate - Called with the tracker every time it holds a new estimate
+ * @param context - Passed through to onUpdate
+ * @return int
+ * @brief Runs a capture frame by frame through a TagTracker, so the tag is followed through the capture
+ *      instead of estimated once. Returns the number of estimates made, or -1 on error
+ * @author ericdvet */
+int procTrack(const char *fullDataPath, const char *captureName, double tagHz, const ProcOptions *options, int windowFrames, int updateFrames,
+              void (*onUpdate)(const TagTracker *tracker, void *context), void *context);
+
+/**
+ * @function procRangeBin(const CaptureData *captureData, int bin)
+ * @param captureData - Processed capture
+ * @param bin - Range bin of captureData (e.g. peakBin)
+ * @return double
+ * @brief Maps a range bin of a possibly decimated capture back to the original sampler resolution
+ *      expected by procSoilMoisture()
+ * @author ericdvet */
+double procRangeBin(const CaptureData *captureData, int bin);
+
+/**
+ * @function procRangeOffset(const ProcOptions *options)
+ * @param options - Processing options, NULL for the defaults
+ * @return int
+ * @brief Returns the original sampler of range bin 0, the start of options->rangeStart's guard band
+ *      rounded down to the decimation, or 0 without a range of interest
+ * @author ericdvet */
+int procRangeOffset(const ProcOptions *options);
+
+/**
+ * @function procTagTest(const char *fullDataPath, const char *captureName, double tagHz, const ProcOptions *options)
  * @param fullDataPath - Full data file path to radar capture. Must be in the format "user@ip:path". Example: "ericdvet@192.168.7.2:/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data"
  * @param captureName - Name of radar capture file
  * @param captureName - Frequency at which tag is oscillating in Hz
+ * @param options - Processing options, NULL for the defaults of procRadarFrames()
  * @return double
  * @brief Function prints capture FT and tag FT to CSV files and returns SNR in dB
  * @author ericdvet */
-double procTagTest(const char *fullDataPath, const char *captureName, double tagHz);
+double procTagTest(const char *fullDataPath, const char *captureName, double tagHz, const ProcOptions *options);
+
+/**
+ * @function procPrecisionReport(const char *fullDataPath, const char *captureName, double tagHz, const ProcOptions *options)
+ * @param fullDataPath - Full data file path to radar capture. Must be in the format "user@ip:path". Example: "ericdvet@192.168.7.2:/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data"
+ * @param captureName - Name of radar capture file
+ * @param tagHz - Frequency at which tag is oscillating in Hz
+ * @param options - Processing options used for both runs, NULL for the defaults of procRadarFrames()
+ * @return double
+ * @brief Processes a capture in double and in single precision and prints how far the float path is
+ *      from the double one. Returns the largest tag FT error relative to the tag FT peak, -1 on error
+ * @author ericdvet */
+double procPrecisionReport(const char *fullDataPath, const char *captureName, double tagHz, const ProcOptions *options);
 
 /**
  * @function procTwoTag(const char *fullDataPath, const char *captureName, double tag1Hz, double tag2Hz)
@@ -76,6 +215,59 @@ double procTagTest(const char *fullDataPath, const char *captureName, double tag
  * @author ericdvet */
 CaptureData *procTwoTag(const char *fullDataPath, const char *captureName, double tag1Hz, double tag2Hz);
 
+/**
+ * @function procTwoTagOpts(const char *fullDataPath, const char *captureName, double tag1Hz, double tag2Hz, const ProcOptions *options)
+ * @param fullDataPath - Full data file path to radar capture. Must be in the format "user@ip:path". Example: "ericdvet@192.168.7.2:/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data"
+ * @param captureName - Name of radar capture file
+ * @param tag1Hz - Frequency at which the first tag is oscillating in Hz
+ * @param tag2Hz - Frequency at which the second tag is oscillating in Hz
+ * @param options - Processing options, NULL for the defaults of procTwoTag(). Passed to procMultiTag()
+ * @return CaptureData *
+ * @brief procTwoTag() with processing options. The first tag's FT is smoothed over 10 range bins before
+ *      its peak is detected, and both peaks are printed from it, as procTwoTag() always has
+ * @author ericdvet */
+CaptureData *procTwoTagOpts(const char *fullDataPath, const char *captureName, double tag1Hz, double tag2Hz, const ProcOptions *options);
+
+/**
+ * @function procMultiTag(const char *fullDataPath, const char *captureName, const double *tagHz, int numTags, const ProcOptions *options)
+ * @param fullDataPath - Full data file path to radar capture. Must be in the format "user@ip:path". Example: "ericdvet@192.168.7.2:/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data"
+ * @param captureName - Name of radar capture file
+ * @param tagHz - Frequency at which each tag is oscillating in Hz (numTags)
+ * @param numTags - Number of tags in the capture
+ * @param options - Processing options, NULL for the defaults. The loader, decimation, targeted bins, harmonics, frame times,
+ *      detector, matched filter, clutter and range are used, any other stage is an error
+ * @return MultiTagData *
+ * @brief Separates tags oscillating at different frequencies with one load, one DDC and one slow-time
+ *      transform of the capture. Each tag's FT is read from the shared spectrum and the tags are
+ *      detected in parallel when built with OpenMP
+ * @author ericdvet */
+MultiTagData *procMultiTag(const char *fullDataPath, const char *captureName, const double *tagHz, int numTags, const ProcOptions *options);
+
+/**
+ * @function procPNTags(const char *fullDataPath, const char *captureName, const int *codes, int codeLength, int numCodes, double chipRate, const ProcOptions *options)
+ * @param fullDataPath - Full data file path to radar capture. Must be in the format "user@ip:path". Example: "ericdvet@192.168.7.2:/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data"
+ * @param captureName - Name of radar capture file
+ * @param codes - Chips of every tag's code, numCodes x codeLength, 0 or 1 like pn[] in radarBackscatter.ino
+ * @param codeLength - Number of chips per code
+ * @param numCodes - Number of tags
+ * @param chipRate - Chips per second sent by the tags
+ * @param options - Processing options, NULL for the defaults. Only the loader, decimation, detector, matched
+ *      filter, clutter and range options are supported, any other option is an error
+ * @return MultiTagData *
+ * @brief Finds tags that share one band but send different pseudo-noise codes by despreading each code
+ *      from the slow-time FFT of the capture. Row t of tagFT is the correlation magnitude of code t
+ * @author ericdvet */
+MultiTagData *procPNTags(const char *fullDataPath, const char *captureName, const int *codes, int codeLength, int numCodes, double chipRate,
+                         const ProcOptions *options);
+
+/**
+ * @function freeMultiTagData(MultiTagData *multiTagData)
+ * @param multiTagData - MultiTagData struct to free
+ * @return None
+ * @brief Free MultiTagData constructed by procMultiTag()
+ * @author ericdvet */
+void freeMultiTagData(MultiTagData *multiTagData);
+
 /**
  * @function freeCaptureData(CaptureData *captureData)
  * @param captureData - CaptureData struct to free
@@ -93,12 +285,55 @@ void freeCaptureData(CaptureData *captureData);
 int procLargestPeak(double *tagFT);
 
 /**
- * @function procCaptureCWT(double *tagFT)
+ * @function procCaptureCWT(double *tagFT, int numOfSamplers)
  * @param *tagFT - pointer to FT of the tag's frequency isolated
+ * @param numOfSamplers - Number of range bins in tagFT
  * @return int
  * @brief Returns bin corresponding to the peak most similar to the ricker wavelet based
  * @author ericdvet */
-int procCaptureCWT(double *tagFT);
+int procCaptureCWT(double *tagFT, int numOfSamplers);
+
+/**
+ * @function procCaptureCWTCleanup(void)
+ * @return None
+ * @brief Releases the wavelet plans and ridge arenas kept by procCaptureCWT() and procMultiTag() between captures
+ * @author ericdvet */
+void procCaptureCWTCleanup(void);
+
+/**
+ * @function procZoomCleanup(void)
+ * @return None
+ * @brief Releases the chirp-Z plan kept for ProcOptions.zoomPoints between captures
+ * @author ericdvet */
+void procZoomCleanup(void);
+
+/**
+ * @function procSpectrumCleanup(void)
+ * @return None
+ * @brief Releases the spectral estimator kept for ProcOptions.spectrum between captures
+ * @author ericdvet */
+void procSpectrumCleanup(void);
+
+/**
+ * @function procTemplateCleanup(void)
+ * @return None
+ * @brief Releases the tag template cached for ProcOptions.templateCapture
+ * @author ericdvet */
+void procTemplateCleanup(void);
+
+/**
+ * @function procMatchedCleanup(void)
+ * @return None
+ * @brief Releases the matched filter cached for ProcOptions.matchedFilter
+ * @author ericdvet */
+void procMatchedCleanup(void);
+
+/**
+ * @function procCFARCleanup(void)
+ * @return None
+ * @brief Releases the CFAR detectors kept for ProcOptions.detector by procRadarFramesOpts() and procMultiTag()
+ * @author ericdvet */
+void procCFARCleanup(void);
 
 /**
  * @function procSoilMoisture(double wetPeakBin, double airPeakBin, const char* soilType, double distance)
@@ -111,4 +346,27 @@ int procCaptureCWT(double *tagFT);
  * @author ericdvet */
 double procSoilMoisture(double wetPeakBin, double airPeakBin, const char* soilType, double distance);
 
+/**
+ * @function procSoilMaxPermittivity(const char *soilType)
+ * @param soilType - type of soil
+ * @return double
+ * @brief Returns the largest radar permittivity the soil type's calibration maps to a VWC, where the
+ *      calibration reaches saturation or turns over, whichever comes first. -1 for an unknown soil type
+ * @author ericdvet */
+double procSoilMaxPermittivity(const char *soilType);
+
+/**
+ * @function procRangeOfInterest(double airPeakBin, const char *soilType, double distance, int *rangeStart, int *rangeStop)
+ * @param airPeakBin - peak bin of backscatter tag uncovered by soil, in original samplers
+ * @param soilType - type of soil
+ * @param distance - distance between backscatter tag and surface in meters
+ * @param rangeStart - Resulting first sampler of the range of interest
+ * @param rangeStop - Resulting sampler past the range of interest
+ * @return int
+ * @brief The buried tag can only appear between its air peak bin and the delay of distance through
+ *      soil of procSoilMaxPermittivity(), so that is the range of interest for ProcOptions. Returns 0
+ *      on success, -1 for an unknown soil type
+ * @author ericdvet */
+int procRangeOfInterest(double airPeakBin, const char *soilType, double distance, int *rangeStart, int *rangeStop);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,552 @@
+/*
+ * File:   psd.c
+ * Author: ericdvet
+ *
+ * Low-variance slow-time spectral estimates of every range bin, Welch averaging of overlapping segments
+ * or DPSS multitapers
+ */
+
+#include "psd.h"
+#include <math.h>
+#include <string.h>
+
+#define PI 3.14159265358979323846
+
+// Bisection steps for each DPSS eigenvalue, enough to reach double precision
+#define PSD_BISECTION_STEPS 128
+
+// Inverse iteration steps for each DPSS eigenvector
+#define PSD_INVERSE_STEPS 3
+
+/**
+ * @function psdSturmCount(const double *diag, const double *offDiag, int length, double shift)
+ * @param diag - Diagonal of the symmetric tridiagonal matrix (length)
+ * @param offDiag - Off diagonal, offDiag[i] couples i - 1 and i (length, offDiag[0] unused)
+ * @param length - Size of the matrix
+ * @param shift - Value the eigenvalues are compared against
+ * @return int
+ * @brief Number of eigenvalues below shift, from the signs of the LDL^T pivots of the shifted matrix
+ * @author ericdvet */
+static int psdSturmCount(const double *diag, const double *offDiag, int length, double shift)
+{
+    int count = 0;
+    double pivot = 1;
+    for (int i = 0; i < length; i++)
+    {
+        pivot = diag[i] - shift - (i > 0 ? offDiag[i] * offDiag[i] / pivot : 0);
+        if (pivot == 0)
+        {
+            pivot = 1e-300;
+        }
+        if (pivot < 0)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * @function psdDPSS(int length, int numTapers, double *tapers)
+ * @param length - Frames per taper
+ * @param numTapers - Number of tapers, the orders 0 to numTapers - 1
+ * @param tapers - Resulting tapers (numTapers x length), each with energy length
+ * @return int
+ * @brief Discrete prolate spheroidal sequences of time-bandwidth product (numTapers + 1) / 2, as the
+ *      eigenvectors of their commuting tridiagonal matrix. Each eigenvalue is bisected with Sturm counts
+ *      and its vector found by inverse iteration, so no dense eigensolver is needed. Returns 0 on
+ *      success, -1 otherwise
+ * @author ericdvet */
+static int psdDPSS(int length, int numTapers, double *tapers)
+{
+    double halfBandwidth = (numTapers + 1) / 2.0 / length;
+    double *diag = (double *)malloc(length * sizeof(double));
+    double *offDiag = (double *)malloc(length * sizeof(double));
+    double *upper = (double *)malloc(length * sizeof(double));
+    if (!diag || !offDiag || !upper)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        free(diag);
+        free(offDiag);
+        free(upper);
+        return -1;
+    }
+
+    double low = INFINITY;
+    double high = -INFINITY;
+    for (int i = 0; i < length; i++)
+    {
+        double center = (length - 1 - 2.0 * i) / 2.0;
+        diag[i] = center * center * cos(2 * PI * halfBandwidth);
+        offDiag[i] = i * (double)(length - i) / 2;
+    }
+    for (int i = 0; i < length; i++)
+    {
+        double radius = (i > 0 ? offDiag[i] : 0) + (i < length - 1 ? offDiag[i + 1] : 0);
+        low = fmin(low, diag[i] - radius);
+        high = fmax(high, diag[i] + radius);
+    }
+
+    for (int k = 0; k < numTapers; k++)
+    {
+        // Order k is the (k + 1)-th largest eigenvalue
+        double below = low;
+        double above = high;
+        for (int step = 0; step < PSD_BISECTION_STEPS && above - below > 1e-15 * fmax(fabs(below), fabs(above)); step++)
+        {
+            double middle = (below + above) / 2;
+            if (psdSturmCount(diag, offDiag, length, middle) > length - 1 - k)
+            {
+                above = middle;
+            }
+            else
+            {
+                below = middle;
+            }
+        }
+        double eigenvalue = (below + above) / 2;
+
+        double *taper = &tapers[(size_t)k * length];
+        for (int i = 0; i < length; i++)
+        {
+            taper[i] = 1 + 0.1 * ((i * 7919) % 13) / 13.0;
+        }
+        for (int step = 0; step < PSD_INVERSE_STEPS; step++)
+        {
+            // Solve (T - eigenvalue I) x = taper in place, tridiagonal elimination
+            double pivot = diag[0] - eigenvalue;
+            pivot = pivot == 0 ? 1e-300 : pivot;
+            upper[0] = length > 1 ? offDiag[1] / pivot : 0;
+            taper[0] /= pivot;
+            for (int i = 1; i < length; i++)
+            {
+                pivot = diag[i] - eigenvalue - offDiag[i] * upper[i - 1];
+                pivot = pivot == 0 ? 1e-300 : pivot;
+                upper[i] = i < length - 1 ? offDiag[i + 1] / pivot : 0;
+                taper[i] = (taper[i] - offDiag[i] * taper[i - 1]) / pivot;
+            }
+            for (int i = length - 2; i >= 0; i--)
+            {
+                taper[i] -= upper[i] * taper[i + 1];
+            }
+
+            // Keep it orthogonal to the lower orders and at energy length
+            for (int j = 0; j < k; j++)
+            {
+                const double *previous = &tapers[(size_t)j * length];
+                double projection = 0;
+                for (int i = 0; i < length; i++)
+                {
+                    projection += taper[i] * previous[i];
+                }
+                for (int i = 0; i < length; i++)
+                {
+                    taper[i] -= projection / length * previous[i];
+                }
+            }
+            double energy = 0;
+            for (int i = 0; i < length; i++)
+            {
+                energy += taper[i] * taper[i];
+            }
+            double scale = sqrt(length / energy);
+            for (int i = 0; i < length; i++)
+            {
+                taper[i] *= scale;
+            }
+        }
+    }
+
+    free(diag);
+    free(offDiag);
+    free(upper);
+    return 0;
+}
+
+/**
+ * @function psdCreate(int method, int numFrames, int numOfSamplers, int segmentFrames, int numTapers)
+ * @param method - PSD_WELCH or PSD_MULTITAPER
+ * @param numFrames - Frames in the capture
+ * @param numOfSamplers - Number of range bins per frame
+ * @param segmentFrames - Frames per segment, 0 for numFrames / PSD_WELCH_SEGMENTS with Welch and numFrames with multitaper
+ * @param numTapers - DPSS tapers per segment with multitaper, 0 for PSD_MULTITAPER_TAPERS. Ignored by Welch
+ * @return PSDEstimator *
+ * @brief Precomputes the tapers and plans one batched FFT of segmentFrames over all range bins, so an
+ *      estimator can be kept and reset for every capture of the same size
+ * @author ericdvet */
+PSDEstimator *psdCreate(int method, int numFrames, int numOfSamplers, int segmentFrames, int numTapers)
+{
+    if (segmentFrames <= 0)
+    {
+        segmentFrames = method == PSD_WELCH ? numFrames / PSD_WELCH_SEGMENTS : numFrames;
+    }
+    if (method == PSD_WELCH)
+    {
+        numTapers = 1;
+    }
+    else if (numTapers <= 0)
+    {
+        numTapers = PSD_MULTITAPER_TAPERS;
+    }
+    if ((method != PSD_WELCH && method != PSD_MULTITAPER) || numOfSamplers < 1 || segmentFrames < 8 || segmentFrames > numFrames ||
+        numTapers >= segmentFrames / 2)
+    {
+        fprintf(stderr, "ERROR: Invalid spectral estimator\n");
+        return NULL;
+    }
+
+    PSDEstimator *psd = (PSDEstimator *)calloc(1, sizeof(PSDEstimator));
+    if (!psd)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        return NULL;
+    }
+    psd->method = method;
+    psd->numFrames = numFrames;
+    psd->numOfSamplers = numOfSamplers;
+    psd->segmentFrames = segmentFrames;
+    psd->hopFrames = method == PSD_WELCH ? segmentFrames / 2 : segmentFrames;
+    psd->numTapers = numTapers;
+
+    size_t size = (size_t)segmentFrames * numOfSamplers;
+    psd->tapers = (double *)malloc((size_t)numTapers * segmentFrames * sizeof(double));
+    psd->segment = (double complex *)malloc(size * sizeof(double complex));
+    psd->work = (double complex *)fftw_malloc(size * sizeof(double complex));
+    psd->power = (double *)calloc(size, sizeof(double));
+    psd->spectrum = (double *)malloc(size * sizeof(double));
+    if (!psd->tapers || !psd->segment || !psd->work || !psd->power || !psd->spectrum)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        psdFree(psd);
+        return NULL;
+    }
+
+    if (method == PSD_WELCH)
+    {
+        // Periodic Hann window scaled to energy segmentFrames, so noise power matches the plain periodogram
+        double scale = sqrt(8.0 / 3.0);
+        for (int n = 0; n < segmentFrames; n++)
+        {
+            psd->tapers[n] = scale * 0.5 * (1 - cos(2 * PI * n / segmentFrames));
+        }
+    }
+    else if (psdDPSS(segmentFrames, numTapers, psd->tapers) < 0)
+    {
+        psdFree(psd);
+        return NULL;
+    }
+
+    // Frame-major like the capture, so every range bin is one strided transform of the same plan
+    fftw_complex *work = (fftw_complex *)psd->work;
+    psd->forward = fftw_plan_many_dft(1, &segmentFrames, numOfSamplers, work, NULL, numOfSamplers, 1, work, NULL, numOfSamplers, 1,
+                                      FFTW_FORWARD, FFTW_MEASURE);
+    if (!psd->forward)
+    {
+        fprintf(stderr, "ERROR: Unable to plan spectral estimator FFT\n");
+        psdFree(psd);
+        return NULL;
+    }
+    return psd;
+}
+
+/**
+ * @function psdReset(PSDEstimator *psd)
+ * @param psd - Estimator created by psdCreate()
+ * @return None
+ * @brief Clears the accumulated power and segment buffer for a new capture
+ * @author ericdvet */
+void psdReset(PSDEstimator *psd)
+{
+    memset(psd->power, 0, (size_t)psd->segmentFrames * psd->numOfSamplers * sizeof(double));
+    psd->segmentFill = 0;
+    psd->numAveraged = 0;
+}
+
+/**
+ * @function psdSegment(PSDEstimator *psd)
+ * @param psd - Estimator with a full segment buffer
+ * @return None
+ * @brief Adds the power of every taper of the buffered segment, each one batched FFT over all range bins
+ * @author ericdvet */
+static void psdSegment(PSDEstimator *psd)
+{
+    int numOfSamplers = psd->numOfSamplers;
+    size_t size = (size_t)psd->segmentFrames * numOfSamplers;
+    for (int t = 0; t < psd->numTapers; t++)
+    {
+        const double *taper = &psd->tapers[(size_t)t * psd->segmentFrames];
+        for (int n = 0; n < psd->segmentFrames; n++)
+        {
+            const double complex *frame = &psd->segment[(size_t)n * numOfSamplers];
+            double complex *row = &psd->work[(size_t)n * numOfSamplers];
+            for (int i = 0; i < numOfSamplers; i++)
+            {
+                row[i] = frame[i] * taper[n];
+            }
+        }
+        fftw_execute(psd->forward);
+        for (size_t i = 0; i < size; i++)
+        {
+            psd->power[i] += creal(psd->work[i]) * creal(psd->work[i]) + cimag(psd->work[i]) * cimag(psd->work[i]);
+        }
+        psd->numAveraged++;
+    }
+}
+
+/**
+ * @function psdAccumulate(PSDEstimator *psd, const double complex *framesBB, int numFrames)
+ * @param psd - Estimator created by psdCreate()
+ * @param framesBB - Block of baseband frames (numFrames x numOfSamplers)
+ * @param numFrames - Number of frames in the block
+ * @return None
+ * @brief Buffers a block of frames and transforms every segment it completes, so a capture can be fed
+ *      block by block as it is downconverted. Frames after the last whole segment are not used
+ * @author ericdvet */
+void psdAccumulate(PSDEstimator *psd, const double complex *framesBB, int numFrames)
+{
+    int numOfSamplers = psd->numOfSamplers;
+    while (numFrames > 0)
+    {
+        int copyFrames = psd->segmentFrames - psd->segmentFill;
+        copyFrames = copyFrames < numFrames ? copyFrames : numFrames;
+        memcpy(&psd->segment[(size_t)psd->segmentFill * numOfSamplers], framesBB, (size_t)copyFrames * numOfSamplers * sizeof(double complex));
+        psd->segmentFill += copyFrames;
+        framesBB += (size_t)copyFrames * numOfSamplers;
+        numFrames -= copyFrames;
+
+        if (psd->segmentFill == psd->segmentFrames)
+        {
+            psdSegment(psd);
+            // Slide by the hop, keeping the overlap for the next segment
+            int keepFrames = psd->segmentFrames - psd->hopFrames;
+            memmove(psd->segment, &psd->segment[(size_t)psd->hopFrames * numOfSamplers], (size_t)keepFrames * numOfSamplers * sizeof(double complex));
+            psd->segmentFill = keepFrames;
+        }
+    }
+}
+
+/**
+ * @function psdSpectrum(PSDEstimator *psd)
+ * @param psd - Estimator holding a whole capture
+ * @return const double *
+ * @brief Returns the magnitude spectrum, the square root of the power averaged over segments and tapers,
+ *      segmentFrames x numOfSamplers laid out like computeFFT()'s output
+ * @author ericdvet */
+const double *psdSpectrum(PSDEstimator *psd)
+{
+    size_t size = (size_t)psd->segmentFrames * psd->numOfSamplers;
+    double scale = psd->numAveraged > 0 ? 1.0 / psd->numAveraged : 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        psd->spectrum[i] = sqrt(psd->power[i] * scale);
+    }
+    return psd->spectrum;
+}
+
+/**
+ * @function psdTagFT(const PSDEstimator *psd, int freqTag, double *tagFT)
+ * @param psd - Estimator after psdSpectrum()
+ * @param freqTag - Expected frequency bin of the tag on the segment grid, 1-based like procRadarFrames()
+ * @param tagFT - Resulting magnitude of every range bin at the tag frequency (numOfSamplers)
+ * @return int
+ * @brief Picks the strongest bin of freqTag +/- 2 and returns it after filling tagFT
+ * @author ericdvet */
+int psdTagFT(const PSDEstimator *psd, int freqTag, double *tagFT)
+{
+    int numOfSamplers = psd->numOfSamplers;
+    int first = freqTag - 2 < 1 ? 1 : freqTag - 2;
+    int last = freqTag + 2 > psd->segmentFrames ? psd->segmentFrames : freqTag + 2;
+
+    double maxFTPeak = 0;
+    int idx_maxFTPeak = first;
+    for (int j = first; j <= last; j++)
+    {
+        const double *row = &psd->spectrum[(size_t)(j - 1) * numOfSamplers];
+        for (int i = 0; i < numOfSamplers; i++)
+        {
+            if (row[i] > maxFTPeak)
+            {
+                maxFTPeak = row[i];
+                idx_maxFTPeak = j;
+            }
+        }
+    }
+
+    memcpy(tagFT, &psd->spectrum[(size_t)(idx_maxFTPeak - 1) * numOfSamplers], numOfSamplers * sizeof(double));
+    return idx_maxFTPeak;
+}
+
+/**
+ * @function psdSNR(const PSDEstimator *psd, int freqTag, int peakBin)
+ * @param psd - Estimator after psdSpectrum()
+ * @param freqTag - Frequency bin of the tag returned by psdTagFT()
+ * @param peakBin - Determined peak bin location of backscatter tag
+ * @return double
+ * @brief calculateSNR() on the estimated spectrum. The noise band is kept at least one bin wide, since
+ *      shorter segments shrink it
+ * @author ericdvet */
+double psdSNR(const PSDEstimator *psd, int freqTag, int peakBin)
+{
+    int numOfSamplers = psd->numOfSamplers;
+    double signalMag = psd->spectrum[peakBin + (size_t)numOfSamplers * (freqTag - 1)];
+
+    int noiseFreqLowBound = (int)(freqTag * 0.945);
+    int noiseFreqHighBound = (int)(freqTag * 0.955);
+    noiseFreqLowBound = noiseFreqLowBound < 1 ? 1 : noiseFreqLowBound;
+    if (noiseFreqHighBound <= noiseFreqLowBound)
+    {
+        noiseFreqHighBound = noiseFreqLowBound + 1;
+    }
+
+    double noiseMag = 0;
+    for (int j = noiseFreqLowBound; j < noiseFreqHighBound; j++)
+    {
+        noiseMag += psd->spectrum[peakBin + (size_t)numOfSamplers * (j - 1)];
+    }
+    noiseMag = noiseMag / (noiseFreqHighBound - noiseFreqLowBound);
+
+    return 10 * log10(signalMag / noiseMag);
+}
+
+/**
+ * @function psdFree(PSDEstimator *psd)
+ * @param psd - PSDEstimator to free
+ * @return None
+ * @brief Free a PSDEstimator constructed by psdCreate()
+ * @author ericdvet */
+void psdFree(PSDEstimator *psd)
+{
+    if (psd)
+    {
+        if (psd->forward)
+        {
+            fftw_destroy_plan(psd->forward);
+        }
+        free(psd->tapers);
+        free(psd->segment);
+        fftw_free(psd->work);
+        free(psd->power);
+        free(psd->spectrum);
+        free(psd);
+    }
+}
+
+// #define PSD_TEST
+
+#ifdef PSD_TEST
+#include <time.h>
+
+/**
+ * @function psdTestNoise(void)
+ * @return double
+ * @brief Standard normal sample by Box-Muller
+ * @author ericdvet */
+static double psdTestNoise(void)
+{
+    double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2 * log(u1)) * cos(2 * PI * u2);
+}
+
+int main()
+{
+    int numFrames = 800;
+    int numOfSamplers = 128;
+    int tagBin = 70;
+    double tagFreq = 80.0 / 200;
+    int numTrials = 40;
+    srand(1);
+
+    double complex *framesBB = (double complex *)malloc((size_t)numFrames * numOfSamplers * sizeof(double complex));
+    PSDEstimator *estimators[3];
+    const char *names[3] = {"Periodogram", "Welch", "Multitaper"};
+    estimators[0] = psdCreate(PSD_WELCH, numFrames, numOfSamplers, numFrames, 0);
+    estimators[1] = psdCreate(PSD_WELCH, numFrames, numOfSamplers, 0, 0);
+    estimators[2] = psdCreate(PSD_MULTITAPER, numFrames, numOfSamplers, 0, 0);
+    // A rectangular window turns the Welch estimator into the plain periodogram
+    for (int n = 0; n < numFrames; n++)
+    {
+        estimators[0]->tapers[n] = 1;
+    }
+
+    // The DPSS tapers should be orthonormal
+    double maxOverlap = 0;
+    PSDEstimator *multitaper = estimators[2];
+    for (int a = 0; a < multitaper->numTapers; a++)
+    {
+        for (int b = 0; b < multitaper->numTapers; b++)
+        {
+            double product = 0;
+            for (int n = 0; n < numFrames; n++)
+            {
+                product += multitaper->tapers[(size_t)a * numFrames + n] * multitaper->tapers[(size_t)b * numFrames + n];
+            }
+            maxOverlap = fmax(maxOverlap, fabs(product / numFrames - (a == b)));
+        }
+    }
+    printf("DPSS tapers: %d of %d frames, max deviation from orthonormal %g\n", multitaper->numTapers, numFrames, maxOverlap);
+
+    // A weak tag at one range bin under unit noise, its oscillator wandering in phase so the tone spreads over
+    // a few bins. Found by the strongest range bin of the tag FT, SNR measured at the true range bin
+    int hits[3] = {0};
+    double noiseSpread[3] = {0};
+    double meanSNR[3] = {0};
+    double meanSquareSNR[3] = {0};
+    double elapsed[3] = {0};
+    double *tagFT = (double *)malloc(numOfSamplers * sizeof(double));
+    for (int trial = 0; trial < numTrials; trial++)
+    {
+        double tagPhase = 0;
+        for (int n = 0; n < numFrames; n++)
+        {
+            tagPhase += 2 * PI * tagFreq + 0.12 * psdTestNoise();
+            for (int i = 0; i < numOfSamplers; i++)
+            {
+                framesBB[(size_t)n * numOfSamplers + i] = psdTestNoise() + I * psdTestNoise() + (i == tagBin ? 0.15 * cexp(I * tagPhase) : 0);
+            }
+        }
+        for (int e = 0; e < 3; e++)
+        {
+            PSDEstimator *psd = estimators[e];
+            clock_t start = clock();
+            psdReset(psd);
+            for (int n = 0; n < numFrames; n += 64)
+            {
+                psdAccumulate(psd, &framesBB[(size_t)n * numOfSamplers], numFrames - n < 64 ? numFrames - n : 64);
+            }
+            psdSpectrum(psd);
+            int freqTag = psdTagFT(psd, (int)(tagFreq * psd->segmentFrames) + 1, tagFT);
+            elapsed[e] += (double)(clock() - start) / CLOCKS_PER_SEC;
+
+            int peakBin = 0;
+            double mean = 0;
+            double meanSquare = 0;
+            for (int i = 0; i < numOfSamplers; i++)
+            {
+                peakBin = tagFT[i] > tagFT[peakBin] ? i : peakBin;
+                if (i != tagBin)
+                {
+                    mean += tagFT[i] / (numOfSamplers - 1);
+                    meanSquare += tagFT[i] * tagFT[i] / (numOfSamplers - 1);
+                }
+            }
+            double SNR = psdSNR(psd, freqTag, tagBin);
+            hits[e] += peakBin == tagBin;
+            noiseSpread[e] += sqrt(meanSquare - mean * mean) / mean / numTrials;
+            meanSNR[e] += SNR / numTrials;
+            meanSquareSNR[e] += SNR * SNR / numTrials;
+        }
+    }
+
+    for (int e = 0; e < 3; e++)
+    {
+        printf("%-12s segment %4d, %2d averages: tag found %2d of %d, noise std/mean %.3f, SNR %.1f +/- %.1f dB, %.2f ms per capture\n",
+               names[e], estimators[e]->segmentFrames, estimators[e]->numAveraged, hits[e], numTrials, noiseSpread[e], meanSNR[e],
+               sqrt(meanSquareSNR[e] - meanSNR[e] * meanSNR[e]), elapsed[e] * 1000 / numTrials);
+        psdFree(estimators[e]);
+    }
+    free(tagFT);
+    free(framesBB);
+    return 0;
+}
+#endif
@@ -0,0 +1,119 @@
+/*
+ * File:   psd.h
+ * Author: ericdvet
+ *
+ * Low-variance slow-time spectral estimates of every range bin, Welch averaging of overlapping segments
+ * or DPSS multitapers
+ */
+
+#ifndef PSD_H
+#define PSD_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <complex.h>
+#include <fftw3.h>
+
+// Spectral estimators of psdCreate()
+#define PSD_WELCH 0      // Hann-windowed segments overlapping by half
+#define PSD_MULTITAPER 1 // orthogonal DPSS tapers over each segment
+
+// Default Welch segment length is numFrames / PSD_WELCH_SEGMENTS
+#define PSD_WELCH_SEGMENTS 4
+
+// Default number of DPSS tapers, with time-bandwidth product (numTapers + 1) / 2
+#define PSD_MULTITAPER_TAPERS 4
+
+/**
+ * @struct PSDEstimator
+ * @brief Tapers, segment buffer and batched FFT of a spectral estimate, and the power accumulated so far
+ * @author ericdvet */
+typedef struct
+{
+    int method;
+    int numFrames;
+    int numOfSamplers;
+    int segmentFrames;
+    int hopFrames;
+    int numTapers;
+    double *tapers;          // numTapers x segmentFrames, each with energy segmentFrames
+    double complex *segment; // the last segmentFrames frames, frame-major
+    int segmentFill;
+    double complex *work;
+    fftw_plan forward;
+    double *power;    // segmentFrames x numOfSamplers, summed |FFT|^2 over segments and tapers
+    double *spectrum; // square root of the mean of power, filled by psdSpectrum()
+    int numAveraged;
+} PSDEstimator;
+
+/**
+ * @function psdCreate(int method, int numFrames, int numOfSamplers, int segmentFrames, int numTapers)
+ * @param method - PSD_WELCH or PSD_MULTITAPER
+ * @param numFrames - Frames in the capture
+ * @param numOfSamplers - Number of range bins per frame
+ * @param segmentFrames - Frames per segment, 0 for numFrames / PSD_WELCH_SEGMENTS with Welch and numFrames with multitaper
+ * @param numTapers - DPSS tapers per segment with multitaper, 0 for PSD_MULTITAPER_TAPERS. Ignored by Welch
+ * @return PSDEstimator *
+ * @brief Precomputes the tapers and plans one batched FFT of segmentFrames over all range bins, so an
+ *      estimator can be kept and reset for every capture of the same size
+ * @author ericdvet */
+PSDEstimator *psdCreate(int method, int numFrames, int numOfSamplers, int segmentFrames, int numTapers);
+
+/**
+ * @function psdReset(PSDEstimator *psd)
+ * @param psd - Estimator created by psdCreate()
+ * @return None
+ * @brief Clears the accumulated power and segment buffer for a new capture
+ * @author ericdvet */
+void psdReset(PSDEstimator *psd);
+
+/**
+ * @function psdAccumulate(PSDEstimator *psd, const double complex *framesBB, int numFrames)
+ * @param psd - Estimator created by psdCreate()
+ * @param framesBB - Block of baseband frames (numFrames x numOfSamplers)
+ * @param numFrames - Number of frames in the block
+ * @return None
+ * @brief Buffers a block of frames and transforms every segment it completes, so a capture can be fed
+ *      block by block as it is downconverted. Frames after the last whole segment are not used
+ * @author ericdvet */
+void psdAccumulate(PSDEstimator *psd, const double complex *framesBB, int numFrames);
+
+/**
+ * @function psdSpectrum(PSDEstimator *psd)
+ * @param psd - Estimator holding a whole capture
+ * @return const double *
+ * @brief Returns the magnitude spectrum, the square root of the power averaged over segments and tapers,
+ *      segmentFrames x numOfSamplers laid out like computeFFT()'s output
+ * @author ericdvet */
+const double *psdSpectrum(PSDEstimator *psd);
+
+/**
+ * @function psdTagFT(const PSDEstimator *psd, int freqTag, double *tagFT)
+ * @param psd - Estimator after psdSpectrum()
+ * @param freqTag - Expected frequency bin of the tag on the segment grid, 1-based like procRadarFrames()
+ * @param tagFT - Resulting magnitude of every range bin at the tag frequency (numOfSamplers)
+ * @return int
+ * @brief Picks the strongest bin of freqTag +/- 2 and returns it after filling tagFT
+ * @author ericdvet */
+int psdTagFT(const PSDEstimator *psd, int freqTag, double *tagFT);
+
+/**
+ * @function psdSNR(const PSDEstimator *psd, int freqTag, int peakBin)
+ * @param psd - Estimator after psdSpectrum()
+ * @param freqTag - Frequency bin of the tag returned by psdTagFT()
+ * @param peakBin - Determined peak bin location of backscatter tag
+ * @return double
+ * @brief calculateSNR() on the estimated spectrum. The noise band is kept at least one bin wide, since
+ *      shorter segments shrink it
+ * @author ericdvet */
+double psdSNR(const PSDEstimator *psd, int freqTag, int peakBin);
+
+/**
+ * @function psdFree(PSDEstimator *psd)
+ * @param psd - PSDEstimator to free
+ * @return None
+ * @brief Free a PSDEstimator constructed by psdCreate()
+ * @author ericdvet */
+void psdFree(PSDEstimator *psd);
+
+#endif // PSD_H
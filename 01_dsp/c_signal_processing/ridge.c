@@ -0,0 +1,378 @@
+/*
+ * File:   ridge.c
+ * Author: ericdvet
+ *
+ * Ridge lines through the local maxima of a continuous wavelet transform, stored in a reusable arena
+ */
+
+#include "ridge.h"
+#include <string.h>
+
+// Every arena allocation is rounded up to this many bytes so doubles and pointers stay aligned
+#define RIDGE_ARENA_ALIGN 16
+
+/**
+ * @function ridgeArenaBlockCreate(size_t capacity)
+ * @param capacity - Size of the block in bytes
+ * @return RidgeArenaBlock *
+ * @brief Allocates an empty arena block
+ * @author ericdvet */
+static RidgeArenaBlock *ridgeArenaBlockCreate(size_t capacity)
+{
+    RidgeArenaBlock *block = (RidgeArenaBlock *)malloc(sizeof(RidgeArenaBlock));
+    if (!block)
+    {
+        return NULL;
+    }
+    block->data = (unsigned char *)malloc(capacity);
+    if (!block->data)
+    {
+        free(block);
+        return NULL;
+    }
+    block->next = NULL;
+    block->capacity = capacity;
+    block->used = 0;
+    return block;
+}
+
+/**
+ * @function ridgeArenaCreate(size_t capacity)
+ * @param capacity - Initial size of the arena in bytes
+ * @return RidgeArena *
+ * @brief Creates an arena. It grows when a capture needs more and is consolidated on reset
+ * @author ericdvet */
+RidgeArena *ridgeArenaCreate(size_t capacity)
+{
+    RidgeArena *arena = (RidgeArena *)malloc(sizeof(RidgeArena));
+    if (!arena)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        return NULL;
+    }
+    arena->head = ridgeArenaBlockCreate(capacity > 0 ? capacity : RIDGE_ARENA_ALIGN);
+    if (!arena->head)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        free(arena);
+        return NULL;
+    }
+    return arena;
+}
+
+/**
+ * @function ridgeArenaAlloc(RidgeArena *arena, size_t size)
+ * @param arena - Arena created by ridgeArenaCreate()
+ * @param size - Number of bytes
+ * @return void *
+ * @brief Allocates from the arena. The memory stays valid until the next ridgeArenaReset()
+ * @author ericdvet */
+void *ridgeArenaAlloc(RidgeArena *arena, size_t size)
+{
+    size = (size + RIDGE_ARENA_ALIGN - 1) / RIDGE_ARENA_ALIGN * RIDGE_ARENA_ALIGN;
+
+    RidgeArenaBlock *block = arena->head;
+    if (block->capacity - block->used < size)
+    {
+        // Earlier blocks stay put so pointers into them remain valid
+        size_t capacity = block->capacity * 2 > size ? block->capacity * 2 : size;
+        block = ridgeArenaBlockCreate(capacity);
+        if (!block)
+        {
+            fprintf(stderr, "ERROR: Memory allocation failure\n");
+            return NULL;
+        }
+        block->next = arena->head;
+        arena->head = block;
+    }
+
+    void *memory = &block->data[block->used];
+    block->used += size;
+    return memory;
+}
+
+/**
+ * @function ridgeArenaReset(RidgeArena *arena)
+ * @param arena - Arena created by ridgeArenaCreate()
+ * @return None
+ * @brief Releases everything allocated from the arena. If the last use overflowed into extra blocks they
+ *      are merged into one block large enough for it, so steady state use does not call malloc
+ * @author ericdvet */
+void ridgeArenaReset(RidgeArena *arena)
+{
+    if (arena->head->next == NULL)
+    {
+        arena->head->used = 0;
+        return;
+    }
+
+    size_t capacity = 0;
+    RidgeArenaBlock *block = arena->head;
+    while (block)
+    {
+        RidgeArenaBlock *next = block->next;
+        capacity += block->capacity;
+        free(block->data);
+        free(block);
+        block = next;
+    }
+    arena->head = ridgeArenaBlockCreate(capacity);
+    if (!arena->head)
+    {
+        // Fall back to a minimal block, allocations will grow it again
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        arena->head = ridgeArenaBlockCreate(RIDGE_ARENA_ALIGN);
+    }
+}
+
+/**
+ * @function ridgeArenaFree(RidgeArena *arena)
+ * @param arena - RidgeArena to free
+ * @return None
+ * @brief Free a RidgeArena constructed by ridgeArenaCreate()
+ * @author ericdvet */
+void ridgeArenaFree(RidgeArena *arena)
+{
+    if (arena)
+    {
+        RidgeArenaBlock *block = arena->head;
+        while (block)
+        {
+            RidgeArenaBlock *next = block->next;
+            free(block->data);
+            free(block);
+            block = next;
+        }
+        free(arena);
+    }
+}
+
+/**
+ * @function ridgeFindPeaks(RidgeArena *arena, const double *arr, int size, int *numPeaks)
+ * @param arena - Arena the peak list is allocated from
+ * @param arr - Signal to search
+ * @param size - Number of samples
+ * @param numPeaks - Resulting number of peaks
+ * @return int *
+ * @brief findPeaks() with a minimum peak height of 0, allocated from the arena. Peaks are in ascending order
+ * @author ericdvet */
+int *ridgeFindPeaks(RidgeArena *arena, const double *arr, int size, int *numPeaks)
+{
+    // Strict local maxima are at least two samples apart
+    int *peaks = (int *)ridgeArenaAlloc(arena, (size / 2 + 1) * sizeof(int));
+    *numPeaks = 0;
+    if (!peaks)
+    {
+        return NULL;
+    }
+
+    for (int i = 1; i < size - 1; i++)
+    {
+        if (arr[i] > arr[i - 1] && arr[i] > arr[i + 1] && arr[i] > 0)
+        {
+            peaks[(*numPeaks)++] = i;
+        }
+    }
+    return peaks;
+}
+
+/**
+ * @function ridgeStart(RidgeArena *arena, RidgeLine *ridge, int scale, int location)
+ * @param arena - Arena the ridge points are allocated from
+ * @param ridge - Ridge line to initialize
+ * @param scale - Scale of the first peak
+ * @param location - Location of the first peak
+ * @return int
+ * @brief Starts a ridge line with room for a point at every remaining scale. Returns -1 if out of memory
+ * @author ericdvet */
+static int ridgeStart(RidgeArena *arena, RidgeLine *ridge, int scale, int location)
+{
+    ridge->pointScales = (int *)ridgeArenaAlloc(arena, (scale + 1) * sizeof(int));
+    ridge->pointLocations = (int *)ridgeArenaAlloc(arena, (scale + 1) * sizeof(int));
+    if (!ridge->pointScales || !ridge->pointLocations)
+    {
+        return -1;
+    }
+    ridge->pointScales[0] = scale;
+    ridge->pointLocations[0] = location;
+    ridge->length = 1;
+    ridge->location = location;
+    ridge->gap = 0;
+    return 0;
+}
+
+/**
+ * @function ridgeTrack(RidgeArena *arena, int *const *peaks, const int *numPeaks, int numScales, int gapThreshold, double windowFactor, int *numRidges)
+ * @param arena - Arena the ridge lines are allocated from
+ * @param peaks - Ascending peak locations of every scale
+ * @param numPeaks - Number of peaks of every scale
+ * @param numScales - Number of scales
+ * @param gapThreshold - Number of scales a ridge may miss in a row before it ends
+ * @param windowFactor - A ridge links to a peak at scale s closer than windowFactor * s to its start
+ * @param numRidges - Resulting number of ridge lines
+ * @return RidgeLine *
+ * @brief Links the peaks into ridge lines from the largest scale down. Ridges are kept ordered by location,
+ *      so each scale is matched against the sorted peaks in a single merge pass and every peak joins at
+ *      most one ridge. Peaks left unmatched start new ridges
+ * @author ericdvet */
+RidgeLine *ridgeTrack(RidgeArena *arena, int *const *peaks, const int *numPeaks, int numScales, int gapThreshold, double windowFactor,
+                      int *numRidges)
+{
+    // Every ridge starts at a distinct peak
+    int totalPeaks = 0;
+    for (int s = 0; s < numScales; s++)
+    {
+        totalPeaks += numPeaks[s];
+    }
+    *numRidges = 0;
+
+    RidgeLine *ridges = (RidgeLine *)ridgeArenaAlloc(arena, (totalPeaks + 1) * sizeof(RidgeLine));
+    int *active = (int *)ridgeArenaAlloc(arena, (totalPeaks + 1) * sizeof(int));
+    int *next = (int *)ridgeArenaAlloc(arena, (totalPeaks + 1) * sizeof(int));
+    if (!ridges || !active || !next)
+    {
+        return NULL;
+    }
+    int numActive = 0;
+
+    for (int s = numScales - 1; s >= 0; s--)
+    {
+        const int *scalePeaks = peaks[s];
+        int scaleNumPeaks = numPeaks[s];
+        double window = windowFactor * s;
+        int numNext = 0;
+        int k = 0;
+
+        for (int a = 0; a <= numActive; a++)
+        {
+            // Peaks before the nearest candidate of this ridge, or all remaining peaks after the last ridge,
+            // cannot join a ridge further right and start their own
+            int end = scaleNumPeaks;
+            int matched = -1;
+            RidgeLine *ridge = NULL;
+            if (a < numActive)
+            {
+                ridge = &ridges[active[a]];
+                int x = ridge->location;
+                int j = k;
+                while (j < scaleNumPeaks && scalePeaks[j] <= x)
+                {
+                    j++;
+                }
+
+                // Nearest of the peaks either side of the ridge, ties go left
+                int candidate = -1;
+                int distance = 0;
+                if (j - 1 >= k)
+                {
+                    candidate = j - 1;
+                    distance = x - scalePeaks[j - 1];
+                }
+                if (j < scaleNumPeaks && (candidate < 0 || scalePeaks[j] - x < distance))
+                {
+                    candidate = j;
+                    distance = scalePeaks[j] - x;
+                }
+
+                if (candidate >= 0 && distance < window)
+                {
+                    matched = candidate;
+                    end = candidate;
+                }
+                else
+                {
+                    end = j;
+                }
+            }
+
+            for (; k < end; k++)
+            {
+                if (ridgeStart(arena, &ridges[*numRidges], s, scalePeaks[k]) < 0)
+                {
+                    return NULL;
+                }
+                next[numNext++] = (*numRidges)++;
+            }
+
+            if (ridge == NULL)
+            {
+                break;
+            }
+            if (matched >= 0)
+            {
+                ridge->pointScales[ridge->length] = s;
+                ridge->pointLocations[ridge->length] = scalePeaks[matched];
+                ridge->length++;
+                ridge->gap = 0;
+                next[numNext++] = active[a];
+                k = matched + 1;
+            }
+            else if (++ridge->gap <= gapThreshold)
+            {
+                next[numNext++] = active[a];
+            }
+        }
+
+        int *swap = active;
+        active = next;
+        next = swap;
+        numActive = numNext;
+    }
+
+    return ridges;
+}
+
+// #define RIDGE_TEST
+
+#ifdef RIDGE_TEST
+#include <math.h>
+#include <time.h>
+
+int main()
+{
+    int size = 512;
+    int numScales = 32;
+    int numRuns = 1000;
+    double *signal = (double *)malloc(size * sizeof(double));
+    int **peaks = (int **)malloc(numScales * sizeof(int *));
+    int *numPeaks = (int *)malloc(numScales * sizeof(int));
+    RidgeArena *arena = ridgeArenaCreate(1024);
+
+    // Noisy scales with a peak at 300 that narrows as the scale shrinks
+    clock_t start = clock();
+    int numRidges = 0;
+    RidgeLine *ridges = NULL;
+    for (int run = 0; run < numRuns; run++)
+    {
+        srand(1);
+        ridgeArenaReset(arena);
+        for (int s = 0; s < numScales; s++)
+        {
+            for (int i = 0; i < size; i++)
+            {
+                signal[i] = 10 * exp(-pow(i - 300, 2) / (2.0 * (s + 2) * (s + 2))) + 0.001 * (rand() % 100) / 100.0;
+            }
+            peaks[s] = ridgeFindPeaks(arena, signal, size, &numPeaks[s]);
+        }
+        ridges = ridgeTrack(arena, peaks, numPeaks, numScales, 5, 0.3, &numRidges);
+    }
+    printf("%g s per run\n", (double)(clock() - start) / CLOCKS_PER_SEC / numRuns);
+
+    int tagRidge = 0;
+    for (int i = 1; i < numRidges; i++)
+    {
+        if (abs(ridges[i].location - 300) < abs(ridges[tagRidge].location - 300) ||
+            (ridges[i].location == ridges[tagRidge].location && ridges[i].length > ridges[tagRidge].length))
+        {
+            tagRidge = i;
+        }
+    }
+    printf("%d ridges, the one at %d has %d points of %d scales\n", numRidges, ridges[tagRidge].location, ridges[tagRidge].length, numScales);
+
+    ridgeArenaFree(arena);
+    free(signal);
+    free(peaks);
+    free(numPeaks);
+    return 0;
+}
+#endif
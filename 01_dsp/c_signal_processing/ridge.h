@@ -0,0 +1,111 @@
+/*
+ * File:   ridge.h
+ * Author: ericdvet
+ *
+ * Ridge lines through the local maxima of a continuous wavelet transform, stored in a reusable arena
+ */
+
+#ifndef RIDGE_H
+#define RIDGE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @struct RidgeArenaBlock
+ * @brief One chunk of arena memory
+ * @author ericdvet */
+typedef struct RidgeArenaBlock
+{
+    struct RidgeArenaBlock *next;
+    size_t capacity;
+    size_t used;
+    unsigned char *data;
+} RidgeArenaBlock;
+
+/**
+ * @struct RidgeArena
+ * @brief Bump allocator for peak lists and ridge lines. Everything it hands out is released at once by
+ *      ridgeArenaReset(), which keeps the memory for the next capture
+ * @author ericdvet */
+typedef struct
+{
+    RidgeArenaBlock *head;
+} RidgeArena;
+
+/**
+ * @struct RidgeLine
+ * @brief Stores ridge line information for procCaptureCWT(). Points run from the largest scale down
+ * @author ericdvet */
+typedef struct
+{
+    int *pointScales;
+    int *pointLocations;
+    int length;
+    int location;
+    int gap;
+} RidgeLine;
+
+/**
+ * @function ridgeArenaCreate(size_t capacity)
+ * @param capacity - Initial size of the arena in bytes
+ * @return RidgeArena *
+ * @brief Creates an arena. It grows when a capture needs more and is consolidated on reset
+ * @author ericdvet */
+RidgeArena *ridgeArenaCreate(size_t capacity);
+
+/**
+ * @function ridgeArenaAlloc(RidgeArena *arena, size_t size)
+ * @param arena - Arena created by ridgeArenaCreate()
+ * @param size - Number of bytes
+ * @return void *
+ * @brief Allocates from the arena. The memory stays valid until the next ridgeArenaReset()
+ * @author ericdvet */
+void *ridgeArenaAlloc(RidgeArena *arena, size_t size);
+
+/**
+ * @function ridgeArenaReset(RidgeArena *arena)
+ * @param arena - Arena created by ridgeArenaCreate()
+ * @return None
+ * @brief Releases everything allocated from the arena. If the last use overflowed into extra blocks they
+ *      are merged into one block large enough for it, so steady state use does not call malloc
+ * @author ericdvet */
+void ridgeArenaReset(RidgeArena *arena);
+
+/**
+ * @function ridgeArenaFree(RidgeArena *arena)
+ * @param arena - RidgeArena to free
+ * @return None
+ * @brief Free a RidgeArena constructed by ridgeArenaCreate()
+ * @author ericdvet */
+void ridgeArenaFree(RidgeArena *arena);
+
+/**
+ * @function ridgeFindPeaks(RidgeArena *arena, const double *arr, int size, int *numPeaks)
+ * @param arena - Arena the peak list is allocated from
+ * @param arr - Signal to search
+ * @param size - Number of samples
+ * @param numPeaks - Resulting number of peaks
+ * @return int *
+ * @brief findPeaks() with a minimum peak height of 0, allocated from the arena. Peaks are in ascending order
+ * @author ericdvet */
+int *ridgeFindPeaks(RidgeArena *arena, const double *arr, int size, int *numPeaks);
+
+/**
+ * @function ridgeTrack(RidgeArena *arena, int *const *peaks, const int *numPeaks, int numScales, int gapThreshold, double windowFactor, int *numRidges)
+ * @param arena - Arena the ridge lines are allocated from
+ * @param peaks - Ascending peak locations of every scale
+ * @param numPeaks - Number of peaks of every scale
+ * @param numScales - Number of scales
+ * @param gapThreshold - Number of scales a ridge may miss in a row before it ends
+ * @param windowFactor - A ridge links to a peak at scale s closer than windowFactor * s to its start
+ * @param numRidges - Resulting number of ridge lines
+ * @return RidgeLine *
+ * @brief Links the peaks into ridge lines from the largest scale down. Ridges are kept ordered by location,
+ *      so each scale is matched against the sorted peaks in a single merge pass and every peak joins at
+ *      most one ridge. Peaks left unmatched start new ridges
+ * @author ericdvet */
+RidgeLine *ridgeTrack(RidgeArena *arena, int *const *peaks, const int *numPeaks, int numScales, int gapThreshold, double windowFactor,
+                      int *numRidges);
+
+#endif // RIDGE_H
@@ -9,221 +9,566 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "salsa.h"
 
 #define FRAME_LOGGER_MAGIC_NUM 0xFEFE00A2
 
 /**
- * @function salsaLoad(const char *fileName)
- * @param fileName - Name of radar capture to load
- * @return RadarData *
- * @brief Load radar data from a binary file (captured from frameLogger.c on BBB)
+ * @struct FramesHeader
+ * @brief Layout of a .frames file header as written by frameLogger.c
  * @author ericdvet */
-RadarData *salsaLoad(const char *fileName)
+typedef struct
+{
+    int iterations;
+    int pps;
+    int dacMin;
+    int dacMax;
+    int dacStep;
+    int numberOfSamplers;
+    int numFrames;
+    int numRuns;
+    int frameRate;
+    size_t timesOffset;
+    size_t countersOffset;
+    size_t fileSize;
+} FramesHeader;
+
+/**
+ * @function salsaReadInt(const uint8_t *data, size_t size, size_t *offset, int *value)
+ * @param data - Start of the .frames file contents
+ * @param size - Number of valid bytes in data
+ * @param offset - Read position, advanced past the value on success
+ * @param value - Resulting value
+ * @return bool
+ * @brief Reads one native int from the header without assuming alignment
+ * @author ericdvet */
+static bool salsaReadInt(const uint8_t *data, size_t size, size_t *offset, int *value)
+{
+    if (*offset + sizeof(int) > size)
+    {
+        return false;
+    }
+    memcpy(value, data + *offset, sizeof(int));
+    *offset += sizeof(int);
+    return true;
+}
+
+/**
+ * @function salsaParseHeader(const uint8_t *data, size_t size, FramesHeader *header)
+ * @param data - Start of the .frames file contents
+ * @param size - Number of valid bytes in data
+ * @param header - Resulting header description
+ * @return bool
+ * @brief Validates the header of a .frames file in place and locates the timestamp and counter payloads
+ * @author ericdvet */
+static bool salsaParseHeader(const uint8_t *data, size_t size, FramesHeader *header)
+{
+    size_t offset = 0;
+    uint32_t magic;
+    if (size < sizeof(uint32_t))
+    {
+        return false;
+    }
+    memcpy(&magic, data, sizeof(uint32_t));
+    offset += sizeof(uint32_t);
+    if (magic != FRAME_LOGGER_MAGIC_NUM)
+    {
+        return false;
+    }
+
+    int radarSpecifier;
+    if (!salsaReadInt(data, size, &offset, &header->iterations) || !salsaReadInt(data, size, &offset, &header->pps) ||
+        !salsaReadInt(data, size, &offset, &header->dacMin) || !salsaReadInt(data, size, &offset, &header->dacMax) ||
+        !salsaReadInt(data, size, &offset, &header->dacStep) || !salsaReadInt(data, size, &offset, &radarSpecifier))
+    {
+        return false;
+    }
+
+    // Chip specific fields are not used by the pipeline, only skipped
+    switch (radarSpecifier)
+    {
+    case 2:
+        // samplesPerSecond (float), pgen, offsetDistance, sampleDelayToReference
+        offset += sizeof(float) + sizeof(int) + sizeof(float) + sizeof(float);
+        break;
+    case 10:
+    case 11:
+        // samplesPerSecond (double), pgen, samplingRate, clkDivider
+        offset += sizeof(double) + sizeof(int) + sizeof(int) + sizeof(int);
+        break;
+    default:
+        return false;
+    }
+
+    if (!salsaReadInt(data, size, &offset, &header->numberOfSamplers) || !salsaReadInt(data, size, &offset, &header->numFrames) ||
+        !salsaReadInt(data, size, &offset, &header->numRuns) || !salsaReadInt(data, size, &offset, &header->frameRate))
+    {
+        return false;
+    }
+    if (header->numFrames <= 0 || header->numberOfSamplers <= 0 || header->pps * header->iterations == 0)
+    {
+        return false;
+    }
+
+    header->timesOffset = offset;
+    header->countersOffset = offset + (size_t)header->numFrames * sizeof(double);
+    return true;
+}
+
+/**
+ * @function salsaMap(const char *fileName)
+ * @param fileName - Name of radar capture to map
+ * @return RadarCapture *
+ * @brief Memory-map a binary file (captured from frameLogger.c on BBB). The header is validated in place
+ *      and the raw counters are exposed without copying; use salsaFrame() to normalize a frame
+ * @author ericdvet */
+RadarCapture *salsaMap(const char *fileName)
 {
-    // char resolvedPath[512];
-    // strcpy(resolvedPath, "/home/ericdvet/hare-lab/dev_ws/src/wadar/b1/chipotle-radar/2024-09-20__test_C1.frames");
-    printf("Loading radar data from %s\n", fileName);
-    FILE *fid = fopen(fileName, "rb");
-    if (!fid)
+    printf("Mapping radar data from %s\n", fileName);
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0)
     {
         fprintf(stderr, "ERROR: File not available");
         return NULL;
     }
 
-    uint32_t magic;
-    if (fread(&magic, sizeof(uint32_t), 1, fid) != 1)
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0)
     {
         fprintf(stderr, "ERROR: .frames file formatting");
-        fclose(fid);
+        close(fd);
         return NULL;
     }
-    if (magic != FRAME_LOGGER_MAGIC_NUM)
+    size_t mapSize = (size_t)fileStat.st_size;
+
+    void *map = mmap(NULL, mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
     {
-        fprintf(stderr, "ERROR: .frames file formatting");
-        fclose(fid);
+        fprintf(stderr, "ERROR: Memory map failure");
         return NULL;
     }
+    madvise(map, mapSize, MADV_SEQUENTIAL);
 
-    int iterations, pps, dacMin, dacMax, dacStep;
-    if (fread(&iterations, sizeof(int), 1, fid) != 1 || fread(&pps, sizeof(int), 1, fid) != 1 ||
-        fread(&dacMin, sizeof(int), 1, fid) != 1 || fread(&dacMax, sizeof(int), 1, fid) != 1 ||
-        fread(&dacStep, sizeof(int), 1, fid) != 1)
+    FramesHeader header;
+    if (!salsaParseHeader((const uint8_t *)map, mapSize, &header))
     {
         fprintf(stderr, "ERROR: .frames file formatting");
-        fclose(fid);
+        munmap(map, mapSize);
         return NULL;
     }
 
-    int radarSpecifier;
-    if (fread(&radarSpecifier, sizeof(int), 1, fid) != 1)
+    // Counters are followed by the estimated frame rate (float)
+    size_t numSamples = (size_t)header.numFrames * header.numberOfSamplers;
+    if (header.countersOffset + numSamples * sizeof(uint32_t) + sizeof(float) > mapSize)
     {
         fprintf(stderr, "ERROR: .frames file formatting");
-        fclose(fid);
+        munmap(map, mapSize);
         return NULL;
     }
 
-    float samplesPerSecond = 0;
-    int samplingRate = 0, clkDivider = 0;
-    float sampleDelayToReference = -1;
-    float offsetDistance = -1;
+    RadarCapture *capture = (RadarCapture *)malloc(sizeof(RadarCapture));
+    if (!capture)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure");
+        munmap(map, mapSize);
+        return NULL;
+    }
 
-    RadarData *radarData = (RadarData *)malloc(sizeof(RadarData));
-    if (!radarData)
+    // Timestamps are not 8-byte aligned in the file, so they are the only part copied out
+    capture->times = (double *)malloc(header.numFrames * sizeof(double));
+    if (!capture->times)
     {
-        fprintf(stderr, "ERROR: .frames file formatting");
-        fclose(fid);
+        fprintf(stderr, "ERROR: Memory allocation failure");
+        free(capture);
+        munmap(map, mapSize);
         return NULL;
     }
+    memcpy(capture->times, (const uint8_t *)map + header.timesOffset, header.numFrames * sizeof(double));
 
-    char chipSet[10];
-    int pgen;
+    capture->counters = (const uint32_t *)((const uint8_t *)map + header.countersOffset);
+    capture->numFrames = header.numFrames;
+    capture->numOfSamplers = header.numberOfSamplers;
+    capture->frameRate = header.frameRate;
+    capture->countsPerStep = header.pps * header.iterations;
+    capture->dacStep = header.dacStep;
+    capture->dacMin = header.dacMin;
+    capture->map = map;
+    capture->mapSize = mapSize;
 
-    switch (radarSpecifier)
+    return capture;
+}
+
+/**
+ * @function salsaNormalizeCounters(const uint32_t *counters, int numOfSamplers, int countsPerStep, int dacStep, int dacMin, double *rfSignal)
+ * @param counters - Raw counters of one frame
+ * @param numOfSamplers - Number of samplers in the frame
+ * @param countsPerStep - Pulses per step times iterations
+ * @param dacStep - DAC step size
+ * @param dacMin - DAC minimum
+ * @param rfSignal - Resulting numOfSamplers DAC values
+ * @return double
+ * @brief Converts one frame of raw counters to DAC values and returns its largest value
+ * @author ericdvet */
+static double salsaNormalizeCounters(const uint32_t *counters, int numOfSamplers, int countsPerStep, int dacStep, int dacMin, double *rfSignal)
+{
+    double maxVal = -INFINITY;
+    for (int j = 0; j < numOfSamplers; j++)
     {
-    case 2:
-        strcpy(chipSet, "X2");
-        if (fread(&samplesPerSecond, sizeof(float), 1, fid) != 1 || fread(&pgen, sizeof(int), 1, fid) != 1 ||
-            fread(&offsetDistance, sizeof(float), 1, fid) != 1 || fread(&sampleDelayToReference, sizeof(float), 1, fid) != 1)
+        rfSignal[j] = (double)counters[j] / countsPerStep * dacStep + dacMin;
+        if (rfSignal[j] > maxVal)
         {
-            fprintf(stderr, "ERROR: .frames file formatting");
-            free(radarData);
-            fclose(fid);
-            return NULL;
+            maxVal = rfSignal[j];
         }
-        break;
-    case 10:
-    case 11:
-        if (radarSpecifier == 10)
-            strcpy(chipSet, "X1-IPGO");
-        if (radarSpecifier == 11)
-            strcpy(chipSet, "X1-IPG1");
-        if (fread(&samplesPerSecond, sizeof(double), 1, fid) != 1 || fread(&pgen, sizeof(int), 1, fid) != 1 ||
-            fread(&samplingRate, sizeof(int), 1, fid) != 1 || fread(&clkDivider, sizeof(int), 1, fid) != 1)
+    }
+    return maxVal;
+}
+
+/**
+ * @function salsaNormalize(const RadarCapture *capture, int frame, double *rfSignal)
+ * @param capture - Capture mapped by salsaMap()
+ * @param frame - Index of the frame to normalize
+ * @param rfSignal - Resulting numOfSamplers DAC values
+ * @return double
+ * @brief Converts one mapped frame to DAC values and returns its largest value
+ * @author ericdvet */
+static double salsaNormalize(const RadarCapture *capture, int frame, double *rfSignal)
+{
+    return salsaNormalizeCounters(capture->counters + (size_t)frame * capture->numOfSamplers, capture->numOfSamplers,
+                                  capture->countsPerStep, capture->dacStep, capture->dacMin, rfSignal);
+}
+
+/**
+ * @function salsaFrame(const RadarCapture *capture, int frame, double *rfSignal)
+ * @param capture - Capture mapped by salsaMap()
+ * @param frame - Index of the frame to normalize
+ * @param rfSignal - Resulting numOfSamplers DAC values
+ * @return None
+ * @brief Lazily normalizes a single frame. Frames containing the counter spike (> 8191) are replaced by
+ *      the closest earlier clean frame (or the next frame for the first one), matching salsaLoad()
+ * @author ericdvet */
+void salsaFrame(const RadarCapture *capture, int frame, double *rfSignal)
+{
+    // Process out the weird spike
+    while (salsaNormalize(capture, frame, rfSignal) > 8191)
+    {
+        if (frame == 0)
         {
-            fprintf(stderr, "ERROR: .frames file formatting");
-            free(radarData);
-            fclose(fid);
-            return NULL;
+            if (capture->numFrames > 1)
+            {
+                salsaNormalize(capture, 1, rfSignal);
+            }
+            return;
         }
-        break;
-    default:
-        fprintf(stderr, "ERROR: .frames file formatting");
-        free(radarData);
-        fclose(fid);
+        frame--;
+    }
+}
+
+/**
+ * @function salsaNormalizef(const RadarCapture *capture, int frame, float *rfSignal)
+ * @param capture - Capture mapped by salsaMap()
+ * @param frame - Index of the frame to normalize
+ * @param rfSignal - Resulting numOfSamplers DAC values
+ * @return double
+ * @brief Single precision salsaNormalize(). Values are rounded only when stored, so the largest value
+ *      and therefore the spike test are exactly those of the double path
+ * @author ericdvet */
+static double salsaNormalizef(const RadarCapture *capture, int frame, float *rfSignal)
+{
+    const uint32_t *counters = capture->counters + (size_t)frame * capture->numOfSamplers;
+    double maxVal = -INFINITY;
+    for (int j = 0; j < capture->numOfSamplers; j++)
+    {
+        double value = (double)counters[j] / capture->countsPerStep * capture->dacStep + capture->dacMin;
+        rfSignal[j] = (float)value;
+        if (value > maxVal)
+        {
+            maxVal = value;
+        }
+    }
+    return maxVal;
+}
+
+/**
+ * @function salsaFramef(const RadarCapture *capture, int frame, float *rfSignal)
+ * @param capture - Capture mapped by salsaMap()
+ * @param frame - Index of the frame to normalize
+ * @param rfSignal - Resulting numOfSamplers DAC values
+ * @return None
+ * @brief Single precision salsaFrame()
+ * @author ericdvet */
+void salsaFramef(const RadarCapture *capture, int frame, float *rfSignal)
+{
+    // Process out the weird spike
+    while (salsaNormalizef(capture, frame, rfSignal) > 8191)
+    {
+        if (frame == 0)
+        {
+            if (capture->numFrames > 1)
+            {
+                salsaNormalizef(capture, 1, rfSignal);
+            }
+            return;
+        }
+        frame--;
+    }
+}
+
+/**
+ * @function salsaUnmap(RadarCapture *capture)
+ * @param capture - RadarCapture struct to release
+ * @return None
+ * @brief Unmap and free a RadarCapture constructed by salsaMap()
+ * @author ericdvet */
+void salsaUnmap(RadarCapture *capture)
+{
+    if (capture)
+    {
+        munmap(capture->map, capture->mapSize);
+        free(capture->times);
+        free(capture);
+    }
+}
+
+/**
+ * @function salsaReadAt(int fd, void *buffer, size_t size, size_t offset)
+ * @param fd - Open .frames file descriptor
+ * @param buffer - Destination buffer
+ * @param size - Number of bytes to read
+ * @param offset - File offset to read from
+ * @return bool
+ * @brief Reads exactly size bytes at offset, retrying short reads
+ * @author ericdvet */
+static bool salsaReadAt(int fd, void *buffer, size_t size, size_t offset)
+{
+    uint8_t *dst = (uint8_t *)buffer;
+    while (size > 0)
+    {
+        ssize_t numRead = pread(fd, dst, size, (off_t)offset);
+        if (numRead <= 0)
+        {
+            return false;
+        }
+        dst += numRead;
+        offset += numRead;
+        size -= numRead;
+    }
+    return true;
+}
+
+/**
+ * @function salsaStreamOpen(const char *fileName, int blockFrames)
+ * @param fileName - Name of radar capture to stream
+ * @param blockFrames - Maximum number of frames returned by each salsaStreamNext() call
+ * @return SalsaStream *
+ * @brief Open a .frames file for block-wise reading. Memory use is bounded by blockFrames regardless of
+ *      the capture length
+ * @author ericdvet */
+SalsaStream *salsaStreamOpen(const char *fileName, int blockFrames)
+{
+    printf("Streaming radar data from %s\n", fileName);
+    if (blockFrames <= 0)
+    {
+        fprintf(stderr, "ERROR: Block size must be positive");
+        return NULL;
+    }
+
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "ERROR: File not available");
         return NULL;
     }
 
-    int numberOfSamplers, numRuns;
-    if (fread(&numberOfSamplers, sizeof(int), 1, fid) != 1 || fread(&(radarData->numFrames), sizeof(int), 1, fid) != 1 ||
-        fread(&numRuns, sizeof(int), 1, fid) != 1 || fread(&(radarData->frameRate), sizeof(int), 1, fid) != 1)
+    // The header is at most a few dozen bytes; read a generous prefix and parse it in place
+    uint8_t headerBytes[256];
+    ssize_t headerSize = pread(fd, headerBytes, sizeof(headerBytes), 0);
+    struct stat fileStat;
+    FramesHeader header;
+    if (headerSize <= 0 || fstat(fd, &fileStat) != 0 || !salsaParseHeader(headerBytes, (size_t)headerSize, &header))
     {
         fprintf(stderr, "ERROR: .frames file formatting");
-        free(radarData);
-        fclose(fid);
+        close(fd);
         return NULL;
     }
 
-    size_t frameTotSize = (radarData->numFrames) * numberOfSamplers * sizeof(uint32_t);
-    uint32_t *frameTotRaw = (uint32_t *)malloc(frameTotSize);
-    if (!frameTotRaw)
+    size_t numSamples = (size_t)header.numFrames * header.numberOfSamplers;
+    if (header.countersOffset + numSamples * sizeof(uint32_t) + sizeof(float) > (size_t)fileStat.st_size)
     {
-        fprintf(stderr, "ERROR: Memory allocation failure");
-        free(radarData);
-        fclose(fid);
+        fprintf(stderr, "ERROR: .frames file formatting");
+        close(fd);
         return NULL;
     }
 
-    radarData->times = (double *)malloc((radarData->numFrames) * sizeof(double));
-    radarData->frameTot = (double *)malloc((radarData->numFrames) * numberOfSamplers * sizeof(double));
-    if (!radarData->times || !radarData->frameTot)
+    SalsaStream *stream = (SalsaStream *)calloc(1, sizeof(SalsaStream));
+    if (!stream)
     {
         fprintf(stderr, "ERROR: Memory allocation failure");
-        free(frameTotRaw);
-        free(radarData->times);
-        free(radarData->frameTot);
-        free(radarData);
-        fclose(fid);
+        close(fd);
         return NULL;
     }
 
-    for (int i = 0; i < (radarData->numFrames); i++)
+    if (blockFrames > header.numFrames)
     {
-        if (fread(&radarData->times[i], sizeof(double), 1, fid) != 1)
-        {
-            fprintf(stderr, "ERROR: .frames file formatting");
-            free(frameTotRaw);
-            free(radarData->times);
-            free(radarData->frameTot);
-            free(radarData);
-            fclose(fid);
-            return NULL;
-        }
+        blockFrames = header.numFrames;
     }
+    stream->fd = fd;
+    stream->blockFrames = blockFrames;
+    stream->numFrames = header.numFrames;
+    stream->numOfSamplers = header.numberOfSamplers;
+    stream->frameRate = header.frameRate;
+    stream->countsPerStep = header.pps * header.iterations;
+    stream->dacStep = header.dacStep;
+    stream->dacMin = header.dacMin;
+    stream->timesOffset = header.timesOffset;
+    stream->countersOffset = header.countersOffset;
 
-    if (fread(frameTotRaw, sizeof(uint32_t), (radarData->numFrames) * numberOfSamplers, fid) != (radarData->numFrames) * numberOfSamplers)
+    stream->frames = (double *)malloc((size_t)blockFrames * stream->numOfSamplers * sizeof(double));
+    stream->times = (double *)malloc(blockFrames * sizeof(double));
+    stream->counters = (uint32_t *)malloc((size_t)blockFrames * stream->numOfSamplers * sizeof(uint32_t));
+    stream->lastFrame = (double *)malloc(stream->numOfSamplers * sizeof(double));
+    if (!stream->frames || !stream->times || !stream->counters || !stream->lastFrame)
     {
-        fprintf(stderr, "ERROR: .frames file formatting");
-        free(frameTotRaw);
-        free(radarData);
-        fclose(fid);
+        fprintf(stderr, "ERROR: Memory allocation failure");
+        salsaStreamClose(stream);
         return NULL;
     }
 
-    for (int i = 0; i < (radarData->numFrames) * numberOfSamplers; i++)
+    return stream;
+}
+
+/**
+ * @function salsaStreamNext(SalsaStream *stream)
+ * @param stream - Stream opened by salsaStreamOpen()
+ * @return int
+ * @brief Reads and normalizes the next block of frames into stream->frames and stream->times.
+ *      Returns the number of frames in the block, 0 at the end of the capture or -1 on a read error
+ * @author ericdvet */
+int salsaStreamNext(SalsaStream *stream)
+{
+    int firstFrame = stream->nextFrame;
+    int blockFrames = stream->numFrames - firstFrame;
+    if (blockFrames > stream->blockFrames)
     {
-        radarData->frameTot[i] = (double)frameTotRaw[i] / (pps * iterations) * dacStep + dacMin;
+        blockFrames = stream->blockFrames;
+    }
+    if (blockFrames <= 0)
+    {
+        return 0;
     }
-    free(frameTotRaw);
 
-    // Process out the weird spike
-    for (int i = 0; i < (radarData->numFrames); i++)
+    size_t frameBytes = (size_t)stream->numOfSamplers * sizeof(uint32_t);
+    if (!salsaReadAt(stream->fd, stream->counters, blockFrames * frameBytes, stream->countersOffset + firstFrame * frameBytes) ||
+        !salsaReadAt(stream->fd, stream->times, blockFrames * sizeof(double), stream->timesOffset + firstFrame * sizeof(double)))
     {
-        double maxVal = radarData->frameTot[i * numberOfSamplers];
-        for (int j = 1; j < numberOfSamplers; j++)
-        {
-            if (radarData->frameTot[i * numberOfSamplers + j] > maxVal)
-            {
-                maxVal = radarData->frameTot[i * numberOfSamplers + j];
-            }
-        }
+        fprintf(stderr, "ERROR: .frames file formatting");
+        return -1;
+    }
+
+    for (int i = 0; i < blockFrames; i++)
+    {
+        double *rfSignal = &stream->frames[(size_t)i * stream->numOfSamplers];
+        double maxVal = salsaNormalizeCounters(&stream->counters[(size_t)i * stream->numOfSamplers], stream->numOfSamplers,
+                                               stream->countsPerStep, stream->dacStep, stream->dacMin, rfSignal);
+
+        // Process out the weird spike, same replacement rule as salsaFrame()
         if (maxVal > 8191)
         {
-            if (i > 0)
+            if (firstFrame + i > 0)
             {
-                memcpy(&radarData->frameTot[i * numberOfSamplers], &radarData->frameTot[(i - 1) * numberOfSamplers], numberOfSamplers * sizeof(double));
+                memcpy(rfSignal, stream->lastFrame, stream->numOfSamplers * sizeof(double));
             }
-            else
+            else if (stream->numFrames > 1)
             {
-                memcpy(&radarData->frameTot[i * numberOfSamplers], &radarData->frameTot[(i + 1) * numberOfSamplers], numberOfSamplers * sizeof(double));
+                // The first frame is replaced by the second; fetch it if it is not part of this block
+                const uint32_t *nextCounters = &stream->counters[stream->numOfSamplers];
+                if (blockFrames == 1)
+                {
+                    if (!salsaReadAt(stream->fd, stream->counters, frameBytes, stream->countersOffset + frameBytes))
+                    {
+                        fprintf(stderr, "ERROR: .frames file formatting");
+                        return -1;
+                    }
+                    nextCounters = stream->counters;
+                }
+                salsaNormalizeCounters(nextCounters, stream->numOfSamplers, stream->countsPerStep,
+                                       stream->dacStep, stream->dacMin, rfSignal);
             }
         }
+        memcpy(stream->lastFrame, rfSignal, stream->numOfSamplers * sizeof(double));
     }
 
-    float fpsEst;
-    if (fread(&fpsEst, sizeof(float), 1, fid) != 1)
+    stream->blockStart = firstFrame;
+    stream->nextFrame = firstFrame + blockFrames;
+    return blockFrames;
+}
+
+/**
+ * @function salsaStreamClose(SalsaStream *stream)
+ * @param stream - Stream to close
+ * @return None
+ * @brief Close the file and free the block buffers of a SalsaStream
+ * @author ericdvet */
+void salsaStreamClose(SalsaStream *stream)
+{
+    if (stream)
+    {
+        close(stream->fd);
+        free(stream->frames);
+        free(stream->times);
+        free(stream->counters);
+        free(stream->lastFrame);
+        free(stream);
+    }
+}
+
+/**
+ * @function salsaLoad(const char *fileName)
+ * @param fileName - Name of radar capture to load
+ * @return RadarData *
+ * @brief Load radar data from a binary file (captured from frameLogger.c on BBB)
+ * @author ericdvet */
+RadarData *salsaLoad(const char *fileName)
+{
+    RadarCapture *capture = salsaMap(fileName);
+    if (!capture)
     {
-        fprintf(stderr, "ERROR: .frames file formatting");
-        free(radarData->times);
-        free(radarData->frameTot);
-        free(radarData);
-        fclose(fid);
         return NULL;
     }
 
-    fseek(fid, 0, SEEK_END);
-    long remainingData = ftell(fid) - ftell(fid);
-    if (remainingData > 0)
+    RadarData *radarData = (RadarData *)malloc(sizeof(RadarData));
+    if (!radarData)
     {
-        fprintf(stderr, "ERROR: .frames file formatting");
-        free(radarData->times);
-        free(radarData->frameTot);
-        free(radarData);
-        fclose(fid);
+        fprintf(stderr, "ERROR: Memory allocation failure");
+        salsaUnmap(capture);
         return NULL;
     }
 
-    fclose(fid);
+    radarData->numFrames = capture->numFrames;
+    radarData->frameRate = capture->frameRate;
+    radarData->times = (double *)malloc((radarData->numFrames) * sizeof(double));
+    radarData->frameTot = (double *)malloc((size_t)(radarData->numFrames) * capture->numOfSamplers * sizeof(double));
+    if (!radarData->times || !radarData->frameTot)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure");
+        freeRadarData(radarData);
+        salsaUnmap(capture);
+        return NULL;
+    }
+
+    memcpy(radarData->times, capture->times, (radarData->numFrames) * sizeof(double));
+    for (int i = 0; i < (radarData->numFrames); i++)
+    {
+        salsaFrame(capture, i, &radarData->frameTot[(size_t)i * capture->numOfSamplers]);
+    }
+
+    salsaUnmap(capture);
     return radarData;
 }
 
@@ -253,6 +598,26 @@ int main()
     {
         freeRadarData(radarData);
     }
+
+    RadarCapture *capture = salsaMap("/home/ericdvet/jlab/wadar/signal_processing/testFile.frames");
+    if (capture)
+    {
+        double *rfSignal = (double *)malloc(capture->numOfSamplers * sizeof(double));
+        salsaFrame(capture, capture->numFrames - 1, rfSignal);
+        free(rfSignal);
+        salsaUnmap(capture);
+    }
+
+    SalsaStream *stream = salsaStreamOpen("/home/ericdvet/jlab/wadar/signal_processing/testFile.frames", 64);
+    if (stream)
+    {
+        int blockFrames;
+        while ((blockFrames = salsaStreamNext(stream)) > 0)
+        {
+            printf("Frames %d to %d\n", stream->blockStart, stream->blockStart + blockFrames - 1);
+        }
+        salsaStreamClose(stream);
+    }
     return 0;
 }
 #endif
@@ -10,6 +10,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <stddef.h>
 
 /**
  * @struct RadarData
@@ -23,6 +24,49 @@ typedef struct
     int numFrames;
 } RadarData;
 
+/**
+ * @struct RadarCapture
+ * @brief Memory-mapped view of a .frames file opened by salsaMap(). Counters point into the mapping
+ * @author ericdvet */
+typedef struct
+{
+    const uint32_t *counters;
+    double *times;
+    int numFrames;
+    int numOfSamplers;
+    int frameRate;
+    int countsPerStep;
+    int dacStep;
+    int dacMin;
+    void *map;
+    size_t mapSize;
+} RadarCapture;
+
+/**
+ * @struct SalsaStream
+ * @brief Block-wise reader over a .frames file opened by salsaStreamOpen(). After each salsaStreamNext()
+ *      call, frames holds the normalized block (frame-major, numOfSamplers per frame) starting at blockStart
+ * @author ericdvet */
+typedef struct
+{
+    double *frames;
+    double *times;
+    int blockStart;
+    int blockFrames;
+    int numFrames;
+    int numOfSamplers;
+    int frameRate;
+    int nextFrame;
+    int countsPerStep;
+    int dacStep;
+    int dacMin;
+    int fd;
+    size_t timesOffset;
+    size_t countersOffset;
+    uint32_t *counters;
+    double *lastFrame;
+} SalsaStream;
+
 /**
  * @function salsaLoad(const char *fileName)
  * @param fileName - Name of radar capture to load
@@ -39,4 +83,69 @@ RadarData *salsaLoad(const char *fileName);
  * @author ericdvet */
 void freeRadarData(RadarData *radarData);
 
+/**
+ * @function salsaMap(const char *fileName)
+ * @param fileName - Name of radar capture to map
+ * @return RadarCapture *
+ * @brief Memory-map a binary file (captured from frameLogger.c on BBB). The header is validated in place
+ *      and the raw counters are exposed without copying; use salsaFrame() to normalize a frame
+ * @author ericdvet */
+RadarCapture *salsaMap(const char *fileName);
+
+/**
+ * @function salsaFrame(const RadarCapture *capture, int frame, double *rfSignal)
+ * @param capture - Capture mapped by salsaMap()
+ * @param frame - Index of the frame to normalize
+ * @param rfSignal - Resulting numOfSamplers DAC values
+ * @return None
+ * @brief Lazily normalizes a single frame. Frames containing the counter spike (> 8191) are replaced by
+ *      the closest earlier clean frame (or the next frame for the first one), matching salsaLoad()
+ * @author ericdvet */
+void salsaFrame(const RadarCapture *capture, int frame, double *rfSignal);
+
+/**
+ * @function salsaFramef(const RadarCapture *capture, int frame, float *rfSignal)
+ * @param capture - Capture mapped by salsaMap()
+ * @param frame - Index of the frame to normalize
+ * @param rfSignal - Resulting numOfSamplers DAC values
+ * @return None
+ * @brief Single precision salsaFrame(). DAC values span 13 bits, well within the precision of a float
+ * @author ericdvet */
+void salsaFramef(const RadarCapture *capture, int frame, float *rfSignal);
+
+/**
+ * @function salsaUnmap(RadarCapture *capture)
+ * @param capture - RadarCapture struct to release
+ * @return None
+ * @brief Unmap and free a RadarCapture constructed by salsaMap()
+ * @author ericdvet */
+void salsaUnmap(RadarCapture *capture);
+
+/**
+ * @function salsaStreamOpen(const char *fileName, int blockFrames)
+ * @param fileName - Name of radar capture to stream
+ * @param blockFrames - Maximum number of frames returned by each salsaStreamNext() call
+ * @return SalsaStream *
+ * @brief Open a .frames file for block-wise reading. Memory use is bounded by blockFrames regardless of
+ *      the capture length
+ * @author ericdvet */
+SalsaStream *salsaStreamOpen(const char *fileName, int blockFrames);
+
+/**
+ * @function salsaStreamNext(SalsaStream *stream)
+ * @param stream - Stream opened by salsaStreamOpen()
+ * @return int
+ * @brief Reads and normalizes the next block of frames into stream->frames and stream->times.
+ *      Returns the number of frames in the block, 0 at the end of the capture or -1 on a read error
+ * @author ericdvet */
+int salsaStreamNext(SalsaStream *stream);
+
+/**
+ * @function salsaStreamClose(SalsaStream *stream)
+ * @param stream - Stream to close
+ * @return None
+ * @brief Close the file and free the block buffers of a SalsaStream
+ * @author ericdvet */
+void salsaStreamClose(SalsaStream *stream);
+
 #endif // SALSA_LOAD_H
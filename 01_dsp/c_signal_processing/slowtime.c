@@ -0,0 +1,781 @@
+/*
+ * File:   slowtime.c
+ * Author: ericdvet
+ *
+ * Slow-time spectral estimates of a few frequency bins, accumulated while frames are downconverted
+ */
+
+#include "slowtime.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+
+#define PI 3.14159265358979323846
+
+// Most odd harmonics slowTimeHarmonicFT() combines
+#define SLOWTIME_MAX_HARMONICS 16
+
+// Harmonics aliasing closer than this fraction of the capture's bins to DC are dropped
+#define SLOWTIME_DC_GUARD 0.01
+
+// Largest phase error in radians, at any bin, for which slowTimeAccumulateTimes() keeps the uniform twiddles
+#define SLOWTIME_JITTER_PHASE 0.05
+
+/**
+ * @function slowTimeWrap(int bin, int numFrames)
+ * @param bin - Frequency bin, possibly negative or past the end of the FFT
+ * @param numFrames - Length of the slow-time DFT
+ * @return int
+ * @brief Wraps a frequency bin into [0, numFrames)
+ * @author ericdvet */
+static int slowTimeWrap(int bin, int numFrames)
+{
+    bin %= numFrames;
+    return bin < 0 ? bin + numFrames : bin;
+}
+
+/**
+ * @function slowTimeCreate(int numFrames, int numOfSamplers, const int *bins, int numBins)
+ * @param numFrames - Length of the slow-time DFT (frames in the capture)
+ * @param numOfSamplers - Number of range bins per frame
+ * @param bins - Frequency bins to compute, as indices of the numFrames-point FFT
+ * @param numBins - Number of frequency bins
+ * @return SlowTimeDFT *
+ * @brief Prepares a DFT that only evaluates the given frequency bins. Duplicate bins are computed once
+ * @author ericdvet */
+SlowTimeDFT *slowTimeCreate(int numFrames, int numOfSamplers, const int *bins, int numBins)
+{
+    if (numFrames < 1 || numOfSamplers < 1 || numBins < 1)
+    {
+        fprintf(stderr, "ERROR: Invalid slow-time DFT size\n");
+        return NULL;
+    }
+
+    SlowTimeDFT *dft = (SlowTimeDFT *)calloc(1, sizeof(SlowTimeDFT));
+    if (!dft)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        return NULL;
+    }
+    dft->numFrames = numFrames;
+    dft->numOfSamplers = numOfSamplers;
+
+    int minBin = numFrames;
+    int maxBin = -1;
+    for (int i = 0; i < numBins; i++)
+    {
+        int bin = slowTimeWrap(bins[i], numFrames);
+        minBin = bin < minBin ? bin : minBin;
+        maxBin = bin > maxBin ? bin : maxBin;
+    }
+    dft->minBin = minBin;
+    dft->binSpan = maxBin - minBin + 1;
+
+    dft->bins = (int *)malloc(numBins * sizeof(int));
+    dft->binIndex = (int *)malloc(dft->binSpan * sizeof(int));
+    dft->twiddle = (double complex *)malloc(numFrames * sizeof(double complex));
+    if (!dft->bins || !dft->binIndex || !dft->twiddle)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        slowTimeFree(dft);
+        return NULL;
+    }
+
+    // Map each requested bin to a row of the spectrum, skipping duplicates
+    for (int i = 0; i < dft->binSpan; i++)
+    {
+        dft->binIndex[i] = -1;
+    }
+    for (int i = 0; i < numBins; i++)
+    {
+        int bin = slowTimeWrap(bins[i], numFrames);
+        if (dft->binIndex[bin - minBin] < 0)
+        {
+            dft->binIndex[bin - minBin] = dft->numBins;
+            dft->bins[dft->numBins++] = bin;
+        }
+    }
+
+    // Roots of unity indexed by (bin * frame) mod numFrames, so long captures do not accumulate phase error
+    for (int n = 0; n < numFrames; n++)
+    {
+        dft->twiddle[n] = cos(2 * PI * n / numFrames) - I * sin(2 * PI * n / numFrames);
+    }
+
+    dft->spectrum = (double complex *)calloc((size_t)dft->numBins * numOfSamplers, sizeof(double complex));
+    if (!dft->spectrum)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        slowTimeFree(dft);
+        return NULL;
+    }
+
+    return dft;
+}
+
+/**
+ * @function slowTimeTagBins(int freqTag, int *numBins)
+ * @param freqTag - Expected frequency bin of the tag, as computed by procRadarFrames()
+ * @param numBins - Resulting number of frequency bins
+ * @return int *
+ * @brief Returns the FFT indices read by procRadarFrames() and calculateSNR(): the tag search window
+ *      freqTag +/- 2 and the noise band 0.945 to 0.955 times the tag frequency
+ * @author ericdvet */
+int *slowTimeTagBins(int freqTag, int *numBins)
+{
+    int noiseLow = (int)((freqTag - 2) * 0.945);
+    int noiseHigh = (int)((freqTag + 2) * 0.955);
+    int maxBins = 5 + (noiseHigh > noiseLow ? noiseHigh - noiseLow : 0);
+
+    int *bins = (int *)malloc(maxBins * sizeof(int));
+    if (!bins)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        return NULL;
+    }
+
+    // Tag window and noise band use 1-based bins like MATLAB, hence the - 1
+    *numBins = 0;
+    for (int j = freqTag - 2; j <= freqTag + 2; j++)
+    {
+        bins[(*numBins)++] = j - 1;
+    }
+    for (int j = noiseLow; j < noiseHigh; j++)
+    {
+        bins[(*numBins)++] = j - 1;
+    }
+    return bins;
+}
+
+/**
+ * @function slowTimeAccumulate(SlowTimeDFT *dft, const double complex *framesBB, int numFrames)
+ * @param dft - DFT created by slowTimeCreate()
+ * @param framesBB - Next baseband frames of the capture (numFrames x numOfSamplers)
+ * @param numFrames - Number of frames in the block
+ * @return None
+ * @brief Adds a block of frames to the running DFT. Blocks must be passed in capture order
+ * @author ericdvet */
+void slowTimeAccumulate(SlowTimeDFT *dft, const double complex *framesBB, int numFrames)
+{
+    int numOfSamplers = dft->numOfSamplers;
+
+    // One frequency bin at a time so its row stays in cache for the whole block. Complex arithmetic is
+    // written out on doubles so the compiler vectorizes it instead of calling the C99 complex helpers
+    for (int b = 0; b < dft->numBins; b++)
+    {
+        double *row = (double *)&dft->spectrum[(size_t)b * numOfSamplers];
+        int step = dft->bins[b];
+        int phase = (int)(((long long)step * dft->frame) % dft->numFrames);
+
+        for (int n = 0; n < numFrames; n++)
+        {
+            const double *frame = (const double *)&framesBB[(size_t)n * numOfSamplers];
+            double wr = creal(dft->twiddle[phase]);
+            double wi = cimag(dft->twiddle[phase]);
+
+            for (int i = 0; i < numOfSamplers; i++)
+            {
+                double xr = frame[2 * i];
+                double xi = frame[2 * i + 1];
+                row[2 * i] += wr * xr - wi * xi;
+                row[2 * i + 1] += wr * xi + wi * xr;
+            }
+
+            phase += step;
+            if (phase >= dft->numFrames)
+            {
+                phase -= dft->numFrames;
+            }
+        }
+    }
+
+    dft->frame += numFrames;
+}
+
+/**
+ * @function slowTimeAccumulateTimes(SlowTimeDFT *dft, const double complex *framesBB, const double *times, int numFrames, double frameRate)
+ * @param dft - DFT created by slowTimeCreate()
+ * @param framesBB - Next baseband frames of the capture (numFrames x numOfSamplers)
+ * @param times - Logged time of each frame in seconds, RadarData.times (numFrames)
+ * @param numFrames - Number of frames in the block
+ * @param frameRate - Nominal frame rate in Hz, bin k stands for k * frameRate / dft->numFrames Hz
+ * @return None
+ * @brief slowTimeAccumulate() on the frames' logged times instead of a perfect frame grid, the least squares
+ *      (Lomb-Scargle) fit of a complex tone at each bin frequency. A block whose times stay within
+ *      SLOWTIME_JITTER_PHASE of the grid at every bin takes the uniform twiddles, so only jittery blocks
+ *      pay for exact phasors. Blocks whose times do not increase are taken as uniform
+ * @author ericdvet */
+void slowTimeAccumulateTimes(SlowTimeDFT *dft, const double complex *framesBB, const double *times, int numFrames, double frameRate)
+{
+    int numOfSamplers = dft->numOfSamplers;
+    if (numFrames < 1)
+    {
+        return;
+    }
+    if (dft->frame == 0)
+    {
+        dft->startTime = times[0];
+        dft->lastTime = times[0] - 1 / frameRate;
+    }
+
+    // Offset of each frame from its slot on the nominal grid, in frames, and the highest frequency it rotates
+    double maxOffset = 0;
+    bool increasing = true;
+    for (int n = 0; n < numFrames; n++)
+    {
+        double offset = (times[n] - dft->startTime) * frameRate - (dft->frame + n);
+        maxOffset = fmax(maxOffset, fabs(offset));
+        increasing = increasing && times[n] > (n > 0 ? times[n - 1] : dft->lastTime);
+    }
+    int maxBin = 0;
+    for (int b = 0; b < dft->numBins; b++)
+    {
+        int bin = dft->bins[b] <= dft->numFrames / 2 ? dft->bins[b] : dft->numFrames - dft->bins[b];
+        maxBin = bin > maxBin ? bin : maxBin;
+    }
+    dft->lastTime = times[numFrames - 1];
+    if (!increasing || 2 * PI * maxBin * maxOffset / dft->numFrames < SLOWTIME_JITTER_PHASE)
+    {
+        slowTimeAccumulate(dft, framesBB, numFrames);
+        return;
+    }
+
+    // Same loop order as slowTimeAccumulate(), with each frame's phasor taken at its logged time. A complex
+    // tone has unit power at every sample, so the Lomb-Scargle fit needs no time offset and is this sum
+    for (int b = 0; b < dft->numBins; b++)
+    {
+        double *row = (double *)&dft->spectrum[(size_t)b * numOfSamplers];
+        double cyclesPerSecond = (double)dft->bins[b] * frameRate / dft->numFrames;
+
+        for (int n = 0; n < numFrames; n++)
+        {
+            const double *frame = (const double *)&framesBB[(size_t)n * numOfSamplers];
+            double cycles = fmod(cyclesPerSecond * (times[n] - dft->startTime), 1.0);
+            double wr = cos(2 * PI * cycles);
+            double wi = -sin(2 * PI * cycles);
+
+            for (int i = 0; i < numOfSamplers; i++)
+            {
+                double xr = frame[2 * i];
+                double xi = frame[2 * i + 1];
+                row[2 * i] += wr * xr - wi * xi;
+                row[2 * i + 1] += wr * xi + wi * xr;
+            }
+        }
+    }
+
+    dft->frame += numFrames;
+    dft->jitterFrames += numFrames;
+}
+
+/**
+ * @function slowTimeSlide(SlowTimeDFT *dft, const double complex *frameIn, const double complex *frameOut)
+ * @param dft - DFT created by slowTimeCreate(), used as a sliding window of numFrames frames
+ * @param frameIn - Newest baseband frame (numOfSamplers)
+ * @param frameOut - Frame leaving the window, NULL while the window is filling
+ * @return None
+ * @brief Sliding DFT update for one frame. Bins stay referenced to frame 0 of the window so the update is
+ *      a single complex multiply-add per bin instead of a rotation of the whole spectrum; magnitudes are
+ *      those of the DFT of the current window
+ * @author ericdvet */
+void slowTimeSlide(SlowTimeDFT *dft, const double complex *frameIn, const double complex *frameOut)
+{
+    int numOfSamplers = dft->numOfSamplers;
+    const double *in = (const double *)frameIn;
+    const double *out = (const double *)frameOut;
+
+    for (int b = 0; b < dft->numBins; b++)
+    {
+        double *row = (double *)&dft->spectrum[(size_t)b * numOfSamplers];
+        int phase = (int)(((long long)dft->bins[b] * dft->frame) % dft->numFrames);
+        double wr = creal(dft->twiddle[phase]);
+        double wi = cimag(dft->twiddle[phase]);
+
+        if (out)
+        {
+            for (int i = 0; i < numOfSamplers; i++)
+            {
+                double xr = in[2 * i] - out[2 * i];
+                double xi = in[2 * i + 1] - out[2 * i + 1];
+                row[2 * i] += wr * xr - wi * xi;
+                row[2 * i + 1] += wr * xi + wi * xr;
+            }
+        }
+        else
+        {
+            for (int i = 0; i < numOfSamplers; i++)
+            {
+                double xr = in[2 * i];
+                double xi = in[2 * i + 1];
+                row[2 * i] += wr * xr - wi * xi;
+                row[2 * i + 1] += wr * xi + wi * xr;
+            }
+        }
+    }
+
+    // The phase reference only matters modulo the window length
+    dft->frame = (dft->frame + 1) % dft->numFrames;
+}
+
+/**
+ * @function slowTimeTagFT(const SlowTimeDFT *dft, int freqTag, double *tagFT)
+ * @param dft - DFT holding the bins returned by slowTimeTagBins()
+ * @param freqTag - Expected frequency bin of the tag
+ * @param tagFT - Resulting magnitude of every range bin at the tag frequency (numOfSamplers)
+ * @return int
+ * @brief Picks the strongest bin of the tag search window freqTag +/- 2, like procRadarFrames(), and
+ *      returns it after filling tagFT
+ * @author ericdvet */
+int slowTimeTagFT(const SlowTimeDFT *dft, int freqTag, double *tagFT)
+{
+    double maxFTPeak = 0;
+    int idx_maxFTPeak = freqTag;
+
+    for (int j = freqTag - 2; j <= freqTag + 2; j++)
+    {
+        const double complex *row = slowTimeBin(dft, j - 1);
+        for (int i = 0; row && i < dft->numOfSamplers; i++)
+        {
+            if (cabs(row[i]) > maxFTPeak)
+            {
+                maxFTPeak = cabs(row[i]);
+                idx_maxFTPeak = j;
+            }
+        }
+    }
+
+    const double complex *tagRow = slowTimeBin(dft, idx_maxFTPeak - 1);
+    for (int i = 0; i < dft->numOfSamplers; i++)
+    {
+        tagFT[i] = tagRow ? cabs(tagRow[i]) : 0;
+    }
+    return idx_maxFTPeak;
+}
+
+/**
+ * @function slowTimeBin(const SlowTimeDFT *dft, int bin)
+ * @param dft - DFT created by slowTimeCreate()
+ * @param bin - Frequency bin, as an index of the numFrames-point FFT
+ * @return double complex *
+ * @brief Returns the spectrum of every range bin at one frequency bin, laid out like a row of
+ *      computeFFT()'s output. NULL if the bin was not requested
+ * @author ericdvet */
+double complex *slowTimeBin(const SlowTimeDFT *dft, int bin)
+{
+    bin = slowTimeWrap(bin, dft->numFrames) - dft->minBin;
+    if (bin < 0 || bin >= dft->binSpan || dft->binIndex[bin] < 0)
+    {
+        return NULL;
+    }
+    return &dft->spectrum[(size_t)dft->binIndex[bin] * dft->numOfSamplers];
+}
+
+/**
+ * @function slowTimeSNR(const SlowTimeDFT *dft, int freqTag, int peakBin)
+ * @param dft - DFT holding the bins returned by slowTimeTagBins()
+ * @param freqTag - FT isolation of backscatter tag
+ * @param peakBin - Determined peak bin location of backscatter tag
+ * @return double
+ * @brief Same signal to noise ratio as calculateSNR(), read from a targeted DFT
+ * @author ericdvet */
+double slowTimeSNR(const SlowTimeDFT *dft, int freqTag, int peakBin)
+{
+    const double complex *signal = slowTimeBin(dft, freqTag - 1);
+    if (!signal)
+    {
+        fprintf(stderr, "ERROR: Tag bin %d was not computed\n", freqTag);
+        return 0;
+    }
+    double signalMag = cabs(signal[peakBin]);
+    double noiseMag = slowTimeNoise(dft, freqTag, peakBin);
+    if (noiseMag == 0)
+    {
+        return 0;
+    }
+
+    return 10 * log10(signalMag / noiseMag);
+}
+
+/**
+ * @function slowTimeNoise(const SlowTimeDFT *dft, int freqTag, int peakBin)
+ * @param dft - DFT holding the bins returned by slowTimeTagBins()
+ * @param freqTag - FT isolation of backscatter tag
+ * @param peakBin - Determined peak bin location of backscatter tag
+ * @return double
+ * @brief Mean magnitude at peakBin over the noise band of calculateSNR(), 0 if a noise bin was not computed
+ * @author ericdvet */
+double slowTimeNoise(const SlowTimeDFT *dft, int freqTag, int peakBin)
+{
+    int noiseFreqLowBound = (int)(freqTag * 0.945);
+    int noiseFreqHighBound = (int)(freqTag * 0.955);
+
+    double noiseMag = 0;
+    for (int j = noiseFreqLowBound; j < noiseFreqHighBound; j++)
+    {
+        const double complex *noise = slowTimeBin(dft, j - 1);
+        if (!noise)
+        {
+            fprintf(stderr, "ERROR: Noise bin %d was not computed\n", j);
+            return 0;
+        }
+        noiseMag += cabs(noise[peakBin]);
+    }
+    return noiseMag / (noiseFreqHighBound - noiseFreqLowBound);
+}
+
+/**
+ * @function slowTimeHarmonicBins(int freqTag, int numHarmonics, int *numBins)
+ * @param freqTag - Expected frequency bin of the tag, as computed by procRadarFrames()
+ * @param numHarmonics - Number of odd harmonics of the tag to combine, 1 for the fundamental alone
+ * @param numBins - Resulting number of frequency bins
+ * @return int *
+ * @brief slowTimeTagBins() plus, for each odd harmonic m, m times the tag search window +/- 1 bin and m
+ *      times the noise band
+ * @author ericdvet */
+int *slowTimeHarmonicBins(int freqTag, int numHarmonics, int *numBins)
+{
+    int numTagBins;
+    int *tagBins = slowTimeTagBins(freqTag, &numTagBins);
+    if (!tagBins)
+    {
+        return NULL;
+    }
+    numHarmonics = numHarmonics < 1 ? 1 : (numHarmonics > SLOWTIME_MAX_HARMONICS ? SLOWTIME_MAX_HARMONICS : numHarmonics);
+
+    // Bins 0 to 4 of slowTimeTagBins() are the search window, the rest the noise band
+    int maxBins = numTagBins + (numHarmonics - 1) * (3 * 5 + numTagBins - 5);
+    int *bins = (int *)realloc(tagBins, maxBins * sizeof(int));
+    if (!bins)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        free(tagBins);
+        return NULL;
+    }
+
+    *numBins = numTagBins;
+    for (int h = 1; h < numHarmonics; h++)
+    {
+        int m = 2 * h + 1;
+        for (int k = 0; k < 5; k++)
+        {
+            for (int d = -1; d <= 1; d++)
+            {
+                bins[(*numBins)++] = m * bins[k] + d;
+            }
+        }
+        for (int k = 5; k < numTagBins; k++)
+        {
+            bins[(*numBins)++] = m * bins[k];
+        }
+    }
+    return bins;
+}
+
+/**
+ * @function slowTimeHarmonicSelect(const SlowTimeDFT *dft, int freqTag, int numHarmonics, bool coherent, int *harmonicBins, double complex *weights)
+ * @param dft - DFT holding the bins returned by slowTimeHarmonicBins()
+ * @param freqTag - Fundamental bin of the tag
+ * @param numHarmonics - Number of odd harmonics to combine
+ * @param coherent - Whether the harmonics are phase aligned
+ * @param harmonicBins - Resulting FFT index of each harmonic in [0, numFrames), -1 if it is left out
+ * @param weights - Resulting factor each harmonic is multiplied by before it is added
+ * @return int
+ * @brief Picks, of the three bins around each odd multiple of the fundamental, the one whose range profile
+ *      correlates best with the fundamental's, since leakage grows with the harmonic. Its weight is 1 / m,
+ *      times the rotation that lines its phase up with the fundamental when coherent. Returns the number
+ *      of harmonics
+ * @author ericdvet */
+static int slowTimeHarmonicSelect(const SlowTimeDFT *dft, int freqTag, int numHarmonics, bool coherent, int *harmonicBins,
+                                  double complex *weights)
+{
+    int numFrames = dft->numFrames;
+    int numOfSamplers = dft->numOfSamplers;
+    numHarmonics = numHarmonics < 1 ? 1 : (numHarmonics > SLOWTIME_MAX_HARMONICS ? SLOWTIME_MAX_HARMONICS : numHarmonics);
+    const double complex *fundamental = slowTimeBin(dft, freqTag - 1);
+
+    harmonicBins[0] = slowTimeWrap(freqTag - 1, numFrames);
+    weights[0] = 1;
+    for (int h = 1; h < numHarmonics; h++)
+    {
+        int m = 2 * h + 1;
+        harmonicBins[h] = -1;
+
+        int center = slowTimeWrap(m * (freqTag - 1), numFrames);
+        int distance = center < numFrames - center ? center : numFrames - center;
+        if (!fundamental || distance <= 1 + (int)(SLOWTIME_DC_GUARD * numFrames))
+        {
+            continue;
+        }
+
+        // A harmonic has the range profile of the fundamental, so its cross-spectrum with the fundamental
+        // summed over range bins picks the bin and phase with every range bin's worth of signal
+        double complex maxCross = 0;
+        for (int d = -1; d <= 1; d++)
+        {
+            const double complex *row = slowTimeBin(dft, m * (freqTag - 1) + d);
+            double complex cross = 0;
+            for (int i = 0; row && i < numOfSamplers; i++)
+            {
+                cross += fundamental[i] * conj(row[i]);
+            }
+            if (row && (harmonicBins[h] < 0 || cabs(cross) > cabs(maxCross)))
+            {
+                maxCross = cross;
+                harmonicBins[h] = slowTimeWrap(m * (freqTag - 1) + d, numFrames);
+            }
+        }
+
+        // Square wave harmonics fall off as 1 / m, which weights the sum towards the stronger ones
+        weights[h] = 1.0 / m;
+        if (coherent && cabs(maxCross) > 0)
+        {
+            weights[h] *= maxCross / cabs(maxCross);
+        }
+    }
+    return numHarmonics;
+}
+
+/**
+ * @function slowTimeHarmonicValue(const SlowTimeDFT *dft, const int *harmonicBins, const double complex *weights, int numHarmonics, bool coherent, int rangeBin)
+ * @param dft - DFT holding the harmonic bins
+ * @param harmonicBins - FFT index of each harmonic, -1 to skip it
+ * @param weights - Combining factor of each harmonic
+ * @param numHarmonics - Number of harmonics
+ * @param coherent - Whether the harmonics are phase aligned
+ * @param rangeBin - Range bin to combine
+ * @return double
+ * @brief Combined magnitude of the harmonics at one range bin
+ * @author ericdvet */
+static double slowTimeHarmonicValue(const SlowTimeDFT *dft, const int *harmonicBins, const double complex *weights, int numHarmonics,
+                                    bool coherent, int rangeBin)
+{
+    double complex sum = 0;
+    double power = 0;
+    for (int h = 0; h < numHarmonics; h++)
+    {
+        const double complex *row = harmonicBins[h] < 0 ? NULL : slowTimeBin(dft, harmonicBins[h]);
+        if (!row)
+        {
+            continue;
+        }
+        double complex value = row[rangeBin] * weights[h];
+        sum += value;
+        power += creal(value) * creal(value) + cimag(value) * cimag(value);
+    }
+    return coherent ? cabs(sum) : sqrt(power);
+}
+
+/**
+ * @function slowTimeHarmonicFT(const SlowTimeDFT *dft, int freqTag, int numHarmonics, bool coherent, double *tagFT)
+ * @param dft - DFT holding the bins returned by slowTimeHarmonicBins()
+ * @param freqTag - Expected frequency bin of the tag
+ * @param numHarmonics - Number of odd harmonics to combine
+ * @param coherent - true to phase align the harmonics to the fundamental before adding them, false to add
+ *      their power. Either way harmonic m is weighted by the 1 / m amplitude of a square wave
+ * @param tagFT - Resulting combined magnitude of every range bin (numOfSamplers)
+ * @return int
+ * @brief slowTimeTagFT() over the fundamental and its odd harmonics. Harmonics that alias onto DC, where
+ *      static clutter sits, are left out. Returns the fundamental bin
+ * @author ericdvet */
+int slowTimeHarmonicFT(const SlowTimeDFT *dft, int freqTag, int numHarmonics, bool coherent, double *tagFT)
+{
+    freqTag = slowTimeTagFT(dft, freqTag, tagFT);
+
+    int harmonicBins[SLOWTIME_MAX_HARMONICS];
+    double complex weights[SLOWTIME_MAX_HARMONICS];
+    numHarmonics = slowTimeHarmonicSelect(dft, freqTag, numHarmonics, coherent, harmonicBins, weights);
+    for (int i = 0; i < dft->numOfSamplers; i++)
+    {
+        tagFT[i] = slowTimeHarmonicValue(dft, harmonicBins, weights, numHarmonics, coherent, i);
+    }
+    return freqTag;
+}
+
+/**
+ * @function slowTimeHarmonicSNR(const SlowTimeDFT *dft, int freqTag, int numHarmonics, bool coherent, int peakBin)
+ * @param dft - DFT holding the bins returned by slowTimeHarmonicBins()
+ * @param freqTag - Fundamental bin returned by slowTimeHarmonicFT()
+ * @param numHarmonics - Number of odd harmonics combined
+ * @param coherent - Combining used by slowTimeHarmonicFT()
+ * @param peakBin - Determined peak bin location of backscatter tag
+ * @return double
+ * @brief slowTimeSNR() of the combined harmonics, with the noise band of each harmonic combined the same way
+ * @author ericdvet */
+double slowTimeHarmonicSNR(const SlowTimeDFT *dft, int freqTag, int numHarmonics, bool coherent, int peakBin)
+{
+    if (peakBin < 0 || peakBin >= dft->numOfSamplers)
+    {
+        return 0;
+    }
+
+    int harmonicBins[SLOWTIME_MAX_HARMONICS];
+    int noiseBins[SLOWTIME_MAX_HARMONICS];
+    double complex weights[SLOWTIME_MAX_HARMONICS];
+    numHarmonics = slowTimeHarmonicSelect(dft, freqTag, numHarmonics, coherent, harmonicBins, weights);
+    double signalMag = slowTimeHarmonicValue(dft, harmonicBins, weights, numHarmonics, coherent, peakBin);
+
+    int noiseFreqLowBound = (int)(freqTag * 0.945);
+    int noiseFreqHighBound = (int)(freqTag * 0.955);
+
+    double noiseMag = 0;
+    for (int j = noiseFreqLowBound; j < noiseFreqHighBound; j++)
+    {
+        for (int h = 0; h < numHarmonics; h++)
+        {
+            noiseBins[h] = harmonicBins[h] < 0 ? -1 : slowTimeWrap((2 * h + 1) * (j - 1), dft->numFrames);
+        }
+        noiseMag += slowTimeHarmonicValue(dft, noiseBins, weights, numHarmonics, coherent, peakBin);
+    }
+    if (noiseMag == 0)
+    {
+        return 0;
+    }
+    noiseMag = noiseMag / (noiseFreqHighBound - noiseFreqLowBound);
+
+    return 10 * log10(signalMag / noiseMag);
+}
+
+/**
+ * @function slowTimeFree(SlowTimeDFT *dft)
+ * @param dft - SlowTimeDFT to free
+ * @return None
+ * @brief Free a SlowTimeDFT constructed by slowTimeCreate()
+ * @author ericdvet */
+void slowTimeFree(SlowTimeDFT *dft)
+{
+    if (dft)
+    {
+        free(dft->bins);
+        free(dft->binIndex);
+        free(dft->twiddle);
+        free(dft->spectrum);
+        free(dft);
+    }
+}
+
+// #define SLOWTIME_TEST
+
+#ifdef SLOWTIME_TEST
+int main()
+{
+    int numFrames = 400;
+    int numOfSamplers = 512;
+    int freqTag = (int)(80.0 / 200 * numFrames);
+    double complex *framesBB = (double complex *)malloc(numFrames * numOfSamplers * sizeof(double complex));
+    double complex *captureFT = (double complex *)malloc(numFrames * numOfSamplers * sizeof(double complex));
+
+    for (int n = 0; n < numFrames; n++)
+    {
+        for (int i = 0; i < numOfSamplers; i++)
+        {
+            framesBB[n * numOfSamplers + i] = cexp(I * 2 * PI * 80.0 / 200 * n) * exp(-pow(i - 200, 2) / 50.0) +
+                                              0.01 * (rand() % 100) + 0.01 * I * (rand() % 100);
+        }
+    }
+    computeFFT(framesBB, captureFT, numFrames, numOfSamplers);
+
+    int numBins;
+    int *bins = slowTimeTagBins(freqTag, &numBins);
+    SlowTimeDFT *dft = slowTimeCreate(numFrames, numOfSamplers, bins, numBins);
+
+    // Feed the frames in uneven blocks as a stream would
+    for (int n = 0; n < numFrames; n += 37)
+    {
+        int blockFrames = numFrames - n < 37 ? numFrames - n : 37;
+        slowTimeAccumulate(dft, &framesBB[n * numOfSamplers], blockFrames);
+    }
+
+    double maxError = 0;
+    for (int b = 0; b < numBins; b++)
+    {
+        double complex *row = slowTimeBin(dft, bins[b]);
+        for (int i = 0; i < numOfSamplers; i++)
+        {
+            maxError = fmax(maxError, cabs(row[i] - captureFT[bins[b] * numOfSamplers + i]));
+        }
+    }
+    printf("%d bins, max error against computeFFT(): %g\n", dft->numBins, maxError);
+    printf("SNR %f (calculateSNR %f)\n", slowTimeSNR(dft, freqTag, 200), calculateSNR(captureFT, numOfSamplers, freqTag, 200));
+    slowTimeFree(dft);
+    free(bins);
+
+    // Tag switched by a 30 Hz square wave, whose harmonics land at 90, -50 and 10 Hz. The noise band is only a
+    // couple of bins wide, so the SNR is averaged over trials
+    int squareTag = (int)(30.0 / 200 * numFrames);
+    int numTrials = 50;
+    double meanSNR[2][2] = {{0}};
+    double *tagFT = (double *)malloc(numOfSamplers * sizeof(double));
+    for (int trial = 0; trial < numTrials; trial++)
+    {
+        for (int n = 0; n < numFrames; n++)
+        {
+            double square = sin(2 * PI * 30.0 / 200 * (n + 0.5)) > 0 ? 1 : -1;
+            for (int i = 0; i < numOfSamplers; i++)
+            {
+                framesBB[n * numOfSamplers + i] = 0.1 * square * exp(-pow(i - 200, 2) / 50.0) + 0.01 * (rand() % 100) + 0.01 * I * (rand() % 100);
+            }
+        }
+        for (int k = 0; k < 2; k++)
+        {
+            int numHarmonics = k == 0 ? 1 : 4;
+            bins = slowTimeHarmonicBins(squareTag, numHarmonics, &numBins);
+            dft = slowTimeCreate(numFrames, numOfSamplers, bins, numBins);
+            slowTimeAccumulate(dft, framesBB, numFrames);
+            for (int coherent = 0; coherent <= 1; coherent++)
+            {
+                int tagBin = slowTimeHarmonicFT(dft, squareTag, numHarmonics, coherent, tagFT);
+                meanSNR[k][coherent] += slowTimeHarmonicSNR(dft, tagBin, numHarmonics, coherent, 200) / numTrials;
+            }
+            slowTimeFree(dft);
+            free(bins);
+        }
+    }
+    printf("Fundamental: SNR %f dB\n", meanSNR[0][0]);
+    printf("4 harmonics: SNR %f dB non-coherent, %f dB coherent\n", meanSNR[1][0], meanSNR[1][1]);
+
+    // Frames logged up to 2 ms late, and from halfway on paced at 190 Hz instead of 200 Hz. The 80 Hz tag
+    // smears on the nominal grid but is recovered at the logged times. Perfect times take the uniform path
+    double *times = (double *)malloc(numFrames * sizeof(double));
+    double *exactTimes = (double *)malloc(numFrames * sizeof(double));
+    for (int n = 0; n < numFrames; n++)
+    {
+        exactTimes[n] = n / 200.0;
+        times[n] = (n < numFrames / 2 ? n / 200.0 : (numFrames / 2) / 200.0 + (n - numFrames / 2) / 190.0) + 0.002 * (rand() % 100) / 100.0;
+        for (int i = 0; i < numOfSamplers; i++)
+        {
+            framesBB[n * numOfSamplers + i] = cexp(I * 2 * PI * 80.0 * times[n]) * exp(-pow(i - 200, 2) / 50.0) + 0.01 * (rand() % 100) +
+                                              0.01 * I * (rand() % 100);
+        }
+    }
+    bins = slowTimeTagBins(freqTag, &numBins);
+    SlowTimeDFT *uniform = slowTimeCreate(numFrames, numOfSamplers, bins, numBins);
+    SlowTimeDFT *timed = slowTimeCreate(numFrames, numOfSamplers, bins, numBins);
+    SlowTimeDFT *exact = slowTimeCreate(numFrames, numOfSamplers, bins, numBins);
+    for (int n = 0; n < numFrames; n += 64)
+    {
+        int blockFrames = numFrames - n < 64 ? numFrames - n : 64;
+        slowTimeAccumulate(uniform, &framesBB[n * numOfSamplers], blockFrames);
+        slowTimeAccumulateTimes(timed, &framesBB[n * numOfSamplers], &times[n], blockFrames, 200);
+        slowTimeAccumulateTimes(exact, &framesBB[n * numOfSamplers], &exactTimes[n], blockFrames, 200);
+    }
+    slowTimeTagFT(uniform, freqTag, tagFT);
+    double uniformPeak = tagFT[200];
+    slowTimeTagFT(timed, freqTag, tagFT);
+    printf("Jittered capture: tag FT %f on the nominal grid, %f at logged times (%d of %d frames exact), ideal %d\n", uniformPeak,
+           tagFT[200], timed->jitterFrames, numFrames, numFrames);
+    printf("Perfect timestamps: %d frames exact\n", exact->jitterFrames);
+    slowTimeFree(uniform);
+    slowTimeFree(timed);
+    slowTimeFree(exact);
+    free(bins);
+    free(times);
+    free(exactTimes);
+    free(tagFT);
+    free(framesBB);
+    free(captureFT);
+    return 0;
+}
+#endif
@@ -0,0 +1,181 @@
+/*
+ * File:   slowtime.h
+ * Author: ericdvet
+ *
+ * Slow-time spectral estimates of a few frequency bins, accumulated while frames are downconverted
+ */
+
+#ifndef SLOWTIME_H
+#define SLOWTIME_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <complex.h>
+
+/**
+ * @struct SlowTimeDFT
+ * @brief Running slow-time DFT of every range bin at a chosen set of frequency bins
+ * @author ericdvet */
+typedef struct
+{
+    int numFrames;
+    int numOfSamplers;
+    int numBins;
+    int *bins;
+    int *binIndex;
+    int minBin;
+    int binSpan;
+    double complex *twiddle;
+    double complex *spectrum;
+    int frame;
+    double startTime;  // timestamp of frame 0 with slowTimeAccumulateTimes()
+    double lastTime;   // timestamp of the latest frame with slowTimeAccumulateTimes()
+    int jitterFrames;  // frames slowTimeAccumulateTimes() had to place at their logged times
+} SlowTimeDFT;
+
+/**
+ * @function slowTimeCreate(int numFrames, int numOfSamplers, const int *bins, int numBins)
+ * @param numFrames - Length of the slow-time DFT (frames in the capture)
+ * @param numOfSamplers - Number of range bins per frame
+ * @param bins - Frequency bins to compute, as indices of the numFrames-point FFT
+ * @param numBins - Number of frequency bins
+ * @return SlowTimeDFT *
+ * @brief Prepares a DFT that only evaluates the given frequency bins. Duplicate bins are computed once
+ * @author ericdvet */
+SlowTimeDFT *slowTimeCreate(int numFrames, int numOfSamplers, const int *bins, int numBins);
+
+/**
+ * @function slowTimeTagBins(int freqTag, int *numBins)
+ * @param freqTag - Expected frequency bin of the tag, as computed by procRadarFrames()
+ * @param numBins - Resulting number of frequency bins
+ * @return int *
+ * @brief Returns the FFT indices read by procRadarFrames() and calculateSNR(): the tag search window
+ *      freqTag +/- 2 and the noise band 0.945 to 0.955 times the tag frequency
+ * @author ericdvet */
+int *slowTimeTagBins(int freqTag, int *numBins);
+
+/**
+ * @function slowTimeAccumulate(SlowTimeDFT *dft, const double complex *framesBB, int numFrames)
+ * @param dft - DFT created by slowTimeCreate()
+ * @param framesBB - Next baseband frames of the capture (numFrames x numOfSamplers)
+ * @param numFrames - Number of frames in the block
+ * @return None
+ * @brief Adds a block of frames to the running DFT. Blocks must be passed in capture order
+ * @author ericdvet */
+void slowTimeAccumulate(SlowTimeDFT *dft, const double complex *framesBB, int numFrames);
+
+/**
+ * @function slowTimeAccumulateTimes(SlowTimeDFT *dft, const double complex *framesBB, const double *times, int numFrames, double frameRate)
+ * @param dft - DFT created by slowTimeCreate()
+ * @param framesBB - Next baseband frames of the capture (numFrames x numOfSamplers)
+ * @param times - Logged time of each frame in seconds, RadarData.times (numFrames)
+ * @param numFrames - Number of frames in the block
+ * @param frameRate - Nominal frame rate in Hz, bin k stands for k * frameRate / dft->numFrames Hz
+ * @return None
+ * @brief slowTimeAccumulate() on the frames' logged times instead of a perfect frame grid, the least squares
+ *      (Lomb-Scargle) fit of a complex tone at each bin frequency. A block whose times stay within
+ *      SLOWTIME_JITTER_PHASE of the grid at every bin takes the uniform twiddles, so only jittery blocks
+ *      pay for exact phasors. Blocks whose times do not increase are taken as uniform
+ * @author ericdvet */
+void slowTimeAccumulateTimes(SlowTimeDFT *dft, const double complex *framesBB, const double *times, int numFrames, double frameRate);
+
+/**
+ * @function slowTimeSlide(SlowTimeDFT *dft, const double complex *frameIn, const double complex *frameOut)
+ * @param dft - DFT created by slowTimeCreate(), used as a sliding window of numFrames frames
+ * @param frameIn - Newest baseband frame (numOfSamplers)
+ * @param frameOut - Frame leaving the window, NULL while the window is filling
+ * @return None
+ * @brief Sliding DFT update for one frame. Bins stay referenced to frame 0 of the window so the update is
+ *      a single complex multiply-add per bin instead of a rotation of the whole spectrum; magnitudes are
+ *      those of the DFT of the current window
+ * @author ericdvet */
+void slowTimeSlide(SlowTimeDFT *dft, const double complex *frameIn, const double complex *frameOut);
+
+/**
+ * @function slowTimeTagFT(const SlowTimeDFT *dft, int freqTag, double *tagFT)
+ * @param dft - DFT holding the bins returned by slowTimeTagBins()
+ * @param freqTag - Expected frequency bin of the tag
+ * @param tagFT - Resulting magnitude of every range bin at the tag frequency (numOfSamplers)
+ * @return int
+ * @brief Picks the strongest bin of the tag search window freqTag +/- 2, like procRadarFrames(), and
+ *      returns it after filling tagFT
+ * @author ericdvet */
+int slowTimeTagFT(const SlowTimeDFT *dft, int freqTag, double *tagFT);
+
+/**
+ * @function slowTimeBin(const SlowTimeDFT *dft, int bin)
+ * @param dft - DFT created by slowTimeCreate()
+ * @param bin - Frequency bin, as an index of the numFrames-point FFT
+ * @return double complex *
+ * @brief Returns the spectrum of every range bin at one frequency bin, laid out like a row of
+ *      computeFFT()'s output. NULL if the bin was not requested
+ * @author ericdvet */
+double complex *slowTimeBin(const SlowTimeDFT *dft, int bin);
+
+/**
+ * @function slowTimeSNR(const SlowTimeDFT *dft, int freqTag, int peakBin)
+ * @param dft - DFT holding the bins returned by slowTimeTagBins()
+ * @param freqTag - FT isolation of backscatter tag
+ * @param peakBin - Determined peak bin location of backscatter tag
+ * @return double
+ * @brief Same signal to noise ratio as calculateSNR(), read from a targeted DFT
+ * @author ericdvet */
+double slowTimeSNR(const SlowTimeDFT *dft, int freqTag, int peakBin);
+
+/**
+ * @function slowTimeNoise(const SlowTimeDFT *dft, int freqTag, int peakBin)
+ * @param dft - DFT holding the bins returned by slowTimeTagBins()
+ * @param freqTag - FT isolation of backscatter tag
+ * @param peakBin - Determined peak bin location of backscatter tag
+ * @return double
+ * @brief Mean magnitude at peakBin over the noise band of calculateSNR(), 0 if a noise bin was not computed
+ * @author ericdvet */
+double slowTimeNoise(const SlowTimeDFT *dft, int freqTag, int peakBin);
+
+/**
+ * @function slowTimeHarmonicBins(int freqTag, int numHarmonics, int *numBins)
+ * @param freqTag - Expected frequency bin of the tag, as computed by procRadarFrames()
+ * @param numHarmonics - Number of odd harmonics of the tag to combine, 1 for the fundamental alone
+ * @param numBins - Resulting number of frequency bins
+ * @return int *
+ * @brief slowTimeTagBins() plus, for each odd harmonic m, m times the tag search window +/- 1 bin and m
+ *      times the noise band
+ * @author ericdvet */
+int *slowTimeHarmonicBins(int freqTag, int numHarmonics, int *numBins);
+
+/**
+ * @function slowTimeHarmonicFT(const SlowTimeDFT *dft, int freqTag, int numHarmonics, bool coherent, double *tagFT)
+ * @param dft - DFT holding the bins returned by slowTimeHarmonicBins()
+ * @param freqTag - Expected frequency bin of the tag
+ * @param numHarmonics - Number of odd harmonics to combine
+ * @param coherent - true to phase align the harmonics to the fundamental before adding them, false to add
+ *      their power. Either way harmonic m is weighted by the 1 / m amplitude of a square wave
+ * @param tagFT - Resulting combined magnitude of every range bin (numOfSamplers)
+ * @return int
+ * @brief slowTimeTagFT() over the fundamental and its odd harmonics. Harmonics that alias onto DC, where
+ *      static clutter sits, are left out. Returns the fundamental bin
+ * @author ericdvet */
+int slowTimeHarmonicFT(const SlowTimeDFT *dft, int freqTag, int numHarmonics, bool coherent, double *tagFT);
+
+/**
+ * @function slowTimeHarmonicSNR(const SlowTimeDFT *dft, int freqTag, int numHarmonics, bool coherent, int peakBin)
+ * @param dft - DFT holding the bins returned by slowTimeHarmonicBins()
+ * @param freqTag - Fundamental bin returned by slowTimeHarmonicFT()
+ * @param numHarmonics - Number of odd harmonics combined
+ * @param coherent - Combining used by slowTimeHarmonicFT()
+ * @param peakBin - Determined peak bin location of backscatter tag
+ * @return double
+ * @brief slowTimeSNR() of the combined harmonics, with the noise band of each harmonic combined the same way
+ * @author ericdvet */
+double slowTimeHarmonicSNR(const SlowTimeDFT *dft, int freqTag, int numHarmonics, bool coherent, int peakBin);
+
+/**
+ * @function slowTimeFree(SlowTimeDFT *dft)
+ * @param dft - SlowTimeDFT to free
+ * @return None
+ * @brief Free a SlowTimeDFT constructed by slowTimeCreate()
+ * @author ericdvet */
+void slowTimeFree(SlowTimeDFT *dft);
+
+#endif // SLOWTIME_H
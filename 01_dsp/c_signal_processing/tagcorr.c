@@ -0,0 +1,235 @@
+/*
+ * File:   tagcorr.c
+ * Author: ericdvet
+ *
+ * Tag localization by circular Pearson correlation of a tag FT against a template capture
+ */
+
+#include "tagcorr.h"
+#include <math.h>
+#include <string.h>
+
+// Candidate peaks must reach this fraction of the largest tag FT value
+#define TAGCORR_PEAK_HEIGHT 0.90
+
+/**
+ * @function tagTemplateCreate(const double *templateFT, int numOfSamplers, int peakBin)
+ * @param templateFT - Tag FT of a capture with a strong tag, e.g. in air with a clear line of sight
+ * @param numOfSamplers - Number of range bins in templateFT
+ * @param peakBin - Peak bin of the tag in the template capture
+ * @return TagTemplate *
+ * @brief Precomputes the conjugate spectrum of the mean-removed, unit-norm template
+ * @author ericdvet */
+TagTemplate *tagTemplateCreate(const double *templateFT, int numOfSamplers, int peakBin)
+{
+    if (numOfSamplers < 2 || peakBin < 0 || peakBin >= numOfSamplers)
+    {
+        fprintf(stderr, "ERROR: Invalid tag template\n");
+        return NULL;
+    }
+
+    TagTemplate *tagTemplate = (TagTemplate *)calloc(1, sizeof(TagTemplate));
+    if (!tagTemplate)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        return NULL;
+    }
+    tagTemplate->numOfSamplers = numOfSamplers;
+    tagTemplate->peakBin = peakBin;
+
+    int numFreqs = numOfSamplers / 2 + 1;
+    tagTemplate->spectrum = (double complex *)fftw_malloc(numFreqs * sizeof(double complex));
+    tagTemplate->signal = (double *)fftw_malloc(numOfSamplers * sizeof(double));
+    tagTemplate->signalFT = (double complex *)fftw_malloc(numFreqs * sizeof(double complex));
+    tagTemplate->correlation = (double *)fftw_malloc(numOfSamplers * sizeof(double));
+    if (!tagTemplate->spectrum || !tagTemplate->signal || !tagTemplate->signalFT || !tagTemplate->correlation)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        tagTemplateFree(tagTemplate);
+        return NULL;
+    }
+
+    fftw_complex *signalFT = (fftw_complex *)tagTemplate->signalFT;
+    tagTemplate->forward = fftw_plan_dft_r2c_1d(numOfSamplers, tagTemplate->signal, signalFT, FFTW_MEASURE);
+    tagTemplate->inverse = fftw_plan_dft_c2r_1d(numOfSamplers, signalFT, tagTemplate->correlation, FFTW_MEASURE);
+    if (!tagTemplate->forward || !tagTemplate->inverse)
+    {
+        fprintf(stderr, "ERROR: Unable to plan template FFTs\n");
+        tagTemplateFree(tagTemplate);
+        return NULL;
+    }
+
+    // Circular shifts keep the mean and norm of the template, so normalizing it once here leaves only the
+    // capture's norm to divide by. The 1 / numOfSamplers of the inverse FFT is folded in as well
+    double mean = 0;
+    for (int i = 0; i < numOfSamplers; i++)
+    {
+        mean += templateFT[i];
+    }
+    mean /= numOfSamplers;
+    double energy = 0;
+    for (int i = 0; i < numOfSamplers; i++)
+    {
+        tagTemplate->signal[i] = templateFT[i] - mean;
+        energy += tagTemplate->signal[i] * tagTemplate->signal[i];
+    }
+    if (energy == 0)
+    {
+        fprintf(stderr, "ERROR: Tag template is flat\n");
+        tagTemplateFree(tagTemplate);
+        return NULL;
+    }
+
+    fftw_execute(tagTemplate->forward);
+    double scale = 1.0 / (sqrt(energy) * numOfSamplers);
+    for (int k = 0; k < numFreqs; k++)
+    {
+        tagTemplate->spectrum[k] = conj(tagTemplate->signalFT[k]) * scale;
+    }
+
+    return tagTemplate;
+}
+
+/**
+ * @function tagTemplateLocate(TagTemplate *tagTemplate, const double *tagFT)
+ * @param tagTemplate - Template created by tagTemplateCreate()
+ * @param tagFT - Tag FT of the capture (numOfSamplers)
+ * @return int
+ * @brief Finds the circular shift of the template with the highest Pearson correlation to tagFT with one
+ *      FFT cross-correlation, then returns the peak of tagFT within 90% of its maximum that is closest to
+ *      the shifted template peak, like tag_correlation.m. lag and coefficient hold the best shift
+ * @author ericdvet */
+int tagTemplateLocate(TagTemplate *tagTemplate, const double *tagFT)
+{
+    int numOfSamplers = tagTemplate->numOfSamplers;
+    int numFreqs = numOfSamplers / 2 + 1;
+
+    double mean = 0;
+    double maxTagFT = 0;
+    for (int i = 0; i < numOfSamplers; i++)
+    {
+        mean += tagFT[i];
+        maxTagFT = fmax(maxTagFT, tagFT[i]);
+    }
+    mean /= numOfSamplers;
+    double energy = 0;
+    for (int i = 0; i < numOfSamplers; i++)
+    {
+        tagTemplate->signal[i] = tagFT[i] - mean;
+        energy += tagTemplate->signal[i] * tagTemplate->signal[i];
+    }
+
+    // correlation[lag] = sum_i (tagFT[i] - mean) * template[i - lag], circularly
+    fftw_execute(tagTemplate->forward);
+    for (int k = 0; k < numFreqs; k++)
+    {
+        tagTemplate->signalFT[k] *= tagTemplate->spectrum[k];
+    }
+    fftw_execute(tagTemplate->inverse);
+
+    int lag = 0;
+    for (int i = 1; i < numOfSamplers; i++)
+    {
+        if (tagTemplate->correlation[i] > tagTemplate->correlation[lag])
+        {
+            lag = i;
+        }
+    }
+    tagTemplate->lag = lag;
+    tagTemplate->coefficient = energy > 0 ? tagTemplate->correlation[lag] / sqrt(energy) : 0;
+
+    // Snap the shifted template peak to the nearest strong peak of the capture
+    int expectedBin = (tagTemplate->peakBin + lag) % numOfSamplers;
+    int peakBin = expectedBin;
+    int closestDistance = numOfSamplers;
+    for (int i = 1; i < numOfSamplers - 1; i++)
+    {
+        if (tagFT[i] > tagFT[i - 1] && tagFT[i] > tagFT[i + 1] && tagFT[i] >= TAGCORR_PEAK_HEIGHT * maxTagFT &&
+            abs(i - expectedBin) < closestDistance)
+        {
+            closestDistance = abs(i - expectedBin);
+            peakBin = i;
+        }
+    }
+
+    return peakBin;
+}
+
+/**
+ * @function tagTemplateFree(TagTemplate *tagTemplate)
+ * @param tagTemplate - TagTemplate to free
+ * @return None
+ * @brief Free a TagTemplate constructed by tagTemplateCreate()
+ * @author ericdvet */
+void tagTemplateFree(TagTemplate *tagTemplate)
+{
+    if (tagTemplate)
+    {
+        if (tagTemplate->forward)
+        {
+            fftw_destroy_plan(tagTemplate->forward);
+        }
+        if (tagTemplate->inverse)
+        {
+            fftw_destroy_plan(tagTemplate->inverse);
+        }
+        fftw_free(tagTemplate->spectrum);
+        fftw_free(tagTemplate->signal);
+        fftw_free(tagTemplate->signalFT);
+        fftw_free(tagTemplate->correlation);
+        free(tagTemplate);
+    }
+}
+
+// #define TAGCORR_TEST
+
+#ifdef TAGCORR_TEST
+
+int main()
+{
+    int numOfSamplers = 512;
+    double *templateFT = (double *)malloc(numOfSamplers * sizeof(double));
+    double *tagFT = (double *)malloc(numOfSamplers * sizeof(double));
+
+    // Air template with the tag at 200, capture shifted by 57 bins with a weaker clutter peak at 100
+    for (int i = 0; i < numOfSamplers; i++)
+    {
+        templateFT[i] = exp(-pow(i - 200, 2) / 100.0) + 0.4 * exp(-pow(i - 215, 2) / 30.0);
+        tagFT[i] = 0.8 * exp(-pow(i - 257, 2) / 100.0) + 0.32 * exp(-pow(i - 272, 2) / 30.0) + 0.75 * exp(-pow(i - 100, 2) / 20.0) +
+                   0.01 * (rand() % 100) / 100.0;
+    }
+
+    TagTemplate *tagTemplate = tagTemplateCreate(templateFT, numOfSamplers, 200);
+    int peakBin = tagTemplateLocate(tagTemplate, tagFT);
+
+    // Brute force Pearson correlation over every circular shift
+    double templateMean = 0, tagMean = 0;
+    for (int i = 0; i < numOfSamplers; i++)
+    {
+        templateMean += templateFT[i] / numOfSamplers;
+        tagMean += tagFT[i] / numOfSamplers;
+    }
+    double maxError = 0;
+    for (int lag = 0; lag < numOfSamplers; lag++)
+    {
+        double sxy = 0, sxx = 0, syy = 0;
+        for (int i = 0; i < numOfSamplers; i++)
+        {
+            double x = templateFT[(i - lag + numOfSamplers) % numOfSamplers] - templateMean;
+            double y = tagFT[i] - tagMean;
+            sxy += x * y;
+            sxx += x * x;
+            syy += y * y;
+        }
+        double norm = sqrt(sxx * syy);
+        maxError = fmax(maxError, fabs(sxy / norm - tagTemplate->correlation[lag] / sqrt(syy)));
+    }
+
+    printf("Peak bin %d (lag %d, r = %.3f), max error against brute force %g\n", peakBin, tagTemplate->lag, tagTemplate->coefficient, maxError);
+
+    tagTemplateFree(tagTemplate);
+    free(templateFT);
+    free(tagFT);
+    return 0;
+}
+#endif
@@ -0,0 +1,63 @@
+/*
+ * File:   tagcorr.h
+ * Author: ericdvet
+ *
+ * Tag localization by circular Pearson correlation of a tag FT against a template capture
+ */
+
+#ifndef TAGCORR_H
+#define TAGCORR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <complex.h>
+#include <fftw3.h>
+
+/**
+ * @struct TagTemplate
+ * @brief Normalized spectrum of a template tag FT and the FFT plans used to correlate captures with it
+ * @author ericdvet */
+typedef struct
+{
+    int numOfSamplers;
+    int peakBin;
+    double complex *spectrum;
+    double *signal;
+    double complex *signalFT;
+    double *correlation;
+    fftw_plan forward;
+    fftw_plan inverse;
+    int lag;
+    double coefficient;
+} TagTemplate;
+
+/**
+ * @function tagTemplateCreate(const double *templateFT, int numOfSamplers, int peakBin)
+ * @param templateFT - Tag FT of a capture with a strong tag, e.g. in air with a clear line of sight
+ * @param numOfSamplers - Number of range bins in templateFT
+ * @param peakBin - Peak bin of the tag in the template capture
+ * @return TagTemplate *
+ * @brief Precomputes the conjugate spectrum of the mean-removed, unit-norm template
+ * @author ericdvet */
+TagTemplate *tagTemplateCreate(const double *templateFT, int numOfSamplers, int peakBin);
+
+/**
+ * @function tagTemplateLocate(TagTemplate *tagTemplate, const double *tagFT)
+ * @param tagTemplate - Template created by tagTemplateCreate()
+ * @param tagFT - Tag FT of the capture (numOfSamplers)
+ * @return int
+ * @brief Finds the circular shift of the template with the highest Pearson correlation to tagFT with one
+ *      FFT cross-correlation, then returns the peak of tagFT within 90% of its maximum that is closest to
+ *      the shifted template peak, like tag_correlation.m. lag and coefficient hold the best shift
+ * @author ericdvet */
+int tagTemplateLocate(TagTemplate *tagTemplate, const double *tagFT);
+
+/**
+ * @function tagTemplateFree(TagTemplate *tagTemplate)
+ * @param tagTemplate - TagTemplate to free
+ * @return None
+ * @brief Free a TagTemplate constructed by tagTemplateCreate()
+ * @author ericdvet */
+void tagTemplateFree(TagTemplate *tagTemplate);
+
+#endif // TAGCORR_H
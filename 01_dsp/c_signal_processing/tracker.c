@@ -0,0 +1,169 @@
+/*
+ * File:   tracker.c
+ * Author: ericdvet
+ *
+ * Real-time tag tracking over a continuous stream of baseband frames using a sliding slow-time DFT
+ */
+
+#include "tracker.h"
+#include "proc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+
+/**
+ * @function trackerCreate(int windowFrames, int numOfSamplers, int frameRate, double tagHz, int updateFrames)
+ * @param windowFrames - Number of most recent frames the tag spectrum is computed over
+ * @param numOfSamplers - Number of baseband samples per frame
+ * @param frameRate - Frame rate of the radar in Hz
+ * @param tagHz - Frequency at which tag is oscillating in Hz
+ * @param updateFrames - Number of frames between tag estimates once the window is full
+ * @return TagTracker *
+ * @brief Creates a tracker that keeps the slow-time DFT of every range bin at the tag and SNR noise
+ *      frequencies of procRadarFrames() up to date frame by frame
+ * @author ericdvet */
+TagTracker *trackerCreate(int windowFrames, int numOfSamplers, int frameRate, double tagHz, int updateFrames)
+{
+    if (windowFrames < 1 || updateFrames < 1)
+    {
+        fprintf(stderr, "ERROR: Invalid tracker window\n");
+        return NULL;
+    }
+
+    TagTracker *tracker = (TagTracker *)calloc(1, sizeof(TagTracker));
+    if (!tracker)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        return NULL;
+    }
+    tracker->windowFrames = windowFrames;
+    tracker->numOfSamplers = numOfSamplers;
+    tracker->updateFrames = updateFrames;
+    tracker->freqTag = (int)(tagHz / frameRate * windowFrames);
+
+    int numBins;
+    int *bins = slowTimeTagBins(tracker->freqTag, &numBins);
+    if (bins)
+    {
+        tracker->dft = slowTimeCreate(windowFrames, numOfSamplers, bins, numBins);
+        free(bins);
+    }
+    tracker->history = (double complex *)calloc((size_t)windowFrames * numOfSamplers, sizeof(double complex));
+    tracker->tagFT = (double *)calloc(numOfSamplers, sizeof(double));
+    if (!tracker->dft || !tracker->history || !tracker->tagFT)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        trackerFree(tracker);
+        return NULL;
+    }
+
+    return tracker;
+}
+
+/**
+ * @function trackerPush(TagTracker *tracker, const double complex *frameBB)
+ * @param tracker - Tracker created by trackerCreate()
+ * @param frameBB - Next baseband frame (numOfSamplers), e.g. from NoveldaDDC()
+ * @return bool
+ * @brief Slides the window by one frame. Returns true when tagFT, tagBin, peakBin and SNRdB hold a new
+ *      estimate, every updateFrames frames once the window is full
+ * @author ericdvet */
+bool trackerPush(TagTracker *tracker, const double complex *frameBB)
+{
+    int windowFrames = tracker->windowFrames;
+    int numOfSamplers = tracker->numOfSamplers;
+    int slot = (int)(tracker->frame % windowFrames);
+    double complex *oldest = &tracker->history[(size_t)slot * numOfSamplers];
+
+    slowTimeSlide(tracker->dft, frameBB, tracker->frame >= windowFrames ? oldest : NULL);
+    memcpy(oldest, frameBB, numOfSamplers * sizeof(double complex));
+    tracker->frame++;
+
+    // History slot k holds the frame with phase reference k, so once per window the sliding sums are
+    // recomputed from it to stop rounding error from building up
+    if (tracker->frame % windowFrames == 0)
+    {
+        memset(tracker->dft->spectrum, 0, (size_t)tracker->dft->numBins * numOfSamplers * sizeof(double complex));
+        tracker->dft->frame = 0;
+        slowTimeAccumulate(tracker->dft, tracker->history, windowFrames);
+        tracker->dft->frame = 0;
+    }
+
+    if (tracker->frame < windowFrames || (tracker->frame - windowFrames) % tracker->updateFrames != 0)
+    {
+        return false;
+    }
+
+    tracker->tagBin = slowTimeTagFT(tracker->dft, tracker->freqTag, tracker->tagFT);
+    tracker->peakBin = procCaptureCWT(tracker->tagFT, numOfSamplers);
+    tracker->SNRdB = slowTimeSNR(tracker->dft, tracker->tagBin, tracker->peakBin);
+    return true;
+}
+
+/**
+ * @function trackerFree(TagTracker *tracker)
+ * @param tracker - TagTracker to free
+ * @return None
+ * @brief Free a TagTracker constructed by trackerCreate()
+ * @author ericdvet */
+void trackerFree(TagTracker *tracker)
+{
+    if (tracker)
+    {
+        slowTimeFree(tracker->dft);
+        free(tracker->history);
+        free(tracker->tagFT);
+        free(tracker);
+    }
+}
+
+// #define TRACKER_TEST
+
+#ifdef TRACKER_TEST
+#include "utils.h"
+
+int main()
+{
+    int windowFrames = 400;
+    int numOfSamplers = 512;
+    int frameRate = 200;
+    int totalFrames = 1000;
+    double tagHz = 80;
+    TagTracker *tracker = trackerCreate(windowFrames, numOfSamplers, frameRate, tagHz, 100);
+
+    double complex *framesBB = (double complex *)malloc((size_t)totalFrames * numOfSamplers * sizeof(double complex));
+    double complex *windowFT = (double complex *)malloc((size_t)windowFrames * numOfSamplers * sizeof(double complex));
+    for (int n = 0; n < totalFrames; n++)
+    {
+        // Tag moves from range bin 200 to 260 halfway through
+        int tagBin = n < totalFrames / 2 ? 200 : 260;
+        for (int i = 0; i < numOfSamplers; i++)
+        {
+            framesBB[n * numOfSamplers + i] = cexp(I * 2 * M_PI * tagHz / frameRate * n) * exp(-pow(i - tagBin, 2) / 50.0) +
+                                              0.01 * (rand() % 100) + 0.01 * I * (rand() % 100);
+        }
+    }
+
+    for (int n = 0; n < totalFrames; n++)
+    {
+        if (trackerPush(tracker, &framesBB[n * numOfSamplers]))
+        {
+            // Compare against a batch FFT of the same window
+            computeFFT(&framesBB[(n + 1 - windowFrames) * numOfSamplers], windowFT, windowFrames, numOfSamplers);
+            double maxError = 0;
+            for (int i = 0; i < numOfSamplers; i++)
+            {
+                maxError = fmax(maxError, fabs(tracker->tagFT[i] - cabs(windowFT[i + numOfSamplers * (tracker->tagBin - 1)])));
+            }
+            printf("Frame %d: peak bin %d, SNR %.2f dB, error against FFT %g\n", n + 1, tracker->peakBin, tracker->SNRdB, maxError);
+        }
+    }
+
+    trackerFree(tracker);
+    free(framesBB);
+    free(windowFT);
+    return 0;
+}
+#endif
@@ -0,0 +1,67 @@
+/*
+ * File:   tracker.h
+ * Author: ericdvet
+ *
+ * Real-time tag tracking over a continuous stream of baseband frames using a sliding slow-time DFT
+ */
+
+#ifndef TRACKER_H
+#define TRACKER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <complex.h>
+#include "slowtime.h"
+
+/**
+ * @struct TagTracker
+ * @brief Sliding window over the most recent frames and the latest tag estimate
+ * @author ericdvet */
+typedef struct
+{
+    SlowTimeDFT *dft;
+    double complex *history;
+    int windowFrames;
+    int numOfSamplers;
+    int updateFrames;
+    int freqTag;
+    long long frame;
+    double *tagFT;
+    int tagBin;
+    int peakBin;
+    double SNRdB;
+} TagTracker;
+
+/**
+ * @function trackerCreate(int windowFrames, int numOfSamplers, int frameRate, double tagHz, int updateFrames)
+ * @param windowFrames - Number of most recent frames the tag spectrum is computed over
+ * @param numOfSamplers - Number of baseband samples per frame
+ * @param frameRate - Frame rate of the radar in Hz
+ * @param tagHz - Frequency at which tag is oscillating in Hz
+ * @param updateFrames - Number of frames between tag estimates once the window is full
+ * @return TagTracker *
+ * @brief Creates a tracker that keeps the slow-time DFT of every range bin at the tag and SNR noise
+ *      frequencies of procRadarFrames() up to date frame by frame
+ * @author ericdvet */
+TagTracker *trackerCreate(int windowFrames, int numOfSamplers, int frameRate, double tagHz, int updateFrames);
+
+/**
+ * @function trackerPush(TagTracker *tracker, const double complex *frameBB)
+ * @param tracker - Tracker created by trackerCreate()
+ * @param frameBB - Next baseband frame (numOfSamplers), e.g. from NoveldaDDC()
+ * @return bool
+ * @brief Slides the window by one frame. Returns true when tagFT, tagBin, peakBin and SNRdB hold a new
+ *      estimate, every updateFrames frames once the window is full
+ * @author ericdvet */
+bool trackerPush(TagTracker *tracker, const double complex *frameBB);
+
+/**
+ * @function trackerFree(TagTracker *tracker)
+ * @param tracker - TagTracker to free
+ * @return None
+ * @brief Free a TagTracker constructed by trackerCreate()
+ * @author ericdvet */
+void trackerFree(TagTracker *tracker);
+
+#endif // TRACKER_H
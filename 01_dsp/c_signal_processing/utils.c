@@ -15,6 +15,14 @@
 
 #define PI 3.14159265358979323846
 
+// Slow-time FFT planning. FFTW_PATIENT finds faster plans but takes much longer the first time
+#define FFT_PLAN_FLAGS FFTW_MEASURE
+#define FFT_WISDOM_FILE "wadar.wisdom"
+#define FFT_WISDOM_FILE_F "wadarf.wisdom"
+
+// Frames x range bins tile transposed at a time, 2 x 32 x 32 doubles stay well inside L1
+#define TRANSPOSE_TILE 32
+
 /**
  * @function NoveldaDDC(double *rfSignal, double complex *basebandSignal)
  * @param rfSignal - Raw radar frames
@@ -154,6 +162,39 @@ void smoothData(double *data, int length, int windowSize)
     free(temp);
 }
 
+/**
+ * @struct FFTPlanCache
+ * @brief Batched slow-time FFT plan kept between captures with the same dimensions
+ * @author ericdvet */
+typedef struct
+{
+    fftw_plan plan;
+    int numFrames;
+    int numOfSamplers;
+    bool inPlace;
+    bool aligned;
+} FFTPlanCache;
+
+static FFTPlanCache fftPlanCache;
+static FFTPlanCache fftPlanarPlanCache;
+static bool fftWisdomLoaded = false;
+
+/**
+ * @struct FFTPlanCachef
+ * @brief Single precision FFTPlanCache
+ * @author ericdvet */
+typedef struct
+{
+    fftwf_plan plan;
+    int numFrames;
+    int numOfSamplers;
+    bool inPlace;
+    bool aligned;
+} FFTPlanCachef;
+
+static FFTPlanCachef fftPlanCachef;
+static bool fftWisdomLoadedf = false;
+
 /**
  * @function computeFFT(double complex *framesBB, double complex *captureFT, int numFrames, int numOfSamplers)
  * @param *framesBB - Input of FFT
@@ -163,38 +204,252 @@ void smoothData(double *data, int length, int windowSize)
  * @return None
  * @brief Fast Fourier transform (FFT) of input
  *      The FFT block computes the fast Fourier transform (FFT) across the first
- *      dimension of an N-D input array, u.
+ *      dimension of an N-D input array, u. Every range bin is transformed by one
+ *      batched plan that reads the frame-major data with its native stride. Plans
+ *      are measured once per capture size and remembered in FFT_WISDOM_FILE
  * @author ericdvet */
 void computeFFT(double complex *framesBB, double complex *captureFT, int numFrames, int numOfSamplers)
 {
-    fftw_plan plan;
+    fftw_complex *in = (fftw_complex *)framesBB;
+    fftw_complex *out = (fftw_complex *)captureFT;
+    bool inPlace = (in == out);
+    bool aligned = (fftw_alignment_of((double *)in) == 0 && fftw_alignment_of((double *)out) == 0);
+
+    if (!fftPlanCache.plan || fftPlanCache.numFrames != numFrames || fftPlanCache.numOfSamplers != numOfSamplers ||
+        fftPlanCache.inPlace != inPlace || fftPlanCache.aligned != aligned)
+    {
+        if (!fftWisdomLoaded)
+        {
+            fftw_import_wisdom_from_filename(FFT_WISDOM_FILE);
+            fftWisdomLoaded = true;
+        }
+        if (fftPlanCache.plan)
+        {
+            fftw_destroy_plan(fftPlanCache.plan);
+        }
+
+        // FFTW_MEASURE overwrites its arrays while planning, so plan on scratch buffers
+        size_t size = (size_t)numFrames * numOfSamplers;
+        fftw_complex *planIn = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * size);
+        fftw_complex *planOut = inPlace ? planIn : (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * size);
+        int n[] = {numFrames};
+        fftPlanCache.plan = fftw_plan_many_dft(1, n, numOfSamplers,
+                                               planIn, NULL, numOfSamplers, 1,
+                                               planOut, NULL, numOfSamplers, 1,
+                                               FFTW_FORWARD, FFT_PLAN_FLAGS | (aligned ? 0 : FFTW_UNALIGNED));
+        if (!inPlace)
+        {
+            fftw_free(planOut);
+        }
+        fftw_free(planIn);
+
+        fftPlanCache.numFrames = numFrames;
+        fftPlanCache.numOfSamplers = numOfSamplers;
+        fftPlanCache.inPlace = inPlace;
+        fftPlanCache.aligned = aligned;
 
-    fftw_complex *in = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * numFrames);
-    fftw_complex *out = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * numFrames);
-    plan = fftw_plan_dft_1d(numFrames, in, out, FFTW_FORWARD, FFTW_ESTIMATE);
+        if (!fftw_export_wisdom_to_filename(FFT_WISDOM_FILE))
+        {
+            fprintf(stderr, "WARNING: Unable to save FFT wisdom to %s\n", FFT_WISDOM_FILE);
+        }
+    }
+
+    fftw_execute_dft(fftPlanCache.plan, in, out);
+}
+
+/**
+ * @function computeFFTf(float complex *framesBB, float complex *captureFT, int numFrames, int numOfSamplers)
+ * @param *framesBB - Input of FFT
+ * @param captureFT - Output of FFT
+ * @param numFrames - Number of frames (total columns)
+ * @param numOfSamplers - Number of samplers (total rows)
+ * @return None
+ * @brief Single precision computeFFT(). Float wisdom is kept in FFT_WISDOM_FILE_F
+ * @author ericdvet */
+void computeFFTf(float complex *framesBB, float complex *captureFT, int numFrames, int numOfSamplers)
+{
+    fftwf_complex *in = (fftwf_complex *)framesBB;
+    fftwf_complex *out = (fftwf_complex *)captureFT;
+    bool inPlace = (in == out);
+    bool aligned = (fftwf_alignment_of((float *)in) == 0 && fftwf_alignment_of((float *)out) == 0);
 
-    for (int j = 0; j < numOfSamplers; j++)
+    if (!fftPlanCachef.plan || fftPlanCachef.numFrames != numFrames || fftPlanCachef.numOfSamplers != numOfSamplers ||
+        fftPlanCachef.inPlace != inPlace || fftPlanCachef.aligned != aligned)
     {
+        if (!fftWisdomLoadedf)
+        {
+            fftwf_import_wisdom_from_filename(FFT_WISDOM_FILE_F);
+            fftWisdomLoadedf = true;
+        }
+        if (fftPlanCachef.plan)
+        {
+            fftwf_destroy_plan(fftPlanCachef.plan);
+        }
 
-        for (int i = 0; i < numFrames; i++)
+        size_t size = (size_t)numFrames * numOfSamplers;
+        fftwf_complex *planIn = (fftwf_complex *)fftwf_malloc(sizeof(fftwf_complex) * size);
+        fftwf_complex *planOut = inPlace ? planIn : (fftwf_complex *)fftwf_malloc(sizeof(fftwf_complex) * size);
+        int n[] = {numFrames};
+        fftPlanCachef.plan = fftwf_plan_many_dft(1, n, numOfSamplers,
+                                                 planIn, NULL, numOfSamplers, 1,
+                                                 planOut, NULL, numOfSamplers, 1,
+                                                 FFTW_FORWARD, FFT_PLAN_FLAGS | (aligned ? 0 : FFTW_UNALIGNED));
+        if (!inPlace)
         {
-            in[i][0] = creal(framesBB[j + i * numOfSamplers]);
-            in[i][1] = cimag(framesBB[j + i * numOfSamplers]);
+            fftwf_free(planOut);
         }
+        fftwf_free(planIn);
 
-        // Execute the FFT
-        fftw_execute(plan);
+        fftPlanCachef.numFrames = numFrames;
+        fftPlanCachef.numOfSamplers = numOfSamplers;
+        fftPlanCachef.inPlace = inPlace;
+        fftPlanCachef.aligned = aligned;
 
-        // Convert FFTW's complex type to double complex
-        for (int i = 0; i < numFrames; ++i)
+        if (!fftwf_export_wisdom_to_filename(FFT_WISDOM_FILE_F))
         {
-            captureFT[j + i * numOfSamplers] = out[i][0] + I * out[i][1];
+            fprintf(stderr, "WARNING: Unable to save FFT wisdom to %s\n", FFT_WISDOM_FILE_F);
         }
     }
 
-    fftw_destroy_plan(plan);
-    fftw_free(in);
-    fftw_free(out);
+    fftwf_execute_dft(fftPlanCachef.plan, in, out);
+}
+
+/**
+ * @function transposeToPlanar(const double complex *framesBB, int blockFrames, int numOfSamplers, double *re, double *im, int numFrames, int frameOffset)
+ * @param framesBB - Frame-major interleaved baseband frames (blockFrames x numOfSamplers)
+ * @param blockFrames - Number of frames in framesBB
+ * @param numOfSamplers - Number of range bins per frame
+ * @param re - Range-bin-major real parts (numOfSamplers x numFrames)
+ * @param im - Range-bin-major imaginary parts (numOfSamplers x numFrames)
+ * @param numFrames - Total number of frames (row length of re and im)
+ * @param frameOffset - Frame index of the first frame of framesBB
+ * @return None
+ * @brief Cache-blocked transpose of a block of DDC output into the planar slow-time layout, so each
+ *      range bin becomes a contiguous run of frames for the FFT, magnitude and SNR kernels
+ * @author ericdvet */
+void transposeToPlanar(const double complex *framesBB, int blockFrames, int numOfSamplers, double *re, double *im, int numFrames, int frameOffset)
+{
+    for (int i0 = 0; i0 < blockFrames; i0 += TRANSPOSE_TILE)
+    {
+        int i1 = i0 + TRANSPOSE_TILE < blockFrames ? i0 + TRANSPOSE_TILE : blockFrames;
+        for (int j0 = 0; j0 < numOfSamplers; j0 += TRANSPOSE_TILE)
+        {
+            int j1 = j0 + TRANSPOSE_TILE < numOfSamplers ? j0 + TRANSPOSE_TILE : numOfSamplers;
+            for (int j = j0; j < j1; j++)
+            {
+                double *rowRe = &re[(size_t)j * numFrames + frameOffset];
+                double *rowIm = &im[(size_t)j * numFrames + frameOffset];
+                for (int i = i0; i < i1; i++)
+                {
+                    const double *sample = (const double *)&framesBB[(size_t)i * numOfSamplers + j];
+                    rowRe[i] = sample[0];
+                    rowIm[i] = sample[1];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @function computeFFTPlanar(double *re, double *im, int numFrames, int numOfSamplers)
+ * @param re - Range-bin-major real parts (numOfSamplers x numFrames), replaced by the FFT
+ * @param im - Range-bin-major imaginary parts (numOfSamplers x numFrames), replaced by the FFT
+ * @param numFrames - Number of frames (row length)
+ * @param numOfSamplers - Number of range bins (rows)
+ * @return None
+ * @brief In-place slow-time FFT of planar data laid out by transposeToPlanar(). Every transform reads
+ *      contiguous memory. Plans are cached and share the wisdom of computeFFT()
+ * @author ericdvet */
+void computeFFTPlanar(double *re, double *im, int numFrames, int numOfSamplers)
+{
+    bool aligned = (fftw_alignment_of(re) == 0 && fftw_alignment_of(im) == 0);
+
+    if (!fftPlanarPlanCache.plan || fftPlanarPlanCache.numFrames != numFrames || fftPlanarPlanCache.numOfSamplers != numOfSamplers ||
+        fftPlanarPlanCache.aligned != aligned)
+    {
+        if (!fftWisdomLoaded)
+        {
+            fftw_import_wisdom_from_filename(FFT_WISDOM_FILE);
+            fftWisdomLoaded = true;
+        }
+        if (fftPlanarPlanCache.plan)
+        {
+            fftw_destroy_plan(fftPlanarPlanCache.plan);
+        }
+
+        size_t size = (size_t)numFrames * numOfSamplers;
+        double *planRe = (double *)fftw_malloc(sizeof(double) * size);
+        double *planIm = (double *)fftw_malloc(sizeof(double) * size);
+        fftw_iodim dims = {numFrames, 1, 1};
+        fftw_iodim howmany = {numOfSamplers, numFrames, numFrames};
+        fftPlanarPlanCache.plan = fftw_plan_guru_split_dft(1, &dims, 1, &howmany, planRe, planIm, planRe, planIm,
+                                                           FFT_PLAN_FLAGS | (aligned ? 0 : FFTW_UNALIGNED));
+        fftw_free(planRe);
+        fftw_free(planIm);
+
+        fftPlanarPlanCache.numFrames = numFrames;
+        fftPlanarPlanCache.numOfSamplers = numOfSamplers;
+        fftPlanarPlanCache.inPlace = true;
+        fftPlanarPlanCache.aligned = aligned;
+
+        if (!fftw_export_wisdom_to_filename(FFT_WISDOM_FILE))
+        {
+            fprintf(stderr, "WARNING: Unable to save FFT wisdom to %s\n", FFT_WISDOM_FILE);
+        }
+    }
+
+    // The split interface has no sign argument; a forward transform is ri, ii in that order
+    fftw_execute_split_dft(fftPlanarPlanCache.plan, re, im, re, im);
+}
+
+/**
+ * @function computeFFTCleanup(void)
+ * @return None
+ * @brief Releases the plans cached by computeFFT(), computeFFTf() and computeFFTPlanar()
+ * @author ericdvet */
+void computeFFTCleanup(void)
+{
+    if (fftPlanCache.plan)
+    {
+        fftw_destroy_plan(fftPlanCache.plan);
+        fftPlanCache.plan = NULL;
+    }
+    if (fftPlanCachef.plan)
+    {
+        fftwf_destroy_plan(fftPlanCachef.plan);
+        fftPlanCachef.plan = NULL;
+    }
+    if (fftPlanarPlanCache.plan)
+    {
+        fftw_destroy_plan(fftPlanarPlanCache.plan);
+        fftPlanarPlanCache.plan = NULL;
+    }
+}
+
+/**
+ * @function fftFastLength(int minLength)
+ * @param minLength - Shortest usable FFT length
+ * @return int
+ * @brief Smallest length >= minLength with no prime factors above 7, which FFTW transforms quickly
+ * @author ericdvet */
+int fftFastLength(int minLength)
+{
+    for (int length = minLength;; length++)
+    {
+        int remainder = length;
+        int factors[4] = {2, 3, 5, 7};
+        for (int f = 0; f < 4; f++)
+        {
+            while (remainder % factors[f] == 0)
+            {
+                remainder /= factors[f];
+            }
+        }
+        if (remainder == 1)
+        {
+            return length;
+        }
+    }
 }
 
 /**
@@ -258,6 +513,59 @@ double calculateSNR(double complex *captureFT, int numOfSamplers, int freqTag, i
     return (10 * log10(SNR));
 }
 
+/**
+ * @function calculateSNRf(float complex *captureFT, int numOfSamplers, int freqTag, int peakBin)
+ * @param *captureFT - FT of radar frames
+ * @param numOfSamplers - Number of sampelrs (rows)
+ * @param freqTag - FT isolation of backscatter tag
+ * @param peakBin - Determined peak bin location of backscatter tag
+ * @return double
+ * @brief Single precision calculateSNR(). The noise average is accumulated in double
+ * @author ericdvet */
+double calculateSNRf(float complex *captureFT, int numOfSamplers, int freqTag, int peakBin)
+{
+    double signalMag = cabsf(captureFT[peakBin + numOfSamplers * (freqTag - 1)]);
+
+    int noiseFreqLowBound = (int)(freqTag * 0.945);
+    int noiseFreqHighBound = (int)(freqTag * 0.955);
+
+    double noiseMag = 0;
+    for (int j = noiseFreqLowBound; j < noiseFreqHighBound; j++) {
+        noiseMag += cabsf(captureFT[peakBin + numOfSamplers * (j-1)]);
+    }
+    noiseMag = noiseMag / (noiseFreqHighBound - noiseFreqLowBound);
+
+    return 10 * log10(signalMag / noiseMag);
+}
+
+/**
+ * @function calculateSNRPlanar(const double *re, const double *im, int numFrames, int freqTag, int peakBin)
+ * @param re - Range-bin-major real parts of the capture FT (numOfSamplers x numFrames)
+ * @param im - Range-bin-major imaginary parts of the capture FT (numOfSamplers x numFrames)
+ * @param numFrames - Number of frames (row length)
+ * @param freqTag - FT isolation of backscatter tag
+ * @param peakBin - Determined peak bin location of backscatter tag
+ * @return double
+ * @brief calculateSNR() on the planar layout, where the noise band of the peak bin is contiguous
+ * @author ericdvet */
+double calculateSNRPlanar(const double *re, const double *im, int numFrames, int freqTag, int peakBin)
+{
+    const double *rowRe = &re[(size_t)peakBin * numFrames];
+    const double *rowIm = &im[(size_t)peakBin * numFrames];
+    double signalMag = hypot(rowRe[freqTag - 1], rowIm[freqTag - 1]);
+
+    int noiseFreqLowBound = (int)(freqTag * 0.945);
+    int noiseFreqHighBound = (int)(freqTag * 0.955);
+
+    double noiseMag = 0;
+    for (int j = noiseFreqLowBound; j < noiseFreqHighBound; j++) {
+        noiseMag += sqrt(rowRe[j - 1] * rowRe[j - 1] + rowIm[j - 1] * rowIm[j - 1]);
+    }
+    noiseMag = noiseMag / (noiseFreqHighBound - noiseFreqLowBound);
+
+    return 10 * log10(signalMag / noiseMag);
+}
+
 /**
  * @function compare(const void *a, const void *b)
  * @param *a - First number to compare
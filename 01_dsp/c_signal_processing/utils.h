@@ -56,10 +56,62 @@ void smoothData(double *data, int length, int windowSize);
  * @return None
  * @brief Fast Fourier transform (FFT) of input
  *      The FFT block computes the fast Fourier transform (FFT) across the first
- *      dimension of an N-D input array, u.
+ *      dimension of an N-D input array, u. The batched plan is cached between calls
+ *      and its wisdom is saved to disk
  * @author ericdvet */
 void computeFFT(double complex *framesBB, double complex *captureFT, int numFrames, int numOfSamplers);
 
+/**
+ * @function computeFFTf(float complex *framesBB, float complex *captureFT, int numFrames, int numOfSamplers)
+ * @param *framesBB - Input of FFT
+ * @param captureFT - Output of FFT
+ * @param numFrames - Number of frames (total columns)
+ * @param numOfSamplers - Number of samplers (total rows)
+ * @return None
+ * @brief Single precision computeFFT()
+ * @author ericdvet */
+void computeFFTf(float complex *framesBB, float complex *captureFT, int numFrames, int numOfSamplers);
+
+/**
+ * @function transposeToPlanar(const double complex *framesBB, int blockFrames, int numOfSamplers, double *re, double *im, int numFrames, int frameOffset)
+ * @param framesBB - Frame-major interleaved baseband frames (blockFrames x numOfSamplers)
+ * @param blockFrames - Number of frames in framesBB
+ * @param numOfSamplers - Number of range bins per frame
+ * @param re - Range-bin-major real parts (numOfSamplers x numFrames)
+ * @param im - Range-bin-major imaginary parts (numOfSamplers x numFrames)
+ * @param numFrames - Total number of frames (row length of re and im)
+ * @param frameOffset - Frame index of the first frame of framesBB
+ * @return None
+ * @brief Cache-blocked transpose of a block of DDC output into the planar slow-time layout
+ * @author ericdvet */
+void transposeToPlanar(const double complex *framesBB, int blockFrames, int numOfSamplers, double *re, double *im, int numFrames, int frameOffset);
+
+/**
+ * @function computeFFTPlanar(double *re, double *im, int numFrames, int numOfSamplers)
+ * @param re - Range-bin-major real parts (numOfSamplers x numFrames), replaced by the FFT
+ * @param im - Range-bin-major imaginary parts (numOfSamplers x numFrames), replaced by the FFT
+ * @param numFrames - Number of frames (row length)
+ * @param numOfSamplers - Number of range bins (rows)
+ * @return None
+ * @brief In-place slow-time FFT of planar data laid out by transposeToPlanar()
+ * @author ericdvet */
+void computeFFTPlanar(double *re, double *im, int numFrames, int numOfSamplers);
+
+/**
+ * @function computeFFTCleanup(void)
+ * @return None
+ * @brief Releases the plans cached by computeFFT(), computeFFTf() and computeFFTPlanar()
+ * @author ericdvet */
+void computeFFTCleanup(void);
+
+/**
+ * @function fftFastLength(int minLength)
+ * @param minLength - Shortest usable FFT length
+ * @return int
+ * @brief Smallest length >= minLength with no prime factors above 7, which FFTW transforms quickly
+ * @author ericdvet */
+int fftFastLength(int minLength);
+
 /**
  * @function findPeaks(double *arr, int size, int *numPeaks, double minPeakHeight)
  * @param *arr - Array to find peaks from
@@ -83,6 +135,29 @@ int *findPeaks(double *arr, int size, int *numPeaks, double minPeakHeight);
  * @author ericdvet */
 double calculateSNR(double complex *captureFT, int numOfSamplers, int freqTag, int peakBin);
 
+/**
+ * @function calculateSNRf(float complex *captureFT, int numOfSamplers, int freqTag, int peakBin)
+ * @param *captureFT - FT of radar frames
+ * @param numOfSamplers - Number of sampelrs (rows)
+ * @param freqTag - FT isolation of backscatter tag
+ * @param peakBin - Determined peak bin location of backscatter tag
+ * @return double
+ * @brief Single precision calculateSNR()
+ * @author ericdvet */
+double calculateSNRf(float complex *captureFT, int numOfSamplers, int freqTag, int peakBin);
+
+/**
+ * @function calculateSNRPlanar(const double *re, const double *im, int numFrames, int freqTag, int peakBin)
+ * @param re - Range-bin-major real parts of the capture FT (numOfSamplers x numFrames)
+ * @param im - Range-bin-major imaginary parts of the capture FT (numOfSamplers x numFrames)
+ * @param numFrames - Number of frames (row length)
+ * @param freqTag - FT isolation of backscatter tag
+ * @param peakBin - Determined peak bin location of backscatter tag
+ * @return double
+ * @brief calculateSNR() on the planar layout of computeFFTPlanar()
+ * @author ericdvet */
+double calculateSNRPlanar(const double *re, const double *im, int numFrames, int freqTag, int peakBin);
+
 /**
  * @function compare(const void *a, const void *b)
  * @param *a - First number to compare
@@ -22,6 +22,16 @@
 #define FRAME_RATE 200
 #define RADAR_TYPE "Chipotle"
 #define SOIL_TYPE "farm"
+#define MAX_PN_CODES 8
+
+// Processing options applied to every capture, set from the command line
+static ProcOptions wadarOptions;
+
+// Gate the soil captures to the range the tag can appear in, derived from the air capture and tag depth
+static bool wadarRangeAuto;
+
+// Compare every tag test capture processed in single precision against double, see procPrecisionReport()
+static bool wadarPrecisionReport;
 
 /**
  * @function wadar(char *fullDataPath, char *airFramesName, char *trialName, double tagHz, int frameCount, int captureCount, double tagDepth)
@@ -40,13 +50,17 @@ double wadar(char *fullDataPath, char *airFramesName, char *trialName, double ta
     double volumetricWaterContent = 0.0;
 
     // Process Air Capture
-    CaptureData *airCapture = procRadarFrames(fullDataPath, airFramesName, tagHz);
+    CaptureData *airCapture = procRadarFramesOpts(fullDataPath, airFramesName, tagHz, &wadarOptions);
     if (!airCapture || !airCapture->procSuccess)
     {
         printf("ERROR: Air Frames Invalid\n");
         return -1;
     }
-    int airPeakBin = airCapture->peakBin;
+    double airPeakBin = procRangeBin(airCapture, airCapture->peakBin);
+    if (wadarRangeAuto && procRangeOfInterest(airPeakBin, SOIL_TYPE, tagDepth, &wadarOptions.rangeStart, &wadarOptions.rangeStop) == 0)
+    {
+        printf("Range of interest: samplers %d to %d\n", wadarOptions.rangeStart, wadarOptions.rangeStop - 1);
+    }
 
     // Load soil capture
     time_t t = time(NULL);
@@ -81,7 +95,7 @@ double wadar(char *fullDataPath, char *airFramesName, char *trialName, double ta
 
         char wetFramesName[1000];
         snprintf(wetFramesName, sizeof(wetFramesName), "%s%d.frames", captureName, i + 1);
-        CaptureData *wetCapture = procRadarFrames(fullDataPath, wetFramesName, tagHz);
+        CaptureData *wetCapture = procRadarFramesOpts(fullDataPath, wetFramesName, tagHz, &wadarOptions);
         if (!wetCapture || !wetCapture->procSuccess)
         {
             failedCaptures[failedCount++] = i;
@@ -92,7 +106,7 @@ double wadar(char *fullDataPath, char *airFramesName, char *trialName, double ta
         peakBin[i] = wetCapture->peakBin;
         SNRdB[i] = wetCapture->SNRdB;
         peakMagnitudes[i] = wetCapture->tagFT[peakBin[i]];
-        vwc[i] = procSoilMoisture(peakBin[i], airPeakBin, SOIL_TYPE, tagDepth);
+        vwc[i] = procSoilMoisture(procRangeBin(wetCapture, peakBin[i]), airPeakBin, SOIL_TYPE, tagDepth);
 
         freeCaptureData(wetCapture);
     }
@@ -165,7 +179,7 @@ void wadarAirCapture(char *fullDataPath, char *airFramesName, double tagHz, int
 
         char airFramesName[1000];
         snprintf(airFramesName, sizeof(airFramesName), "%s%d.frames", captureName, i + 1);
-        CaptureData *airCapture = procRadarFrames(fullDataPath, airFramesName, tagHz);
+        CaptureData *airCapture = procRadarFramesOpts(fullDataPath, airFramesName, tagHz, &wadarOptions);
         if (!airCapture || !airCapture->procSuccess)
         {
             failedCaptures[failedCount++] = i;
@@ -236,13 +250,17 @@ double wadarTagTest(char *fullDataPath, char *trialName, double tagHz, int frame
 
         char fileName[1000];
         snprintf(fileName, sizeof(fileName), "%s%d.frames", captureName, i + 1);
-        SNRdB[i] = procTagTest(fullDataPath, fileName, tagHz);
+        SNRdB[i] = procTagTest(fullDataPath, fileName, tagHz, &wadarOptions);
         if (SNRdB[i] == -1)
         {
             failedCaptures[failedCount++] = i;
             printf("Capture %d will not be processed due to an issue.\n", i + 1);
             continue;
         }
+        if (wadarPrecisionReport && procPrecisionReport(fullDataPath, fileName, tagHz, &wadarOptions) < 0)
+        {
+            printf("No precision report for capture %d.\n", i + 1);
+        }
     }
 
     // Remove failed captures
@@ -321,7 +339,7 @@ double wadarTwoTag(char *fullDataPath, char *trialName, double tag1Hz, double ta
 
         char wetFramesName[1000];
         snprintf(wetFramesName, sizeof(wetFramesName), "%s%d.frames", captureName, i + 1);
-        CaptureData *wetCapture = procTwoTag(fullDataPath, wetFramesName, tag1Hz, tag2Hz);
+        CaptureData *wetCapture = procTwoTagOpts(fullDataPath, wetFramesName, tag1Hz, tag2Hz, &wadarOptions);
         if (!wetCapture || !wetCapture->procSuccess)
         {
             failedCaptures[failedCount++] = i;
@@ -364,6 +382,120 @@ double wadarTwoTag(char *fullDataPath, char *trialName, double tag1Hz, double ta
     return volumetricWaterContent;
 }
 
+/**
+ * @struct WadarTrackState
+ * @brief Air reference and tag depth used to convert each tracker estimate to VWC
+ * @author ericdvet */
+typedef struct
+{
+    double airPeakBin;
+    double tagDepth;
+    int decimation;
+    int rangeOffset;
+} WadarTrackState;
+
+/**
+ * @function wadarTrackUpdate(const TagTracker *tracker, void *context)
+ * @param tracker - Tracker holding a new estimate
+ * @param context - WadarTrackState of the current wadarTrack() call
+ * @return void
+ * @brief Prints the volumetric water content of the latest tracker estimate
+ * @author ericdvet */
+static void wadarTrackUpdate(const TagTracker *tracker, void *context)
+{
+    const WadarTrackState *state = (const WadarTrackState *)context;
+    double vwc = procSoilMoisture(state->rangeOffset + (double)tracker->peakBin * state->decimation, state->airPeakBin, SOIL_TYPE,
+                                  state->tagDepth);
+    printf("%.2f s: Peak bin %d, SNR %.2f dB, VWC %.2f\n", (double)tracker->frame / FRAME_RATE, tracker->peakBin, tracker->SNRdB, vwc);
+}
+
+/**
+ * @function wadarTrack(char *fullDataPath, char *airFramesName, char *captureName, double tagHz, double tagDepth, int windowFrames, int updateFrames)
+ * @param fullDataPath - Full data file path to radar capture. Must be in the format "user@ip:path". Example: "ericdvet@192.168.7.1:/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data"
+ * @param airFramesName - Name of radar capture file with tag uncovered with soil
+ * @param captureName - Name of radar capture file to track the tag through
+ * @param tagHz - Oscillation frequency of tag being captured
+ * @param tagDepth - Depth at which tag is buried measured in meters
+ * @param windowFrames - Number of most recent frames each estimate is computed over
+ * @param updateFrames - Number of frames between estimates
+ * @return int
+ * @brief Function follows the tag through a capture with a sliding DFT and prints the volumetric water
+ *      content every updateFrames frames. Returns the number of estimates, -1 on error
+ * @author ericdvet */
+int wadarTrack(char *fullDataPath, char *airFramesName, char *captureName, double tagHz, double tagDepth, int windowFrames, int updateFrames)
+{
+    CaptureData *airCapture = procRadarFramesOpts(fullDataPath, airFramesName, tagHz, &wadarOptions);
+    if (!airCapture || !airCapture->procSuccess)
+    {
+        printf("ERROR: Air Frames Invalid\n");
+        return -1;
+    }
+
+    WadarTrackState state;
+    state.airPeakBin = procRangeBin(airCapture, airCapture->peakBin);
+    state.tagDepth = tagDepth;
+    state.decimation = airCapture->decimation;
+    freeCaptureData(airCapture);
+    if (wadarRangeAuto)
+    {
+        procRangeOfInterest(state.airPeakBin, SOIL_TYPE, tagDepth, &wadarOptions.rangeStart, &wadarOptions.rangeStop);
+    }
+    state.rangeOffset = procRangeOffset(&wadarOptions);
+
+    return procTrack(fullDataPath, captureName, tagHz, &wadarOptions, windowFrames, updateFrames, wadarTrackUpdate, &state);
+}
+
+/**
+ * @function wadarPNTag(char *fullDataPath, char *captureName, char **codes, int numCodes, double chipRate)
+ * @param fullDataPath - Full data file path to radar capture. Must be in the format "user@ip:path". Example: "ericdvet@192.168.7.1:/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data".
+ * @param captureName - Name of radar capture file
+ * @param codes - Code of each tag as a string of 0 and 1 chips, like pn[] in radarBackscatter.ino
+ * @param numCodes - Number of codes
+ * @param chipRate - Chips per second sent by the tags
+ * @return int
+ * @brief Function despreads every code from one capture and prints each tag's code lag, peak bin and SNR.
+ *      Returns 0 on success, -1 on error
+ * @author ericdvet */
+int wadarPNTag(char *fullDataPath, char *captureName, char **codes, int numCodes, double chipRate)
+{
+    int codeLength = strlen(codes[0]);
+    int *chips = (int *)malloc((size_t)numCodes * codeLength * sizeof(int));
+    if (!chips)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failure\n");
+        return -1;
+    }
+    for (int code = 0; code < numCodes; code++)
+    {
+        if ((int)strlen(codes[code]) != codeLength)
+        {
+            printf("ERROR: PN codes must have the same length\n");
+            free(chips);
+            return -1;
+        }
+        for (int c = 0; c < codeLength; c++)
+        {
+            chips[code * codeLength + c] = codes[code][c] == '1';
+        }
+    }
+
+    MultiTagData *tags = procPNTags(fullDataPath, captureName, chips, codeLength, numCodes, chipRate, &wadarOptions);
+    free(chips);
+    if (!tags || !tags->procSuccess)
+    {
+        printf("ERROR: Capture Invalid\n");
+        freeMultiTagData(tags);
+        return -1;
+    }
+
+    for (int code = 0; code < numCodes; code++)
+    {
+        printf("Code %s: Lag %d frames, Peak bin %d, SNR %.2f dB\n", codes[code], tags->tagBin[code], tags->peakBin[code], tags->SNRdB[code]);
+    }
+    freeMultiTagData(tags);
+    return 0;
+}
+
 /**
  * @function wadarSaveData(char *fullDataPath, char *name, char *dataName, double vwc, double snr, int peakBin)
  * @param fullDataPath - Full data file path to radar capture. Must be in the format "user@ip:path". Example: "ericdvet@192.168.7.1:/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data".
@@ -407,6 +539,216 @@ void wadar2dirtviz(const char *url, double vwc)
     system(message);
 }
 
+/**
+ * @function wadarParseOption(int argc, char *argv[], int *i)
+ * @param argc - Number of command line arguments
+ * @param argv - Command line arguments
+ * @param i - Index of the argument to parse, advanced past the option value
+ * @return bool
+ * @brief Parses a processing option shared by every command into wadarOptions. Returns false if argv[*i]
+ *      is not a processing option
+ * @author ericdvet */
+static bool wadarParseOption(int argc, char *argv[], int *i)
+{
+    if (strcmp(argv[*i], "--targeted") == 0)
+    {
+        wadarOptions.targetedBins = true;
+        return true;
+    }
+    if (strcmp(argv[*i], "--float") == 0)
+    {
+        wadarOptions.singlePrecision = true;
+        return true;
+    }
+    if (strcmp(argv[*i], "--fixed") == 0)
+    {
+        wadarOptions.fixedPoint = true;
+        return true;
+    }
+    if (strcmp(argv[*i], "--planar") == 0)
+    {
+        wadarOptions.planarLayout = true;
+        return true;
+    }
+    if (strcmp(argv[*i], "--coherent") == 0)
+    {
+        wadarOptions.coherentHarmonics = true;
+        return true;
+    }
+    if (strcmp(argv[*i], "--times") == 0)
+    {
+        wadarOptions.frameTimes = true;
+        return true;
+    }
+    if (strcmp(argv[*i], "--roi-auto") == 0)
+    {
+        wadarRangeAuto = true;
+        return true;
+    }
+    if (strcmp(argv[*i], "--precision-report") == 0)
+    {
+        wadarPrecisionReport = true;
+        return true;
+    }
+    if (strcmp(argv[*i], "--matched") == 0)
+    {
+        wadarOptions.matchedFilter = true;
+        return true;
+    }
+    if (*i + 1 >= argc)
+    {
+        return false;
+    }
+    if (strcmp(argv[*i], "--roi") == 0 && *i + 2 < argc)
+    {
+        wadarOptions.rangeStart = atoi(argv[++(*i)]);
+        wadarOptions.rangeStop = atoi(argv[++(*i)]) + 1;
+        return true;
+    }
+    if (strcmp(argv[*i], "--decimate") == 0)
+    {
+        wadarOptions.decimation = atoi(argv[++(*i)]);
+        return true;
+    }
+    if (strcmp(argv[*i], "--stream") == 0)
+    {
+        wadarOptions.blockFrames = atoi(argv[++(*i)]);
+        return true;
+    }
+    if (strcmp(argv[*i], "--template") == 0)
+    {
+        wadarOptions.templateCapture = argv[++(*i)];
+        return true;
+    }
+    if (strcmp(argv[*i], "--detector") == 0)
+    {
+        const char *detector = argv[++(*i)];
+        if (strcmp(detector, "cwt") == 0)
+        {
+            wadarOptions.detector = PROC_DETECTOR_CWT;
+        }
+        else if (strcmp(detector, "cfar-ca") == 0)
+        {
+            wadarOptions.detector = PROC_DETECTOR_CFAR_CA;
+        }
+        else if (strcmp(detector, "cfar-os") == 0)
+        {
+            wadarOptions.detector = PROC_DETECTOR_CFAR_OS;
+        }
+        else
+        {
+            printf("Unknown detector: %s\n", detector);
+            return false;
+        }
+        return true;
+    }
+    if (strcmp(argv[*i], "--guard") == 0)
+    {
+        wadarOptions.cfarGuardCells = atoi(argv[++(*i)]);
+        return true;
+    }
+    if (strcmp(argv[*i], "--training") == 0)
+    {
+        wadarOptions.cfarTrainingCells = atoi(argv[++(*i)]);
+        return true;
+    }
+    if (strcmp(argv[*i], "--pfa") == 0)
+    {
+        wadarOptions.cfarFalseAlarmRate = atof(argv[++(*i)]);
+        return true;
+    }
+    if (strcmp(argv[*i], "--harmonics") == 0)
+    {
+        wadarOptions.harmonics = atoi(argv[++(*i)]);
+        return true;
+    }
+    if (strcmp(argv[*i], "--zoom") == 0)
+    {
+        wadarOptions.zoomPoints = atoi(argv[++(*i)]);
+        return true;
+    }
+    if (strcmp(argv[*i], "--spectrum") == 0)
+    {
+        const char *spectrum = argv[++(*i)];
+        if (strcmp(spectrum, "periodogram") == 0)
+        {
+            wadarOptions.spectrum = PROC_SPECTRUM_PERIODOGRAM;
+        }
+        else if (strcmp(spectrum, "welch") == 0)
+        {
+            wadarOptions.spectrum = PROC_SPECTRUM_WELCH;
+        }
+        else if (strcmp(spectrum, "multitaper") == 0)
+        {
+            wadarOptions.spectrum = PROC_SPECTRUM_MULTITAPER;
+        }
+        else
+        {
+            printf("Unknown spectrum: %s\n", spectrum);
+            return false;
+        }
+        return true;
+    }
+    if (strcmp(argv[*i], "--clutter") == 0)
+    {
+        const char *clutter = argv[++(*i)];
+        if (strcmp(clutter, "none") == 0)
+        {
+            wadarOptions.clutter = PROC_CLUTTER_NONE;
+        }
+        else if (strcmp(clutter, "static") == 0)
+        {
+            wadarOptions.clutter = PROC_CLUTTER_STATIC;
+        }
+        else if (strcmp(clutter, "adaptive") == 0)
+        {
+            wadarOptions.clutter = PROC_CLUTTER_ADAPTIVE;
+        }
+        else if (strcmp(clutter, "mti") == 0)
+        {
+            wadarOptions.clutter = PROC_CLUTTER_MTI;
+        }
+        else
+        {
+            printf("Unknown clutter map: %s\n", clutter);
+            return false;
+        }
+        return true;
+    }
+    if (strcmp(argv[*i], "--beta") == 0)
+    {
+        wadarOptions.clutterBeta = atof(argv[++(*i)]);
+        return true;
+    }
+    if (strcmp(argv[*i], "--out-of-core") == 0)
+    {
+        wadarOptions.outOfCoreDir = argv[++(*i)];
+        return true;
+    }
+    if (strcmp(argv[*i], "--memory") == 0)
+    {
+        wadarOptions.outOfCoreMB = atoi(argv[++(*i)]);
+        return true;
+    }
+    if (strcmp(argv[*i], "--pulse") == 0)
+    {
+        wadarOptions.matchedFilter = true;
+        wadarOptions.pulseCapture = argv[++(*i)];
+        return true;
+    }
+    if (strcmp(argv[*i], "--segment") == 0)
+    {
+        wadarOptions.spectrumSegmentFrames = atoi(argv[++(*i)]);
+        return true;
+    }
+    if (strcmp(argv[*i], "--tapers") == 0)
+    {
+        wadarOptions.spectrumTapers = atoi(argv[++(*i)]);
+        return true;
+    }
+    return false;
+}
+
 #define WADAR_TEST
 #ifdef WADAR_TEST
 int main(int argc, char *argv[])
@@ -418,6 +760,14 @@ int main(int argc, char *argv[])
         printf("Usage: %s wadarAirCapture -s <fullDataPath> -b <airFramesName> -f <tagHz> -c <frameCount> -n <captureCount>\n", argv[0]);
         printf("Usage: %s wadarTagTest -s <fullDataPath> -t <trialName> -f <tagHz> -c <frameCount> -n <captureCount> -d <tagDepth>\n", argv[0]);
         printf("Usage: %s wadarTwoTag -s <fullDataPath> -t <trialName> -f <tag1Hz> -g <tag2Hz> -c <frameCount> -n <captureCount> -d <tagDiff>\n", argv[0]);
+        printf("Usage: %s wadarTrack -s <fullDataPath> -b <airFramesName> -l <captureName> -f <tagHz> -d <tagDepth> -w <windowFrames> -u <updateFrames>\n", argv[0]);
+        printf("Usage: %s wadarPNTag -s <fullDataPath> -l <captureName> -p <code> [-p <code> ...] -r <chipRate>\n", argv[0]);
+        printf("Processing options: --decimate <factor> --stream <blockFrames> --targeted --float --fixed --planar --template <captureName> --harmonics <count> --coherent --zoom <points> --times --out-of-core <scratchDir> --memory <MB> --matched --pulse <airCaptureName>\n");
+        printf("Spectrum options: --spectrum <periodogram|welch|multitaper> --segment <frames> --tapers <count>\n");
+        printf("Range options: --roi <startBin> <stopBin> --roi-auto\n");
+        printf("Clutter options: --clutter <none|static|adaptive|mti> --beta <rate>\n");
+        printf("Detector options: --detector <cwt|cfar-ca|cfar-os> --guard <cells> --training <cells> --pfa <rate>\n");
+        printf("Report options: --precision-report (wadarTagTest)\n");
         return -1;
     }
 
@@ -430,6 +780,12 @@ int main(int argc, char *argv[])
     int captureCount = 0;
     double tagDepth = 0.0;
     double tagDiff = 0.0;
+    char *captureName = NULL;
+    int windowFrames = 0;
+    int updateFrames = 0;
+    char *codes[MAX_PN_CODES];
+    int numCodes = 0;
+    double chipRate = 0.0;
 
     // Case: "wadar"
     if (strcmp(argv[1], "wadar") == 0)
@@ -464,6 +820,10 @@ int main(int argc, char *argv[])
             {
                 tagDepth = atof(argv[++i]);
             }
+            else if (wadarParseOption(argc, argv, &i))
+            {
+                continue;
+            }
             else
             {
                 printf("Unknown argument: %s\n", argv[i]);
@@ -506,6 +866,10 @@ int main(int argc, char *argv[])
             {
                 captureCount = atoi(argv[++i]);
             }
+            else if (wadarParseOption(argc, argv, &i))
+            {
+                continue;
+            }
             else
             {
                 printf("Unknown argument: %s\n", argv[i]);
@@ -548,6 +912,10 @@ int main(int argc, char *argv[])
             {
                 captureCount = atoi(argv[++i]);
             }
+            else if (wadarParseOption(argc, argv, &i))
+            {
+                continue;
+            }
             else
             {
                 printf("Unknown argument: %s\n", argv[i]);
@@ -598,6 +966,10 @@ int main(int argc, char *argv[])
             {
                 tagDiff = atof(argv[++i]);
             }
+            else if (wadarParseOption(argc, argv, &i))
+            {
+                continue;
+            }
             else
             {
                 printf("Unknown argument: %s\n", argv[i]);
@@ -616,12 +988,108 @@ int main(int argc, char *argv[])
         return 0;
     }
 
+    // Case: "wadarTrack"
+    if (strcmp(argv[1], "wadarTrack") == 0)
+    {
+        for (int i = 2; i < argc; i++)
+        {
+            if (strcmp(argv[i], "-s") == 0)
+            {
+                fullDataPath = argv[++i];
+            }
+            else if (strcmp(argv[i], "-b") == 0)
+            {
+                airFramesName = argv[++i];
+            }
+            else if (strcmp(argv[i], "-l") == 0)
+            {
+                captureName = argv[++i];
+            }
+            else if (strcmp(argv[i], "-f") == 0)
+            {
+                tagHz = atof(argv[++i]);
+            }
+            else if (strcmp(argv[i], "-d") == 0)
+            {
+                tagDepth = atof(argv[++i]);
+            }
+            else if (strcmp(argv[i], "-w") == 0)
+            {
+                windowFrames = atoi(argv[++i]);
+            }
+            else if (strcmp(argv[i], "-u") == 0)
+            {
+                updateFrames = atoi(argv[++i]);
+            }
+            else if (wadarParseOption(argc, argv, &i))
+            {
+                continue;
+            }
+            else
+            {
+                printf("Unknown argument: %s\n", argv[i]);
+                return -1;
+            }
+        }
+        if (!fullDataPath || !airFramesName || !captureName || tagHz == 0.0 || tagDepth == 0.0 || windowFrames == 0 || updateFrames == 0)
+        {
+            printf("Missing arguments. Usage: %s wadarTrack -s <fullDataPath> -b <airFramesName> -l <captureName> -f <tagHz> -d <tagDepth> -w <windowFrames> -u <updateFrames>\n", argv[0]);
+            return -1;
+        }
+
+        // Call the wadar function with the parsed arguments
+        wadarTrack(fullDataPath, airFramesName, captureName, tagHz, tagDepth, windowFrames, updateFrames);
+        return 0;
+    }
+
+    // Case: "wadarPNTag"
+    if (strcmp(argv[1], "wadarPNTag") == 0)
+    {
+        for (int i = 2; i < argc; i++)
+        {
+            if (strcmp(argv[i], "-s") == 0)
+            {
+                fullDataPath = argv[++i];
+            }
+            else if (strcmp(argv[i], "-l") == 0)
+            {
+                captureName = argv[++i];
+            }
+            else if (strcmp(argv[i], "-p") == 0 && numCodes < MAX_PN_CODES)
+            {
+                codes[numCodes++] = argv[++i];
+            }
+            else if (strcmp(argv[i], "-r") == 0)
+            {
+                chipRate = atof(argv[++i]);
+            }
+            else if (wadarParseOption(argc, argv, &i))
+            {
+                continue;
+            }
+            else
+            {
+                printf("Unknown argument: %s\n", argv[i]);
+                return -1;
+            }
+        }
+        if (!fullDataPath || !captureName || numCodes == 0 || chipRate == 0.0)
+        {
+            printf("Missing arguments. Usage: %s wadarPNTag -s <fullDataPath> -l <captureName> -p <code> [-p <code> ...] -r <chipRate>\n", argv[0]);
+            return -1;
+        }
+
+        return wadarPNTag(fullDataPath, captureName, codes, numCodes, chipRate);
+    }
+
     // Invalid function message
     printf("Run wadar for measuring soil moisture content or wadarTagTest for testing the tag\n");
     printf("Usage: %s wadar -s <fullDataPath> -b <airFramesName> -t <trialName> -f <tagHz> -c <frameCount> -n <captureCount> -d <tagDepth>\n", argv[0]);
     printf("Usage: %s wadarAirCapture -s <fullDataPath> -b <airFramesName> -f <tagHz> -c <frameCount> -n <captureCount>\n", argv[0]);
     printf("Usage: %s wadarTagTest -s <fullDataPath> -b <airFramesName> -t <trialName> -f <tagHz> -c <frameCount> -n <captureCount>\n", argv[0]);
     printf("Usage: %s wadarTwoTag -s <fullDataPath> -t <trialName> -f <tag1Hz> -g <tag2Hz> -c <frameCount> -n <captureCount> -d <tagDiff>\n", argv[0]);
+    printf("Usage: %s wadarTrack -s <fullDataPath> -b <airFramesName> -l <captureName> -f <tagHz> -d <tagDepth> -w <windowFrames> -u <updateFrames>\n", argv[0]);
+    printf("Usage: %s wadarPNTag -s <fullDataPath> -l <captureName> -p <code> [-p <code> ...] -r <chipRate>\n", argv[0]);
     return -1;
 }
 #endif
@@ -78,4 +78,32 @@ double wadarTagTest(char *fullDataPath, char *trialName, double tagHz, int frame
  * @author ericdvet */
 double wadarTwoTag(char *fullDataPath, char *trialName, double tag1Hz, double tag2Hz, int frameCount, int captureCount, double tagDiff);
 
+/**
+ * @function wadarTrack(char *fullDataPath, char *airFramesName, char *captureName, double tagHz, double tagDepth, int windowFrames, int updateFrames)
+ * @param fullDataPath - Full data file path to radar capture. Must be in the format "user@ip:path". Example: "ericdvet@192.168.7.1:/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data".
+ * @param airFramesName - Name of radar capture file with tag uncovered with soil
+ * @param captureName - Name of radar capture file to track the tag through
+ * @param tagHz - Oscillation frequency of tag being captured
+ * @param tagDepth - Depth at which tag is buried measured in meters
+ * @param windowFrames - Number of most recent frames each estimate is computed over
+ * @param updateFrames - Number of frames between estimates
+ * @return int
+ * @brief Function follows the tag through a capture with a sliding DFT and prints the volumetric water
+ *      content every updateFrames frames
+ * @author ericdvet */
+int wadarTrack(char *fullDataPath, char *airFramesName, char *captureName, double tagHz, double tagDepth, int windowFrames, int updateFrames);
+
+/**
+ * @function wadarPNTag(char *fullDataPath, char *captureName, char **codes, int numCodes, double chipRate)
+ * @param fullDataPath - Full data file path to radar capture. Must be in the format "user@ip:path". Example: "ericdvet@192.168.7.1:/home/ericdvet/hare-lab/dev_ws/src/wadar/signal_processing/data".
+ * @param captureName - Name of radar capture file
+ * @param codes - Code of each tag as a string of 0 and 1 chips, like pn[] in radarBackscatter.ino
+ * @param numCodes - Number of codes
+ * @param chipRate - Chips per second sent by the tags
+ * @return int
+ * @brief Function despreads every code from one capture and prints each tag's code lag, peak bin and SNR.
+ *      Returns 0 on success, -1 on error
+ * @author ericdvet */
+int wadarPNTag(char *fullDataPath, char *captureName, char **codes, int numCodes, double chipRate);
+
 #endif 
\ No newline at end of file